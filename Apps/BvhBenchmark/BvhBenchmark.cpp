@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+#include <Singularity.Render/Bvh.h>
+#include <Singularity.Render/FrustumCuller.h>
+
+using namespace Singularity;
+using namespace Singularity::Render;
+
+namespace
+{
+	uint32 constexpr c_queryCount = 10000u;
+	uint32 constexpr c_repeats = 5u; // Best of, to keep scheduler noise out of the numbers
+
+	double Now()
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Boxes of 0.5 to 2 units scattered with a constant density, so every object count sees similar query selectivity
+	void Scatter(uint32 _count, float _jitter, std::mt19937& io_random, CullBounds& io_bounds)
+	{
+		float const extent = std::cbrt(static_cast<float>(_count)) * 8.0f;
+		std::uniform_real_distribution<float> position(-extent, extent);
+		std::uniform_real_distribution<float> size(0.25f, 1.0f);
+		std::uniform_real_distribution<float> jitter(-_jitter, _jitter);
+
+		bool const move = io_bounds.GetCount() == _count;
+		for (uint32 i = 0u; i < _count; ++i)
+		{
+			glm::vec3 centre;
+			if (move)
+			{
+				centre = io_bounds.GetCentre(i) + glm::vec3(jitter(io_random), jitter(io_random), jitter(io_random));
+			}
+			else
+			{
+				io_bounds.PushBack();
+				centre = glm::vec3(position(io_random), position(io_random), position(io_random));
+			}
+
+			glm::vec3 const half(size(io_random), size(io_random), size(io_random));
+			io_bounds.Set(i, glm::vec4(centre, glm::length(half)), centre - half, centre + half);
+		}
+	}
+
+	template <typename Function>
+	double Time(Function const& _function)
+	{
+		double best = DBL_MAX;
+		for (uint32 i = 0u; i < c_repeats; ++i)
+		{
+			double const start = Now();
+			_function();
+			best = std::min(best, Now() - start);
+		}
+		return best;
+	}
+
+	bool Run(uint32 _count)
+	{
+		std::mt19937 random(_count);
+		CullBounds bounds;
+		Scatter(_count, 0.0f, random, bounds);
+
+		Bvh bvh;
+		double const build = Time([&]() { bvh.Build(bounds); });
+
+		Scatter(_count, 0.5f, random, bounds);
+		double const refit = Time([&]() { bvh.Refit(bounds); });
+
+		float const extent = std::cbrt(static_cast<float>(_count)) * 8.0f;
+		std::uniform_real_distribution<float> position(-extent, extent);
+		std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+		std::vector<glm::vec3> origins(c_queryCount);
+		std::vector<glm::vec3> directions(c_queryCount);
+		for (uint32 i = 0u; i < c_queryCount; ++i)
+		{
+			origins[i] = glm::vec3(position(random), position(random), position(random));
+			directions[i] = glm::normalize(glm::vec3(direction(random), direction(random), direction(random)) + glm::vec3(0.0f, 0.0f, 1e-3f));
+		}
+
+		uint32 hits = 0u;
+		double const raycast = Time([&]()
+			{
+				hits = 0u;
+				for (uint32 i = 0u; i < c_queryCount; ++i)
+				{
+					RayHit hit;
+					hits += bvh.Raycast(origins[i], directions[i], 100.0f, bounds, hit) ? 1u : 0u;
+				}
+			});
+
+		std::vector<uint32> objects;
+		size_t found = 0u;
+		double const sphere = Time([&]()
+			{
+				found = 0u;
+				for (uint32 i = 0u; i < c_queryCount; ++i)
+				{
+					objects.clear();
+					bvh.QuerySphere(origins[i], 10.0f, bounds, objects);
+					found += objects.size();
+				}
+			});
+
+		glm::mat4 const projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, extent);
+		glm::mat4 const view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		Frustum const frustum = Frustum::FromViewProjection(projection * view);
+		std::vector<uint32> visible;
+		double const frustumQuery = Time([&]()
+			{
+				visible.clear();
+				bvh.QueryFrustum(frustum, bounds, visible);
+			});
+
+		FrustumCuller culler;
+		double const flatCull = Time([&]() { culler.Cull(frustum, bounds); });
+
+		// Subtrees are accepted whole, so the hierarchy may keep more than the flat test but never less
+		std::vector<uint32> hierarchical = visible;
+		std::sort(hierarchical.begin(), hierarchical.end());
+		std::vector<uint32> const& flat = culler.GetVisible();
+		bool const superset = std::includes(hierarchical.begin(), hierarchical.end(), flat.begin(), flat.end());
+
+		std::printf("%8u objects, %8u nodes: build %8.2f ms, refit %6.2f ms, %u rays %7.2f ms (%u hits), %u spheres %7.2f ms (%zu found), frustum %6.2f ms (%zu visible), flat %6.2f ms (%zu visible)\n",
+			_count, bvh.GetNodeCount(), build, refit, c_queryCount, raycast, hits, c_queryCount, sphere, found, frustumQuery, visible.size(), flatCull, flat.size());
+		if (!superset)
+		{
+			std::printf("Error: the BVH missed objects the flat cull kept!\n");
+		}
+		return superset;
+	}
+}
+
+// Times Bvh build, refit and queries over randomly scattered boxes, and its frustum query against the flat SIMD cull.
+// Build with the Release configuration, Debug numbers mostly measure iterator checks.
+int main()
+{
+	bool passed = true;
+	for (uint32 const count : { 10000u, 100000u, 1000000u })
+	{
+		passed = Run(count) && passed;
+	}
+
+	return passed ? 0 : 1;
+}
\ No newline at end of file
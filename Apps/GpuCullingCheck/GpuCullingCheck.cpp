@@ -0,0 +1,795 @@
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include <Singularity.IO/IO.h>
+#include <Singularity.Render/FrustumCuller.h>
+#include <Singularity.Render/GpuObjectData.h>
+#include <Singularity.Render/Mesh.h>
+#include <Singularity.Render/MeshletBuilder.h>
+
+using namespace Singularity;
+using namespace Singularity::Render;
+
+namespace
+{
+	uint32 constexpr c_objectCount = 10000u;
+	uint32 constexpr c_bucketCount = 3u;
+	uint32 constexpr c_clusterObjectCount = 2000u;
+	uint32 constexpr c_clusterBucketCount = 2u;
+	uint32 constexpr c_reservedClusters = 16u; // Slots at the end of every cluster bucket with no object yet
+	uint32 constexpr c_sphereRings = 16u;
+	uint32 constexpr c_sphereSegments = 32u;
+	uint32 constexpr c_workgroupSize = 64u; // local_size_x of the culling shaders
+	uint32 constexpr c_bindingCount = 7u;
+	float constexpr c_extent = 100.0f; // Objects are scattered over a cube this far from the camera in every direction
+	float constexpr c_margin = 1e-3f; // Spheres closer than this to a plane could land either side of it after rounding
+
+	// Same layout as GpuCullingPass's push constants, which the shaders read as CullPushConstants
+	struct PushConstants
+	{
+		glm::vec4 m_planes[6];
+		glm::vec4 m_lodParameters = glm::vec4(0.0f);
+		uint32 m_objectCount = 0u;
+		uint32 m_compact = 0u;
+		float m_lodHysteresis = 0.0f;
+	};
+
+	struct HostBuffer
+	{
+		VkBuffer m_buffer = VK_NULL_HANDLE;
+		VkDeviceMemory m_memory = VK_NULL_HANDLE;
+		void* m_data = nullptr;
+	};
+
+	// Just enough Vulkan to run a compute shader over host visible buffers, no window or swap chain, so it runs on lavapipe
+	class ComputeContext
+	{
+	public:
+		ComputeContext()
+		{
+			VkApplicationInfo appInfo{};
+			appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+			appInfo.pApplicationName = "GpuCullingCheck";
+			appInfo.apiVersion = VK_API_VERSION_1_0;
+
+			VkInstanceCreateInfo instanceInfo{};
+			instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+			instanceInfo.pApplicationInfo = &appInfo;
+			if (vkCreateInstance(&instanceInfo, nullptr, &m_instance) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create instance!");
+			}
+
+			uint32 deviceCount = 0u;
+			vkEnumeratePhysicalDevices(m_instance, &deviceCount, nullptr);
+			std::vector<VkPhysicalDevice> devices(deviceCount);
+			vkEnumeratePhysicalDevices(m_instance, &deviceCount, devices.data());
+
+			// A software device is preferred, it is what runs without a GPU
+			for (VkPhysicalDevice const device : devices)
+			{
+				VkPhysicalDeviceProperties properties;
+				vkGetPhysicalDeviceProperties(device, &properties);
+				if (m_physicalDevice == VK_NULL_HANDLE || properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU)
+				{
+					m_physicalDevice = device;
+					m_deviceName = properties.deviceName;
+				}
+			}
+
+			if (m_physicalDevice == VK_NULL_HANDLE)
+			{
+				throw std::runtime_error("failed to find a Vulkan device!");
+			}
+
+			uint32 familyCount = 0u;
+			vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &familyCount, nullptr);
+			std::vector<VkQueueFamilyProperties> families(familyCount);
+			vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &familyCount, families.data());
+			m_queueFamily = UINT32_MAX;
+			for (uint32 i = 0; i < familyCount && m_queueFamily == UINT32_MAX; ++i)
+			{
+				m_queueFamily = (families[i].queueFlags & VK_QUEUE_COMPUTE_BIT) ? i : UINT32_MAX;
+			}
+
+			if (m_queueFamily == UINT32_MAX)
+			{
+				throw std::runtime_error("failed to find a compute queue!");
+			}
+
+			float const priority = 1.0f;
+			VkDeviceQueueCreateInfo queueInfo{};
+			queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			queueInfo.queueFamilyIndex = m_queueFamily;
+			queueInfo.queueCount = 1u;
+			queueInfo.pQueuePriorities = &priority;
+
+			VkDeviceCreateInfo deviceInfo{};
+			deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+			deviceInfo.queueCreateInfoCount = 1u;
+			deviceInfo.pQueueCreateInfos = &queueInfo;
+			if (vkCreateDevice(m_physicalDevice, &deviceInfo, nullptr, &m_device) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create logical device!");
+			}
+			vkGetDeviceQueue(m_device, m_queueFamily, 0u, &m_queue);
+
+			VkCommandPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.queueFamilyIndex = m_queueFamily;
+			if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create command pool!");
+			}
+		}
+
+		~ComputeContext()
+		{
+			vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+			vkDestroyDevice(m_device, nullptr);
+			vkDestroyInstance(m_instance, nullptr);
+		}
+
+		// Host visible and coherent, so it is filled and read back through m_data without any copies
+		HostBuffer CreateBuffer(VkDeviceSize _size)
+		{
+			HostBuffer buffer;
+
+			VkBufferCreateInfo bufferInfo{};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size = _size;
+			bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			if (vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer.m_buffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create buffer!");
+			}
+
+			VkMemoryRequirements requirements;
+			vkGetBufferMemoryRequirements(m_device, buffer.m_buffer, &requirements);
+
+			VkPhysicalDeviceMemoryProperties memoryProperties;
+			vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &memoryProperties);
+			VkMemoryPropertyFlags const flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			uint32 memoryType = UINT32_MAX;
+			for (uint32 i = 0; i < memoryProperties.memoryTypeCount && memoryType == UINT32_MAX; ++i)
+			{
+				memoryType = (requirements.memoryTypeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & flags) == flags ? i : UINT32_MAX;
+			}
+
+			VkMemoryAllocateInfo allocateInfo{};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocateInfo.allocationSize = requirements.size;
+			allocateInfo.memoryTypeIndex = memoryType;
+			if (memoryType == UINT32_MAX || vkAllocateMemory(m_device, &allocateInfo, nullptr, &buffer.m_memory) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to allocate buffer memory!");
+			}
+
+			vkBindBufferMemory(m_device, buffer.m_buffer, buffer.m_memory, 0u);
+			vkMapMemory(m_device, buffer.m_memory, 0u, _size, 0u, &buffer.m_data);
+			return buffer;
+		}
+
+		void DestroyBuffer(HostBuffer& io_buffer)
+		{
+			vkUnmapMemory(m_device, io_buffer.m_memory);
+			vkDestroyBuffer(m_device, io_buffer.m_buffer, nullptr);
+			vkFreeMemory(m_device, io_buffer.m_memory, nullptr);
+			io_buffer = HostBuffer();
+		}
+
+		// Runs the shader once over _invocations threads and waits for it, bindings without a buffer are left out
+		void Dispatch(std::string const& _shader, HostBuffer const* _bindings, PushConstants const& _pushConstants, uint32 _invocations)
+		{
+			std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+			std::vector<VkDescriptorBufferInfo> bufferInfos;
+			for (uint32 i = 0; i < c_bindingCount; ++i)
+			{
+				if (_bindings[i].m_buffer != VK_NULL_HANDLE)
+				{
+					layoutBindings.push_back({ i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1u, VK_SHADER_STAGE_COMPUTE_BIT, nullptr });
+					bufferInfos.push_back({ _bindings[i].m_buffer, 0u, VK_WHOLE_SIZE });
+				}
+			}
+
+			VkDescriptorSetLayoutCreateInfo setLayoutInfo{};
+			setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			setLayoutInfo.bindingCount = static_cast<uint32>(layoutBindings.size());
+			setLayoutInfo.pBindings = layoutBindings.data();
+			VkDescriptorSetLayout setLayout;
+			vkCreateDescriptorSetLayout(m_device, &setLayoutInfo, nullptr, &setLayout);
+
+			VkPushConstantRange pushConstantRange{ VK_SHADER_STAGE_COMPUTE_BIT, 0u, sizeof(PushConstants) };
+			VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+			pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+			pipelineLayoutInfo.setLayoutCount = 1u;
+			pipelineLayoutInfo.pSetLayouts = &setLayout;
+			pipelineLayoutInfo.pushConstantRangeCount = 1u;
+			pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+			VkPipelineLayout pipelineLayout;
+			vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+
+			std::vector<char> const code = IO::ReadFile(_shader);
+			VkShaderModuleCreateInfo moduleInfo{};
+			moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+			moduleInfo.codeSize = code.size();
+			moduleInfo.pCode = reinterpret_cast<uint32_t const*>(code.data());
+			VkShaderModule shaderModule;
+			if (vkCreateShaderModule(m_device, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create shader module!");
+			}
+
+			VkComputePipelineCreateInfo pipelineInfo{};
+			pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+			pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+			pipelineInfo.stage.module = shaderModule;
+			pipelineInfo.stage.pName = "main";
+			pipelineInfo.layout = pipelineLayout;
+			VkPipeline pipeline;
+			if (vkCreateComputePipelines(m_device, VK_NULL_HANDLE, 1u, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create compute pipeline!");
+			}
+
+			VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, static_cast<uint32>(layoutBindings.size()) };
+			VkDescriptorPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+			poolInfo.maxSets = 1u;
+			poolInfo.poolSizeCount = 1u;
+			poolInfo.pPoolSizes = &poolSize;
+			VkDescriptorPool descriptorPool;
+			vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &descriptorPool);
+
+			VkDescriptorSetAllocateInfo setInfo{};
+			setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			setInfo.descriptorPool = descriptorPool;
+			setInfo.descriptorSetCount = 1u;
+			setInfo.pSetLayouts = &setLayout;
+			VkDescriptorSet descriptorSet;
+			vkAllocateDescriptorSets(m_device, &setInfo, &descriptorSet);
+
+			std::vector<VkWriteDescriptorSet> writes(layoutBindings.size());
+			for (size_t i = 0; i < writes.size(); ++i)
+			{
+				writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				writes[i].dstSet = descriptorSet;
+				writes[i].dstBinding = layoutBindings[i].binding;
+				writes[i].descriptorCount = 1u;
+				writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				writes[i].pBufferInfo = &bufferInfos[i];
+			}
+			vkUpdateDescriptorSets(m_device, static_cast<uint32>(writes.size()), writes.data(), 0u, nullptr);
+
+			VkCommandBufferAllocateInfo commandInfo{};
+			commandInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			commandInfo.commandPool = m_commandPool;
+			commandInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			commandInfo.commandBufferCount = 1u;
+			VkCommandBuffer commandBuffer;
+			vkAllocateCommandBuffers(m_device, &commandInfo, &commandBuffer);
+
+			VkCommandBufferBeginInfo beginInfo{};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			vkBeginCommandBuffer(commandBuffer, &beginInfo);
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0u, 1u, &descriptorSet, 0u, nullptr);
+			vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0u, sizeof(PushConstants), &_pushConstants);
+			vkCmdDispatch(commandBuffer, (_invocations + c_workgroupSize - 1u) / c_workgroupSize, 1u, 1u);
+
+			// Results are read straight from the mapped memory once the queue is idle
+			VkMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0u, 1u, &barrier, 0u, nullptr, 0u, nullptr);
+			vkEndCommandBuffer(commandBuffer);
+
+			VkSubmitInfo submitInfo{};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.commandBufferCount = 1u;
+			submitInfo.pCommandBuffers = &commandBuffer;
+			if (vkQueueSubmit(m_queue, 1u, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to submit compute command buffer!");
+			}
+			vkQueueWaitIdle(m_queue);
+
+			vkFreeCommandBuffers(m_device, m_commandPool, 1u, &commandBuffer);
+			vkDestroyDescriptorPool(m_device, descriptorPool, nullptr);
+			vkDestroyPipeline(m_device, pipeline, nullptr);
+			vkDestroyShaderModule(m_device, shaderModule, nullptr);
+			vkDestroyPipelineLayout(m_device, pipelineLayout, nullptr);
+			vkDestroyDescriptorSetLayout(m_device, setLayout, nullptr);
+		}
+
+		std::string const& GetDeviceName() const { return m_deviceName; }
+
+	private:
+		VkInstance m_instance = VK_NULL_HANDLE;
+		VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+		VkDevice m_device = VK_NULL_HANDLE;
+		VkQueue m_queue = VK_NULL_HANDLE;
+		uint32 m_queueFamily = 0u;
+		VkCommandPool m_commandPool = VK_NULL_HANDLE;
+		std::string m_deviceName;
+	};
+
+	// The renderer's camera, looking down -z from the origin
+	Frustum MakeFrustum()
+	{
+		glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, c_extent);
+		projection[1][1] *= -1;
+		glm::mat4 const view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		return Frustum::FromViewProjection(projection * view);
+	}
+
+	// Rotated, translated and sometimes non-uniformly scaled, the way objects reach the shader
+	glm::mat4 RandomModel(std::mt19937& io_random)
+	{
+		std::uniform_real_distribution<float> position(-c_extent, c_extent);
+		std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+		std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+		glm::vec3 const axis = glm::normalize(glm::vec3(direction(io_random), direction(io_random), direction(io_random)) + glm::vec3(0.0f, 1e-3f, 0.0f));
+		float const uniform = scale(io_random);
+		glm::vec3 const scales = io_random() % 4u == 0u ? glm::vec3(scale(io_random), scale(io_random), scale(io_random)) : glm::vec3(uniform);
+
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(position(io_random), position(io_random), position(io_random)));
+		model = glm::rotate(model, angle(io_random), axis);
+		return glm::scale(model, scales);
+	}
+
+	// World space sphere, scaled by the largest axis like the shaders do
+	glm::vec4 WorldSphere(glm::mat4 const& _model, glm::vec4 const& _sphere)
+	{
+		float const scale = std::max(std::max(glm::length(glm::vec3(_model[0])), glm::length(glm::vec3(_model[1]))), glm::length(glm::vec3(_model[2])));
+		return glm::vec4(glm::vec3(_model * glm::vec4(glm::vec3(_sphere), 1.0f)), _sphere.w * scale);
+	}
+
+	bool OnPlane(Frustum const& _frustum, glm::vec4 const& _sphere)
+	{
+		for (glm::vec4 const& plane : _frustum.m_planes)
+		{
+			if (std::abs(glm::dot(glm::vec3(plane), glm::vec3(_sphere)) + plane.w + _sphere.w) < c_margin)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Unit sphere wound counter clockwise from outside, so every cluster's triangles face away from its centre
+	void MakeSphere(std::vector<Vertex>& o_vertices, std::vector<uint32>& o_indices)
+	{
+		for (uint32 ring = 0; ring <= c_sphereRings; ++ring)
+		{
+			float const polar = 3.1415927f * ring / c_sphereRings;
+			for (uint32 segment = 0; segment <= c_sphereSegments; ++segment)
+			{
+				float const azimuth = 6.2831853f * segment / c_sphereSegments;
+				o_vertices.push_back(Vertex(glm::vec3(std::sin(polar) * std::cos(azimuth), std::cos(polar), std::sin(polar) * std::sin(azimuth))));
+			}
+		}
+
+		auto const addTriangle = [&](uint32 _a, uint32 _b, uint32 _c)
+		{
+			glm::vec3 const& a = o_vertices[_a].m_position;
+			glm::vec3 const& b = o_vertices[_b].m_position;
+			glm::vec3 const& c = o_vertices[_c].m_position;
+			glm::vec3 const normal = glm::cross(b - a, c - a);
+			if (glm::dot(normal, normal) == 0.0f)
+			{
+				return; // Slivers at the poles
+			}
+
+			bool const outward = glm::dot(normal, a + b + c) > 0.0f;
+			o_indices.insert(o_indices.end(), { _a, outward ? _b : _c, outward ? _c : _b });
+		};
+
+		uint32 const stride = c_sphereSegments + 1u;
+		for (uint32 ring = 0; ring < c_sphereRings; ++ring)
+		{
+			for (uint32 segment = 0; segment < c_sphereSegments; ++segment)
+			{
+				uint32 const corner = ring * stride + segment;
+				addTriangle(corner, corner + stride, corner + 1u);
+				addTriangle(corner + 1u, corner + stride, corner + stride + 1u);
+			}
+		}
+	}
+
+	// Runs cull.comp over random objects in a few buckets, both compacted for DrawIndexedIndirectCount and with a fixed
+	// command per object, and checks both against FrustumCuller::Cull over the same world space spheres
+	void CheckObjects(ComputeContext& io_context, std::string const& _shaderDirectory, std::vector<std::string>& io_failures)
+	{
+		std::mt19937 random(1u);
+		std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> radius(0.5f, 2.0f);
+		Frustum const frustum = MakeFrustum();
+
+		std::vector<GpuDrawBucket> buckets(c_bucketCount);
+		std::vector<uint32> bucketSizes(c_bucketCount, 0u);
+		std::vector<GpuObjectData> objects(c_objectCount);
+		CullBounds bounds;
+		for (uint32 i = 0; i < c_objectCount; ++i)
+		{
+			GpuObjectData& object = objects[i];
+			object.m_boundingSphere = glm::vec4(offset(random), offset(random), offset(random), radius(random));
+			object.m_bucket = i % c_bucketCount;
+			object.m_commandSlot = bucketSizes[object.m_bucket]++; // Made absolute once every bucket's base is known
+
+			// Boxes around the spheres never reject one the sphere test keeps, so the culler does the shader's test
+			glm::vec4 world;
+			do
+			{
+				object.m_model = RandomModel(random);
+				world = WorldSphere(object.m_model, object.m_boundingSphere);
+			} while (OnPlane(frustum, world));
+
+			bounds.PushBack();
+			bounds.Set(i, world, glm::vec3(world) - world.w, glm::vec3(world) + world.w);
+		}
+
+		uint32 commandBase = 0u;
+		for (uint32 i = 0; i < c_bucketCount; ++i)
+		{
+			buckets[i].m_commandBase = commandBase;
+			buckets[i].m_firstIndex[0] = 100u * i;
+			buckets[i].m_indexCount[0] = 36u + i;
+			commandBase += bucketSizes[i];
+		}
+		for (GpuObjectData& object : objects)
+		{
+			object.m_commandSlot += buckets[object.m_bucket].m_commandBase;
+		}
+
+		FrustumCuller culler;
+		culler.Cull(frustum, bounds);
+		std::vector<bool> expected(c_objectCount, false);
+		std::vector<std::vector<uint32>> expectedPerBucket(c_bucketCount);
+		for (uint32 const object : culler.GetVisible())
+		{
+			expected[object] = true;
+			expectedPerBucket[objects[object].m_bucket].push_back(object);
+		}
+
+		HostBuffer bindings[c_bindingCount];
+		bindings[0] = io_context.CreateBuffer(sizeof(GpuObjectData) * c_objectCount);
+		bindings[1] = io_context.CreateBuffer(sizeof(GpuDrawBucket) * c_bucketCount);
+		bindings[2] = io_context.CreateBuffer(sizeof(VkDrawIndexedIndirectCommand) * c_objectCount);
+		bindings[3] = io_context.CreateBuffer(sizeof(uint32) * c_bucketCount);
+		bindings[6] = io_context.CreateBuffer(sizeof(uint32) * c_objectCount);
+		std::copy(objects.begin(), objects.end(), static_cast<GpuObjectData*>(bindings[0].m_data));
+		std::copy(buckets.begin(), buckets.end(), static_cast<GpuDrawBucket*>(bindings[1].m_data));
+		std::fill_n(static_cast<uint32*>(bindings[6].m_data), c_objectCount, 0u);
+
+		PushConstants pushConstants;
+		std::copy(frustum.m_planes.begin(), frustum.m_planes.end(), pushConstants.m_planes);
+		pushConstants.m_objectCount = c_objectCount;
+
+		VkDrawIndexedIndirectCommand const* const commands = static_cast<VkDrawIndexedIndirectCommand const*>(bindings[2].m_data);
+		uint32 const* const counts = static_cast<uint32 const*>(bindings[3].m_data);
+		auto const matches = [&](VkDrawIndexedIndirectCommand const& _command, uint32 _object)
+		{
+			GpuDrawBucket const& bucket = buckets[objects[_object].m_bucket];
+			return _command.indexCount == bucket.m_indexCount[0] && _command.firstIndex == bucket.m_firstIndex[0] && _command.vertexOffset == 0 && _command.firstInstance == _object;
+		};
+
+		// Compacted, every bucket's survivors packed at its base in whatever order the atomics handed out
+		pushConstants.m_compact = 1u;
+		std::fill_n(static_cast<uint32*>(bindings[3].m_data), c_bucketCount, 0u);
+		io_context.Dispatch(_shaderDirectory + "cull_comp.spv", bindings, pushConstants, c_objectCount);
+
+		uint32 gpuVisible = 0u;
+		for (uint32 i = 0; i < c_bucketCount; ++i)
+		{
+			gpuVisible += counts[i];
+			if (counts[i] != expectedPerBucket[i].size())
+			{
+				io_failures.push_back("objects: bucket " + std::to_string(i) + " counted " + std::to_string(counts[i]) + " visible, the CPU kept " + std::to_string(expectedPerBucket[i].size()));
+				continue;
+			}
+
+			std::vector<uint32> drawn;
+			for (uint32 slot = 0; slot < counts[i]; ++slot)
+			{
+				VkDrawIndexedIndirectCommand const& command = commands[buckets[i].m_commandBase + slot];
+				drawn.push_back(command.firstInstance);
+				if (command.instanceCount != 1u || command.firstInstance >= c_objectCount || !matches(command, command.firstInstance))
+				{
+					io_failures.push_back("objects: bucket " + std::to_string(i) + " has a malformed compacted command");
+					break;
+				}
+			}
+
+			std::sort(drawn.begin(), drawn.end());
+			if (drawn != expectedPerBucket[i])
+			{
+				io_failures.push_back("objects: bucket " + std::to_string(i) + " compacted other objects than the CPU kept");
+			}
+		}
+
+		// Fixed slots, culled objects keep their command with no instances
+		pushConstants.m_compact = 0u;
+		io_context.Dispatch(_shaderDirectory + "cull_comp.spv", bindings, pushConstants, c_objectCount);
+
+		uint32 mismatches = 0u;
+		for (uint32 i = 0; i < c_objectCount; ++i)
+		{
+			VkDrawIndexedIndirectCommand const& command = commands[objects[i].m_commandSlot];
+			mismatches += command.instanceCount != (expected[i] ? 1u : 0u) || !matches(command, i) ? 1u : 0u;
+		}
+		if (mismatches > 0u)
+		{
+			io_failures.push_back("objects: " + std::to_string(mismatches) + " fixed slot command(s) disagree with the CPU");
+		}
+
+		for (HostBuffer& binding : bindings)
+		{
+			if (binding.m_buffer != VK_NULL_HANDLE)
+			{
+				io_context.DestroyBuffer(binding);
+			}
+		}
+
+		std::cout << "objects: " << c_objectCount << " tested, " << culler.GetVisible().size() << " visible on the CPU, " << gpuVisible << " on the GPU" << std::endl;
+	}
+
+	// Runs cluster_cull.comp over a sphere's meshlets on random objects and checks it against MeshletBuilder::IsVisible,
+	// then checks the CPU test itself: a cluster it rejects while inside the frustum must have no triangle facing the camera
+	void CheckClusters(ComputeContext& io_context, std::string const& _shaderDirectory, std::vector<std::string>& io_failures)
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32> indices;
+		MakeSphere(vertices, indices);
+		std::vector<Meshlet> meshlets;
+		MeshletBuilder::Build(vertices, indices, 0u, static_cast<uint32>(indices.size()), meshlets);
+		uint32 const meshletCount = static_cast<uint32>(meshlets.size());
+
+		std::mt19937 random(2u);
+		Frustum const frustum = MakeFrustum();
+		glm::vec3 const cameraPosition(0.0f);
+
+		// Spheres within rounding of either test's boundary could go either way, objects with one are placed again
+		auto const ambiguous = [&](glm::mat4 const& _model)
+		{
+			for (Meshlet meshlet : meshlets)
+			{
+				float const radius = meshlet.m_boundingSphere.w;
+				meshlet.m_boundingSphere.w = radius + c_margin;
+				bool const grown = MeshletBuilder::IsVisible(meshlet, _model, frustum, cameraPosition);
+				meshlet.m_boundingSphere.w = std::max(0.0f, radius - c_margin);
+				if (grown != MeshletBuilder::IsVisible(meshlet, _model, frustum, cameraPosition))
+				{
+					return true;
+				}
+			}
+			return false;
+		};
+
+		std::vector<GpuObjectData> objects(c_clusterObjectCount);
+		std::vector<GpuDrawBucket> buckets(c_clusterBucketCount);
+		std::vector<uint32> bucketObjects(c_clusterBucketCount, 0u);
+		for (uint32 i = 0; i < c_clusterObjectCount; ++i)
+		{
+			objects[i].m_bucket = i % c_clusterBucketCount;
+			++bucketObjects[objects[i].m_bucket];
+			do
+			{
+				objects[i].m_model = RandomModel(random);
+			} while (ambiguous(objects[i].m_model));
+		}
+
+		// Like GpuCullingPass, each bucket's clusters are laid out object by object with a few reserved slots at the end
+		std::vector<GpuCluster> clusters;
+		uint32 commandBase = 0u;
+		for (uint32 bucket = 0; bucket < c_clusterBucketCount; ++bucket)
+		{
+			buckets[bucket].m_commandBase = commandBase;
+			for (uint32 i = bucket; i < c_clusterObjectCount; i += c_clusterBucketCount)
+			{
+				for (uint32 meshlet = 0; meshlet < meshletCount; ++meshlet)
+				{
+					clusters.push_back({ i, meshlet, bucket, static_cast<uint32>(clusters.size()) });
+				}
+			}
+			for (uint32 i = 0; i < c_reservedClusters; ++i)
+			{
+				clusters.push_back({ UINT32_MAX, 0u, bucket, static_cast<uint32>(clusters.size()) });
+			}
+			commandBase = static_cast<uint32>(clusters.size());
+		}
+		uint32 const clusterCount = static_cast<uint32>(clusters.size());
+
+		std::vector<bool> expected(clusterCount, false);
+		std::vector<std::vector<uint64>> expectedPerBucket(c_clusterBucketCount); // Object and meshlet of every survivor
+		uint32 coneCulled = 0u;
+		uint32 frontFacing = 0u;
+		for (uint32 i = 0; i < clusterCount; ++i)
+		{
+			GpuCluster const& cluster = clusters[i];
+			if (cluster.m_object == UINT32_MAX)
+			{
+				continue;
+			}
+
+			glm::mat4 const& model = objects[cluster.m_object].m_model;
+			Meshlet const& meshlet = meshlets[cluster.m_meshlet];
+			expected[i] = MeshletBuilder::IsVisible(meshlet, model, frustum, cameraPosition);
+			if (expected[i])
+			{
+				expectedPerBucket[cluster.m_bucket].push_back((uint64)cluster.m_object << 32u | cluster.m_meshlet);
+				continue;
+			}
+
+			float const scale = std::max(std::max(glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1]))), glm::length(glm::vec3(model[2])));
+			if (!frustum.IntersectsSphere(glm::vec3(model * glm::vec4(glm::vec3(meshlet.m_boundingSphere), 1.0f)), meshlet.m_boundingSphere.w * scale))
+			{
+				continue;
+			}
+
+			++coneCulled;
+			for (uint32 index = meshlet.m_firstIndex; index < meshlet.m_firstIndex + meshlet.m_indexCount; index += 3u)
+			{
+				glm::vec3 const a = glm::vec3(model * glm::vec4(vertices[indices[index]].m_position, 1.0f));
+				glm::vec3 const b = glm::vec3(model * glm::vec4(vertices[indices[index + 1u]].m_position, 1.0f));
+				glm::vec3 const c = glm::vec3(model * glm::vec4(vertices[indices[index + 2u]].m_position, 1.0f));
+				if (glm::dot(glm::cross(b - a, c - a), cameraPosition - a) > 0.0f)
+				{
+					++frontFacing;
+					break;
+				}
+			}
+		}
+
+		if (coneCulled == 0u)
+		{
+			io_failures.push_back("clusters: no cluster was culled by its cone, the test never ran");
+		}
+		if (frontFacing > 0u)
+		{
+			io_failures.push_back("clusters: " + std::to_string(frontFacing) + " cone culled cluster(s) have a triangle facing the camera");
+		}
+
+		HostBuffer bindings[c_bindingCount];
+		bindings[0] = io_context.CreateBuffer(sizeof(GpuObjectData) * c_clusterObjectCount);
+		bindings[1] = io_context.CreateBuffer(sizeof(GpuDrawBucket) * c_clusterBucketCount);
+		bindings[2] = io_context.CreateBuffer(sizeof(VkDrawIndexedIndirectCommand) * clusterCount);
+		bindings[3] = io_context.CreateBuffer(sizeof(uint32) * c_clusterBucketCount);
+		bindings[4] = io_context.CreateBuffer(sizeof(Meshlet) * meshletCount);
+		bindings[5] = io_context.CreateBuffer(sizeof(GpuCluster) * clusterCount);
+		std::copy(objects.begin(), objects.end(), static_cast<GpuObjectData*>(bindings[0].m_data));
+		std::copy(buckets.begin(), buckets.end(), static_cast<GpuDrawBucket*>(bindings[1].m_data));
+		std::copy(meshlets.begin(), meshlets.end(), static_cast<Meshlet*>(bindings[4].m_data));
+		std::copy(clusters.begin(), clusters.end(), static_cast<GpuCluster*>(bindings[5].m_data));
+
+		PushConstants pushConstants;
+		std::copy(frustum.m_planes.begin(), frustum.m_planes.end(), pushConstants.m_planes);
+		pushConstants.m_lodParameters = glm::vec4(cameraPosition, 0.0f);
+		pushConstants.m_objectCount = clusterCount;
+
+		VkDrawIndexedIndirectCommand* const commands = static_cast<VkDrawIndexedIndirectCommand*>(bindings[2].m_data);
+		uint32 const* const counts = static_cast<uint32 const*>(bindings[3].m_data);
+		auto const matches = [&](VkDrawIndexedIndirectCommand const& _command, GpuCluster const& _cluster)
+		{
+			Meshlet const& meshlet = meshlets[_cluster.m_meshlet];
+			return _command.indexCount == meshlet.m_indexCount && _command.firstIndex == meshlet.m_firstIndex && _command.vertexOffset == 0 && _command.firstInstance == _cluster.m_object;
+		};
+
+		// Compacted, every bucket's survivors packed at its base
+		pushConstants.m_compact = 1u;
+		std::fill_n(static_cast<uint32*>(bindings[3].m_data), c_clusterBucketCount, 0u);
+		io_context.Dispatch(_shaderDirectory + "cluster_cull_comp.spv", bindings, pushConstants, clusterCount);
+
+		uint32 gpuVisible = 0u;
+		for (uint32 i = 0; i < c_clusterBucketCount; ++i)
+		{
+			gpuVisible += counts[i];
+			if (counts[i] != expectedPerBucket[i].size())
+			{
+				io_failures.push_back("clusters: bucket " + std::to_string(i) + " counted " + std::to_string(counts[i]) + " visible, the CPU kept " + std::to_string(expectedPerBucket[i].size()));
+				continue;
+			}
+
+			// Commands only carry the meshlet's index range, which is unique to it, so that identifies the cluster
+			std::vector<uint64> drawn;
+			for (uint32 slot = 0; slot < counts[i]; ++slot)
+			{
+				VkDrawIndexedIndirectCommand const& command = commands[buckets[i].m_commandBase + slot];
+				auto const meshlet = std::find_if(meshlets.begin(), meshlets.end(), [&](Meshlet const& _meshlet) { return _meshlet.m_firstIndex == command.firstIndex; });
+				if (command.instanceCount != 1u || command.firstInstance >= c_clusterObjectCount || meshlet == meshlets.end() || meshlet->m_indexCount != command.indexCount)
+				{
+					io_failures.push_back("clusters: bucket " + std::to_string(i) + " has a malformed compacted command");
+					break;
+				}
+				drawn.push_back((uint64)command.firstInstance << 32u | static_cast<uint32>(meshlet - meshlets.begin()));
+			}
+
+			std::sort(drawn.begin(), drawn.end());
+			std::sort(expectedPerBucket[i].begin(), expectedPerBucket[i].end());
+			if (drawn != expectedPerBucket[i])
+			{
+				io_failures.push_back("clusters: bucket " + std::to_string(i) + " compacted other clusters than the CPU kept");
+			}
+		}
+
+		// Fixed slots, reserved ones are never written so they keep the marker
+		pushConstants.m_compact = 0u;
+		std::fill_n(reinterpret_cast<uint8*>(commands), sizeof(VkDrawIndexedIndirectCommand) * clusterCount, static_cast<uint8>(0xFFu));
+		io_context.Dispatch(_shaderDirectory + "cluster_cull_comp.spv", bindings, pushConstants, clusterCount);
+
+		uint32 mismatches = 0u;
+		for (uint32 i = 0; i < clusterCount; ++i)
+		{
+			VkDrawIndexedIndirectCommand const& command = commands[clusters[i].m_commandSlot];
+			if (clusters[i].m_object == UINT32_MAX)
+			{
+				mismatches += command.instanceCount != UINT32_MAX ? 1u : 0u;
+			}
+			else
+			{
+				mismatches += command.instanceCount != (expected[i] ? 1u : 0u) || !matches(command, clusters[i]) ? 1u : 0u;
+			}
+		}
+		if (mismatches > 0u)
+		{
+			io_failures.push_back("clusters: " + std::to_string(mismatches) + " fixed slot command(s) disagree with the CPU");
+		}
+
+		for (HostBuffer& binding : bindings)
+		{
+			if (binding.m_buffer != VK_NULL_HANDLE)
+			{
+				io_context.DestroyBuffer(binding);
+			}
+		}
+
+		uint32 cpuVisible = 0u;
+		for (std::vector<uint64> const& visible : expectedPerBucket)
+		{
+			cpuVisible += static_cast<uint32>(visible.size());
+		}
+		std::cout << "clusters: " << clusterCount << " tested over " << meshletCount << " meshlets, " << cpuVisible << " visible on the CPU, " << gpuVisible << " on the GPU, " << coneCulled << " culled by their cone" << std::endl;
+	}
+}
+
+// Dispatches cull.comp and cluster_cull.comp on whatever Vulkan device is there, a software one like lavapipe is picked first,
+// and compares their output with FrustumCuller and MeshletBuilder::IsVisible on the same scene. Shaders are read from the compiled shader directory,
+// or the directory passed as the only argument. Exits with 1 and lists the differences when anything disagrees.
+int main(int _argc, char** _argv)
+{
+	std::string const shaderDirectory = _argc > 1 ? _argv[1] : std::string(DATA_DIRECTORY) + "Shaders/Compute/";
+
+	std::vector<std::string> failures;
+	try
+	{
+		ComputeContext context;
+		std::cout << "Running on " << context.GetDeviceName() << std::endl;
+		CheckObjects(context, shaderDirectory, failures);
+		CheckClusters(context, shaderDirectory, failures);
+	}
+	catch (std::exception const& _exception)
+	{
+		failures.push_back(_exception.what());
+	}
+
+	for (std::string const& failure : failures)
+	{
+		std::cout << "Error: " << failure << std::endl;
+	}
+
+	std::cout << failures.size() << " difference(s)" << std::endl;
+	return failures.empty() ? 0 : 1;
+}
\ No newline at end of file
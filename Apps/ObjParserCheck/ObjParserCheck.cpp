@@ -0,0 +1,182 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <tinyobj/tiny_obj_loader.h>
+#include <vector>
+
+#include <Singularity.Render/ObjParser.h>
+
+using namespace Singularity;
+
+namespace
+{
+	// Lines and points before any face, groups that hold only lines, materials switching under pending lines, negative
+	// indices, an empty group name, and lines ending in "\r", "\r\n" and "\n"
+	char const* const c_fixture =
+		"# ObjParserCheck fixture\r"
+		"mtllib Fixture.mtl\r"
+		"v 0 0 0\r"
+		"v 1 0 0\r\n"
+		"v 1 1 0\r"
+		"v 0 1 0\n"
+		"vt 0 0\r"
+		"vt 1 1\r"
+		"vn 0 0 1\r"
+		"l 1 2 3\r"
+		"l -1/-1 -2/-2\r\n"
+		"p 1 -1 2\r"
+		"o Quad\r"
+		"usemtl Red\r"
+		"f -4/1/1 -3/2/-1 -2/2/1 -1/1/1\r"
+		"l 1 3\r"
+		"usemtl Green\n"
+		"f 1 2 3\r"
+		"p 4\r"
+		"g LinesOnly\r"
+		"l -4 -3 -2 -1\r"
+		"g Mixed Group\r\n"
+		"f -3//1 -2//1 -1//1\r"
+		"l 2 4\r"
+		"g\r"
+		"p 1 2\r"
+		"usemtl Red\r"
+		"f 1 2 4\r";
+
+	char const* const c_fixtureMaterials =
+		"newmtl Red\n"
+		"Kd 1 0 0\n"
+		"newmtl Green\n"
+		"Kd 0 1 0\n";
+
+	uint32 constexpr c_largeFixtureSize = 4u * Render::ObjParser::c_minChunkSize; // Big enough to be parsed in several chunks
+
+	void Write(std::filesystem::path const& _path, std::string const& _text)
+	{
+		std::ofstream file(_path, std::ios::binary);
+		file << _text;
+	}
+
+	// Values have to match to the bit, so floats are compared as bytes
+	template <typename T>
+	bool Same(std::vector<T> const& _expected, std::vector<T> const& _actual)
+	{
+		return _expected.size() == _actual.size() && (_expected.empty() || memcmp(_expected.data(), _actual.data(), _expected.size() * sizeof(T)) == 0);
+	}
+
+	bool Same(std::vector<tinyobj::index_t> const& _expected, std::vector<tinyobj::index_t> const& _actual)
+	{
+		if (_expected.size() != _actual.size())
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < _expected.size(); ++i)
+		{
+			if (_expected[i].vertex_index != _actual[i].vertex_index || _expected[i].normal_index != _actual[i].normal_index || _expected[i].texcoord_index != _actual[i].texcoord_index)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void Expect(bool _condition, std::string const& _file, char const* _what, std::vector<std::string>& io_failures)
+	{
+		if (!_condition)
+		{
+			io_failures.push_back(_file + ": " + _what + " differ");
+		}
+	}
+
+	// Parses the file with tinyobj's own reader and with ObjParser, and records everything the two disagree on
+	void Check(std::string const& _file, std::vector<std::string>& io_failures)
+	{
+		tinyobj::ObjReader reader;
+		bool const expectedResult = reader.ParseFromFile(_file);
+
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warning;
+		std::string error;
+		bool const result = Render::ObjParser::Parse(_file, attrib, shapes, materials, warning, error);
+
+		Expect(expectedResult == result, _file, "results", io_failures);
+		Expect(reader.Warning() == warning, _file, "warnings", io_failures);
+		Expect(reader.Error() == error, _file, "errors", io_failures);
+
+		tinyobj::attrib_t const& expectedAttrib = reader.GetAttrib();
+		Expect(Same(expectedAttrib.vertices, attrib.vertices), _file, "positions", io_failures);
+		Expect(Same(expectedAttrib.vertex_weights, attrib.vertex_weights), _file, "vertex weights", io_failures);
+		Expect(Same(expectedAttrib.normals, attrib.normals), _file, "normals", io_failures);
+		Expect(Same(expectedAttrib.texcoords, attrib.texcoords), _file, "texcoords", io_failures);
+		Expect(Same(expectedAttrib.texcoord_ws, attrib.texcoord_ws), _file, "texcoord ws", io_failures);
+		Expect(Same(expectedAttrib.colors, attrib.colors), _file, "colours", io_failures);
+
+		std::vector<tinyobj::shape_t> const& expectedShapes = reader.GetShapes();
+		Expect(expectedShapes.size() == shapes.size(), _file, "shape counts", io_failures);
+		for (size_t i = 0; i < std::min(expectedShapes.size(), shapes.size()); ++i)
+		{
+			tinyobj::mesh_t const& expected = expectedShapes[i].mesh;
+			tinyobj::mesh_t const& actual = shapes[i].mesh;
+			Expect(expectedShapes[i].name == shapes[i].name, _file, "shape names", io_failures);
+			Expect(Same(expected.indices, actual.indices), _file, "indices", io_failures);
+			Expect(Same(expected.num_face_vertices, actual.num_face_vertices), _file, "face vertex counts", io_failures);
+			Expect(Same(expected.material_ids, actual.material_ids), _file, "material ids", io_failures);
+			Expect(Same(expected.smoothing_group_ids, actual.smoothing_group_ids), _file, "smoothing group ids", io_failures);
+			Expect(Same(expectedShapes[i].lines.indices, shapes[i].lines.indices), _file, "line indices", io_failures);
+			Expect(Same(expectedShapes[i].lines.num_line_vertices, shapes[i].lines.num_line_vertices), _file, "line vertex counts", io_failures);
+			Expect(Same(expectedShapes[i].points.indices, shapes[i].points.indices), _file, "point indices", io_failures);
+		}
+
+		std::vector<tinyobj::material_t> const& expectedMaterials = reader.GetMaterials();
+		Expect(expectedMaterials.size() == materials.size(), _file, "material counts", io_failures);
+		for (size_t i = 0; i < std::min(expectedMaterials.size(), materials.size()); ++i)
+		{
+			Expect(expectedMaterials[i].name == materials[i].name && expectedMaterials[i].diffuse_texname == materials[i].diffuse_texname, _file, "materials", io_failures);
+		}
+	}
+}
+
+// Checks that ObjParser gives exactly what tinyobj gives for the built in fixture, once small and once repeated over
+// several chunks, and for every .obj in the models directory, or the directory passed as the only argument. Exits with 1
+// and lists the differences when anything disagrees.
+int main(int _argc, char** _argv)
+{
+	std::string const directory = _argc > 1 ? _argv[1] : std::string(DATA_DIRECTORY) + "Models/";
+
+	std::filesystem::path const fixtures = std::filesystem::temp_directory_path() / "ObjParserCheck";
+	std::filesystem::create_directories(fixtures);
+	Write(fixtures / "Fixture.mtl", c_fixtureMaterials);
+	Write(fixtures / "Fixture.obj", c_fixture);
+
+	std::string large;
+	while (large.size() < c_largeFixtureSize)
+	{
+		large += c_fixture;
+	}
+	Write(fixtures / "FixtureLarge.obj", large);
+
+	std::vector<std::string> failures;
+	Check((fixtures / "Fixture.obj").string(), failures);
+	Check((fixtures / "FixtureLarge.obj").string(), failures);
+	uint32 fileCount = 2u;
+	for (std::filesystem::directory_entry const& entry : std::filesystem::directory_iterator(directory))
+	{
+		if (entry.is_regular_file() && entry.path().extension() == ".obj")
+		{
+			Check(entry.path().string(), failures);
+			++fileCount;
+		}
+	}
+
+	for (std::string const& failure : failures)
+	{
+		std::cout << "Error: " << failure << std::endl;
+	}
+
+	std::cout << fileCount << " file(s) checked, " << failures.size() << " difference(s)" << std::endl;
+	return failures.empty() && fileCount > 0u ? 0 : 1;
+}
\ No newline at end of file
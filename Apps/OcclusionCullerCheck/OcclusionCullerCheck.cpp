@@ -0,0 +1,93 @@
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <Singularity.Render/FrustumCuller.h>
+#include <Singularity.Render/Mesh.h>
+#include <Singularity.Render/OcclusionCuller.h>
+
+using namespace Singularity;
+using namespace Singularity::Render;
+
+namespace
+{
+	float constexpr c_nearPlane = 0.1f; // The renderer's clip planes
+	float constexpr c_farPlane = 1000.0f;
+
+	struct Case
+	{
+		char const* m_name;
+		glm::vec3 m_centre;
+		float m_halfExtent;
+		bool m_visible;
+	};
+
+	// The camera sits at z = 10 looking down -z at a 10 by 10 wall through the origin
+	Case const c_cases[] =
+	{
+		{ "box behind the wall", glm::vec3(0.0f, 0.0f, -5.0f), 0.5f, false },
+		{ "box far behind the wall", glm::vec3(2.0f, -2.0f, -40.0f), 1.0f, false },
+		{ "large box behind the wall", glm::vec3(0.0f, 0.0f, -3.0f), 2.0f, false },
+		{ "box in front of the wall", glm::vec3(0.0f, 0.0f, 3.0f), 0.5f, true },
+		{ "box beside the wall", glm::vec3(20.0f, 0.0f, -5.0f), 0.5f, true },
+		{ "box around the camera", glm::vec3(0.0f, 0.0f, 10.0f), 0.5f, true },
+		{ "box crossing the near plane", glm::vec3(0.0f, 0.0f, 10.5f), 0.6f, true },
+		{ "box peeking past the wall's side", glm::vec3(5.5f, 0.0f, -2.0f), 1.0f, true },
+		{ "box peeking over the wall", glm::vec3(0.0f, 5.5f, -2.0f), 1.0f, true },
+		{ "box wider than the wall behind it", glm::vec3(0.0f, 0.0f, -20.0f), 12.0f, true },
+	};
+}
+
+// Rasterizes a single wall into the occlusion culler and checks which boxes around it survive. Boxes fully behind the wall
+// must be culled, while boxes crossing the near plane or only partly hidden must stay. Exits with 1 and lists every box
+// that came out wrong.
+int main()
+{
+	std::vector<Vertex> const vertices = { Vertex(glm::vec3(-5.0f, -5.0f, 0.0f)), Vertex(glm::vec3(5.0f, -5.0f, 0.0f)), Vertex(glm::vec3(5.0f, 5.0f, 0.0f)), Vertex(glm::vec3(-5.0f, 5.0f, 0.0f)) };
+	Mesh const wall(vertices, { 0u, 1u, 2u, 0u, 2u, 3u });
+
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 2.0f, c_nearPlane, c_farPlane);
+	projection[1][1] *= -1;
+	glm::mat4 const view = glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	OcclusionCuller culler;
+	culler.Begin(projection * view);
+	culler.AddOccluder(wall, glm::mat4(1.0f));
+	culler.Rasterize();
+
+	CullBounds bounds;
+	std::vector<uint32> candidates;
+	for (Case const& test : c_cases)
+	{
+		glm::vec3 const half(test.m_halfExtent);
+		bounds.PushBack();
+		bounds.Set(bounds.GetCount() - 1u, glm::vec4(test.m_centre, glm::length(half)), test.m_centre - half, test.m_centre + half);
+		candidates.push_back(bounds.GetCount() - 1u);
+	}
+	culler.Cull(bounds, candidates);
+
+	std::vector<bool> visible(candidates.size(), false);
+	for (uint32 const object : culler.GetVisible())
+	{
+		visible[object] = true;
+	}
+
+	std::vector<std::string> failures;
+	for (size_t i = 0; i < candidates.size(); ++i)
+	{
+		if (visible[i] != c_cases[i].m_visible)
+		{
+			failures.push_back(std::string(c_cases[i].m_name) + (c_cases[i].m_visible ? " was culled" : " was kept"));
+		}
+	}
+
+	for (std::string const& failure : failures)
+	{
+		std::cout << "Error: " << failure << std::endl;
+	}
+
+	OcclusionStats const& stats = culler.GetStats();
+	std::cout << stats.m_tested << " box(es) tested against " << stats.m_triangles << " triangle(s), " << stats.m_occluded << " occluded, " << failures.size() << " wrong" << std::endl;
+	return failures.empty() && stats.m_triangles > 0u ? 0 : 1;
+}
\ No newline at end of file
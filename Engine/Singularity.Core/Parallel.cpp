@@ -0,0 +1,184 @@
+#include "Parallel.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Singularity
+{
+	namespace Core
+	{
+		namespace
+		{
+			// Worker of the job the current thread is running, UINT32_MAX outside of ParallelFor
+			thread_local uint32 t_worker = UINT32_MAX;
+
+			// Threads are started on first use and live until the process exits. The calling thread is always worker
+			// zero, so the pool owns one thread less than there are workers and each thread keeps its index for good.
+			class WorkerPool
+			{
+			public:
+				WorkerPool();
+				~WorkerPool();
+
+				void Run(uint32 _count, uint32 _workerCount, std::function<void(uint32 _begin, uint32 _end, uint32 _worker)> const& _function);
+
+			private:
+				void WorkerMain(uint32 _worker);
+				void RunRange(uint32 _worker);
+
+				std::vector<std::thread> m_threads;
+				std::mutex m_submitMutex; // Jobs from different threads run one after another
+				std::mutex m_mutex;
+				std::condition_variable m_start;
+				std::condition_variable m_finished;
+
+				std::function<void(uint32 _begin, uint32 _end, uint32 _worker)> const* m_function = nullptr;
+				uint32 m_count = 0u;
+				uint32 m_perWorker = 0u;
+				uint32 m_workerCount = 0u;
+				uint32 m_pending = 0u; // Pool threads still running the current job
+				uint64 m_generation = 0u; // Bumped for every job, so sleeping threads can tell a new one from a spurious wake
+				bool m_stop = false;
+			};
+
+			//////////////////////////////////////////////////////////////////////////////////////
+			WorkerPool::WorkerPool()
+			{
+				uint32 const workerCount = GetWorkerCount();
+				m_threads.reserve(workerCount - 1u);
+				for (uint32 worker = 1u; worker < workerCount; ++worker)
+				{
+					m_threads.emplace_back(&WorkerPool::WorkerMain, this, worker);
+				}
+			}
+
+			//////////////////////////////////////////////////////////////////////////////////////
+			WorkerPool::~WorkerPool()
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_stop = true;
+				}
+				m_start.notify_all();
+
+				for (std::thread& thread : m_threads)
+				{
+					thread.join();
+				}
+			}
+
+			//////////////////////////////////////////////////////////////////////////////////////
+			void WorkerPool::Run(uint32 _count, uint32 _workerCount, std::function<void(uint32 _begin, uint32 _end, uint32 _worker)> const& _function)
+			{
+				std::lock_guard<std::mutex> submitLock(m_submitMutex);
+
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_function = &_function;
+					m_count = _count;
+					m_perWorker = (_count + _workerCount - 1u) / _workerCount;
+					m_workerCount = _workerCount;
+					m_pending = _workerCount - 1u;
+					++m_generation;
+				}
+				m_start.notify_all();
+
+				// The job has to outlive every worker using it, so the pool is waited for even if this range throws
+				auto const wait = [this]()
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_finished.wait(lock, [this]() { return m_pending == 0u; });
+				};
+
+				try
+				{
+					RunRange(0u);
+				}
+				catch (...)
+				{
+					wait();
+					throw;
+				}
+				wait();
+			}
+
+			//////////////////////////////////////////////////////////////////////////////////////
+			void WorkerPool::WorkerMain(uint32 _worker)
+			{
+				uint64 generation = 0u;
+				std::unique_lock<std::mutex> lock(m_mutex);
+				while (true)
+				{
+					m_start.wait(lock, [&]() { return m_stop || m_generation != generation; });
+					if (m_stop)
+					{
+						return;
+					}
+
+					// Jobs with fewer workers leave the higher indices asleep
+					generation = m_generation;
+					if (_worker >= m_workerCount)
+					{
+						continue;
+					}
+
+					lock.unlock();
+					RunRange(_worker);
+					lock.lock();
+
+					if (--m_pending == 0u)
+					{
+						m_finished.notify_one();
+					}
+				}
+			}
+
+			//////////////////////////////////////////////////////////////////////////////////////
+			void WorkerPool::RunRange(uint32 _worker)
+			{
+				uint32 const begin = std::min(m_count, _worker * m_perWorker);
+				uint32 const end = std::min(m_count, begin + m_perWorker);
+
+				t_worker = _worker;
+				(*m_function)(begin, end, _worker);
+				t_worker = UINT32_MAX;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		uint32 GetWorkerCount()
+		{
+			static uint32 const workerCount = std::max(1u, std::thread::hardware_concurrency());
+			return workerCount;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void ParallelFor(uint32 _count, uint32 _minPerWorker, std::function<void(uint32 _begin, uint32 _end, uint32 _worker)> const& _function)
+		{
+			if (_count == 0u)
+			{
+				return;
+			}
+
+			// Nested calls stay on the worker that made them, under its index, since the pool is busy with the outer job
+			if (t_worker != UINT32_MAX)
+			{
+				_function(0u, _count, t_worker);
+				return;
+			}
+
+			uint32 const maxWorkers = std::max(1u, _count / std::max(1u, _minPerWorker));
+			uint32 const workerCount = std::min(GetWorkerCount(), maxWorkers);
+			if (workerCount == 1u)
+			{
+				_function(0u, _count, 0u);
+				return;
+			}
+
+			static WorkerPool pool;
+			pool.Run(_count, workerCount, _function);
+		}
+	}
+}
\ No newline at end of file
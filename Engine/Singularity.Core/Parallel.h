@@ -0,0 +1,18 @@
+#pragma once
+
+#include <functional>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Core
+	{
+		uint32 GetWorkerCount();
+
+		// Splits [0, _count) into one contiguous range per worker and runs them concurrently, the calling thread takes the
+		// first range. Ranges are never smaller than _minPerWorker, so small inputs stay on the calling thread. Other ranges
+		// go to a pool of threads started on the first call, and every worker index always maps to the same thread.
+		void ParallelFor(uint32 _count, uint32 _minPerWorker, std::function<void(uint32 _begin, uint32 _end, uint32 _worker)> const& _function);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "RadixSort.h"
+
+#include <array>
+
+#include <Singularity.Core/Parallel.h>
+
+namespace Singularity
+{
+	namespace Core
+	{
+		namespace
+		{
+			uint32 constexpr c_radixBits = 8u;
+			uint32 constexpr c_radixSize = 1u << c_radixBits;
+			uint32 constexpr c_passCount = 64u / c_radixBits;
+			uint32 constexpr c_minPerWorker = 16384u; // Below this the threads cost more than they save
+
+			using Histogram = std::array<uint32, c_radixSize>;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void RadixSort(std::vector<uint64>& io_keys, std::vector<uint32>& io_values, std::vector<uint64>& io_keyScratch, std::vector<uint32>& io_valueScratch)
+		{
+			uint32 const count = static_cast<uint32>(io_keys.size());
+			if (count < 2u)
+			{
+				return;
+			}
+
+			io_keyScratch.resize(count);
+			io_valueScratch.resize(count);
+
+			// Bytes that are identical across every key don't change the order, find them up front
+			uint64 keyAnd = ~0ull;
+			uint64 keyOr = 0ull;
+			for (uint64 key : io_keys)
+			{
+				keyAnd &= key;
+				keyOr |= key;
+			}
+			uint64 const varyingBits = keyAnd ^ keyOr;
+
+			// ParallelFor may use fewer workers than this, their histograms just stay empty
+			std::vector<Histogram> histograms(GetWorkerCount());
+
+			uint64* source = io_keys.data();
+			uint64* destination = io_keyScratch.data();
+			uint32* sourceValues = io_values.data();
+			uint32* destinationValues = io_valueScratch.data();
+
+			for (uint32 pass = 0u; pass < c_passCount; ++pass)
+			{
+				uint32 const shift = pass * c_radixBits;
+				if (((varyingBits >> shift) & (c_radixSize - 1u)) == 0u)
+				{
+					continue;
+				}
+
+				for (Histogram& histogram : histograms)
+				{
+					histogram.fill(0u);
+				}
+
+				// Count each worker's chunk
+				ParallelFor(count, c_minPerWorker, [&](uint32 _begin, uint32 _end, uint32 _worker)
+				{
+					Histogram& histogram = histograms[_worker];
+					for (uint32 i = _begin; i < _end; ++i)
+					{
+						++histogram[(source[i] >> shift) & (c_radixSize - 1u)];
+					}
+				});
+
+				// Exclusive prefix over (digit, worker) so every worker knows where each of its digits starts
+				uint32 offset = 0u;
+				for (uint32 digit = 0u; digit < c_radixSize; ++digit)
+				{
+					for (Histogram& histogram : histograms)
+					{
+						uint32 const digitCount = histogram[digit];
+						histogram[digit] = offset;
+						offset += digitCount;
+					}
+				}
+
+				// Scatter, chunks keep their relative order so the sort stays stable
+				ParallelFor(count, c_minPerWorker, [&](uint32 _begin, uint32 _end, uint32 _worker)
+				{
+					Histogram& histogram = histograms[_worker];
+					for (uint32 i = _begin; i < _end; ++i)
+					{
+						uint32 const target = histogram[(source[i] >> shift) & (c_radixSize - 1u)]++;
+						destination[target] = source[i];
+						destinationValues[target] = sourceValues[i];
+					}
+				});
+
+				std::swap(source, destination);
+				std::swap(sourceValues, destinationValues);
+			}
+
+			if (source != io_keys.data())
+			{
+				// Odd number of passes ran, the result is sitting in the scratch buffers
+				io_keys.swap(io_keyScratch);
+				io_values.swap(io_valueScratch);
+			}
+		}
+	}
+}
\ No newline at end of file
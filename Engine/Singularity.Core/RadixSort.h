@@ -0,0 +1,16 @@
+#pragma once
+
+#include <vector>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Core
+	{
+		// Stable LSD radix sort of 64-bit keys, carrying a 32-bit value (usually an index) along with each key.
+		// One byte per pass so each worker's histogram stays in L1, and passes where every key shares the same byte are skipped.
+		// Scratch vectors are resized as needed and can be kept between calls to avoid reallocating.
+		void RadixSort(std::vector<uint64>& io_keys, std::vector<uint32>& io_values, std::vector<uint64>& io_keyScratch, std::vector<uint32>& io_valueScratch);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "MappedFile.h"
+
+namespace Singularity
+{
+	namespace IO
+	{
+		MappedFile::~MappedFile()
+		{
+			Close();
+		}
+
+		bool MappedFile::Open(const std::string& _filename)
+		{
+			Close();
+
+			// Sequential scan lets the OS read ahead aggressively, loads walk the file front to back
+			m_file = CreateFileA(_filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (m_file == INVALID_HANDLE_VALUE) {
+				return false;
+			}
+
+			// Empty files can't be mapped
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart == 0) {
+				Close();
+				return false;
+			}
+
+			m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!m_mapping) {
+				Close();
+				return false;
+			}
+
+			m_data = static_cast<uint8 const*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+			if (!m_data) {
+				Close();
+				return false;
+			}
+
+			m_size = (size_t)fileSize.QuadPart;
+			return true;
+		}
+
+		void MappedFile::Close()
+		{
+			if (m_data) {
+				UnmapViewOfFile(m_data);
+				m_data = nullptr;
+			}
+
+			if (m_mapping) {
+				CloseHandle(m_mapping);
+				m_mapping = nullptr;
+			}
+
+			if (m_file != INVALID_HANDLE_VALUE) {
+				CloseHandle(m_file);
+				m_file = INVALID_HANDLE_VALUE;
+			}
+
+			m_size = 0u;
+		}
+	}
+}
\ No newline at end of file
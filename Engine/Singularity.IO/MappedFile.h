@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace IO
+	{
+		// Read only view of a whole file. Nothing is read up front, pages come in from the OS file cache as they are
+		// touched, so copying out of the view is the only copy made.
+		class MappedFile
+		{
+		public:
+			MappedFile() {}
+			MappedFile(MappedFile const&) = delete;
+			MappedFile& operator=(MappedFile const&) = delete;
+			~MappedFile();
+
+			bool Open(const std::string& _filename); // False when the file is missing, empty or can't be mapped
+			void Close();
+
+			bool IsOpen() const { return m_data != nullptr; }
+			uint8 const* GetData() const { return m_data; }
+			size_t GetSize() const { return m_size; }
+
+		private:
+			HANDLE m_file = INVALID_HANDLE_VALUE;
+			HANDLE m_mapping = nullptr;
+			uint8 const* m_data = nullptr;
+			size_t m_size = 0u;
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "BindlessTextureTable.h"
+
+#include <algorithm>
+
+#include <Singularity.Render/Renderer.h>
+#include <Singularity.Render/Texture.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		//////////////////////////////////////////////////////////////////////////////////////
+		void BindlessTextureTable::Create(uint32 _framesInFlight)
+		{
+			m_pendingSlots.assign(_framesInFlight, std::vector<uint32>());
+			m_currentFrame = 0u;
+
+			Device const& device = m_renderer.GetDevice();
+			VkPhysicalDeviceVulkan12Properties const& properties = device.GetVulkan12Properties();
+			m_capacity = std::min({ c_maxTextures, properties.maxPerStageDescriptorUpdateAfterBindSamplers, properties.maxPerStageDescriptorUpdateAfterBindSampledImages });
+
+			// Unused slots are never read so the array can be partially bound, and slots are filled in while earlier frames are still in flight
+			VkDescriptorBindingFlags const bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+			m_layout.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, m_capacity, bindingFlags);
+			m_layout.Create();
+
+			VkDescriptorPoolSize poolSize{};
+			poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			poolSize.descriptorCount = m_capacity;
+
+			VkDescriptorPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+			poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+			poolInfo.poolSizeCount = 1;
+			poolInfo.pPoolSizes = &poolSize;
+			poolInfo.maxSets = 1;
+
+			VkDevice const logicalDevice = device.GetLogicalDevice();
+			if (vkCreateDescriptorPool(logicalDevice, &poolInfo, nullptr, &m_descriptorPool) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create bindless descriptor pool!");
+			}
+
+			VkDescriptorSetLayout const layout = m_layout.GetLayout();
+			VkDescriptorSetAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocInfo.descriptorPool = m_descriptorPool;
+			allocInfo.descriptorSetCount = 1;
+			allocInfo.pSetLayouts = &layout;
+
+			if (vkAllocateDescriptorSets(logicalDevice, &allocInfo, &m_descriptorSet) != VK_SUCCESS) {
+				throw std::runtime_error("failed to allocate bindless descriptor set!");
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void BindlessTextureTable::Destroy()
+		{
+			vkDestroyDescriptorPool(m_renderer.GetDevice().GetLogicalDevice(), m_descriptorPool, nullptr);
+			m_descriptorPool = VK_NULL_HANDLE;
+			m_descriptorSet = VK_NULL_HANDLE;
+
+			m_layout.Destroy();
+
+			m_nextSlot = 0u;
+			m_freeSlots.clear();
+			m_pendingSlots.clear();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		uint32 BindlessTextureTable::Register(Texture const& _texture)
+		{
+			uint32 slot = c_invalidSlot;
+			if (!m_freeSlots.empty())
+			{
+				slot = m_freeSlots.back();
+				m_freeSlots.pop_back();
+			}
+			else if (m_nextSlot < m_capacity)
+			{
+				slot = m_nextSlot++;
+			}
+			else
+			{
+				throw std::runtime_error("bindless texture table is full!");
+			}
+
+			VkDescriptorImageInfo imageInfo{};
+			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			imageInfo.imageView = _texture.GetTextureImage().GetImageView();
+			imageInfo.sampler = _texture.GetTextureSampler();
+
+			VkWriteDescriptorSet descriptorWrite{};
+			descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrite.dstSet = m_descriptorSet;
+			descriptorWrite.dstBinding = 0;
+			descriptorWrite.dstArrayElement = slot;
+			descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			descriptorWrite.descriptorCount = 1;
+			descriptorWrite.pImageInfo = &imageInfo;
+
+			vkUpdateDescriptorSets(m_renderer.GetDevice().GetLogicalDevice(), 1, &descriptorWrite, 0, nullptr);
+
+			return slot;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void BindlessTextureTable::Unregister(uint32 _slot)
+		{
+			if (_slot == c_invalidSlot || _slot >= m_nextSlot)
+			{
+				return;
+			}
+
+			// Command buffers already submitted may still sample the descriptor, so it can't be overwritten until the current
+			// frame comes round again. The stale descriptor stays in the array meanwhile, nothing new indexes it.
+			m_pendingSlots[m_currentFrame].push_back(_slot);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void BindlessTextureTable::BeginFrame(uint32 _frame)
+		{
+			if (m_pendingSlots.empty())
+			{
+				return;
+			}
+
+			// Everything released the last time this frame was current was released before the frames since were recorded,
+			// and this frame's own work has finished
+			m_currentFrame = _frame;
+			std::vector<uint32>& released = m_pendingSlots[m_currentFrame];
+			m_freeSlots.insert(m_freeSlots.end(), released.begin(), released.end());
+			released.clear();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		uint32 BindlessTextureTable::GetRegisteredCount() const
+		{
+			size_t pendingCount = 0u;
+			for (std::vector<uint32> const& pending : m_pendingSlots)
+			{
+				pendingCount += pending.size();
+			}
+			return m_nextSlot - static_cast<uint32>(m_freeSlots.size() + pendingCount);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void BindlessTextureTable::Bind(VkCommandBuffer _commandBuffer, VkPipelineLayout _pipelineLayout, uint32 _setIndex) const
+		{
+			vkCmdBindDescriptorSets(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, _setIndex, 1, &m_descriptorSet, 0, nullptr);
+		}
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include <Singularity.Core/CoreDeclare.h>
+#include <Singularity.Render/DescriptorLayout.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		class Renderer;
+		class Texture;
+
+		// One global, partially bound array of every loaded texture. Textures register into stable slots that shaders
+		// index with a per-draw texture ID, so draws using different textures can share a single descriptor set.
+		class BindlessTextureTable
+		{
+		public:
+			BindlessTextureTable(Renderer& _renderer) : m_renderer(_renderer), m_layout(_renderer) {}
+
+			void Create(uint32 _framesInFlight);
+			void Destroy();
+
+			uint32 Register(Texture const& _texture);
+			void Unregister(uint32 _slot); // The slot only becomes free again once every frame that might still sample it has finished
+			void BeginFrame(uint32 _frame); // Call once the frame's fence has signalled
+
+			void Bind(VkCommandBuffer _commandBuffer, VkPipelineLayout _pipelineLayout, uint32 _setIndex) const;
+
+			DescriptorLayout const& GetLayout() const { return m_layout; }
+			uint32 GetCapacity() const { return m_capacity; }
+			uint32 GetRegisteredCount() const; // Slots waiting on in flight frames aren't counted
+
+			static uint32 constexpr c_invalidSlot = UINT32_MAX;
+
+		private:
+			static uint32 constexpr c_maxTextures = 4096u;
+
+			Renderer& m_renderer;
+
+			DescriptorLayout m_layout;
+			VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+			VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+
+			uint32 m_capacity = 0u;
+			uint32 m_nextSlot = 0u;
+			std::vector<uint32> m_freeSlots;
+			std::vector<std::vector<uint32>> m_pendingSlots; // Per frame in flight, released while that frame was current
+			uint32 m_currentFrame = 0u;
+		};
+	}
+}
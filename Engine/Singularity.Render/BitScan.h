@@ -0,0 +1,25 @@
+#pragma once
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		// Index of the lowest set bit of a non-zero mask. Static so the AVX2 file never shares its copy with the rest.
+		static inline uint32 CountTrailingZeros(uint32 _mask)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward(&index, _mask);
+			return static_cast<uint32>(index);
+#else
+			return static_cast<uint32>(__builtin_ctz(_mask));
+#endif
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,448 @@
+#include "Bvh.h"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+#include <Singularity.Core/Parallel.h>
+#include <Singularity.Render/FrustumCuller.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		namespace
+		{
+			float HalfArea(glm::vec3 const& _minimum, glm::vec3 const& _maximum)
+			{
+				glm::vec3 const extent = _maximum - _minimum;
+				return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+			}
+
+			glm::vec3 GetMinimum(CullBounds const& _bounds, uint32 _object)
+			{
+				return glm::vec3(_bounds.m_minimumX[_object], _bounds.m_minimumY[_object], _bounds.m_minimumZ[_object]);
+			}
+
+			glm::vec3 GetMaximum(CullBounds const& _bounds, uint32 _object)
+			{
+				return glm::vec3(_bounds.m_maximumX[_object], _bounds.m_maximumY[_object], _bounds.m_maximumZ[_object]);
+			}
+
+			// Distance along the ray to where it enters the box, FLT_MAX when it misses
+			float IntersectBox(glm::vec3 const& _origin, glm::vec3 const& _inverseDirection, float _maxDistance, glm::vec3 const& _minimum, glm::vec3 const& _maximum)
+			{
+				glm::vec3 const t0 = (_minimum - _origin) * _inverseDirection;
+				glm::vec3 const t1 = (_maximum - _origin) * _inverseDirection;
+				glm::vec3 const tNear = glm::min(t0, t1);
+				glm::vec3 const tFar = glm::max(t0, t1);
+
+				float const enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+				float const exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, _maxDistance));
+				return enter <= exit ? enter : FLT_MAX;
+			}
+
+			bool OverlapsSphere(glm::vec3 const& _centre, float _radiusSquared, glm::vec3 const& _minimum, glm::vec3 const& _maximum)
+			{
+				glm::vec3 const offset = _centre - glm::clamp(_centre, _minimum, _maximum);
+				return glm::dot(offset, offset) <= _radiusSquared;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Bvh::Build(CullBounds const& _bounds)
+		{
+			uint32 const count = _bounds.GetCount();
+
+			m_nodes.clear();
+			m_objects.resize(count);
+			std::iota(m_objects.begin(), m_objects.end(), 0u);
+			if (count == 0u)
+			{
+				return;
+			}
+
+			m_centroids.resize(count);
+			Core::ParallelFor(count, c_minPerWorker, [&](uint32 _begin, uint32 _end, uint32)
+			{
+				for (uint32 i = _begin; i < _end; ++i)
+				{
+					m_centroids[i] = (GetMinimum(_bounds, i) + GetMaximum(_bounds, i)) * 0.5f;
+				}
+			});
+
+			// A binary tree with at least one object per leaf never needs more than this, so node indices stay stable
+			m_nodes.reserve(count * 2u - 1u);
+			BvhNode& root = m_nodes.emplace_back();
+			root.m_first = 0u;
+			root.m_count = count;
+			UpdateNodeBounds(root, _bounds);
+
+			Subdivide(0u, _bounds);
+
+			m_centroids.clear();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Bvh::Refit(CullBounds const& _bounds)
+		{
+			// Children are always created after their parent, so walking backwards visits them first
+			for (uint32 i = GetNodeCount(); i-- > 0u;)
+			{
+				BvhNode& node = m_nodes[i];
+				if (node.IsLeaf())
+				{
+					UpdateNodeBounds(node, _bounds);
+					continue;
+				}
+
+				BvhNode const& left = m_nodes[node.m_left];
+				BvhNode const& right = m_nodes[node.m_left + 1u];
+				node.m_minimum = glm::min(left.m_minimum, right.m_minimum);
+				node.m_maximum = glm::max(left.m_maximum, right.m_maximum);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Bvh::Clear()
+		{
+			m_nodes.clear();
+			m_objects.clear();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Bvh::QueryFrustum(Frustum const& _frustum, CullBounds const& _bounds, std::vector<uint32>& o_visible) const
+		{
+			if (m_nodes.empty())
+			{
+				return;
+			}
+
+			uint32 stack[c_maxDepth + 2u];
+			uint32 stackSize = 0u;
+			stack[stackSize++] = 0u;
+
+			while (stackSize > 0u)
+			{
+				BvhNode const& node = m_nodes[stack[--stackSize]];
+
+				bool outside = false;
+				bool inside = true;
+				for (glm::vec4 const& plane : _frustum.m_planes)
+				{
+					glm::vec3 const normal(plane);
+					glm::vec3 const positive(normal.x >= 0.0f ? node.m_maximum.x : node.m_minimum.x, normal.y >= 0.0f ? node.m_maximum.y : node.m_minimum.y, normal.z >= 0.0f ? node.m_maximum.z : node.m_minimum.z);
+					if (glm::dot(normal, positive) + plane.w < 0.0f)
+					{
+						outside = true;
+						break;
+					}
+
+					glm::vec3 const negative(normal.x >= 0.0f ? node.m_minimum.x : node.m_maximum.x, normal.y >= 0.0f ? node.m_minimum.y : node.m_maximum.y, normal.z >= 0.0f ? node.m_minimum.z : node.m_maximum.z);
+					inside = inside && glm::dot(normal, negative) + plane.w >= 0.0f;
+				}
+
+				if (outside)
+				{
+					continue;
+				}
+
+				if (inside)
+				{
+					// Whole subtree is in view, nothing under it needs testing
+					o_visible.insert(o_visible.end(), m_objects.begin() + node.m_first, m_objects.begin() + node.m_first + node.m_count);
+					continue;
+				}
+
+				if (node.IsLeaf())
+				{
+					for (uint32 i = node.m_first; i < node.m_first + node.m_count; ++i)
+					{
+						uint32 const object = m_objects[i];
+						if (_frustum.IntersectsSphere(_bounds.GetCentre(object), _bounds.m_radius[object]) && _frustum.IntersectsBox(GetMinimum(_bounds, object), GetMaximum(_bounds, object)))
+						{
+							o_visible.push_back(object);
+						}
+					}
+					continue;
+				}
+
+				stack[stackSize++] = node.m_left + 1u;
+				stack[stackSize++] = node.m_left;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Bvh::QuerySphere(glm::vec3 const& _centre, float _radius, CullBounds const& _bounds, std::vector<uint32>& o_objects) const
+		{
+			if (m_nodes.empty())
+			{
+				return;
+			}
+
+			float const radiusSquared = _radius * _radius;
+
+			uint32 stack[c_maxDepth + 2u];
+			uint32 stackSize = 0u;
+			stack[stackSize++] = 0u;
+
+			while (stackSize > 0u)
+			{
+				BvhNode const& node = m_nodes[stack[--stackSize]];
+				if (!OverlapsSphere(_centre, radiusSquared, node.m_minimum, node.m_maximum))
+				{
+					continue;
+				}
+
+				if (node.IsLeaf())
+				{
+					for (uint32 i = node.m_first; i < node.m_first + node.m_count; ++i)
+					{
+						uint32 const object = m_objects[i];
+						if (OverlapsSphere(_centre, radiusSquared, GetMinimum(_bounds, object), GetMaximum(_bounds, object)))
+						{
+							o_objects.push_back(object);
+						}
+					}
+					continue;
+				}
+
+				stack[stackSize++] = node.m_left + 1u;
+				stack[stackSize++] = node.m_left;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		bool Bvh::Raycast(glm::vec3 const& _origin, glm::vec3 const& _direction, float _maxDistance, CullBounds const& _bounds, RayHit& o_hit) const
+		{
+			o_hit = RayHit();
+			if (m_nodes.empty())
+			{
+				return false;
+			}
+
+			glm::vec3 const inverseDirection = 1.0f / _direction;
+			float closest = _maxDistance;
+
+			uint32 stack[c_maxDepth + 2u];
+			uint32 stackSize = 0u;
+			stack[stackSize++] = 0u;
+
+			while (stackSize > 0u)
+			{
+				BvhNode const& node = m_nodes[stack[--stackSize]];
+				if (IntersectBox(_origin, inverseDirection, closest, node.m_minimum, node.m_maximum) == FLT_MAX)
+				{
+					continue;
+				}
+
+				if (node.IsLeaf())
+				{
+					for (uint32 i = node.m_first; i < node.m_first + node.m_count; ++i)
+					{
+						uint32 const object = m_objects[i];
+						float const distance = IntersectBox(_origin, inverseDirection, closest, GetMinimum(_bounds, object), GetMaximum(_bounds, object));
+						if (distance < o_hit.m_distance)
+						{
+							o_hit.m_object = object;
+							o_hit.m_distance = distance;
+							closest = distance;
+						}
+					}
+					continue;
+				}
+
+				// Nearer child goes on top so hits found there prune the other side
+				BvhNode const& left = m_nodes[node.m_left];
+				BvhNode const& right = m_nodes[node.m_left + 1u];
+				float const leftDistance = IntersectBox(_origin, inverseDirection, closest, left.m_minimum, left.m_maximum);
+				float const rightDistance = IntersectBox(_origin, inverseDirection, closest, right.m_minimum, right.m_maximum);
+				uint32 const nearChild = leftDistance < rightDistance ? node.m_left : node.m_left + 1u;
+				uint32 const farChild = leftDistance < rightDistance ? node.m_left + 1u : node.m_left;
+				if (std::max(leftDistance, rightDistance) != FLT_MAX)
+				{
+					stack[stackSize++] = farChild;
+				}
+				if (std::min(leftDistance, rightDistance) != FLT_MAX)
+				{
+					stack[stackSize++] = nearChild;
+				}
+			}
+
+			return o_hit.m_object != UINT32_MAX;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Bvh::Subdivide(uint32 _root, CullBounds const& _bounds)
+		{
+			std::vector<std::pair<uint32, uint32>> pending = { { _root, 0u } };
+			while (!pending.empty())
+			{
+				uint32 const nodeIndex = pending.back().first;
+				uint32 const depth = pending.back().second;
+				pending.pop_back();
+
+				// Depth is capped so queries can traverse with a fixed size stack
+				BvhNode& node = m_nodes[nodeIndex];
+				if (node.m_count <= c_maxLeafSize || depth >= c_maxDepth)
+				{
+					continue;
+				}
+
+				// Bins are spread over where the centroids are, not the boxes, so big objects don't squash them together
+				glm::vec3 centroidMinimum(FLT_MAX);
+				glm::vec3 centroidMaximum(-FLT_MAX);
+				for (uint32 i = node.m_first; i < node.m_first + node.m_count; ++i)
+				{
+					centroidMinimum = glm::min(centroidMinimum, m_centroids[m_objects[i]]);
+					centroidMaximum = glm::max(centroidMaximum, m_centroids[m_objects[i]]);
+				}
+
+				glm::vec3 const extent = centroidMaximum - centroidMinimum;
+				glm::vec3 binScale(0.0f);
+				for (uint32 axis = 0; axis < 3u; ++axis)
+				{
+					binScale[axis] = extent[axis] > 0.0f ? c_binCount / extent[axis] : 0.0f;
+				}
+
+				if (binScale == glm::vec3(0.0f))
+				{
+					// Every centroid in the same spot, no plane can separate them
+					continue;
+				}
+
+				FillBins(node, centroidMinimum, binScale, _bounds);
+
+				uint32 bestAxis = 0u;
+				uint32 bestSplit = 0u;
+				float bestCost = FLT_MAX;
+				for (uint32 axis = 0; axis < 3u; ++axis)
+				{
+					if (binScale[axis] == 0.0f)
+					{
+						continue;
+					}
+
+					Bin const* bins = &m_bins[axis * c_binCount];
+
+					// Sweep from the right first so each split's cost is one pass from the left
+					float rightArea[c_binCount];
+					uint32 rightCount[c_binCount];
+					Bin right;
+					for (uint32 i = c_binCount - 1u; i > 0u; --i)
+					{
+						right.m_minimum = glm::min(right.m_minimum, bins[i].m_minimum);
+						right.m_maximum = glm::max(right.m_maximum, bins[i].m_maximum);
+						right.m_count += bins[i].m_count;
+						rightArea[i] = right.m_count > 0u ? HalfArea(right.m_minimum, right.m_maximum) : 0.0f;
+						rightCount[i] = right.m_count;
+					}
+
+					Bin left;
+					for (uint32 split = 1u; split < c_binCount; ++split)
+					{
+						Bin const& bin = bins[split - 1u];
+						left.m_minimum = glm::min(left.m_minimum, bin.m_minimum);
+						left.m_maximum = glm::max(left.m_maximum, bin.m_maximum);
+						left.m_count += bin.m_count;
+
+						if (left.m_count == 0u || rightCount[split] == 0u)
+						{
+							continue;
+						}
+
+						float const cost = left.m_count * HalfArea(left.m_minimum, left.m_maximum) + rightCount[split] * rightArea[split];
+						if (cost < bestCost)
+						{
+							bestCost = cost;
+							bestAxis = axis;
+							bestSplit = split;
+						}
+					}
+				}
+
+				// Splitting has to beat testing every object in the node directly
+				if (bestCost >= node.m_count * HalfArea(node.m_minimum, node.m_maximum))
+				{
+					continue;
+				}
+
+				float const minimum = centroidMinimum[bestAxis];
+				float const scale = binScale[bestAxis];
+				auto const middle = std::partition(m_objects.begin() + node.m_first, m_objects.begin() + node.m_first + node.m_count, [&](uint32 _object)
+				{
+					uint32 const bin = std::min(c_binCount - 1u, static_cast<uint32>((m_centroids[_object][bestAxis] - minimum) * scale));
+					return bin < bestSplit;
+				});
+
+				uint32 const leftCount = static_cast<uint32>(middle - (m_objects.begin() + node.m_first));
+
+				uint32 const leftIndex = GetNodeCount();
+				BvhNode& left = m_nodes.emplace_back();
+				left.m_first = node.m_first;
+				left.m_count = leftCount;
+				UpdateNodeBounds(left, _bounds);
+
+				BvhNode& right = m_nodes.emplace_back();
+				right.m_first = node.m_first + leftCount;
+				right.m_count = node.m_count - leftCount;
+				UpdateNodeBounds(right, _bounds);
+
+				m_nodes[nodeIndex].m_left = leftIndex;
+				pending.emplace_back(leftIndex + 1u, depth + 1u);
+				pending.emplace_back(leftIndex, depth + 1u);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Bvh::UpdateNodeBounds(BvhNode& io_node, CullBounds const& _bounds) const
+		{
+			io_node.m_minimum = glm::vec3(FLT_MAX);
+			io_node.m_maximum = glm::vec3(-FLT_MAX);
+			for (uint32 i = io_node.m_first; i < io_node.m_first + io_node.m_count; ++i)
+			{
+				io_node.m_minimum = glm::min(io_node.m_minimum, GetMinimum(_bounds, m_objects[i]));
+				io_node.m_maximum = glm::max(io_node.m_maximum, GetMaximum(_bounds, m_objects[i]));
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Bvh::FillBins(BvhNode const& _node, glm::vec3 const& _centroidMinimum, glm::vec3 const& _binScale, CullBounds const& _bounds)
+		{
+			uint32 const binsPerWorker = 3u * c_binCount;
+			m_bins.assign(Core::GetWorkerCount() * binsPerWorker, Bin());
+
+			// Each worker bins its own slice of the node, the slices are merged afterwards
+			Core::ParallelFor(_node.m_count, c_minPerWorker, [&](uint32 _begin, uint32 _end, uint32 _worker)
+			{
+				Bin* const bins = &m_bins[_worker * binsPerWorker];
+				for (uint32 i = _node.m_first + _begin; i < _node.m_first + _end; ++i)
+				{
+					uint32 const object = m_objects[i];
+					glm::vec3 const position = (m_centroids[object] - _centroidMinimum) * _binScale;
+					glm::vec3 const minimum = GetMinimum(_bounds, object);
+					glm::vec3 const maximum = GetMaximum(_bounds, object);
+
+					for (uint32 axis = 0; axis < 3u; ++axis)
+					{
+						Bin& bin = bins[axis * c_binCount + std::min(c_binCount - 1u, static_cast<uint32>(position[axis]))];
+						bin.m_minimum = glm::min(bin.m_minimum, minimum);
+						bin.m_maximum = glm::max(bin.m_maximum, maximum);
+						++bin.m_count;
+					}
+				}
+			});
+
+			for (uint32 worker = 1u; worker < Core::GetWorkerCount(); ++worker)
+			{
+				for (uint32 i = 0; i < binsPerWorker; ++i)
+				{
+					Bin const& workerBin = m_bins[worker * binsPerWorker + i];
+					m_bins[i].m_minimum = glm::min(m_bins[i].m_minimum, workerBin.m_minimum);
+					m_bins[i].m_maximum = glm::max(m_bins[i].m_maximum, workerBin.m_maximum);
+					m_bins[i].m_count += workerBin.m_count;
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cfloat>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include <Singularity.Core/CoreDeclare.h>
+#include <Singularity.Render/Frustum.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		struct CullBounds;
+
+		struct BvhNode
+		{
+			glm::vec3 m_minimum = glm::vec3(FLT_MAX);
+			uint32 m_first = 0u; // Objects under a node are contiguous in the object list
+			glm::vec3 m_maximum = glm::vec3(-FLT_MAX);
+			uint32 m_count = 0u;
+			uint32 m_left = 0u; // Right child follows the left, zero for leaves since the root is never a child
+
+			bool IsLeaf() const { return m_left == 0u; }
+		};
+
+		struct RayHit
+		{
+			uint32 m_object = UINT32_MAX;
+			float m_distance = FLT_MAX;
+		};
+
+		// Bounding volume hierarchy over world space object boxes, built top down with a binned surface area heuristic.
+		// Binning for large nodes is spread across workers. Objects that move keep their leaf and are handled by Refit,
+		// which only grows or shrinks boxes bottom up, so a Build is only needed when objects are added or removed.
+		class Bvh
+		{
+		public:
+			void Build(CullBounds const& _bounds);
+			void Refit(CullBounds const& _bounds);
+			void Clear();
+
+			void QueryFrustum(Frustum const& _frustum, CullBounds const& _bounds, std::vector<uint32>& o_visible) const;
+			void QuerySphere(glm::vec3 const& _centre, float _radius, CullBounds const& _bounds, std::vector<uint32>& o_objects) const;
+			bool Raycast(glm::vec3 const& _origin, glm::vec3 const& _direction, float _maxDistance, CullBounds const& _bounds, RayHit& o_hit) const;
+
+			uint32 GetObjectCount() const { return static_cast<uint32>(m_objects.size()); }
+			uint32 GetNodeCount() const { return static_cast<uint32>(m_nodes.size()); }
+			std::vector<BvhNode> const& GetNodes() const { return m_nodes; }
+
+		private:
+			struct Bin
+			{
+				glm::vec3 m_minimum = glm::vec3(FLT_MAX);
+				glm::vec3 m_maximum = glm::vec3(-FLT_MAX);
+				uint32 m_count = 0u;
+			};
+
+			void Subdivide(uint32 _root, CullBounds const& _bounds);
+			void UpdateNodeBounds(BvhNode& io_node, CullBounds const& _bounds) const;
+			void FillBins(BvhNode const& _node, glm::vec3 const& _centroidMinimum, glm::vec3 const& _binScale, CullBounds const& _bounds);
+
+			static uint32 constexpr c_binCount = 16u;
+			static uint32 constexpr c_maxLeafSize = 4u;
+			static uint32 constexpr c_maxDepth = 62u;
+			static uint32 constexpr c_minPerWorker = 16384u; // Nodes smaller than this are binned on the calling thread
+
+			std::vector<BvhNode> m_nodes;
+			std::vector<uint32> m_objects; // Object indices, reordered so every node owns one contiguous range
+			std::vector<glm::vec3> m_centroids; // Only valid during Build
+			std::vector<Bin> m_bins; // Three axes of c_binCount bins per worker, merged into the first worker's set
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "DescriptorAllocator.h"
+
+#include <array>
+#include <utility>
+
+#include <Singularity.Render/Renderer.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		namespace
+		{
+			// Descriptors of each type reserved per set in a pool
+			std::array<std::pair<VkDescriptorType, float>, 4> constexpr c_poolSizeRatios = { {
+				{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+				{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2.0f },
+				{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1.0f },
+				{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 0.5f }
+			} };
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		VkDescriptorSet DescriptorAllocator::Allocate(VkDescriptorSetLayout _layout)
+		{
+			if (m_currentPool == VK_NULL_HANDLE)
+			{
+				m_currentPool = GrabPool();
+				m_usedPools.push_back(m_currentPool);
+			}
+
+			VkDescriptorSetAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocInfo.descriptorPool = m_currentPool;
+			allocInfo.descriptorSetCount = 1;
+			allocInfo.pSetLayouts = &_layout;
+
+			VkDevice const logicalDevice = m_renderer.GetDevice().GetLogicalDevice();
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+			VkResult result = vkAllocateDescriptorSets(logicalDevice, &allocInfo, &descriptorSet);
+
+			if (result == VK_ERROR_FRAGMENTED_POOL || result == VK_ERROR_OUT_OF_POOL_MEMORY)
+			{
+				// Current pool is exhausted, move on to the next one in the chain
+				m_currentPool = GrabPool();
+				m_usedPools.push_back(m_currentPool);
+
+				allocInfo.descriptorPool = m_currentPool;
+				result = vkAllocateDescriptorSets(logicalDevice, &allocInfo, &descriptorSet);
+			}
+
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error("failed to allocate descriptor set!");
+			}
+
+			return descriptorSet;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void DescriptorAllocator::Reset()
+		{
+			VkDevice const logicalDevice = m_renderer.GetDevice().GetLogicalDevice();
+			for (VkDescriptorPool pool : m_usedPools)
+			{
+				vkResetDescriptorPool(logicalDevice, pool, 0);
+				m_freePools.push_back(pool);
+			}
+
+			m_usedPools.clear();
+			m_currentPool = VK_NULL_HANDLE;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void DescriptorAllocator::Shutdown()
+		{
+			VkDevice const logicalDevice = m_renderer.GetDevice().GetLogicalDevice();
+			for (VkDescriptorPool pool : m_usedPools)
+			{
+				vkDestroyDescriptorPool(logicalDevice, pool, nullptr);
+			}
+
+			for (VkDescriptorPool pool : m_freePools)
+			{
+				vkDestroyDescriptorPool(logicalDevice, pool, nullptr);
+			}
+
+			m_usedPools.clear();
+			m_freePools.clear();
+			m_currentPool = VK_NULL_HANDLE;
+			m_setsPerPool = c_initialSetsPerPool;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		VkDescriptorPool DescriptorAllocator::GrabPool()
+		{
+			if (!m_freePools.empty())
+			{
+				VkDescriptorPool const pool = m_freePools.back();
+				m_freePools.pop_back();
+				return pool;
+			}
+
+			// Each new pool is bigger than the last so large scenes settle on a handful of pools
+			VkDescriptorPool const pool = CreatePool(m_setsPerPool);
+			m_setsPerPool = std::min(m_setsPerPool * 2u, c_maxSetsPerPool);
+			return pool;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		VkDescriptorPool DescriptorAllocator::CreatePool(uint32 _maxSets) const
+		{
+			std::array<VkDescriptorPoolSize, c_poolSizeRatios.size()> poolSizes{};
+			for (size_t i = 0; i < c_poolSizeRatios.size(); ++i)
+			{
+				poolSizes[i].type = c_poolSizeRatios[i].first;
+				poolSizes[i].descriptorCount = std::max(1u, static_cast<uint32>(c_poolSizeRatios[i].second * _maxSets));
+			}
+
+			VkDescriptorPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+			poolInfo.flags = 0;
+			poolInfo.poolSizeCount = static_cast<uint32>(poolSizes.size());
+			poolInfo.pPoolSizes = poolSizes.data();
+			poolInfo.maxSets = _maxSets;
+
+			VkDescriptorPool pool;
+			if (vkCreateDescriptorPool(m_renderer.GetDevice().GetLogicalDevice(), &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create descriptor pool!");
+			}
+
+			return pool;
+		}
+	}
+}
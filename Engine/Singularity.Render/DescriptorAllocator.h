@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		class Renderer;
+
+		// Hands out descriptor sets from a chain of pools, growing the chain whenever the current pool runs dry.
+		// Long-lived allocators keep their sets until Shutdown, transient ones are Reset once the frame that used them has retired.
+		class DescriptorAllocator
+		{
+		public:
+			DescriptorAllocator(Renderer& _renderer) : m_renderer(_renderer) {}
+
+			VkDescriptorSet Allocate(VkDescriptorSetLayout _layout);
+			void Reset();
+			void Shutdown();
+
+			uint64 GetPoolCount() const { return m_usedPools.size() + m_freePools.size(); }
+
+		private:
+			VkDescriptorPool GrabPool();
+			VkDescriptorPool CreatePool(uint32 _maxSets) const;
+
+			static uint32 constexpr c_initialSetsPerPool = 64u;
+			static uint32 constexpr c_maxSetsPerPool = 4096u;
+
+			Renderer& m_renderer;
+
+			VkDescriptorPool m_currentPool = VK_NULL_HANDLE;
+			std::vector<VkDescriptorPool> m_usedPools;
+			std::vector<VkDescriptorPool> m_freePools;
+			uint32 m_setsPerPool = c_initialSetsPerPool;
+		};
+	}
+}
@@ -0,0 +1,230 @@
+#include "DescriptorLayout.h"
+
+#include <Singularity.Render/DescriptorSetCache.h>
+#include <Singularity.Render/Renderer.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		//////////////////////////////////////////////////////////////////////////////////////
+		void DescriptorLayout::AddBinding(uint32 _binding, VkDescriptorType _type, VkShaderStageFlags _stages, uint32 _count, VkDescriptorBindingFlags _flags)
+		{
+			if (m_layout)
+			{
+				throw std::runtime_error("can't add bindings to a created descriptor layout!");
+			}
+
+			Entry entry;
+			entry.m_layoutBinding.binding = _binding;
+			entry.m_layoutBinding.descriptorType = _type;
+			entry.m_layoutBinding.descriptorCount = _count;
+			entry.m_layoutBinding.stageFlags = _stages;
+			entry.m_layoutBinding.pImmutableSamplers = nullptr;
+			entry.m_flags = _flags;
+
+			entry.m_stride = IsImageDescriptor(_type) ? sizeof(VkDescriptorImageInfo) : sizeof(VkDescriptorBufferInfo);
+			entry.m_offset = m_dataSize;
+			m_dataSize += entry.m_stride * _count;
+
+			m_entries.push_back(entry);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void DescriptorLayout::Create()
+		{
+			std::vector<VkDescriptorSetLayoutBinding> bindings;
+			std::vector<VkDescriptorBindingFlags> bindingFlags;
+			bindings.reserve(m_entries.size());
+			bindingFlags.reserve(m_entries.size());
+			VkDescriptorBindingFlags allFlags = 0u;
+			for (Entry const& entry : m_entries)
+			{
+				bindings.push_back(entry.m_layoutBinding);
+				bindingFlags.push_back(entry.m_flags);
+				allFlags |= entry.m_flags;
+			}
+
+			VkDescriptorSetLayoutCreateInfo layoutInfo{};
+			layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			layoutInfo.bindingCount = static_cast<uint32>(bindings.size());
+			layoutInfo.pBindings = bindings.data();
+
+			// Descriptor indexing flags (partially bound, update after bind...) are only chained in when a binding asks for them
+			VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+			bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+			bindingFlagsInfo.bindingCount = static_cast<uint32>(bindingFlags.size());
+			bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+			if (allFlags != 0u)
+			{
+				layoutInfo.pNext = &bindingFlagsInfo;
+			}
+
+			if (allFlags & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT)
+			{
+				layoutInfo.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+			}
+
+			if (vkCreateDescriptorSetLayout(m_renderer.GetDevice().GetLogicalDevice(), &layoutInfo, nullptr, &m_layout) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create descriptor set layout!");
+			}
+
+			// Update templates are core in 1.1, older devices fall back to plain descriptor writes built from the same description
+			if (m_renderer.GetDevice().GetProperties().apiVersion >= VK_API_VERSION_1_1)
+			{
+				CreateUpdateTemplate();
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void DescriptorLayout::Destroy()
+		{
+			VkDevice const logicalDevice = m_renderer.GetDevice().GetLogicalDevice();
+			if (m_updateTemplate)
+			{
+				vkDestroyDescriptorUpdateTemplate(logicalDevice, m_updateTemplate, nullptr);
+				m_updateTemplate = VK_NULL_HANDLE;
+			}
+
+			vkDestroyDescriptorSetLayout(logicalDevice, m_layout, nullptr);
+			m_layout = VK_NULL_HANDLE;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		size_t DescriptorLayout::GetBindingOffset(uint32 _binding) const
+		{
+			for (Entry const& entry : m_entries)
+			{
+				if (entry.m_layoutBinding.binding == _binding)
+				{
+					return entry.m_offset;
+				}
+			}
+
+			throw std::runtime_error("descriptor layout has no such binding!");
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		std::vector<uint8> DescriptorLayout::Pack(std::vector<DescriptorBinding> const& _bindings) const
+		{
+			std::vector<uint8> data(m_dataSize, 0u);
+			for (DescriptorBinding const& binding : _bindings)
+			{
+				uint8* const target = data.data() + GetBindingOffset(binding.m_binding);
+				if (IsImageDescriptor(binding.m_type))
+				{
+					memcpy(target, &binding.m_imageInfo, sizeof(VkDescriptorImageInfo));
+				}
+				else
+				{
+					memcpy(target, &binding.m_bufferInfo, sizeof(VkDescriptorBufferInfo));
+				}
+			}
+			return data;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void DescriptorLayout::Write(VkDescriptorSet _set, void const* _data) const
+		{
+			VkDevice const logicalDevice = m_renderer.GetDevice().GetLogicalDevice();
+			if (m_updateTemplate)
+			{
+				vkUpdateDescriptorSetWithTemplate(logicalDevice, _set, m_updateTemplate, _data);
+				return;
+			}
+
+			std::vector<VkWriteDescriptorSet> writes;
+			AppendWrites(_set, static_cast<uint8 const*>(_data), writes);
+			vkUpdateDescriptorSets(logicalDevice, static_cast<uint32>(writes.size()), writes.data(), 0, nullptr);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void DescriptorLayout::Write(std::vector<VkDescriptorSet> const& _sets, void const* _data, size_t _stride) const
+		{
+			VkDevice const logicalDevice = m_renderer.GetDevice().GetLogicalDevice();
+			uint8 const* const data = static_cast<uint8 const*>(_data);
+
+			if (m_updateTemplate)
+			{
+				for (size_t i = 0; i < _sets.size(); ++i)
+				{
+					vkUpdateDescriptorSetWithTemplate(logicalDevice, _sets[i], m_updateTemplate, data + i * _stride);
+				}
+				return;
+			}
+
+			// Without templates, every set goes out in one vkUpdateDescriptorSets call
+			std::vector<VkWriteDescriptorSet> writes;
+			writes.reserve(_sets.size() * m_entries.size());
+			for (size_t i = 0; i < _sets.size(); ++i)
+			{
+				AppendWrites(_sets[i], data + i * _stride, writes);
+			}
+			vkUpdateDescriptorSets(logicalDevice, static_cast<uint32>(writes.size()), writes.data(), 0, nullptr);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		bool DescriptorLayout::IsImageDescriptor(VkDescriptorType _type)
+		{
+			return _type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+				|| _type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE
+				|| _type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+				|| _type == VK_DESCRIPTOR_TYPE_SAMPLER
+				|| _type == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void DescriptorLayout::CreateUpdateTemplate()
+		{
+			std::vector<VkDescriptorUpdateTemplateEntry> templateEntries;
+			templateEntries.reserve(m_entries.size());
+			for (Entry const& entry : m_entries)
+			{
+				VkDescriptorUpdateTemplateEntry templateEntry{};
+				templateEntry.dstBinding = entry.m_layoutBinding.binding;
+				templateEntry.dstArrayElement = 0;
+				templateEntry.descriptorCount = entry.m_layoutBinding.descriptorCount;
+				templateEntry.descriptorType = entry.m_layoutBinding.descriptorType;
+				templateEntry.offset = entry.m_offset;
+				templateEntry.stride = entry.m_stride;
+				templateEntries.push_back(templateEntry);
+			}
+
+			VkDescriptorUpdateTemplateCreateInfo templateInfo{};
+			templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+			templateInfo.descriptorUpdateEntryCount = static_cast<uint32>(templateEntries.size());
+			templateInfo.pDescriptorUpdateEntries = templateEntries.data();
+			templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+			templateInfo.descriptorSetLayout = m_layout;
+
+			if (vkCreateDescriptorUpdateTemplate(m_renderer.GetDevice().GetLogicalDevice(), &templateInfo, nullptr, &m_updateTemplate) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create descriptor update template!");
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void DescriptorLayout::AppendWrites(VkDescriptorSet _set, uint8 const* _data, std::vector<VkWriteDescriptorSet>& o_writes) const
+		{
+			for (Entry const& entry : m_entries)
+			{
+				VkWriteDescriptorSet descriptorWrite{};
+				descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				descriptorWrite.dstSet = _set;
+				descriptorWrite.dstBinding = entry.m_layoutBinding.binding;
+				descriptorWrite.dstArrayElement = 0;
+				descriptorWrite.descriptorType = entry.m_layoutBinding.descriptorType;
+				descriptorWrite.descriptorCount = entry.m_layoutBinding.descriptorCount;
+				if (IsImageDescriptor(entry.m_layoutBinding.descriptorType))
+				{
+					descriptorWrite.pImageInfo = reinterpret_cast<VkDescriptorImageInfo const*>(_data + entry.m_offset);
+				}
+				else
+				{
+					descriptorWrite.pBufferInfo = reinterpret_cast<VkDescriptorBufferInfo const*>(_data + entry.m_offset);
+				}
+				o_writes.push_back(descriptorWrite);
+			}
+		}
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		class Renderer;
+		struct DescriptorBinding;
+
+		// Describes the bindings of a descriptor set layout. From that description it builds both the VkDescriptorSetLayout
+		// and a VkDescriptorUpdateTemplate, so a whole set can be written from one packed struct in a single call.
+		// The packed struct holds one VkDescriptorBufferInfo/VkDescriptorImageInfo per descriptor, in binding order.
+		class DescriptorLayout
+		{
+		public:
+			DescriptorLayout(Renderer& _renderer) : m_renderer(_renderer) {}
+
+			void AddBinding(uint32 _binding, VkDescriptorType _type, VkShaderStageFlags _stages, uint32 _count = 1u, VkDescriptorBindingFlags _flags = 0u);
+
+			void Create();
+			void Destroy();
+
+			VkDescriptorSetLayout GetLayout() const { return m_layout; }
+			bool UsesUpdateTemplate() const { return m_updateTemplate != VK_NULL_HANDLE; }
+
+			size_t GetDataSize() const { return m_dataSize; }
+			size_t GetBindingOffset(uint32 _binding) const;
+			std::vector<uint8> Pack(std::vector<DescriptorBinding> const& _bindings) const;
+
+			void Write(VkDescriptorSet _set, void const* _data) const;
+			void Write(std::vector<VkDescriptorSet> const& _sets, void const* _data, size_t _stride) const;
+
+			static bool IsImageDescriptor(VkDescriptorType _type);
+
+		private:
+			struct Entry
+			{
+				VkDescriptorSetLayoutBinding m_layoutBinding{};
+				VkDescriptorBindingFlags m_flags = 0u;
+				size_t m_offset = 0u;
+				size_t m_stride = 0u;
+			};
+
+			void CreateUpdateTemplate();
+			void AppendWrites(VkDescriptorSet _set, uint8 const* _data, std::vector<VkWriteDescriptorSet>& o_writes) const;
+
+			Renderer& m_renderer;
+
+			std::vector<Entry> m_entries;
+			size_t m_dataSize = 0u;
+
+			VkDescriptorSetLayout m_layout = VK_NULL_HANDLE;
+			VkDescriptorUpdateTemplate m_updateTemplate = VK_NULL_HANDLE;
+		};
+	}
+}
@@ -0,0 +1,95 @@
+#include "DescriptorSetCache.h"
+
+#include <functional>
+
+#include <Singularity.Render/DescriptorAllocator.h>
+#include <Singularity.Render/DescriptorLayout.h>
+#include <Singularity.Render/Renderer.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		namespace
+		{
+			//////////////////////////////////////////////////////////////////////////////////////
+			template<typename T>
+			void HashCombine(size_t& io_seed, T const& _value)
+			{
+				io_seed ^= std::hash<T>()(_value) + 0x9e3779b9 + (io_seed << 6) + (io_seed >> 2);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		DescriptorBinding DescriptorBinding::Buffer(uint32 _binding, VkDescriptorType _type, VkBuffer _buffer, VkDeviceSize _offset, VkDeviceSize _range)
+		{
+			DescriptorBinding binding;
+			binding.m_binding = _binding;
+			binding.m_type = _type;
+			binding.m_bufferInfo.buffer = _buffer;
+			binding.m_bufferInfo.offset = _offset;
+			binding.m_bufferInfo.range = _range;
+			return binding;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		DescriptorBinding DescriptorBinding::Image(uint32 _binding, VkDescriptorType _type, VkImageView _imageView, VkSampler _sampler, VkImageLayout _layout)
+		{
+			DescriptorBinding binding;
+			binding.m_binding = _binding;
+			binding.m_type = _type;
+			binding.m_imageInfo.imageView = _imageView;
+			binding.m_imageInfo.sampler = _sampler;
+			binding.m_imageInfo.imageLayout = _layout;
+			return binding;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		bool DescriptorBinding::operator==(DescriptorBinding const& _other) const
+		{
+			return m_binding == _other.m_binding
+				&& m_type == _other.m_type
+				&& m_bufferInfo.buffer == _other.m_bufferInfo.buffer
+				&& m_bufferInfo.offset == _other.m_bufferInfo.offset
+				&& m_bufferInfo.range == _other.m_bufferInfo.range
+				&& m_imageInfo.imageView == _other.m_imageInfo.imageView
+				&& m_imageInfo.sampler == _other.m_imageInfo.sampler
+				&& m_imageInfo.imageLayout == _other.m_imageInfo.imageLayout;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		size_t DescriptorSetCache::KeyHash::operator()(Key const& _key) const
+		{
+			size_t seed = std::hash<VkDescriptorSetLayout>()(_key.m_layout);
+			for (DescriptorBinding const& binding : _key.m_bindings)
+			{
+				HashCombine(seed, binding.m_binding);
+				HashCombine(seed, static_cast<uint32>(binding.m_type));
+				HashCombine(seed, binding.m_bufferInfo.buffer);
+				HashCombine(seed, binding.m_bufferInfo.offset);
+				HashCombine(seed, binding.m_imageInfo.imageView);
+				HashCombine(seed, binding.m_imageInfo.sampler);
+			}
+			return seed;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		VkDescriptorSet DescriptorSetCache::GetDescriptorSet(DescriptorLayout const& _layout, std::vector<DescriptorBinding> const& _bindings)
+		{
+			Key key{ _layout.GetLayout(), _bindings };
+			auto const existing = m_descriptorSets.find(key);
+			if (existing != m_descriptorSets.end())
+			{
+				return existing->second;
+			}
+
+			VkDescriptorSet const descriptorSet = m_allocator.Allocate(_layout.GetLayout());
+
+			std::vector<uint8> const data = _layout.Pack(_bindings);
+			_layout.Write(descriptorSet, data.data());
+
+			m_descriptorSets.emplace(std::move(key), descriptorSet);
+			return descriptorSet;
+		}
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		class DescriptorAllocator;
+		class DescriptorLayout;
+		class Renderer;
+
+		// A single resource bound into a descriptor set
+		struct DescriptorBinding
+		{
+			static DescriptorBinding Buffer(uint32 _binding, VkDescriptorType _type, VkBuffer _buffer, VkDeviceSize _offset, VkDeviceSize _range);
+			static DescriptorBinding Image(uint32 _binding, VkDescriptorType _type, VkImageView _imageView, VkSampler _sampler, VkImageLayout _layout);
+
+			bool operator==(DescriptorBinding const& _other) const;
+
+			uint32 m_binding = 0u;
+			VkDescriptorType m_type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			VkDescriptorBufferInfo m_bufferInfo{};
+			VkDescriptorImageInfo m_imageInfo{};
+		};
+
+		// Returns an existing descriptor set when the same layout is requested with identical bindings, otherwise allocates and writes a new one
+		class DescriptorSetCache
+		{
+		public:
+			DescriptorSetCache(Renderer& _renderer, DescriptorAllocator& _allocator) : m_renderer(_renderer), m_allocator(_allocator) {}
+
+			VkDescriptorSet GetDescriptorSet(DescriptorLayout const& _layout, std::vector<DescriptorBinding> const& _bindings);
+			void Clear() { m_descriptorSets.clear(); }
+
+			uint64 GetCachedCount() const { return m_descriptorSets.size(); }
+
+		private:
+			struct Key
+			{
+				VkDescriptorSetLayout m_layout = VK_NULL_HANDLE;
+				std::vector<DescriptorBinding> m_bindings;
+
+				bool operator==(Key const& _other) const { return m_layout == _other.m_layout && m_bindings == _other.m_bindings; }
+			};
+
+			struct KeyHash
+			{
+				size_t operator()(Key const& _key) const;
+			};
+
+			Renderer& m_renderer;
+			DescriptorAllocator& m_allocator;
+
+			std::unordered_map<Key, VkDescriptorSet, KeyHash> m_descriptorSets;
+		};
+	}
+}
@@ -67,10 +67,19 @@ namespace Singularity
 			std::vector<VkPhysicalDevice> devices(deviceCount);
 			vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
 
+			// Prefer a discrete GPU but take anything suitable, software implementations included
 			for (const auto& device : devices) {
 				if (IsPhysicalDeviceSuitable(device)) {
-					m_physicalDevice = device;
-					break;
+					VkPhysicalDeviceProperties deviceProperties;
+					vkGetPhysicalDeviceProperties(device, &deviceProperties);
+
+					if (m_physicalDevice == VK_NULL_HANDLE || deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
+						m_physicalDevice = device;
+					}
+
+					if (deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
+						break;
+					}
 				}
 			}
 
@@ -78,10 +87,99 @@ namespace Singularity
 				throw std::runtime_error("failed to find a suitable GPU!");
 			}
 
+			vkGetPhysicalDeviceProperties(m_physicalDevice, &m_physicalDeviceProperties);
+			QueryVulkan12Support();
+			QueryUnifiedMemory();
+			SelectFeatures();
+
 			m_deviceQueueFamilies = FindQueueFamilies(m_physicalDevice);
 			RecalculateSwapChainSupportDetails();
 		}
 
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Device::QueryUnifiedMemory()
+		{
+			// Discrete GPUs can expose a small host visible window of their memory too, only integrated ones share all of it
+			m_unifiedMemory = false;
+			if (m_physicalDeviceProperties.deviceType != VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU)
+			{
+				return;
+			}
+
+			VkPhysicalDeviceMemoryProperties memProperties;
+			vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &memProperties);
+
+			VkMemoryPropertyFlags const unified = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			for (uint32 i = 0; i < memProperties.memoryTypeCount; i++) {
+				if ((memProperties.memoryTypes[i].propertyFlags & unified) == unified) {
+					m_unifiedMemory = true;
+					return;
+				}
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Device::QueryVulkan12Support()
+		{
+			m_vulkan12Properties = {};
+			m_vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+			m_supportedVulkan12Features = {};
+			m_supportedVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+			m_enabledVulkan12Features = {};
+			m_enabledVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+			if (m_physicalDeviceProperties.apiVersion < VK_API_VERSION_1_2)
+			{
+				m_supportsBindlessTextures = false;
+				return;
+			}
+
+			VkPhysicalDeviceProperties2 properties{};
+			properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+			properties.pNext = &m_vulkan12Properties;
+			vkGetPhysicalDeviceProperties2(m_physicalDevice, &properties);
+
+			VkPhysicalDeviceFeatures2 features{};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features.pNext = &m_supportedVulkan12Features;
+			vkGetPhysicalDeviceFeatures2(m_physicalDevice, &features);
+
+			// Bindless textures need a runtime sized, partially bound sampler array that can be updated after binding
+			m_supportsBindlessTextures = m_supportedVulkan12Features.descriptorIndexing
+				&& m_supportedVulkan12Features.runtimeDescriptorArray
+				&& m_supportedVulkan12Features.descriptorBindingPartiallyBound
+				&& m_supportedVulkan12Features.descriptorBindingSampledImageUpdateAfterBind
+				&& m_supportedVulkan12Features.descriptorBindingUpdateUnusedWhilePending
+				&& m_supportedVulkan12Features.shaderSampledImageArrayNonUniformIndexing;
+
+			if (m_supportsBindlessTextures)
+			{
+				m_enabledVulkan12Features.descriptorIndexing = VK_TRUE;
+				m_enabledVulkan12Features.runtimeDescriptorArray = VK_TRUE;
+				m_enabledVulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+				m_enabledVulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+				m_enabledVulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+				m_enabledVulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Device::SelectFeatures()
+		{
+			VkPhysicalDeviceFeatures supportedFeatures;
+			vkGetPhysicalDeviceFeatures(m_physicalDevice, &supportedFeatures);
+
+			m_enabledFeatures = {};
+			m_enabledFeatures.samplerAnisotropy = VK_TRUE;
+
+			// GPU driven rendering writes one indirect command per object, each pointing at its data through firstInstance
+			m_enabledFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+			m_enabledFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+
+			// Lets the culling pass compact the commands and have the GPU read back how many survived
+			m_enabledVulkan12Features.drawIndirectCount = m_supportedVulkan12Features.drawIndirectCount;
+		}
+
 		//////////////////////////////////////////////////////////////////////////////////////
 		bool Device::HasExtensionSupport(VkPhysicalDevice _device) const
 		{
@@ -110,22 +208,9 @@ namespace Singularity
 		//////////////////////////////////////////////////////////////////////////////////////
 		bool Device::IsPhysicalDeviceSuitable(VkPhysicalDevice _device) const
 		{
-			VkPhysicalDeviceProperties deviceProperties;
-			vkGetPhysicalDeviceProperties(_device, &deviceProperties);
-
-			if (deviceProperties.deviceType != VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
-			{
-				return false;
-			}
-
 			VkPhysicalDeviceFeatures deviceFeatures;
 			vkGetPhysicalDeviceFeatures(_device, &deviceFeatures);
 
-			if (!deviceFeatures.geometryShader)
-			{
-				return false;
-			}
-
 			if (!deviceFeatures.samplerAnisotropy) // TODO remove dependancy make optional
 			{
 				return false;
@@ -157,7 +242,8 @@ namespace Singularity
 			QueueFamilies queue;
 			uint32 i = 0;
 			for (const auto& queueFamily : queueFamilies) {
-				if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+				// The culling pass records compute work on the graphics queue
+				if ((queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)) {
 					queue.m_graphicsFamily = i;
 				}
 
@@ -227,14 +313,16 @@ namespace Singularity
 				queueCreateInfos.push_back(GetDeviceQueueCreateInfo(index));
 			}
 
-			VkPhysicalDeviceFeatures deviceFeatures{};
-			deviceFeatures.samplerAnisotropy = VK_TRUE;
-
 			VkDeviceCreateInfo createInfo{};
 			createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 			createInfo.pQueueCreateInfos = queueCreateInfos.data();
 			createInfo.queueCreateInfoCount = static_cast<uint32>(queueCreateInfos.size());
-			createInfo.pEnabledFeatures = &deviceFeatures;
+			createInfo.pEnabledFeatures = &m_enabledFeatures;
+
+			if (m_physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_2)
+			{
+				createInfo.pNext = &m_enabledVulkan12Features;
+			}
 
 			createInfo.enabledExtensionCount = static_cast<uint32>(m_deviceExtensions.size());
 			createInfo.ppEnabledExtensionNames = m_deviceExtensions.data();
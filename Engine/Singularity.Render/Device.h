@@ -40,6 +40,14 @@ namespace Singularity
 
 			VkDevice GetLogicalDevice() const { return m_logicalDevice; }
 			VkPhysicalDevice GetPhysicalDevice() const { return m_physicalDevice; }
+			VkPhysicalDeviceProperties const& GetProperties() const { return m_physicalDeviceProperties; }
+			VkPhysicalDeviceVulkan12Properties const& GetVulkan12Properties() const { return m_vulkan12Properties; }
+			VkPhysicalDeviceVulkan12Features const& GetEnabledVulkan12Features() const { return m_enabledVulkan12Features; }
+
+			bool SupportsBindlessTextures() const { return m_supportsBindlessTextures; }
+			bool SupportsMultiDrawIndirect() const { return m_enabledFeatures.multiDrawIndirect && m_enabledFeatures.drawIndirectFirstInstance; }
+			bool SupportsDrawIndirectCount() const { return m_enabledVulkan12Features.drawIndirectCount; }
+			bool HasUnifiedMemory() const { return m_unifiedMemory; } // Device local memory the CPU can write directly, so uploads can skip staging
 			
 			QueueFamilies const& GetQueueFamilies() const { return m_deviceQueueFamilies; } 
 			SwapChainSupportDetails const& GetSwapChainSupportDetails() const { return m_swapChainSupportDetails; }
@@ -54,8 +62,11 @@ namespace Singularity
 			void SelectPhysicalDevice();
 			void CreateLogicalDevice();
 			void SetDeviceQueues();
+			void QueryVulkan12Support();
+			void QueryUnifiedMemory();
 
 			bool IsPhysicalDeviceSuitable(VkPhysicalDevice _device) const;
+			void SelectFeatures();
 			bool HasExtensionSupport(VkPhysicalDevice _device) const;
 			bool HasSwapChainSupport(VkPhysicalDevice _device) const;
 			QueueFamilies FindQueueFamilies(VkPhysicalDevice _device) const;
@@ -67,6 +78,13 @@ namespace Singularity
 
 			VkDevice m_logicalDevice = VK_NULL_HANDLE;
 			VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+			VkPhysicalDeviceProperties m_physicalDeviceProperties{};
+			VkPhysicalDeviceFeatures m_enabledFeatures{};
+			VkPhysicalDeviceVulkan12Properties m_vulkan12Properties{};
+			VkPhysicalDeviceVulkan12Features m_supportedVulkan12Features{};
+			VkPhysicalDeviceVulkan12Features m_enabledVulkan12Features{};
+			bool m_supportsBindlessTextures = false;
+			bool m_unifiedMemory = false;
 			QueueFamilies m_deviceQueueFamilies;
 			SwapChainSupportDetails m_swapChainSupportDetails;
 			VkQueue m_graphicsQueue;
@@ -0,0 +1,21 @@
+#pragma once
+#include <glm/matrix.hpp>
+#include <glm/vec4.hpp>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+    namespace Render
+    {
+
+        // Data that changes once per frame and is shared by every draw (descriptor set 0)
+        struct FrameUniformBufferObject
+        {
+            glm::mat4 m_view = glm::mat4(1.0f);
+            glm::mat4 m_projection = glm::mat4(1.0f);
+            glm::vec4 m_time = glm::vec4(0.0f); // x: seconds since start, y: timestep
+        };
+
+    }
+}
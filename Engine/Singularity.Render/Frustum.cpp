@@ -0,0 +1,59 @@
+#include "Frustum.h"
+
+namespace Singularity
+{
+	namespace Render
+	{
+		//////////////////////////////////////////////////////////////////////////////////////
+		Frustum Frustum::FromViewProjection(glm::mat4 const& _viewProjection)
+		{
+			// Gribb/Hartmann, rows of the matrix combined. glm::perspective gives -1..1 depth, so near is w + z like the other sides.
+			glm::mat4 const m = glm::transpose(_viewProjection);
+
+			Frustum frustum;
+			frustum.m_planes[0] = m[3] + m[0]; // Left
+			frustum.m_planes[1] = m[3] - m[0]; // Right
+			frustum.m_planes[2] = m[3] + m[1]; // Bottom
+			frustum.m_planes[3] = m[3] - m[1]; // Top
+			frustum.m_planes[4] = m[3] + m[2]; // Near
+			frustum.m_planes[5] = m[3] - m[2]; // Far
+
+			for (glm::vec4& plane : frustum.m_planes)
+			{
+				plane /= glm::length(glm::vec3(plane));
+			}
+
+			return frustum;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		bool Frustum::IntersectsSphere(glm::vec3 const& _centre, float _radius) const
+		{
+			for (glm::vec4 const& plane : m_planes)
+			{
+				if (glm::dot(glm::vec3(plane), _centre) + plane.w < -_radius)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		bool Frustum::IntersectsBox(glm::vec3 const& _minimum, glm::vec3 const& _maximum) const
+		{
+			for (glm::vec4 const& plane : m_planes)
+			{
+				// Only the corner furthest along the plane normal matters, if that is behind so is the whole box
+				glm::vec3 const corner(plane.x >= 0.0f ? _maximum.x : _minimum.x, plane.y >= 0.0f ? _maximum.y : _minimum.y, plane.z >= 0.0f ? _maximum.z : _minimum.z);
+				if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <array>
+#include <glm/glm.hpp>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		// Six normalised planes (xyz normal pointing inwards, w distance) extracted from a view projection matrix
+		struct Frustum
+		{
+			static Frustum FromViewProjection(glm::mat4 const& _viewProjection);
+
+			bool IntersectsSphere(glm::vec3 const& _centre, float _radius) const;
+			bool IntersectsBox(glm::vec3 const& _minimum, glm::vec3 const& _maximum) const;
+
+			std::array<glm::vec4, 6> m_planes;
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "FrustumCuller.h"
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <Singularity.Core/Parallel.h>
+#include <Singularity.Render/BitScan.h>
+#include <Singularity.Render/Bvh.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		namespace
+		{
+			// AVX2 and the OS saving the upper halves of the registers both have to be there
+			bool SupportsAvx2()
+			{
+#if defined(_MSC_VER)
+				int registers[4];
+				__cpuid(registers, 0);
+				if (registers[0] < 7)
+				{
+					return false;
+				}
+
+				__cpuid(registers, 1);
+				bool const osxsave = (registers[2] & (1 << 27)) != 0;
+				bool const avx = (registers[2] & (1 << 28)) != 0;
+				if (!osxsave || !avx || (_xgetbv(0) & 0x6u) != 0x6u)
+				{
+					return false;
+				}
+
+				__cpuidex(registers, 7, 0);
+				return (registers[1] & (1 << 5)) != 0;
+#else
+				return __builtin_cpu_supports("avx2");
+#endif
+			}
+
+			void AppendVisible(uint32 _first, uint32 _visibleMask, std::vector<uint32>& o_visible)
+			{
+				while (_visibleMask != 0u)
+				{
+					o_visible.push_back(_first + CountTrailingZeros(_visibleMask));
+					_visibleMask &= _visibleMask - 1u;
+				}
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void CullBounds::PushBack()
+		{
+			m_centreX.push_back(0.0f);
+			m_centreY.push_back(0.0f);
+			m_centreZ.push_back(0.0f);
+			m_radius.push_back(0.0f);
+			m_minimumX.push_back(0.0f);
+			m_minimumY.push_back(0.0f);
+			m_minimumZ.push_back(0.0f);
+			m_maximumX.push_back(0.0f);
+			m_maximumY.push_back(0.0f);
+			m_maximumZ.push_back(0.0f);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void CullBounds::PopBack()
+		{
+			m_centreX.pop_back();
+			m_centreY.pop_back();
+			m_centreZ.pop_back();
+			m_radius.pop_back();
+			m_minimumX.pop_back();
+			m_minimumY.pop_back();
+			m_minimumZ.pop_back();
+			m_maximumX.pop_back();
+			m_maximumY.pop_back();
+			m_maximumZ.pop_back();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void CullBounds::Clear()
+		{
+			m_centreX.clear();
+			m_centreY.clear();
+			m_centreZ.clear();
+			m_radius.clear();
+			m_minimumX.clear();
+			m_minimumY.clear();
+			m_minimumZ.clear();
+			m_maximumX.clear();
+			m_maximumY.clear();
+			m_maximumZ.clear();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void CullBounds::Set(uint32 _index, glm::vec4 const& _sphere, glm::vec3 const& _minimum, glm::vec3 const& _maximum)
+		{
+			m_centreX[_index] = _sphere.x;
+			m_centreY[_index] = _sphere.y;
+			m_centreZ[_index] = _sphere.z;
+			m_radius[_index] = _sphere.w;
+			m_minimumX[_index] = _minimum.x;
+			m_minimumY[_index] = _minimum.y;
+			m_minimumZ[_index] = _minimum.z;
+			m_maximumX[_index] = _maximum.x;
+			m_maximumY[_index] = _maximum.y;
+			m_maximumZ[_index] = _maximum.z;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void CullBounds::Move(uint32 _from, uint32 _to)
+		{
+			m_centreX[_to] = m_centreX[_from];
+			m_centreY[_to] = m_centreY[_from];
+			m_centreZ[_to] = m_centreZ[_from];
+			m_radius[_to] = m_radius[_from];
+			m_minimumX[_to] = m_minimumX[_from];
+			m_minimumY[_to] = m_minimumY[_from];
+			m_minimumZ[_to] = m_minimumZ[_from];
+			m_maximumX[_to] = m_maximumX[_from];
+			m_maximumY[_to] = m_maximumY[_from];
+			m_maximumZ[_to] = m_maximumZ[_from];
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void FrustumCuller::Cull(Frustum const& _frustum, CullBounds const& _bounds)
+		{
+			uint32 const count = _bounds.GetCount();
+
+			m_workerVisible.resize(Core::GetWorkerCount());
+			for (std::vector<uint32>& visible : m_workerVisible)
+			{
+				visible.clear();
+			}
+
+			Core::ParallelFor(count, c_minPerWorker, [&](uint32 _begin, uint32 _end, uint32 _worker)
+			{
+				CullRange(_frustum, _bounds, _begin, _end, m_workerVisible[_worker]);
+			});
+
+			// Workers own consecutive ranges, so joining in worker order keeps the indices sorted
+			m_visible.clear();
+			for (std::vector<uint32> const& visible : m_workerVisible)
+			{
+				m_visible.insert(m_visible.end(), visible.begin(), visible.end());
+			}
+
+			m_stats.m_tested = count;
+			m_stats.m_visible = static_cast<uint32>(m_visible.size());
+			m_stats.m_culled = count - m_stats.m_visible;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void FrustumCuller::Cull(Frustum const& _frustum, CullBounds const& _bounds, Bvh const& _bvh)
+		{
+			m_visible.clear();
+			_bvh.QueryFrustum(_frustum, _bounds, m_visible);
+
+			m_stats.m_tested = _bounds.GetCount();
+			m_stats.m_visible = static_cast<uint32>(m_visible.size());
+			m_stats.m_culled = m_stats.m_tested - m_stats.m_visible;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void FrustumCuller::CullRange(Frustum const& _frustum, CullBounds const& _bounds, uint32 _begin, uint32 _end, std::vector<uint32>& o_visible)
+		{
+			// The box is tested against each plane's most positive corner. That choice only depends on the plane, so it is
+			// made once per plane here rather than per object.
+			float const* cornerX[6];
+			float const* cornerY[6];
+			float const* cornerZ[6];
+			for (uint32 p = 0; p < 6u; ++p)
+			{
+				glm::vec4 const& plane = _frustum.m_planes[p];
+				cornerX[p] = plane.x >= 0.0f ? _bounds.m_maximumX.data() : _bounds.m_minimumX.data();
+				cornerY[p] = plane.y >= 0.0f ? _bounds.m_maximumY.data() : _bounds.m_minimumY.data();
+				cornerZ[p] = plane.z >= 0.0f ? _bounds.m_maximumZ.data() : _bounds.m_minimumZ.data();
+			}
+
+			uint32 i = _begin;
+
+			static bool const supportsAvx2 = SupportsAvx2();
+			if (supportsAvx2)
+			{
+				// Whole groups of 8, written into room made for all of them and trimmed to what survived
+				i = _begin + ((_end - _begin) & ~7u);
+				size_t const first = o_visible.size();
+				o_visible.resize(first + (i - _begin));
+				uint32 const visibleCount = CullRangeAvx2(_frustum.m_planes.data(), _bounds.m_centreX.data(), _bounds.m_centreY.data(), _bounds.m_centreZ.data(), _bounds.m_radius.data(), cornerX, cornerY, cornerZ, _begin, i, o_visible.data() + first);
+				o_visible.resize(first + visibleCount);
+			}
+
+			for (; i + 4u <= _end; i += 4u)
+			{
+				__m128 const centreX = _mm_loadu_ps(&_bounds.m_centreX[i]);
+				__m128 const centreY = _mm_loadu_ps(&_bounds.m_centreY[i]);
+				__m128 const centreZ = _mm_loadu_ps(&_bounds.m_centreZ[i]);
+				__m128 const negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&_bounds.m_radius[i]));
+
+				__m128 outside = _mm_setzero_ps();
+				for (uint32 p = 0; p < 6u; ++p)
+				{
+					glm::vec4 const& plane = _frustum.m_planes[p];
+					__m128 const normalX = _mm_set1_ps(plane.x);
+					__m128 const normalY = _mm_set1_ps(plane.y);
+					__m128 const normalZ = _mm_set1_ps(plane.z);
+					__m128 const distance = _mm_set1_ps(plane.w);
+
+					__m128 sphereDistance = _mm_add_ps(_mm_mul_ps(normalX, centreX), distance);
+					sphereDistance = _mm_add_ps(_mm_mul_ps(normalY, centreY), sphereDistance);
+					sphereDistance = _mm_add_ps(_mm_mul_ps(normalZ, centreZ), sphereDistance);
+					outside = _mm_or_ps(outside, _mm_cmplt_ps(sphereDistance, negativeRadius));
+
+					__m128 boxDistance = _mm_add_ps(_mm_mul_ps(normalX, _mm_loadu_ps(cornerX[p] + i)), distance);
+					boxDistance = _mm_add_ps(_mm_mul_ps(normalY, _mm_loadu_ps(cornerY[p] + i)), boxDistance);
+					boxDistance = _mm_add_ps(_mm_mul_ps(normalZ, _mm_loadu_ps(cornerZ[p] + i)), boxDistance);
+					outside = _mm_or_ps(outside, _mm_cmplt_ps(boxDistance, _mm_setzero_ps()));
+				}
+
+				AppendVisible(i, ~static_cast<uint32>(_mm_movemask_ps(outside)) & 0xFu, o_visible);
+			}
+
+			for (; i < _end; ++i)
+			{
+				glm::vec3 const minimum(_bounds.m_minimumX[i], _bounds.m_minimumY[i], _bounds.m_minimumZ[i]);
+				glm::vec3 const maximum(_bounds.m_maximumX[i], _bounds.m_maximumY[i], _bounds.m_maximumZ[i]);
+				if (_frustum.IntersectsSphere(_bounds.GetCentre(i), _bounds.m_radius[i]) && _frustum.IntersectsBox(minimum, maximum))
+				{
+					o_visible.push_back(i);
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
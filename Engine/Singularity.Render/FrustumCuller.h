@@ -0,0 +1,67 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include <Singularity.Core/CoreDeclare.h>
+#include <Singularity.Render/Frustum.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		class Bvh;
+
+		// World space bounds kept as one array per component, so several objects load straight into a SIMD register
+		struct CullBounds
+		{
+			uint32 GetCount() const { return static_cast<uint32>(m_radius.size()); }
+			glm::vec3 GetCentre(uint32 _index) const { return glm::vec3(m_centreX[_index], m_centreY[_index], m_centreZ[_index]); }
+
+			void PushBack();
+			void PopBack();
+			void Clear();
+			void Set(uint32 _index, glm::vec4 const& _sphere, glm::vec3 const& _minimum, glm::vec3 const& _maximum);
+			void Move(uint32 _from, uint32 _to);
+
+			std::vector<float> m_centreX;
+			std::vector<float> m_centreY;
+			std::vector<float> m_centreZ;
+			std::vector<float> m_radius;
+			std::vector<float> m_minimumX;
+			std::vector<float> m_minimumY;
+			std::vector<float> m_minimumZ;
+			std::vector<float> m_maximumX;
+			std::vector<float> m_maximumY;
+			std::vector<float> m_maximumZ;
+		};
+
+		struct CullStats
+		{
+			uint32 m_tested = 0u;
+			uint32 m_visible = 0u;
+			uint32 m_culled = 0u;
+		};
+
+		// Tests spheres and boxes against the frustum with AVX2 or SSE, across workers, listing survivors in ascending order
+		class FrustumCuller
+		{
+		public:
+			void Cull(Frustum const& _frustum, CullBounds const& _bounds);
+			void Cull(Frustum const& _frustum, CullBounds const& _bounds, Bvh const& _bvh); // Whole subtrees at once, leaves the list unordered
+
+			std::vector<uint32> const& GetVisible() const { return m_visible; }
+			CullStats const& GetStats() const { return m_stats; }
+
+		private:
+			static void CullRange(Frustum const& _frustum, CullBounds const& _bounds, uint32 _begin, uint32 _end, std::vector<uint32>& o_visible);
+			static uint32 CullRangeAvx2(glm::vec4 const* _planes, float const* _centreX, float const* _centreY, float const* _centreZ, float const* _radius, float const* const* _cornerX, float const* const* _cornerY, float const* const* _cornerZ, uint32 _begin, uint32 _end, uint32* o_visible); // Built for AVX2 and kept free of STL, a multiple of 8 objects, returns how many it wrote
+
+			static uint32 constexpr c_minPerWorker = 8192u;
+
+			std::vector<uint32> m_visible;
+			std::vector<std::vector<uint32>> m_workerVisible;
+			CullStats m_stats;
+		};
+	}
+}
\ No newline at end of file
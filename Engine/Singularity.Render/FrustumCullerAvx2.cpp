@@ -0,0 +1,60 @@
+#include "FrustumCuller.h"
+
+#include <immintrin.h>
+
+#include <Singularity.Render/BitScan.h>
+
+// MSVC builds the whole file for AVX2, others get it per function
+#if defined(_MSC_VER)
+#define SINGULARITY_AVX2
+#else
+#define SINGULARITY_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace Singularity
+{
+	namespace Render
+	{
+		//////////////////////////////////////////////////////////////////////////////////////
+		SINGULARITY_AVX2 uint32 FrustumCuller::CullRangeAvx2(glm::vec4 const* _planes, float const* _centreX, float const* _centreY, float const* _centreZ, float const* _radius, float const* const* _cornerX, float const* const* _cornerY, float const* const* _cornerZ, uint32 _begin, uint32 _end, uint32* o_visible)
+		{
+			uint32 visibleCount = 0u;
+			for (uint32 i = _begin; i < _end; i += 8u)
+			{
+				__m256 const centreX = _mm256_loadu_ps(_centreX + i);
+				__m256 const centreY = _mm256_loadu_ps(_centreY + i);
+				__m256 const centreZ = _mm256_loadu_ps(_centreZ + i);
+				__m256 const negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(_radius + i));
+
+				__m256 outside = _mm256_setzero_ps();
+				for (uint32 p = 0; p < 6u; ++p)
+				{
+					glm::vec4 const& plane = _planes[p];
+					__m256 const normalX = _mm256_set1_ps(plane.x);
+					__m256 const normalY = _mm256_set1_ps(plane.y);
+					__m256 const normalZ = _mm256_set1_ps(plane.z);
+					__m256 const distance = _mm256_set1_ps(plane.w);
+
+					__m256 sphereDistance = _mm256_add_ps(_mm256_mul_ps(normalX, centreX), distance);
+					sphereDistance = _mm256_add_ps(_mm256_mul_ps(normalY, centreY), sphereDistance);
+					sphereDistance = _mm256_add_ps(_mm256_mul_ps(normalZ, centreZ), sphereDistance);
+					outside = _mm256_or_ps(outside, _mm256_cmp_ps(sphereDistance, negativeRadius, _CMP_LT_OQ));
+
+					__m256 boxDistance = _mm256_add_ps(_mm256_mul_ps(normalX, _mm256_loadu_ps(_cornerX[p] + i)), distance);
+					boxDistance = _mm256_add_ps(_mm256_mul_ps(normalY, _mm256_loadu_ps(_cornerY[p] + i)), boxDistance);
+					boxDistance = _mm256_add_ps(_mm256_mul_ps(normalZ, _mm256_loadu_ps(_cornerZ[p] + i)), boxDistance);
+					outside = _mm256_or_ps(outside, _mm256_cmp_ps(boxDistance, _mm256_setzero_ps(), _CMP_LT_OQ));
+				}
+
+				uint32 visibleMask = ~static_cast<uint32>(_mm256_movemask_ps(outside)) & 0xFFu;
+				while (visibleMask != 0u)
+				{
+					o_visible[visibleCount++] = i + CountTrailingZeros(visibleMask);
+					visibleMask &= visibleMask - 1u;
+				}
+			}
+
+			return visibleCount;
+		}
+	}
+}
\ No newline at end of file
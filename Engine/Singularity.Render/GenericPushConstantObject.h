@@ -0,0 +1,20 @@
+#pragma once
+#include <glm/matrix.hpp>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+    namespace Render
+    {
+
+        // Small per-draw data delivered through vkCmdPushConstants when the device allows it
+        struct GenericPushConstantObject
+        {
+            glm::mat4 m_model = glm::mat4(1.0f);
+            uint32 m_textureIndex = 0u; // Slot in the bindless texture table
+            uint32 m_padding[3] = {};
+        };
+
+    }
+}
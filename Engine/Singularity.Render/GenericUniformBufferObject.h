@@ -12,12 +12,13 @@ namespace Singularity
     namespace Render
     {
 
+        // Per-object data (descriptor set 2), only used when push constants are unavailable
         struct GenericUniformBufferObject
         {
             glm::mat4 m_model = glm::mat4(1.0f);
-            glm::mat4 m_view = glm::mat4(1.0f);
-            glm::mat4 m_projection = glm::mat4(1.0f);
+            uint32 m_textureIndex = 0u; // Slot in the bindless texture table
+            uint32 m_padding[3] = {};
         };
 
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,783 @@
+#include "GltfParser.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <utility>
+
+
+namespace Singularity
+{
+	namespace Render
+	{
+		namespace
+		{
+			uint32 constexpr c_glbMagic = 0x46546C67u; // "glTF"
+			uint32 constexpr c_jsonChunk = 0x4E4F534Au; // "JSON"
+			uint32 constexpr c_binaryChunk = 0x004E4942u; // "BIN\0"
+			uint32 constexpr c_maxJsonDepth = 64u;
+
+			struct JsonValue
+			{
+				enum class Type
+				{
+					Null,
+					Bool,
+					Number,
+					String,
+					Array,
+					Object
+				};
+
+				JsonValue const* Find(char const* _name) const
+				{
+					for (auto const& member : m_members)
+					{
+						if (member.first == _name)
+						{
+							return &member.second;
+						}
+					}
+					return nullptr;
+				}
+
+				Type m_type = Type::Null;
+				bool m_bool = false;
+				double m_number = 0.0;
+				std::string m_string;
+				std::vector<JsonValue> m_elements;
+				std::vector<std::pair<std::string, JsonValue>> m_members;
+			};
+
+			// Recursive descent over the JSON chunk, strict enough to refuse anything malformed
+			class JsonReader
+			{
+			public:
+				JsonReader(char const* _begin, char const* _end) : m_data(_begin), m_end(_end) {}
+
+				bool Read(JsonValue& o_value)
+				{
+					return ReadValue(o_value, 0u) && (SkipSpace(), m_data == m_end);
+				}
+
+			private:
+				void SkipSpace()
+				{
+					while (m_data < m_end && (*m_data == ' ' || *m_data == '\t' || *m_data == '\n' || *m_data == '\r'))
+					{
+						++m_data;
+					}
+				}
+
+				bool Expect(char const* _literal)
+				{
+					size_t const length = strlen(_literal);
+					if (static_cast<size_t>(m_end - m_data) < length || memcmp(m_data, _literal, length) != 0)
+					{
+						return false;
+					}
+					m_data += length;
+					return true;
+				}
+
+				bool ReadValue(JsonValue& o_value, uint32 _depth)
+				{
+					SkipSpace();
+					if (m_data == m_end || _depth > c_maxJsonDepth)
+					{
+						return false;
+					}
+
+					switch (*m_data)
+					{
+					case '{':
+						o_value.m_type = JsonValue::Type::Object;
+						return ReadObject(o_value, _depth);
+					case '[':
+						o_value.m_type = JsonValue::Type::Array;
+						return ReadArray(o_value, _depth);
+					case '"':
+						o_value.m_type = JsonValue::Type::String;
+						return ReadString(o_value.m_string);
+					case 't':
+						o_value.m_type = JsonValue::Type::Bool;
+						o_value.m_bool = true;
+						return Expect("true");
+					case 'f':
+						o_value.m_type = JsonValue::Type::Bool;
+						return Expect("false");
+					case 'n':
+						return Expect("null");
+					default:
+						o_value.m_type = JsonValue::Type::Number;
+						return ReadNumber(o_value.m_number);
+					}
+				}
+
+				bool ReadObject(JsonValue& o_value, uint32 _depth)
+				{
+					++m_data;
+					SkipSpace();
+					if (m_data < m_end && *m_data == '}')
+					{
+						++m_data;
+						return true;
+					}
+
+					while (true)
+					{
+						SkipSpace();
+						auto& member = o_value.m_members.emplace_back();
+						if (m_data == m_end || *m_data != '"' || !ReadString(member.first))
+						{
+							return false;
+						}
+
+						SkipSpace();
+						if (m_data == m_end || *m_data++ != ':' || !ReadValue(member.second, _depth + 1u))
+						{
+							return false;
+						}
+
+						SkipSpace();
+						if (m_data == m_end)
+						{
+							return false;
+						}
+
+						char const next = *m_data++;
+						if (next == '}')
+						{
+							return true;
+						}
+						if (next != ',')
+						{
+							return false;
+						}
+					}
+				}
+
+				bool ReadArray(JsonValue& o_value, uint32 _depth)
+				{
+					++m_data;
+					SkipSpace();
+					if (m_data < m_end && *m_data == ']')
+					{
+						++m_data;
+						return true;
+					}
+
+					while (true)
+					{
+						if (!ReadValue(o_value.m_elements.emplace_back(), _depth + 1u))
+						{
+							return false;
+						}
+
+						SkipSpace();
+						if (m_data == m_end)
+						{
+							return false;
+						}
+
+						char const next = *m_data++;
+						if (next == ']')
+						{
+							return true;
+						}
+						if (next != ',')
+						{
+							return false;
+						}
+					}
+				}
+
+				bool ReadHex(uint32& o_codePoint)
+				{
+					if (m_end - m_data < 4)
+					{
+						return false;
+					}
+
+					o_codePoint = 0u;
+					for (uint32 i = 0; i < 4u; ++i)
+					{
+						char const digit = *m_data++;
+						uint32 const value = digit >= '0' && digit <= '9' ? digit - '0' : digit >= 'a' && digit <= 'f' ? digit - 'a' + 10 : digit >= 'A' && digit <= 'F' ? digit - 'A' + 10 : 16u;
+						if (value > 15u)
+						{
+							return false;
+						}
+						o_codePoint = (o_codePoint << 4u) | value;
+					}
+					return true;
+				}
+
+				bool ReadString(std::string& o_string)
+				{
+					++m_data;
+					while (m_data < m_end)
+					{
+						char const character = *m_data++;
+						if (character == '"')
+						{
+							return true;
+						}
+						if (character != '\\')
+						{
+							o_string.push_back(character);
+							continue;
+						}
+
+						if (m_data == m_end)
+						{
+							return false;
+						}
+
+						char const escape = *m_data++;
+						switch (escape)
+						{
+						case '"': o_string.push_back('"'); break;
+						case '\\': o_string.push_back('\\'); break;
+						case '/': o_string.push_back('/'); break;
+						case 'b': o_string.push_back('\b'); break;
+						case 'f': o_string.push_back('\f'); break;
+						case 'n': o_string.push_back('\n'); break;
+						case 'r': o_string.push_back('\r'); break;
+						case 't': o_string.push_back('\t'); break;
+						case 'u':
+						{
+							uint32 codePoint;
+							if (!ReadHex(codePoint))
+							{
+								return false;
+							}
+
+							// A high surrogate pairs with the low one escaped straight after it
+							if (codePoint >= 0xD800u && codePoint < 0xDC00u)
+							{
+								uint32 low;
+								if (!Expect("\\u") || !ReadHex(low) || low < 0xDC00u || low >= 0xE000u)
+								{
+									return false;
+								}
+								codePoint = 0x10000u + ((codePoint - 0xD800u) << 10u) + (low - 0xDC00u);
+							}
+
+							if (codePoint < 0x80u)
+							{
+								o_string.push_back(static_cast<char>(codePoint));
+							}
+							else if (codePoint < 0x800u)
+							{
+								o_string.push_back(static_cast<char>(0xC0u | (codePoint >> 6u)));
+								o_string.push_back(static_cast<char>(0x80u | (codePoint & 0x3Fu)));
+							}
+							else if (codePoint < 0x10000u)
+							{
+								o_string.push_back(static_cast<char>(0xE0u | (codePoint >> 12u)));
+								o_string.push_back(static_cast<char>(0x80u | ((codePoint >> 6u) & 0x3Fu)));
+								o_string.push_back(static_cast<char>(0x80u | (codePoint & 0x3Fu)));
+							}
+							else
+							{
+								o_string.push_back(static_cast<char>(0xF0u | (codePoint >> 18u)));
+								o_string.push_back(static_cast<char>(0x80u | ((codePoint >> 12u) & 0x3Fu)));
+								o_string.push_back(static_cast<char>(0x80u | ((codePoint >> 6u) & 0x3Fu)));
+								o_string.push_back(static_cast<char>(0x80u | (codePoint & 0x3Fu)));
+							}
+							break;
+						}
+						default:
+							return false;
+						}
+					}
+					return false;
+				}
+
+				// strtod can't be told where to stop, so the number is copied out first
+				bool ReadNumber(double& o_number)
+				{
+					char buffer[64];
+					size_t length = 0u;
+					while (m_data + length < m_end && length < sizeof(buffer) - 1u && strchr("+-0123456789.eE", m_data[length]) && m_data[length] != '\0')
+					{
+						buffer[length] = m_data[length];
+						++length;
+					}
+					buffer[length] = '\0';
+
+					char* end;
+					o_number = strtod(buffer, &end);
+					if (length == 0u || end != buffer + length)
+					{
+						return false;
+					}
+					m_data += length;
+					return true;
+				}
+
+				char const* m_data;
+				char const* const m_end;
+			};
+
+			struct GltfBufferView
+			{
+				size_t m_offset = 0u; // Into the binary chunk
+				size_t m_length = 0u;
+				uint32 m_stride = 0u; // Zero for tightly packed
+			};
+
+			// Every lookup checks type and range, so a broken file fails with an error rather than reading garbage
+			class GltfReader
+			{
+			public:
+				GltfReader(std::string& o_error) : m_error(o_error) {}
+
+				bool Fail(std::string const& _error)
+				{
+					if (m_error.empty())
+					{
+						m_error = _error;
+					}
+					return false;
+				}
+
+				JsonValue const* GetArray(JsonValue const& _object, char const* _name)
+				{
+					JsonValue const* const value = _object.Find(_name);
+					return value && value->m_type == JsonValue::Type::Array ? value : nullptr;
+				}
+
+				bool GetUint(JsonValue const& _object, char const* _name, uint32& io_value, bool _required = false)
+				{
+					JsonValue const* const value = _object.Find(_name);
+					if (!value)
+					{
+						return !_required || Fail(std::string("missing \"") + _name + "\"");
+					}
+					if (value->m_type != JsonValue::Type::Number || value->m_number < 0.0 || value->m_number > 4294967295.0 || value->m_number != static_cast<double>(static_cast<uint32>(value->m_number)))
+					{
+						return Fail(std::string("\"") + _name + "\" is not an unsigned integer");
+					}
+					io_value = static_cast<uint32>(value->m_number);
+					return true;
+				}
+
+				bool GetIndex(JsonValue const& _object, char const* _name, size_t _count, uint32& io_index)
+				{
+					if (!GetUint(_object, _name, io_index))
+					{
+						return false;
+					}
+					return io_index == UINT32_MAX || io_index < _count || Fail(std::string("\"") + _name + "\" is out of range");
+				}
+
+				bool GetFloats(JsonValue const& _object, char const* _name, float* io_values, uint32 _count)
+				{
+					JsonValue const* const value = _object.Find(_name);
+					if (!value)
+					{
+						return true;
+					}
+					if (value->m_type != JsonValue::Type::Array || value->m_elements.size() != _count)
+					{
+						return Fail(std::string("\"") + _name + "\" has the wrong size");
+					}
+					for (uint32 i = 0; i < _count; ++i)
+					{
+						if (value->m_elements[i].m_type != JsonValue::Type::Number)
+						{
+							return Fail(std::string("\"") + _name + "\" is not numeric");
+						}
+						io_values[i] = static_cast<float>(value->m_elements[i].m_number);
+					}
+					return true;
+				}
+
+			private:
+				std::string& m_error;
+			};
+
+			uint32 GetComponentSize(uint32 _componentType)
+			{
+				switch (_componentType)
+				{
+				case GltfParser::c_byte:
+				case GltfParser::c_unsignedByte:
+					return 1u;
+				case GltfParser::c_short:
+				case GltfParser::c_unsignedShort:
+					return 2u;
+				case GltfParser::c_unsignedInt:
+				case GltfParser::c_float:
+					return 4u;
+				default:
+					return 0u;
+				}
+			}
+
+			uint32 GetComponentCount(std::string const& _type)
+			{
+				if (_type == "SCALAR") return 1u;
+				if (_type == "VEC2") return 2u;
+				if (_type == "VEC3") return 3u;
+				if (_type == "VEC4") return 4u;
+				if (_type == "MAT2") return 4u;
+				if (_type == "MAT3") return 9u;
+				if (_type == "MAT4") return 16u;
+				return 0u;
+			}
+
+			bool ReadBufferViews(JsonValue const& _root, size_t _binarySize, GltfReader& _reader, std::vector<GltfBufferView>& o_views)
+			{
+				// Buffer 0 is the binary chunk, which may be padded past the length the buffer declares
+				JsonValue const* const buffers = _reader.GetArray(_root, "buffers");
+				size_t bufferLength = 0u;
+				if (buffers)
+				{
+					for (uint32 i = 0; i < buffers->m_elements.size(); ++i)
+					{
+						JsonValue const& buffer = buffers->m_elements[i];
+						if (i > 0u || buffer.Find("uri"))
+						{
+							return _reader.Fail("only the binary chunk can hold buffers");
+						}
+
+						uint32 length = 0u;
+						if (!_reader.GetUint(buffer, "byteLength", length, true))
+						{
+							return false;
+						}
+						if (length > _binarySize)
+						{
+							return _reader.Fail("the binary chunk is shorter than its buffer");
+						}
+						bufferLength = length;
+					}
+				}
+
+				JsonValue const* const views = _reader.GetArray(_root, "bufferViews");
+				if (!views)
+				{
+					return true;
+				}
+
+				o_views.reserve(views->m_elements.size());
+				for (JsonValue const& source : views->m_elements)
+				{
+					uint32 buffer = UINT32_MAX;
+					uint32 offset = 0u;
+					uint32 length = 0u;
+					GltfBufferView& view = o_views.emplace_back();
+					if (!_reader.GetUint(source, "buffer", buffer, true) || !_reader.GetUint(source, "byteOffset", offset) || !_reader.GetUint(source, "byteLength", length, true) || !_reader.GetUint(source, "byteStride", view.m_stride))
+					{
+						return false;
+					}
+					if (buffer != 0u || !buffers || static_cast<uint64>(offset) + length > bufferLength)
+					{
+						return _reader.Fail("a buffer view lies outside the binary chunk");
+					}
+					if (view.m_stride != 0u && (view.m_stride < 4u || view.m_stride > 252u || view.m_stride % 4u != 0u))
+					{
+						return _reader.Fail("a buffer view has an invalid stride");
+					}
+					view.m_offset = offset;
+					view.m_length = length;
+				}
+				return true;
+			}
+
+			bool ReadAccessors(JsonValue const& _root, uint8 const* _binary, std::vector<GltfBufferView> const& _views, GltfReader& _reader, std::vector<GltfAccessor>& o_accessors)
+			{
+				JsonValue const* const accessors = _reader.GetArray(_root, "accessors");
+				if (!accessors)
+				{
+					return true;
+				}
+
+				o_accessors.reserve(accessors->m_elements.size());
+				for (JsonValue const& source : accessors->m_elements)
+				{
+					GltfAccessor& accessor = o_accessors.emplace_back();
+					uint32 view = UINT32_MAX;
+					uint32 offset = 0u;
+					JsonValue const* const type = source.Find("type");
+					JsonValue const* const normalized = source.Find("normalized");
+					if (!_reader.GetIndex(source, "bufferView", _views.size(), view) || !_reader.GetUint(source, "byteOffset", offset) || !_reader.GetUint(source, "componentType", accessor.m_componentType, true) || !_reader.GetUint(source, "count", accessor.m_count, true))
+					{
+						return false;
+					}
+					if (source.Find("sparse"))
+					{
+						return _reader.Fail("sparse accessors are not supported");
+					}
+					if (view == UINT32_MAX)
+					{
+						return _reader.Fail("accessors without a buffer view are not supported");
+					}
+
+					uint32 const componentSize = GetComponentSize(accessor.m_componentType);
+					accessor.m_componentCount = type && type->m_type == JsonValue::Type::String ? GetComponentCount(type->m_string) : 0u;
+					accessor.m_normalized = normalized && normalized->m_type == JsonValue::Type::Bool && normalized->m_bool;
+					if (componentSize == 0u || accessor.m_componentCount == 0u)
+					{
+						return _reader.Fail("an accessor has an invalid type");
+					}
+
+					// The last element only has to fit, not its stride's worth of padding
+					GltfBufferView const& bufferView = _views[view];
+					uint32 const elementSize = componentSize * accessor.m_componentCount;
+					accessor.m_stride = bufferView.m_stride != 0u ? bufferView.m_stride : elementSize;
+					uint64 const end = accessor.m_count == 0u ? offset : offset + static_cast<uint64>(accessor.m_stride) * (accessor.m_count - 1u) + elementSize;
+					if (end > bufferView.m_length || offset % componentSize != 0u || (bufferView.m_offset + offset) % componentSize != 0u)
+					{
+						return _reader.Fail("an accessor lies outside its buffer view or is misaligned");
+					}
+					accessor.m_data = _binary + bufferView.m_offset + offset;
+				}
+				return true;
+			}
+
+			bool ReadMeshes(JsonValue const& _root, size_t _accessorCount, uint32 _materialCount, GltfReader& _reader, std::vector<GltfMesh>& o_meshes)
+			{
+				JsonValue const* const meshes = _reader.GetArray(_root, "meshes");
+				if (!meshes)
+				{
+					return true;
+				}
+
+				o_meshes.reserve(meshes->m_elements.size());
+				for (JsonValue const& source : meshes->m_elements)
+				{
+					GltfMesh& mesh = o_meshes.emplace_back();
+					JsonValue const* const primitives = _reader.GetArray(source, "primitives");
+					if (!primitives)
+					{
+						return _reader.Fail("a mesh has no primitives");
+					}
+
+					for (JsonValue const& sourcePrimitive : primitives->m_elements)
+					{
+						GltfPrimitive& primitive = mesh.m_primitives.emplace_back();
+						JsonValue const* const attributes = sourcePrimitive.Find("attributes");
+						if (!attributes || attributes->m_type != JsonValue::Type::Object)
+						{
+							return _reader.Fail("a primitive has no attributes");
+						}
+
+						if (!_reader.GetIndex(*attributes, "POSITION", _accessorCount, primitive.m_positions) || !_reader.GetIndex(*attributes, "COLOR_0", _accessorCount, primitive.m_colours) || !_reader.GetIndex(*attributes, "TEXCOORD_0", _accessorCount, primitive.m_uvs)
+							|| !_reader.GetIndex(sourcePrimitive, "indices", _accessorCount, primitive.m_indices) || !_reader.GetIndex(sourcePrimitive, "material", _materialCount, primitive.m_material) || !_reader.GetUint(sourcePrimitive, "mode", primitive.m_mode))
+						{
+							return false;
+						}
+					}
+				}
+				return true;
+			}
+
+			bool ReadNodes(JsonValue const& _root, size_t _meshCount, GltfReader& _reader, std::vector<GltfNode>& o_nodes)
+			{
+				JsonValue const* const nodes = _reader.GetArray(_root, "nodes");
+				if (!nodes)
+				{
+					return true;
+				}
+
+				o_nodes.reserve(nodes->m_elements.size());
+				for (JsonValue const& source : nodes->m_elements)
+				{
+					GltfNode& node = o_nodes.emplace_back();
+					if (!_reader.GetIndex(source, "mesh", _meshCount, node.m_mesh))
+					{
+						return false;
+					}
+
+					if (source.Find("matrix"))
+					{
+						if (!_reader.GetFloats(source, "matrix", glm::value_ptr(node.m_transform), 16u)) // Column major, as glm stores it
+						{
+							return false;
+						}
+					}
+					else
+					{
+						glm::vec3 translation(0.0f);
+						glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
+						glm::vec3 scale(1.0f);
+						float quaternion[4] = { 0.0f, 0.0f, 0.0f, 1.0f }; // xyzw in the file, glm's constructor takes w first
+						if (!_reader.GetFloats(source, "translation", glm::value_ptr(translation), 3u) || !_reader.GetFloats(source, "rotation", quaternion, 4u) || !_reader.GetFloats(source, "scale", glm::value_ptr(scale), 3u))
+						{
+							return false;
+						}
+						rotation = glm::quat(quaternion[3], quaternion[0], quaternion[1], quaternion[2]);
+						node.m_transform = glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
+					}
+
+					if (JsonValue const* const children = _reader.GetArray(source, "children"))
+					{
+						for (JsonValue const& child : children->m_elements)
+						{
+							if (child.m_type != JsonValue::Type::Number || child.m_number < 0.0 || child.m_number >= static_cast<double>(nodes->m_elements.size()) || child.m_number != static_cast<double>(static_cast<uint32>(child.m_number)))
+							{
+								return _reader.Fail("a node has an invalid child");
+							}
+							node.m_children.push_back(static_cast<uint32>(child.m_number));
+						}
+					}
+				}
+
+				// Every node may have one parent at most, which also rules out cycles once the roots are known
+				std::vector<uint32> parentCounts(o_nodes.size(), 0u);
+				for (GltfNode const& node : o_nodes)
+				{
+					for (uint32 const child : node.m_children)
+					{
+						if (++parentCounts[child] > 1u)
+						{
+							return _reader.Fail("a node has several parents");
+						}
+					}
+				}
+				return true;
+			}
+
+			bool ReadRoots(JsonValue const& _root, std::vector<GltfNode> const& _nodes, GltfReader& _reader, std::vector<uint32>& o_roots)
+			{
+				std::vector<bool> isChild(_nodes.size(), false);
+				for (GltfNode const& node : _nodes)
+				{
+					for (uint32 const child : node.m_children)
+					{
+						isChild[child] = true;
+					}
+				}
+
+				JsonValue const* const scenes = _reader.GetArray(_root, "scenes");
+				if (!scenes || scenes->m_elements.empty())
+				{
+					for (uint32 i = 0; i < _nodes.size(); ++i)
+					{
+						if (!isChild[i])
+						{
+							o_roots.push_back(i);
+						}
+					}
+				}
+				else
+				{
+					uint32 scene = 0u;
+					if (!_reader.GetIndex(_root, "scene", scenes->m_elements.size(), scene))
+					{
+						return false;
+					}
+
+					JsonValue const* const nodes = _reader.GetArray(scenes->m_elements[scene], "nodes");
+					for (size_t i = 0; nodes && i < nodes->m_elements.size(); ++i)
+					{
+						JsonValue const& node = nodes->m_elements[i];
+						if (node.m_type != JsonValue::Type::Number || node.m_number < 0.0 || node.m_number >= static_cast<double>(_nodes.size()) || isChild[static_cast<uint32>(node.m_number)])
+						{
+							return _reader.Fail("a scene has an invalid root node");
+						}
+						o_roots.push_back(static_cast<uint32>(node.m_number));
+					}
+				}
+
+				// With single parents, a node is only ever reached once from the roots unless it sits on a cycle
+				std::vector<bool> visited(_nodes.size(), false);
+				std::vector<uint32> stack(o_roots.begin(), o_roots.end());
+				while (!stack.empty())
+				{
+					uint32 const node = stack.back();
+					stack.pop_back();
+					if (visited[node])
+					{
+						return _reader.Fail("the node hierarchy has a cycle");
+					}
+					visited[node] = true;
+					stack.insert(stack.end(), _nodes[node].m_children.begin(), _nodes[node].m_children.end());
+				}
+				return true;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		bool GltfParser::Parse(std::string const& _file, GltfScene& o_scene, std::string& o_error)
+		{
+			o_scene.m_accessors.clear();
+			o_scene.m_meshes.clear();
+			o_scene.m_nodes.clear();
+			o_scene.m_roots.clear();
+			o_scene.m_materialCount = 0u;
+			o_scene.m_file.Close();
+			if (!o_scene.m_file.Open(_file))
+			{
+				o_error = "cannot open file";
+				return false;
+			}
+
+			// A 12 byte header, then the JSON chunk and an optional binary chunk, each with an 8 byte header of its own
+			uint8 const* const data = o_scene.m_file.GetData();
+			size_t const size = o_scene.m_file.GetSize();
+			uint32 header[5];
+			if (size < sizeof(header))
+			{
+				o_error = "too small to be a .glb";
+				return false;
+			}
+			memcpy(header, data, sizeof(header));
+			if (header[0] != c_glbMagic || header[1] != 2u || header[2] > size || header[2] < sizeof(header) || header[4] != c_jsonChunk || header[3] > header[2] - sizeof(header))
+			{
+				o_error = "not a glTF 2.0 binary";
+				return false;
+			}
+
+			char const* const json = reinterpret_cast<char const*>(data + sizeof(header));
+			size_t const binaryChunk = sizeof(header) + header[3];
+			uint8 const* binary = nullptr;
+			size_t binarySize = 0u;
+			if (header[2] - binaryChunk >= 2u * sizeof(uint32))
+			{
+				uint32 chunk[2];
+				memcpy(chunk, data + binaryChunk, sizeof(chunk));
+				if (chunk[1] == c_binaryChunk && chunk[0] <= header[2] - binaryChunk - sizeof(chunk))
+				{
+					binary = data + binaryChunk + sizeof(chunk);
+					binarySize = chunk[0];
+				}
+			}
+
+			JsonValue root;
+			if (!JsonReader(json, json + header[3]).Read(root) || root.m_type != JsonValue::Type::Object)
+			{
+				o_error = "the JSON chunk is malformed";
+				return false;
+			}
+
+			GltfReader reader(o_error);
+			if (JsonValue const* const required = reader.GetArray(root, "extensionsRequired"))
+			{
+				if (!required->m_elements.empty())
+				{
+					std::string const name = required->m_elements.front().m_type == JsonValue::Type::String ? required->m_elements.front().m_string : "?";
+					return reader.Fail("requires the unsupported extension " + name);
+				}
+			}
+
+			JsonValue const* const materials = reader.GetArray(root, "materials");
+			o_scene.m_materialCount = materials ? static_cast<uint32>(materials->m_elements.size()) : 0u;
+
+			std::vector<GltfBufferView> views;
+			if (!ReadBufferViews(root, binarySize, reader, views) || !ReadAccessors(root, binary, views, reader, o_scene.m_accessors) || !ReadMeshes(root, o_scene.m_accessors.size(), o_scene.m_materialCount, reader, o_scene.m_meshes)
+				|| !ReadNodes(root, o_scene.m_meshes.size(), reader, o_scene.m_nodes) || !ReadRoots(root, o_scene.m_nodes, reader, o_scene.m_roots))
+			{
+				o_scene.m_accessors.clear();
+				return false;
+			}
+			return true;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+// Externals
+#include <glm/mat4x4.hpp>
+#include <string>
+#include <vector>
+
+#include <Singularity.Core/CoreDeclare.h>
+#include <Singularity.IO/MappedFile.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		// A typed, strided run of elements inside the file's binary chunk, checked to fit it
+		struct GltfAccessor
+		{
+			uint8 const* m_data = nullptr; // Points into the mapped file
+			uint32 m_count = 0u;
+			uint32 m_stride = 0u; // Bytes between elements, tightly packed unless the buffer view interleaves
+			uint32 m_componentType = 0u; // GL enum, GltfParser::c_float and friends
+			uint32 m_componentCount = 0u;
+			bool m_normalized = false;
+		};
+
+		// Attributes and indices name accessors, UINT32_MAX when absent
+		struct GltfPrimitive
+		{
+			uint32 m_positions = UINT32_MAX;
+			uint32 m_colours = UINT32_MAX;
+			uint32 m_uvs = UINT32_MAX;
+			uint32 m_indices = UINT32_MAX; // Absent for primitives drawn without
+			uint32 m_material = UINT32_MAX;
+			uint32 m_mode = 4u; // Triangles
+		};
+
+		struct GltfMesh
+		{
+			std::vector<GltfPrimitive> m_primitives;
+		};
+
+		struct GltfNode
+		{
+			glm::mat4 m_transform = glm::mat4(1.0f); // Relative to the parent, from the matrix or the TRS properties
+			uint32 m_mesh = UINT32_MAX;
+			std::vector<uint32> m_children;
+		};
+
+		// Everything mesh loading needs from a .glb. The file stays mapped for as long as the scene lives, so accessors can
+		// be read in place.
+		struct GltfScene
+		{
+			IO::MappedFile m_file;
+			std::vector<GltfAccessor> m_accessors;
+			std::vector<GltfMesh> m_meshes;
+			std::vector<GltfNode> m_nodes; // Checked to form a forest
+			std::vector<uint32> m_roots; // Of the default scene, or every parentless node when there is none
+			uint32 m_materialCount = 0u;
+		};
+
+		// Reads binary glTF 2.0, the JSON chunk is parsed and the binary chunk is only pointed into. Buffers have to live in
+		// the binary chunk, and files that require extensions or use sparse accessors are refused.
+		class GltfParser
+		{
+		public:
+			static bool Parse(std::string const& _file, GltfScene& o_scene, std::string& o_error);
+
+			static uint32 constexpr c_byte = 5120u; // Accessor component types
+			static uint32 constexpr c_unsignedByte = 5121u;
+			static uint32 constexpr c_short = 5122u;
+			static uint32 constexpr c_unsignedShort = 5123u;
+			static uint32 constexpr c_unsignedInt = 5125u;
+			static uint32 constexpr c_float = 5126u;
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,669 @@
+#include "GpuCullingPass.h"
+
+#include <algorithm>
+
+#include <Singularity.Render/DescriptorSetCache.h>
+#include <Singularity.Render/Material.h>
+#include <Singularity.Render/Mesh.h>
+#include <Singularity.Render/Renderer.h>
+#include <Singularity.Render/Scene.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		namespace
+		{
+			uint32 Grow(uint32 _capacity, uint32 _required)
+			{
+				while (_capacity < _required)
+				{
+					_capacity *= 2u;
+				}
+				return _capacity;
+			}
+
+			// Objects are drawn with the mesh's dequantization folded into their model matrix, so anything the shaders
+			// place with that matrix has to be given in the mesh's buffered space too
+			glm::vec4 ToBufferedSpace(glm::vec4 const& _sphere, glm::vec4 const& _dequantization)
+			{
+				return glm::vec4((glm::vec3(_sphere) - glm::vec3(_dequantization)) / _dequantization.w, _sphere.w / _dequantization.w);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::Create()
+		{
+			m_useDrawIndirectCount = m_renderer.GetDevice().SupportsDrawIndirectCount();
+			m_useClusterCulling = m_renderer.UseClusterCulling();
+
+			// Objects, buckets, indirect commands and per-bucket draw counts, then meshlets and clusters for cluster culling,
+			// then each object's last level of detail
+			m_layout.AddBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+			m_layout.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+			m_layout.AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+			m_layout.AddBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+			m_layout.AddBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+			m_layout.AddBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+			m_layout.AddBinding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+			m_layout.Create();
+
+			CreatePipeline();
+			GrowLodBuffer(c_initialObjectCapacity);
+			CreateFrames();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::CreateFrames()
+		{
+			for (Frame& frame : m_frames)
+			{
+				DestroyFrameBuffers(frame);
+			}
+			m_frames.clear();
+
+			// New frames start with a full upload, then grow their buffers to fit on their first Update
+			uint32 const imageViewCount = static_cast<uint32>(m_renderer.GetSwapChain().GetImageViews().size());
+			m_frames.reserve(imageViewCount);
+			for (uint32 i = 0; i < imageViewCount; ++i)
+			{
+				Frame& frame = m_frames.emplace_back(m_renderer);
+				CreateFrameBuffers(frame, c_initialObjectCapacity, c_initialBucketCapacity, c_initialMeshletCapacity, c_initialClusterCapacity, c_initialCommandCapacity);
+				frame.m_isDirty.resize(GetObjectCount(), false);
+				frame.m_isClusterDirty.resize(m_clusters.size(), false);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::Destroy()
+		{
+			for (Frame& frame : m_frames)
+			{
+				DestroyFrameBuffers(frame);
+			}
+			m_frames.clear();
+
+			delete m_lods;
+			m_lods = nullptr;
+			m_lodCapacity = 0u;
+
+			VkDevice const logicalDevice = m_renderer.GetDevice().GetLogicalDevice();
+			vkDestroyPipeline(logicalDevice, m_pipeline, nullptr);
+			vkDestroyPipelineLayout(logicalDevice, m_pipelineLayout, nullptr);
+			m_pipeline = VK_NULL_HANDLE;
+			m_pipelineLayout = VK_NULL_HANDLE;
+
+			m_layout.Destroy();
+
+			m_objects.clear();
+			m_objectSlots.clear();
+			m_buckets.clear();
+			m_bucketLookup.clear();
+			m_meshlets.clear();
+			m_clusters.clear();
+			m_commandCount = 0u;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		uint32 GpuCullingPass::AddObject(Mesh const* _mesh, uint32 _submesh, Material const* _material, glm::mat4 const& _model, glm::vec4 const& _tint)
+		{
+			// A new bucket shifts every command range after it, so slots are laid out once before the next upload
+			auto const key = std::make_tuple(_mesh, _submesh, _material);
+			auto bucketIt = m_bucketLookup.find(key);
+			if (bucketIt == m_bucketLookup.end())
+			{
+				Bucket& bucket = m_buckets.emplace_back();
+				bucket.m_mesh = _mesh;
+				bucket.m_submesh = _submesh;
+				bucket.m_material = _material;
+				bucketIt = m_bucketLookup.emplace(key, static_cast<uint32>(m_buckets.size() - 1u)).first;
+				m_bucketsDirty = true;
+			}
+
+			uint32 const index = static_cast<uint32>(m_objects.size());
+			GpuObjectData& object = m_objects.emplace_back();
+			object.m_model = _model * _mesh->GetDequantizeTransform();
+			object.m_tint = _tint;
+			object.m_boundingSphere = ToBufferedSpace(_mesh->GetBoundingSphere(), _mesh->GetDequantization());
+			object.m_textureIndex = _material->GetTextureIndex();
+			object.m_bucket = bucketIt->second;
+
+			for (Frame& frame : m_frames)
+			{
+				frame.m_isDirty.push_back(false);
+			}
+
+			Bucket& bucket = m_buckets[object.m_bucket];
+			m_objectSlots.push_back(static_cast<uint32>(bucket.m_objects.size()));
+			bucket.m_objects.push_back(index);
+
+			// Outgrowing the reservation shifts later buckets too, otherwise the object takes the next free slot
+			if (bucket.m_objects.size() > bucket.m_objectCapacity)
+			{
+				bucket.m_objectCapacity = Grow(bucket.m_objectCapacity, static_cast<uint32>(bucket.m_objects.size()));
+				m_bucketsDirty = true;
+			}
+			PlaceObject(index);
+
+			return index;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::SetObject(uint32 _object, glm::mat4 const& _model, glm::vec4 const& _tint)
+		{
+			m_objects[_object].m_model = _model * m_buckets[m_objects[_object].m_bucket].m_mesh->GetDequantizeTransform();
+			m_objects[_object].m_tint = _tint;
+
+			// Every image keeps its own copy, each needs the new transform before it is next used
+			MarkObjectDirty(_object);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::RemoveObject(uint32 _object)
+		{
+			// The bucket's last object fills the hole so its used slots stay at the front, and the freed slot is emptied
+			Bucket& bucket = m_buckets[m_objects[_object].m_bucket];
+			uint32 const slot = m_objectSlots[_object];
+			uint32 const moved = bucket.m_objects.back();
+			bucket.m_objects[slot] = moved;
+			m_objectSlots[moved] = slot;
+			bucket.m_objects.pop_back();
+			ClearSlot(bucket, static_cast<uint32>(bucket.m_objects.size()));
+			if (moved != _object)
+			{
+				PlaceObject(moved);
+			}
+
+			// Then the last object fills the hole in the object array, keeping its slot
+			uint32 const last = static_cast<uint32>(m_objects.size() - 1u);
+			if (_object != last)
+			{
+				m_objects[_object] = m_objects[last];
+				m_objectSlots[_object] = m_objectSlots[last];
+				m_buckets[m_objects[_object].m_bucket].m_objects[m_objectSlots[_object]] = _object;
+				PlaceObject(_object);
+			}
+
+			m_objects.pop_back();
+			m_objectSlots.pop_back();
+			for (Frame& frame : m_frames)
+			{
+				frame.m_isDirty.pop_back();
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::Update(uint32 _imageIndex)
+		{
+			if (m_bucketsDirty)
+			{
+				RebuildBuckets();
+				for (Frame& frame : m_frames)
+				{
+					frame.m_fullUpload = true;
+				}
+			}
+
+			Frame& frame = m_frames[_imageIndex];
+			uint32 const objectCount = GetObjectCount();
+			uint32 const bucketCount = GetBucketCount();
+			uint32 const meshletCount = static_cast<uint32>(m_meshlets.size());
+			uint32 const clusterCount = GetClusterCount();
+
+			if (objectCount > m_lodCapacity)
+			{
+				// Other images pick up the new buffer with the set they allocate on their next Update
+				GrowLodBuffer(Grow(m_lodCapacity, objectCount));
+			}
+
+			if (objectCount > frame.m_objectCapacity || bucketCount > frame.m_bucketCapacity || meshletCount > frame.m_meshletCapacity || clusterCount > frame.m_clusterCapacity || m_commandCount > frame.m_commandCapacity)
+			{
+				// This image's previous frame has retired, so its buffers can be swapped out
+				uint32 const objectCapacity = Grow(frame.m_objectCapacity, objectCount);
+				uint32 const bucketCapacity = Grow(frame.m_bucketCapacity, bucketCount);
+				uint32 const meshletCapacity = Grow(frame.m_meshletCapacity, meshletCount);
+				uint32 const clusterCapacity = Grow(frame.m_clusterCapacity, clusterCount);
+				uint32 const commandCapacity = Grow(frame.m_commandCapacity, m_commandCount);
+
+				DestroyFrameBuffers(frame);
+				CreateFrameBuffers(frame, objectCapacity, bucketCapacity, meshletCapacity, clusterCapacity, commandCapacity);
+				frame.m_fullUpload = true;
+			}
+
+			// The image's last frame has retired and its transient sets with it
+			frame.m_descriptorSet = m_renderer.GetTransientDescriptorAllocator(_imageIndex).Allocate(m_layout.GetLayout());
+			WriteDescriptorSet(frame);
+
+			GpuObjectData* const objects = static_cast<GpuObjectData*>(frame.m_mappedObjects);
+			if (frame.m_fullUpload)
+			{
+				std::copy(m_objects.begin(), m_objects.end(), objects);
+
+				GpuDrawBucket* const buckets = static_cast<GpuDrawBucket*>(frame.m_mappedBuckets);
+				for (uint32 i = 0; i < bucketCount; ++i)
+				{
+					Mesh const* mesh = m_buckets[i].m_mesh;
+					uint32 const submesh = m_buckets[i].m_submesh;
+					buckets[i].m_commandBase = m_buckets[i].m_commandBase;
+					buckets[i].m_lodCount = mesh->GetLodCount(submesh);
+					for (uint32 lod = 0; lod < mesh->GetLodCount(submesh); ++lod)
+					{
+						buckets[i].m_firstIndex[lod] = mesh->GetLod(lod, submesh).m_first;
+						buckets[i].m_indexCount[lod] = mesh->GetLod(lod, submesh).m_count;
+						buckets[i].m_lodError[lod] = mesh->GetLod(lod, submesh).m_error / mesh->GetDequantization().w;
+					}
+				}
+
+				std::copy(m_meshlets.begin(), m_meshlets.end(), static_cast<Meshlet*>(frame.m_mappedMeshlets));
+				std::copy(m_clusters.begin(), m_clusters.end(), static_cast<GpuCluster*>(frame.m_mappedClusters));
+
+				frame.m_fullUpload = false;
+			}
+			else
+			{
+				// Removals can leave indices behind that no longer exist
+				GpuCluster* const clusters = static_cast<GpuCluster*>(frame.m_mappedClusters);
+				for (uint32 object : frame.m_dirtyObjects)
+				{
+					if (object < objectCount)
+					{
+						objects[object] = m_objects[object];
+					}
+				}
+				for (uint32 cluster : frame.m_dirtyClusters)
+				{
+					clusters[cluster] = m_clusters[cluster];
+				}
+			}
+
+			for (uint32 object : frame.m_dirtyObjects)
+			{
+				if (object < objectCount)
+				{
+					frame.m_isDirty[object] = false;
+				}
+			}
+			frame.m_dirtyObjects.clear();
+
+			for (uint32 cluster : frame.m_dirtyClusters)
+			{
+				frame.m_isClusterDirty[cluster] = false;
+			}
+			frame.m_dirtyClusters.clear();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::Cull(VkCommandBuffer _commandBuffer, uint32 _imageIndex, Frustum const& _frustum, glm::vec3 const& _cameraPosition, float _lodScale) const
+		{
+			if (m_objects.empty())
+			{
+				return;
+			}
+
+			Frame const& frame = m_frames[_imageIndex];
+
+			// Levels of detail start from where the previous frame's dispatch left them
+			VkMemoryBarrier lodBarrier{};
+			lodBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			lodBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			lodBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			vkCmdPipelineBarrier(_commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &lodBarrier, 0, nullptr, 0, nullptr);
+
+			if (m_useDrawIndirectCount)
+			{
+				// Counts are bumped atomically by the shader so they start from zero every frame
+				vkCmdFillBuffer(_commandBuffer, frame.m_counts.GetBuffer(), 0, VK_WHOLE_SIZE, 0u);
+
+				VkMemoryBarrier clearBarrier{};
+				clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+				clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+				vkCmdPipelineBarrier(_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clearBarrier, 0, nullptr, 0, nullptr);
+			}
+
+			PushConstants pushConstants;
+			std::copy(_frustum.m_planes.begin(), _frustum.m_planes.end(), pushConstants.m_planes);
+			pushConstants.m_lodParameters = glm::vec4(_cameraPosition, _lodScale);
+			pushConstants.m_objectCount = m_useClusterCulling ? GetClusterCount() : GetObjectCount();
+			pushConstants.m_compact = m_useDrawIndirectCount ? 1u : 0u;
+			pushConstants.m_lodHysteresis = Scene::c_lodHysteresis;
+
+			vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+			vkCmdBindDescriptorSets(_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &frame.m_descriptorSet, 0, nullptr);
+			vkCmdPushConstants(_commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pushConstants);
+			vkCmdDispatch(_commandBuffer, (pushConstants.m_objectCount + c_workgroupSize - 1u) / c_workgroupSize, 1, 1);
+
+			VkMemoryBarrier cullBarrier{};
+			cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+			vkCmdPipelineBarrier(_commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::Draw(VkCommandBuffer _commandBuffer, uint32 _imageIndex, bool _depthOnly) const
+		{
+			Frame const& frame = m_frames[_imageIndex];
+			uint32 const commandStride = sizeof(VkDrawIndexedIndirectCommand);
+
+			Material const* boundMaterial = nullptr;
+			for (uint32 i = 0; i < m_buckets.size(); ++i)
+			{
+				Bucket const& bucket = m_buckets[i];
+				if (bucket.m_objects.empty() || !bucket.m_mesh->UseIndices() || (_depthOnly && bucket.m_material->IsBlended()))
+				{
+					continue;
+				}
+
+				if (!_depthOnly && bucket.m_material != boundMaterial)
+				{
+					boundMaterial = bucket.m_material;
+					boundMaterial->Bind(_commandBuffer);
+				}
+
+				bucket.m_mesh->BindVertexBuffers(_commandBuffer, _depthOnly);
+				vkCmdBindIndexBuffer(_commandBuffer, bucket.m_mesh->GetIndexBuffer()->GetBuffer(), 0, bucket.m_mesh->GetIndexType());
+
+				// Only the slots in use, the bucket's reserve is never written
+				VkDeviceSize const commandOffset = static_cast<VkDeviceSize>(bucket.m_commandBase) * commandStride;
+				uint32 const commandCount = static_cast<uint32>(bucket.m_objects.size()) * (m_useClusterCulling ? bucket.m_meshletCount : 1u);
+				if (m_useDrawIndirectCount)
+				{
+					vkCmdDrawIndexedIndirectCount(_commandBuffer, frame.m_commands.GetBuffer(), commandOffset, frame.m_counts.GetBuffer(), sizeof(uint32) * i, commandCount, commandStride);
+				}
+				else
+				{
+					// Culled objects still have a command, just with no instances
+					vkCmdDrawIndexedIndirect(_commandBuffer, frame.m_commands.GetBuffer(), commandOffset, commandCount, commandStride);
+				}
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::CreatePipeline()
+		{
+			VkDevice const logicalDevice = m_renderer.GetDevice().GetLogicalDevice();
+
+			VkPushConstantRange pushConstantRange{};
+			pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			pushConstantRange.offset = 0;
+			pushConstantRange.size = sizeof(PushConstants);
+
+			VkDescriptorSetLayout const setLayout = m_layout.GetLayout();
+			VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+			pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+			pipelineLayoutInfo.setLayoutCount = 1;
+			pipelineLayoutInfo.pSetLayouts = &setLayout;
+			pipelineLayoutInfo.pushConstantRangeCount = 1;
+			pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+			if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create culling pipeline layout!");
+			}
+
+			char const* const shader = m_useClusterCulling ? "Shaders/Compute/cluster_cull_comp.spv" : "Shaders/Compute/cull_comp.spv";
+			VkShaderModule const computeShaderModule = m_renderer.CreateShaderModule(std::string(DATA_DIRECTORY) + shader);
+
+			VkComputePipelineCreateInfo pipelineInfo{};
+			pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+			pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+			pipelineInfo.stage.module = computeShaderModule;
+			pipelineInfo.stage.pName = "main";
+			pipelineInfo.layout = m_pipelineLayout;
+
+			if (vkCreateComputePipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create culling pipeline!");
+			}
+
+			vkDestroyShaderModule(logicalDevice, computeShaderModule, nullptr);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::CreateFrameBuffers(Frame& io_frame, uint32 _objectCapacity, uint32 _bucketCapacity, uint32 _meshletCapacity, uint32 _clusterCapacity, uint32 _commandCapacity)
+		{
+			VkDevice const logicalDevice = m_renderer.GetDevice().GetLogicalDevice();
+
+			VkBufferCreateInfo bufferInfo{};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			// Written from the CPU as objects change, so kept mapped
+			bufferInfo.size = sizeof(GpuObjectData) * _objectCapacity;
+			bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+			io_frame.m_objects.CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			if (vkMapMemory(logicalDevice, io_frame.m_objects.GetBufferMemory(), 0, bufferInfo.size, 0, &io_frame.m_mappedObjects) != VK_SUCCESS) {
+				throw std::runtime_error("failed to map object buffer!");
+			}
+
+			bufferInfo.size = sizeof(GpuDrawBucket) * _bucketCapacity;
+			io_frame.m_buckets.CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			if (vkMapMemory(logicalDevice, io_frame.m_buckets.GetBufferMemory(), 0, bufferInfo.size, 0, &io_frame.m_mappedBuckets) != VK_SUCCESS) {
+				throw std::runtime_error("failed to map bucket buffer!");
+			}
+
+			bufferInfo.size = sizeof(Meshlet) * _meshletCapacity;
+			io_frame.m_meshlets.CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			if (vkMapMemory(logicalDevice, io_frame.m_meshlets.GetBufferMemory(), 0, bufferInfo.size, 0, &io_frame.m_mappedMeshlets) != VK_SUCCESS) {
+				throw std::runtime_error("failed to map meshlet buffer!");
+			}
+
+			bufferInfo.size = sizeof(GpuCluster) * _clusterCapacity;
+			io_frame.m_clusters.CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			if (vkMapMemory(logicalDevice, io_frame.m_clusters.GetBufferMemory(), 0, bufferInfo.size, 0, &io_frame.m_mappedClusters) != VK_SUCCESS) {
+				throw std::runtime_error("failed to map cluster buffer!");
+			}
+
+			// Only ever touched by the GPU, one command per reserved object or cluster slot
+			bufferInfo.size = sizeof(VkDrawIndexedIndirectCommand) * _commandCapacity;
+			bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+			io_frame.m_commands.CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			bufferInfo.size = sizeof(uint32) * _bucketCapacity;
+			bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			io_frame.m_counts.CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			io_frame.m_objectCapacity = _objectCapacity;
+			io_frame.m_bucketCapacity = _bucketCapacity;
+			io_frame.m_meshletCapacity = _meshletCapacity;
+			io_frame.m_clusterCapacity = _clusterCapacity;
+			io_frame.m_commandCapacity = _commandCapacity;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::DestroyFrameBuffers(Frame& io_frame)
+		{
+			VkDevice const logicalDevice = m_renderer.GetDevice().GetLogicalDevice();
+			vkUnmapMemory(logicalDevice, io_frame.m_objects.GetBufferMemory());
+			vkUnmapMemory(logicalDevice, io_frame.m_buckets.GetBufferMemory());
+			vkUnmapMemory(logicalDevice, io_frame.m_meshlets.GetBufferMemory());
+			vkUnmapMemory(logicalDevice, io_frame.m_clusters.GetBufferMemory());
+
+			io_frame.m_objects.DestroyBuffer();
+			io_frame.m_buckets.DestroyBuffer();
+			io_frame.m_commands.DestroyBuffer();
+			io_frame.m_counts.DestroyBuffer();
+			io_frame.m_meshlets.DestroyBuffer();
+			io_frame.m_clusters.DestroyBuffer();
+
+			io_frame.m_mappedObjects = nullptr;
+			io_frame.m_mappedBuckets = nullptr;
+			io_frame.m_mappedMeshlets = nullptr;
+			io_frame.m_mappedClusters = nullptr;
+			io_frame.m_objectCapacity = 0u;
+			io_frame.m_bucketCapacity = 0u;
+			io_frame.m_meshletCapacity = 0u;
+			io_frame.m_clusterCapacity = 0u;
+			io_frame.m_commandCapacity = 0u;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::WriteDescriptorSet(Frame const& _frame) const
+		{
+			std::vector<uint8> const packed = m_layout.Pack({
+				DescriptorBinding::Buffer(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _frame.m_objects.GetBuffer(), 0, VK_WHOLE_SIZE),
+				DescriptorBinding::Buffer(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _frame.m_buckets.GetBuffer(), 0, VK_WHOLE_SIZE),
+				DescriptorBinding::Buffer(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _frame.m_commands.GetBuffer(), 0, VK_WHOLE_SIZE),
+				DescriptorBinding::Buffer(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _frame.m_counts.GetBuffer(), 0, VK_WHOLE_SIZE),
+				DescriptorBinding::Buffer(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _frame.m_meshlets.GetBuffer(), 0, VK_WHOLE_SIZE),
+				DescriptorBinding::Buffer(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _frame.m_clusters.GetBuffer(), 0, VK_WHOLE_SIZE),
+				DescriptorBinding::Buffer(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_lods->GetBuffer(), 0, VK_WHOLE_SIZE)
+			});
+			m_layout.Write(_frame.m_descriptorSet, packed.data());
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::GrowLodBuffer(uint32 _capacity)
+		{
+			// Only ever touched by the GPU. Left uninitialised, the shader clamps whatever it finds to the mesh's levels.
+			VkBufferCreateInfo bufferInfo{};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size = sizeof(uint32) * _capacity;
+			bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			Buffer* lods = new Buffer(m_renderer);
+			lods->CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			if (m_lods)
+			{
+				// The copy waits for the queue to go idle, after which no frame can still be reading the old buffer
+				m_lods->CopyBuffer(lods->GetBuffer());
+				delete m_lods;
+			}
+
+			m_lods = lods;
+			m_lodCapacity = _capacity;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::RebuildBuckets()
+		{
+			// Meshes without clusters are culled as one, covering their full detail range
+			m_meshlets.clear();
+			if (m_useClusterCulling)
+			{
+				for (Bucket& bucket : m_buckets)
+				{
+					bucket.m_meshletBase = static_cast<uint32>(m_meshlets.size());
+
+					std::vector<Meshlet> const& meshlets = bucket.m_mesh->GetMeshlets(bucket.m_submesh);
+					if (meshlets.empty())
+					{
+						Meshlet& whole = m_meshlets.emplace_back();
+						whole.m_boundingSphere = ToBufferedSpace(bucket.m_mesh->GetBoundingSphere(), bucket.m_mesh->GetDequantization());
+						whole.m_firstIndex = bucket.m_mesh->GetLod(0u, bucket.m_submesh).m_first;
+						whole.m_indexCount = bucket.m_mesh->GetLod(0u, bucket.m_submesh).m_count;
+						whole.m_vertexCount = bucket.m_mesh->GetVertexCount();
+					}
+					else
+					{
+						for (Meshlet meshlet : meshlets)
+						{
+							meshlet.m_boundingSphere = ToBufferedSpace(meshlet.m_boundingSphere, bucket.m_mesh->GetDequantization());
+							m_meshlets.push_back(meshlet);
+						}
+					}
+
+					bucket.m_meshletCount = static_cast<uint32>(m_meshlets.size()) - bucket.m_meshletBase;
+				}
+			}
+
+			// Each bucket owns a contiguous run of commands, one per object or cluster it has room for. Clusters sit in the
+			// same slots as their commands, the unused ones without an object.
+			uint32 commandBase = 0u;
+			for (Bucket& bucket : m_buckets)
+			{
+				bucket.m_commandBase = commandBase;
+				commandBase += bucket.m_objectCapacity * (m_useClusterCulling ? bucket.m_meshletCount : 1u);
+			}
+			m_commandCount = commandBase;
+
+			GpuCluster empty;
+			empty.m_object = UINT32_MAX;
+			m_clusters.assign(m_useClusterCulling ? m_commandCount : 0u, empty);
+			for (Frame& frame : m_frames)
+			{
+				frame.m_dirtyClusters.clear();
+				frame.m_isClusterDirty.assign(m_clusters.size(), false);
+			}
+
+			m_bucketsDirty = false;
+			for (uint32 i = 0; i < m_objects.size(); ++i)
+			{
+				PlaceObject(i);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::PlaceObject(uint32 _object)
+		{
+			if (m_bucketsDirty)
+			{
+				return; // Laid out with everything else before the next upload
+			}
+
+			GpuObjectData& object = m_objects[_object];
+			Bucket const& bucket = m_buckets[object.m_bucket];
+			if (!m_useClusterCulling)
+			{
+				object.m_commandSlot = bucket.m_commandBase + m_objectSlots[_object];
+				MarkObjectDirty(_object);
+				return;
+			}
+
+			object.m_commandSlot = bucket.m_commandBase + m_objectSlots[_object] * bucket.m_meshletCount;
+			MarkObjectDirty(_object);
+			for (uint32 meshlet = 0; meshlet < bucket.m_meshletCount; ++meshlet)
+			{
+				GpuCluster& cluster = m_clusters[object.m_commandSlot + meshlet];
+				cluster.m_object = _object;
+				cluster.m_meshlet = bucket.m_meshletBase + meshlet;
+				cluster.m_bucket = object.m_bucket;
+				cluster.m_commandSlot = object.m_commandSlot + meshlet;
+				MarkClusterDirty(object.m_commandSlot + meshlet);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::ClearSlot(Bucket const& _bucket, uint32 _slot)
+		{
+			if (m_bucketsDirty || !m_useClusterCulling)
+			{
+				return;
+			}
+
+			uint32 const first = _bucket.m_commandBase + _slot * _bucket.m_meshletCount;
+			for (uint32 cluster = first; cluster < first + _bucket.m_meshletCount; ++cluster)
+			{
+				m_clusters[cluster].m_object = UINT32_MAX;
+				MarkClusterDirty(cluster);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::MarkObjectDirty(uint32 _object)
+		{
+			for (Frame& frame : m_frames)
+			{
+				if (!frame.m_isDirty[_object])
+				{
+					frame.m_isDirty[_object] = true;
+					frame.m_dirtyObjects.push_back(_object);
+				}
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void GpuCullingPass::MarkClusterDirty(uint32 _cluster)
+		{
+			for (Frame& frame : m_frames)
+			{
+				if (!frame.m_isClusterDirty[_cluster])
+				{
+					frame.m_isClusterDirty[_cluster] = true;
+					frame.m_dirtyClusters.push_back(_cluster);
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <map>
+#include <tuple>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include <Singularity.Core/CoreDeclare.h>
+#include <Singularity.Render/Buffer.h>
+#include <Singularity.Render/DescriptorLayout.h>
+#include <Singularity.Render/Frustum.h>
+#include <Singularity.Render/GpuObjectData.h>
+#include <Singularity.Render/Mesh.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		class Material;
+		class Renderer;
+
+		// GPU driven path, a compute pass culls objects or their clusters and picks LODs, then draws go out indirect per bucket
+		class GpuCullingPass
+		{
+		public:
+			GpuCullingPass(Renderer& _renderer) : m_renderer(_renderer), m_layout(_renderer) {}
+
+			void Create();
+			void Destroy();
+			void CreateFrames(); // One per swap chain image, again whenever a rebuilt swap chain has a different number of them
+
+			uint32 AddObject(Mesh const* _mesh, uint32 _submesh, Material const* _material, glm::mat4 const& _model, glm::vec4 const& _tint = glm::vec4(1.0f)); // Meshes without indices are kept but never drawn
+			void SetObject(uint32 _object, glm::mat4 const& _model, glm::vec4 const& _tint);
+			void RemoveObject(uint32 _object); // Moves the last object into _object's index so the array stays packed
+
+			void Update(uint32 _imageIndex); // Also allocates the image's descriptor set for this frame
+			void Cull(VkCommandBuffer _commandBuffer, uint32 _imageIndex, Frustum const& _frustum, glm::vec3 const& _cameraPosition, float _lodScale) const;
+			void Draw(VkCommandBuffer _commandBuffer, uint32 _imageIndex, bool _depthOnly = false) const; // Depth only skips blended buckets and binds positions alone
+
+			VkBuffer GetObjectBuffer(uint32 _imageIndex) const { return m_frames[_imageIndex].m_objects.GetBuffer(); }
+			uint32 GetObjectCount() const { return static_cast<uint32>(m_objects.size()); }
+			uint32 GetBucketCount() const { return static_cast<uint32>(m_buckets.size()); }
+			uint32 GetClusterCount() const { return static_cast<uint32>(m_clusters.size()); } // Including the slots buckets keep in reserve
+			bool UsesDrawIndirectCount() const { return m_useDrawIndirectCount; }
+
+		private:
+			struct Bucket
+			{
+				Mesh const* m_mesh = nullptr;
+				uint32 m_submesh = 0u;
+				Material const* m_material = nullptr;
+				std::vector<uint32> m_objects; // In command slot order, the first m_objects.size() slots are in use
+				uint32 m_objectCapacity = c_initialBucketObjectCapacity;
+				uint32 m_commandBase = 0u; // One command per object, or per object and cluster, for the whole capacity
+				uint32 m_meshletBase = 0u;
+				uint32 m_meshletCount = 1u;
+			};
+
+			struct Frame
+			{
+				Frame(Renderer& _renderer) : m_objects(_renderer), m_buckets(_renderer), m_commands(_renderer), m_counts(_renderer), m_meshlets(_renderer), m_clusters(_renderer) {}
+
+				Buffer m_objects;
+				Buffer m_buckets;
+				Buffer m_commands;
+				Buffer m_counts;
+				Buffer m_meshlets;
+				Buffer m_clusters;
+				void* m_mappedObjects = nullptr;
+				void* m_mappedBuckets = nullptr;
+				void* m_mappedMeshlets = nullptr;
+				void* m_mappedClusters = nullptr;
+				uint32 m_objectCapacity = 0u;
+				uint32 m_bucketCapacity = 0u;
+				uint32 m_meshletCapacity = 0u;
+				uint32 m_clusterCapacity = 0u;
+				uint32 m_commandCapacity = 0u;
+
+				VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+
+				std::vector<uint32> m_dirtyObjects; // May hold indices past the end after removals, those are skipped
+				std::vector<bool> m_isDirty;
+				std::vector<uint32> m_dirtyClusters;
+				std::vector<bool> m_isClusterDirty;
+				bool m_fullUpload = true;
+			};
+
+			struct PushConstants
+			{
+				glm::vec4 m_planes[6];
+				glm::vec4 m_lodParameters = glm::vec4(0.0f); // Camera position, then pixels per unit at unit distance over the allowed pixel error
+				uint32 m_objectCount = 0u; // Clusters when culling clusters
+				uint32 m_compact = 0u;
+				float m_lodHysteresis = 0.0f;
+			};
+
+			void CreatePipeline();
+			void CreateFrameBuffers(Frame& io_frame, uint32 _objectCapacity, uint32 _bucketCapacity, uint32 _meshletCapacity, uint32 _clusterCapacity, uint32 _commandCapacity);
+			void DestroyFrameBuffers(Frame& io_frame);
+			void WriteDescriptorSet(Frame const& _frame) const;
+			void GrowLodBuffer(uint32 _capacity); // Waits for the GPU to go idle when there already is one, to copy it over
+			void RebuildBuckets();
+			void PlaceObject(uint32 _object); // Points the object and its clusters at its bucket slot and marks them for upload
+			void ClearSlot(Bucket const& _bucket, uint32 _slot); // Leaves the slot's clusters without an object
+			void MarkObjectDirty(uint32 _object);
+			void MarkClusterDirty(uint32 _cluster);
+
+			static uint32 constexpr c_initialObjectCapacity = 1024u;
+			static uint32 constexpr c_initialBucketCapacity = 64u;
+			static uint32 constexpr c_initialMeshletCapacity = 256u;
+			static uint32 constexpr c_initialClusterCapacity = 1024u;
+			static uint32 constexpr c_initialCommandCapacity = 1024u;
+			static uint32 constexpr c_initialBucketObjectCapacity = 4u;
+			static uint32 constexpr c_workgroupSize = 64u;
+
+			Renderer& m_renderer;
+
+			DescriptorLayout m_layout;
+			VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+			VkPipeline m_pipeline = VK_NULL_HANDLE;
+			bool m_useDrawIndirectCount = false;
+			bool m_useClusterCulling = false;
+
+			std::vector<GpuObjectData> m_objects;
+			std::vector<uint32> m_objectSlots; // Each object's slot within its bucket
+			std::vector<Bucket> m_buckets;
+			std::map<std::tuple<Mesh const*, uint32, Material const*>, uint32> m_bucketLookup;
+			bool m_bucketsDirty = false; // Slots are only valid while this is clear
+			uint32 m_commandCount = 0u; // Reserved by every bucket together
+
+			std::vector<Meshlet> m_meshlets; // Every bucket's mesh clusters, laid end to end
+			std::vector<GpuCluster> m_clusters;
+
+			Buffer* m_lods = nullptr; // Each object's last level of detail, shared by every image since it carries across frames
+			uint32 m_lodCapacity = 0u;
+
+			std::vector<Frame> m_frames; // One per swap chain image
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include <glm/matrix.hpp>
+#include <glm/vec4.hpp>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+    namespace Render
+    {
+
+        // Per-object data for GPU driven rendering, read by the culling compute shader and by the vertex shader through
+        // gl_InstanceIndex (descriptor set 0, binding 1), std430 layout
+        struct GpuObjectData
+        {
+            glm::mat4 m_model = glm::mat4(1.0f);
+            glm::vec4 m_tint = glm::vec4(1.0f);
+            glm::vec4 m_boundingSphere = glm::vec4(0.0f); // Local space centre (xyz) and radius (w)
+            uint32 m_textureIndex = 0u;
+            uint32 m_bucket = 0u; // Which mesh/material draw this object belongs to
+            uint32 m_commandSlot = 0u; // Fixed command slot, only used when draws can't be compacted
+            uint32 m_padding = 0u;
+        };
+
+        // One per object and cluster when culling clusters, the meshlet indexes every bucket's clusters laid end to end
+        struct GpuCluster
+        {
+            uint32 m_object = 0u; // UINT32_MAX for slots a bucket keeps in reserve
+            uint32 m_meshlet = 0u;
+            uint32 m_bucket = 0u;
+            uint32 m_commandSlot = 0u; // Fixed command slot, only used when draws can't be compacted
+        };
+
+        // One per mesh/material pair, tells the culling shader where that draw's commands start and which index range
+        // each of the mesh's levels of detail covers
+        struct GpuDrawBucket
+        {
+            uint32 m_commandBase = 0u;
+            uint32 m_lodCount = 1u;
+            uint32 m_padding[2] = {};
+            glm::uvec4 m_firstIndex = glm::uvec4(0u); // Finest level first, up to Mesh::c_maxLodCount
+            glm::uvec4 m_indexCount = glm::uvec4(0u);
+            glm::vec4 m_lodError = glm::vec4(0.0f);
+        };
+
+    }
+}
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "InstanceBatcher.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <functional>
+#include <tuple>
+
+#include <Singularity.Render/Material.h>
+#include <Singularity.Render/Mesh.h>
+#include <Singularity.Render/Renderer.h>
+#include <Singularity.Render/RenderQueue.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		//////////////////////////////////////////////////////////////////////////////////////
+		void InstanceBatcher::Create()
+		{
+			uint32 const imageViewCount = static_cast<uint32>(m_renderer.GetSwapChain().GetImageViews().size());
+			m_instanceBuffers.reserve(imageViewCount);
+			m_mappedInstances.resize(imageViewCount, nullptr);
+			m_capacities.resize(imageViewCount, 0u);
+
+			for (uint32 i = 0; i < imageViewCount; ++i)
+			{
+				m_instanceBuffers.emplace_back(m_renderer);
+				CreateInstanceBuffer(i, c_initialCapacity);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void InstanceBatcher::Destroy()
+		{
+			for (uint32 i = 0; i < m_instanceBuffers.size(); ++i)
+			{
+				DestroyInstanceBuffer(i);
+			}
+
+			m_instanceBuffers.clear();
+			m_mappedInstances.clear();
+			m_capacities.clear();
+
+			Begin();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void InstanceBatcher::Begin()
+		{
+			m_items.clear();
+			m_order.clear();
+			m_batches.clear();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void InstanceBatcher::Add(VkPipeline _pipeline, Mesh const* _mesh, uint32 _submesh, uint32 _lod, Material const* _material, InstanceData const& _instance)
+		{
+			Item& item = m_items.emplace_back();
+			item.m_pipeline = _pipeline;
+			item.m_mesh = _mesh;
+			item.m_submesh = _submesh;
+			item.m_lod = _lod;
+			item.m_material = _material;
+			item.m_instance = _instance;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void InstanceBatcher::Build(uint32 _imageIndex)
+		{
+			uint32 const instanceCount = static_cast<uint32>(m_items.size());
+
+			if (instanceCount > m_capacities[_imageIndex])
+			{
+				// Only this image's buffer is replaced, its previous frame has already retired
+				uint32 capacity = std::max(m_capacities[_imageIndex], c_initialCapacity);
+				while (capacity < instanceCount)
+				{
+					capacity *= 2u;
+				}
+
+				DestroyInstanceBuffer(_imageIndex);
+				CreateInstanceBuffer(_imageIndex, capacity);
+			}
+
+			// Sort by pipeline, then material, then mesh so state changes between groups are as cheap as possible, a mesh's
+			// submeshes and LODs share its buffers so they split draws but never add binds
+			m_order.resize(instanceCount);
+			for (uint32 i = 0; i < instanceCount; ++i)
+			{
+				m_order[i] = i;
+			}
+
+			std::sort(m_order.begin(), m_order.end(), [this](uint32 _a, uint32 _b)
+			{
+				Item const& a = m_items[_a];
+				Item const& b = m_items[_b];
+				// Pointers to unrelated objects only have a total order through std::less
+				if (a.m_pipeline != b.m_pipeline)
+				{
+					return std::less<VkPipeline>()(a.m_pipeline, b.m_pipeline);
+				}
+				if (a.m_material != b.m_material)
+				{
+					return std::less<Material const*>()(a.m_material, b.m_material);
+				}
+				if (a.m_mesh != b.m_mesh)
+				{
+					return std::less<Mesh const*>()(a.m_mesh, b.m_mesh);
+				}
+				return std::tie(a.m_submesh, a.m_lod) < std::tie(b.m_submesh, b.m_lod);
+			});
+
+			m_batches.clear();
+			InstanceData* const instances = static_cast<InstanceData*>(m_mappedInstances[_imageIndex]);
+			for (uint32 i = 0; i < instanceCount; ++i)
+			{
+				Item const& item = m_items[m_order[i]];
+				instances[i] = item.m_instance;
+
+				if (m_batches.empty() || m_batches.back().m_pipeline != item.m_pipeline || m_batches.back().m_material != item.m_material || m_batches.back().m_mesh != item.m_mesh || m_batches.back().m_submesh != item.m_submesh || m_batches.back().m_lod != item.m_lod)
+				{
+					Batch& batch = m_batches.emplace_back();
+					batch.m_pipeline = item.m_pipeline;
+					batch.m_mesh = item.m_mesh;
+					batch.m_submesh = item.m_submesh;
+					batch.m_lod = item.m_lod;
+					batch.m_material = item.m_material;
+					batch.m_firstInstance = i;
+				}
+
+				++m_batches.back().m_instanceCount;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void InstanceBatcher::Submit(RenderQueue& io_queue) const
+		{
+			for (Batch const& batch : m_batches)
+			{
+				DrawPacket packet;
+				packet.m_pipeline = batch.m_pipeline;
+				packet.m_material = batch.m_material;
+				packet.m_mesh = batch.m_mesh;
+				packet.m_submesh = batch.m_submesh;
+				packet.m_lod = batch.m_lod;
+				packet.m_firstInstance = batch.m_firstInstance; // Offsets gl_InstanceIndex into this group's slice of the buffer
+				packet.m_instanceCount = batch.m_instanceCount;
+
+				// A group sorts by its closest instance when opaque and its furthest when blended
+				float nearestDepth = FLT_MAX;
+				float furthestDepth = -FLT_MAX;
+				for (uint32 i = batch.m_firstInstance; i < batch.m_firstInstance + batch.m_instanceCount; ++i)
+				{
+					float const depth = io_queue.GetViewDepth(glm::vec3(m_items[m_order[i]].m_instance.m_model[3]));
+					nearestDepth = std::min(nearestDepth, depth);
+					furthestDepth = std::max(furthestDepth, depth);
+				}
+
+				io_queue.Submit(packet, batch.m_material->IsBlended() ? furthestDepth : nearestDepth);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void InstanceBatcher::CreateInstanceBuffer(uint32 _imageIndex, uint32 _capacity)
+		{
+			VkBufferCreateInfo bufferInfo{};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size = sizeof(InstanceData) * _capacity;
+			bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			Buffer& buffer = m_instanceBuffers[_imageIndex];
+			buffer.CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+			// Written every frame, so it stays mapped for its whole lifetime
+			if (vkMapMemory(m_renderer.GetDevice().GetLogicalDevice(), buffer.GetBufferMemory(), 0, bufferInfo.size, 0, &m_mappedInstances[_imageIndex]) != VK_SUCCESS) {
+				throw std::runtime_error("failed to map instance buffer!");
+			}
+
+			m_capacities[_imageIndex] = _capacity;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void InstanceBatcher::DestroyInstanceBuffer(uint32 _imageIndex)
+		{
+			Buffer& buffer = m_instanceBuffers[_imageIndex];
+			vkUnmapMemory(m_renderer.GetDevice().GetLogicalDevice(), buffer.GetBufferMemory());
+			buffer.DestroyBuffer();
+
+			m_mappedInstances[_imageIndex] = nullptr;
+			m_capacities[_imageIndex] = 0u;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include <Singularity.Core/CoreDeclare.h>
+#include <Singularity.Render/Buffer.h>
+#include <Singularity.Render/InstanceData.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		class Material;
+		class Mesh;
+		class Renderer;
+		class RenderQueue;
+
+		// Collects the objects submitted for a frame, groups those sharing pipeline, material, mesh and LOD, and writes their
+		// instance data contiguously into the frame's storage buffer so each group is a single instanced draw.
+		class InstanceBatcher
+		{
+		public:
+			InstanceBatcher(Renderer& _renderer) : m_renderer(_renderer) {}
+
+			void Create();
+			void Destroy();
+
+			void Begin();
+			void Add(VkPipeline _pipeline, Mesh const* _mesh, uint32 _submesh, uint32 _lod, Material const* _material, InstanceData const& _instance);
+			void Build(uint32 _imageIndex);
+			void Submit(RenderQueue& io_queue) const;
+
+			VkBuffer GetInstanceBuffer(uint32 _imageIndex) const { return m_instanceBuffers[_imageIndex].GetBuffer(); }
+			VkDeviceSize GetInstanceBufferSize(uint32 _imageIndex) const { return m_instanceBuffers[_imageIndex].GetDeviceSize(); }
+
+			uint32 GetInstanceCount() const { return static_cast<uint32>(m_items.size()); }
+			uint32 GetDrawCount() const { return static_cast<uint32>(m_batches.size()); }
+
+		private:
+			struct Item
+			{
+				VkPipeline m_pipeline = VK_NULL_HANDLE;
+				Mesh const* m_mesh = nullptr;
+				uint32 m_submesh = 0u;
+				uint32 m_lod = 0u;
+				Material const* m_material = nullptr;
+				InstanceData m_instance;
+			};
+
+			struct Batch
+			{
+				VkPipeline m_pipeline = VK_NULL_HANDLE;
+				Mesh const* m_mesh = nullptr;
+				uint32 m_submesh = 0u;
+				uint32 m_lod = 0u;
+				Material const* m_material = nullptr;
+				uint32 m_firstInstance = 0u;
+				uint32 m_instanceCount = 0u;
+			};
+
+			void CreateInstanceBuffer(uint32 _imageIndex, uint32 _capacity);
+			void DestroyInstanceBuffer(uint32 _imageIndex);
+
+			static uint32 constexpr c_initialCapacity = 1024u;
+
+			Renderer& m_renderer;
+
+			std::vector<Item> m_items;
+			std::vector<uint32> m_order;
+			std::vector<Batch> m_batches;
+
+			// One buffer per swap chain image, persistently mapped and grown when a frame outgrows it
+			std::vector<Buffer> m_instanceBuffers;
+			std::vector<void*> m_mappedInstances;
+			std::vector<uint32> m_capacities;
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+#include <glm/matrix.hpp>
+#include <glm/vec4.hpp>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+    namespace Render
+    {
+
+        // Per-instance data read from the instance storage buffer (descriptor set 0, binding 1) by gl_InstanceIndex, std430 layout
+        struct InstanceData
+        {
+            glm::mat4 m_model = glm::mat4(1.0f);
+            glm::vec4 m_tint = glm::vec4(1.0f);
+            uint32 m_textureIndex = 0u; // Slot in the bindless texture table
+            uint32 m_padding[3] = {};
+        };
+
+    }
+}
\ No newline at end of file
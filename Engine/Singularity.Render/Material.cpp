@@ -0,0 +1,51 @@
+#include "Material.h"
+
+#include <Singularity.Render/Renderer.h>
+#include <Singularity.Render/Texture.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Material::CreateDescriptorSet()
+		{
+			if (m_renderer.UseBindlessTextures())
+			{
+				// Texture lives in the global table and is picked by index in the shader, the material has no set of its own
+				m_textureIndex = m_renderer.GetBindlessTextureTable().Register(*m_textureRef);
+				return;
+			}
+
+			// Material data does not change between frames, so a single set is shared by every swap chain image.
+			// Materials using the same texture end up sharing the cached set.
+			DescriptorBinding const binding = DescriptorBinding::Image(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_textureRef->GetTextureImage().GetImageView(), m_textureRef->GetTextureSampler(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			m_descriptorSet = m_renderer.GetDescriptorSetCache().GetDescriptorSet(m_renderer.GetMaterialDescriptorLayout(), { binding });
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Material::Destroy()
+		{
+			if (m_renderer.UseBindlessTextures())
+			{
+				m_renderer.GetBindlessTextureTable().Unregister(m_textureIndex);
+				m_textureIndex = 0u;
+			}
+
+			// Non-bindless sets belong to the descriptor set cache and go away with it
+			m_descriptorSet = VK_NULL_HANDLE;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Material::Bind(VkCommandBuffer _commandBuffer) const
+		{
+			if (m_renderer.UseBindlessTextures())
+			{
+				// The table is bound once per command buffer
+				return;
+			}
+
+			vkCmdBindDescriptorSets(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_renderer.GetPipelineLayout(), Renderer::c_materialDescriptorSet, 1, &m_descriptorSet, 0, nullptr);
+		}
+	}
+}
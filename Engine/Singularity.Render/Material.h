@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		class Renderer;
+		class Texture;
+
+		class Material
+		{
+		public:
+			Material(Renderer& _renderer) : m_renderer(_renderer) {}
+
+			void SetTexture(Texture const* _texture) { m_textureRef = _texture; }
+			void SetBlended(bool _blended) { m_blended = _blended; }
+			bool IsBlended() const { return m_blended; }
+
+			void CreateDescriptorSet();
+			void Destroy();
+			void Bind(VkCommandBuffer _commandBuffer) const;
+
+			VkDescriptorSet GetDescriptorSet() const { return m_descriptorSet; }
+			uint32 GetTextureIndex() const { return m_textureIndex; }
+
+		private:
+			Renderer& m_renderer;
+
+			Texture const* m_textureRef = nullptr;
+
+			VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+			uint32 m_textureIndex = 0u;
+			bool m_blended = false; // Blended materials are drawn after opaque ones, back to front
+		};
+	}
+}
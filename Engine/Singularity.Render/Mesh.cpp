@@ -1,13 +1,110 @@
 #include "Mesh.h"
 
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 
+#include <Singularity.Render/MeshCodec.h>
+#include <Singularity.Render/MeshletBuilder.h>
+#include <Singularity.Render/MeshOptimizer.h>
+#include <Singularity.Render/MeshSimplifier.h>
 #include <Singularity.Render/Renderer.h>
 
 namespace Singularity
 {
 	namespace Render
 	{
+		namespace
+		{
+			void* CreateMappedStagingBuffer(VkDevice _logicalDevice, Render::Buffer& io_stagingBuffer, VkDeviceSize _size)
+			{
+				VkBufferCreateInfo stagingBufferInfo{};
+				stagingBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+				stagingBufferInfo.size = _size;
+				stagingBufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+				stagingBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+				io_stagingBuffer.CreateBuffer(stagingBufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+				void* data;
+				vkMapMemory(_logicalDevice, io_stagingBuffer.GetBufferMemory(), 0, _size, 0, &data);
+				return data;
+			}
+
+			Render::Buffer* CreateVertexBuffer(Renderer& _renderer, Render::Buffer& io_stagingBuffer)
+			{
+				vkUnmapMemory(_renderer.GetDevice().GetLogicalDevice(), io_stagingBuffer.GetBufferMemory());
+
+				VkBufferCreateInfo bufferInfo{};
+				bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+				bufferInfo.size = io_stagingBuffer.GetDeviceSize();
+				bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+				bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+				Render::Buffer* vertexBuffer = new Render::Buffer(_renderer);
+				vertexBuffer->CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+				io_stagingBuffer.CopyBuffer(vertexBuffer->GetBuffer());
+				io_stagingBuffer.DestroyBuffer();
+				return vertexBuffer;
+			}
+
+			// _write fills the mapped memory, which is all the CPU ever writes of the buffer
+			// Null when _write fails, in which case nothing is created or copied
+			Render::Buffer* UploadBuffer(Renderer& _renderer, VkDeviceSize _size, VkBufferUsageFlags _usage, std::function<bool(void* o_data)> const& _write)
+			{
+				VkDevice const logicalDevice = _renderer.GetDevice().GetLogicalDevice();
+
+				VkBufferCreateInfo bufferInfo{};
+				bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+				bufferInfo.size = _size;
+				bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+				Render::Buffer* buffer = new Render::Buffer(_renderer);
+
+				// With unified memory the GPU reads whatever the CPU writes in place, staging would only copy it again
+				if (_renderer.GetDevice().HasUnifiedMemory())
+				{
+					bufferInfo.usage = _usage;
+					buffer->CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+					void* data;
+					vkMapMemory(logicalDevice, buffer->GetBufferMemory(), 0, _size, 0, &data);
+					bool const written = _write(data);
+					vkUnmapMemory(logicalDevice, buffer->GetBufferMemory());
+					if (!written)
+					{
+						buffer->DestroyBuffer();
+						delete buffer;
+						return nullptr;
+					}
+					return buffer;
+				}
+
+				Render::Buffer stagingBuffer(_renderer);
+				bool const written = _write(CreateMappedStagingBuffer(logicalDevice, stagingBuffer, _size));
+				vkUnmapMemory(logicalDevice, stagingBuffer.GetBufferMemory());
+				if (!written)
+				{
+					stagingBuffer.DestroyBuffer();
+					delete buffer;
+					return nullptr;
+				}
+
+				bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | _usage;
+				buffer->CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+				stagingBuffer.CopyBuffer(buffer->GetBuffer());
+				stagingBuffer.DestroyBuffer();
+				return buffer;
+			}
+		}
+
 		//////////////////////////////////////////////////////////////////////////////////////
 		Mesh::~Mesh()
 		{
@@ -27,6 +124,12 @@ namespace Singularity
 
 			m_vertices = _vertices;
 			m_indices.clear();
+			m_vertexCount = static_cast<uint32>(m_vertices.size());
+			m_indexCount = 0u;
+			m_indexType = VK_INDEX_TYPE_UINT32;
+			m_submeshes.assign(1u, Submesh());
+			m_submeshes.front().m_lods.assign(1u, { 0u, GetVertexCount(), 0.0f });
+			CalculateBounds();
 			m_valid = true;
 		}
 
@@ -41,9 +144,204 @@ namespace Singularity
 
 			m_vertices = _vertices;
 			m_indices = _indices;
+			m_vertexCount = static_cast<uint32>(m_vertices.size());
+			m_indexCount = static_cast<uint32>(m_indices.size());
+			m_indexType = GetVertexCount() <= c_maxShortIndexVertexCount ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+			m_submeshes.assign(1u, Submesh());
+			m_submeshes.front().m_lods.assign(1u, { 0u, GetIndexCount(), 0.0f });
+			CalculateBounds();
 			m_valid = true;
 		}
 
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Mesh::SetData(std::vector<Vertex> const& _vertices, std::vector<uint32> _indices, std::vector<Submesh> _submeshes)
+		{
+			SetData(_vertices, _indices);
+
+			// Later passes treat the full detail ranges as one block at the front, so anything else is left as a single submesh
+			uint32 next = 0u;
+			bool tiled = !_submeshes.empty();
+			for (Submesh const& submesh : _submeshes)
+			{
+				if (submesh.m_lods.size() != 1u || submesh.m_lods.front().m_first != next)
+				{
+					tiled = false;
+					break;
+				}
+				next += submesh.m_lods.front().m_count;
+			}
+
+			if (!tiled || next != GetIndexCount())
+			{
+				std::cout << "Error: Submeshes must each have one range, back to back and covering every index!" << std::endl;
+				return;
+			}
+
+			m_submeshes = _submeshes;
+			for (Submesh& submesh : m_submeshes)
+			{
+				submesh.m_meshlets.clear();
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		uint32 Mesh::GetFullDetailIndexCount() const
+		{
+			uint32 count = 0u;
+			for (Submesh const& submesh : m_submeshes)
+			{
+				count += submesh.m_lods.front().m_count;
+			}
+			return count;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Mesh::GenerateLods(uint32 _lodCount)
+		{
+			if (m_buffered)
+			{
+				std::cout << "Error: Generating LODs for an already buffered mesh!" << std::endl;
+				return;
+			}
+
+			if (!UseIndices())
+			{
+				std::cout << "Error: LODs can only be generated for indexed meshes!" << std::endl;
+				return;
+			}
+
+			m_indexCount = GetFullDetailIndexCount();
+			m_indices.resize(m_indexCount);
+
+			// Each level halves the one before it, simplifying the previous level rather than the original. Submeshes
+			// simplify on their own, the edges they share are open borders to each and stay locked.
+			_lodCount = std::min(_lodCount, c_maxLodCount);
+			for (Submesh& submesh : m_submeshes)
+			{
+				submesh.m_lods.resize(1u);
+
+				std::vector<uint32> source(m_indices.begin() + submesh.m_lods.front().m_first, m_indices.begin() + submesh.m_lods.front().m_first + submesh.m_lods.front().m_count);
+				for (uint32 lod = 1u; lod < _lodCount; ++lod)
+				{
+					uint32 const targetIndexCount = (static_cast<uint32>(source.size()) / 6u) * 3u;
+
+					float error = 0.0f;
+					std::vector<uint32> simplified = MeshSimplifier::Simplify(m_vertices, source, targetIndexCount, FLT_MAX, &error);
+					if (simplified.empty() || simplified.size() * 10u > source.size() * 9u)
+					{
+						// Locked borders and seams stop further progress, another level would cost memory for nothing
+						break;
+					}
+
+					MeshLod& level = submesh.m_lods.emplace_back();
+					level.m_first = GetIndexCount();
+					level.m_count = static_cast<uint32>(simplified.size());
+					level.m_error = submesh.m_lods[lod - 1u].m_error + error;
+
+					m_indices.insert(m_indices.end(), simplified.begin(), simplified.end());
+					m_indexCount = static_cast<uint32>(m_indices.size());
+					source.swap(simplified);
+				}
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Mesh::BuildMeshlets()
+		{
+			if (m_buffered)
+			{
+				std::cout << "Error: Building meshlets for an already buffered mesh!" << std::endl;
+				return;
+			}
+
+			if (!UseIndices())
+			{
+				std::cout << "Error: Meshlets can only be built for indexed meshes!" << std::endl;
+				return;
+			}
+
+			// Only triangle order changes, so coarser levels and anything else reading the range are unaffected
+			for (Submesh& submesh : m_submeshes)
+			{
+				MeshletBuilder::Build(m_vertices, m_indices, submesh.m_lods.front().m_first, submesh.m_lods.front().m_count, submesh.m_meshlets);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Mesh::Optimize(VertexCacheStats* o_before, VertexCacheStats* o_after)
+		{
+			if (m_buffered)
+			{
+				std::cout << "Error: Optimizing already buffered mesh!" << std::endl;
+				return;
+			}
+
+			if (!UseIndices())
+			{
+				return;
+			}
+
+			if (o_before)
+			{
+				*o_before = MeshOptimizer::AnalyzeVertexCache(m_indices, 0u, GetFullDetailIndexCount(), GetVertexCount());
+			}
+
+			// Meshlets pin which triangles share a run, so those are only reordered within themselves. Their few vertices
+			// are numbered locally first, so the optimizer's tables are sized to the meshlet rather than the whole mesh.
+			std::vector<uint32> localIndices;
+			std::vector<uint32> localVertices; // Mesh vertex of each local one
+			std::vector<uint32> vertexToLocal;
+			for (Submesh const& submesh : m_submeshes)
+			{
+				for (uint32 lod = 0; lod < submesh.m_lods.size(); ++lod)
+				{
+					if (lod == 0u && !submesh.m_meshlets.empty())
+					{
+						vertexToLocal.resize(GetVertexCount(), UINT32_MAX);
+						for (Meshlet const& meshlet : submesh.m_meshlets)
+						{
+							uint32* const indices = m_indices.data() + meshlet.m_firstIndex;
+							localIndices.resize(meshlet.m_indexCount);
+							localVertices.clear();
+							for (uint32 i = 0; i < meshlet.m_indexCount; ++i)
+							{
+								uint32& local = vertexToLocal[indices[i]];
+								if (local == UINT32_MAX)
+								{
+									local = static_cast<uint32>(localVertices.size());
+									localVertices.push_back(indices[i]);
+								}
+								localIndices[i] = local;
+							}
+
+							MeshOptimizer::OptimizeVertexCache(localIndices, 0u, meshlet.m_indexCount, static_cast<uint32>(localVertices.size()));
+
+							for (uint32 i = 0; i < meshlet.m_indexCount; ++i)
+							{
+								indices[i] = localVertices[localIndices[i]];
+							}
+
+							for (uint32 vertex : localVertices)
+							{
+								vertexToLocal[vertex] = UINT32_MAX;
+							}
+						}
+						continue;
+					}
+
+					MeshOptimizer::OptimizeVertexCache(m_indices, submesh.m_lods[lod].m_first, submesh.m_lods[lod].m_count, GetVertexCount());
+					MeshOptimizer::OptimizeOverdraw(m_vertices, m_indices, submesh.m_lods[lod].m_first, submesh.m_lods[lod].m_count);
+				}
+			}
+
+			MeshOptimizer::OptimizeVertexFetch(m_vertices, m_indices);
+
+			if (o_after)
+			{
+				*o_after = MeshOptimizer::AnalyzeVertexCache(m_indices, 0u, GetFullDetailIndexCount(), GetVertexCount());
+			}
+		}
+
 		//////////////////////////////////////////////////////////////////////////////////////
 		void Mesh::Buffer(Renderer& _renderer)
 		{
@@ -62,38 +360,32 @@ namespace Singularity
 
 			VkDevice const logicalDevice = _renderer.GetDevice().GetLogicalDevice();
 
+			VertexFormat const& vertexFormat = _renderer.GetVertexFormat();
+			VkDeviceSize const vertexCount = GetVertexCount();
+			if (vertexFormat.HasSplitPositions())
 			{
-				VkDeviceSize const vertexBufferSize = sizeof(Vertex) * GetVertexCount();
-				VkBufferCreateInfo vertexStagingBufferInfo{};
-				vertexStagingBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-				vertexStagingBufferInfo.size = vertexBufferSize;
-				vertexStagingBufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-				vertexStagingBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-				Render::Buffer stagingBuffer(_renderer);
-				stagingBuffer.CreateBuffer(vertexStagingBufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-				
-				void* data;
-				vkMapMemory(logicalDevice, stagingBuffer.GetBufferMemory(), 0, vertexStagingBufferInfo.size, 0, &data);
-				memcpy(data, m_vertices.data(), (size_t)vertexStagingBufferInfo.size);
-				vkUnmapMemory(logicalDevice, stagingBuffer.GetBufferMemory());
-
-				VkBufferCreateInfo bufferInfo{};
-				bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-				bufferInfo.size = vertexBufferSize;
-				bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-				bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+				Render::Buffer positionStagingBuffer(_renderer);
+				Render::Buffer attributeStagingBuffer(_renderer);
+				void* positionData = CreateMappedStagingBuffer(logicalDevice, positionStagingBuffer, vertexFormat.GetPositionStride() * vertexCount);
+				void* attributeData = CreateMappedStagingBuffer(logicalDevice, attributeStagingBuffer, (vertexFormat.GetStride() - vertexFormat.GetPositionStride()) * vertexCount);
+				vertexFormat.Encode(m_vertices, m_dequantization, positionData, attributeData);
 
-				m_vertexBuffer = new Render::Buffer(_renderer);
-				m_vertexBuffer->CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+				m_positionBuffer = CreateVertexBuffer(_renderer, positionStagingBuffer);
+				m_vertexBuffer = CreateVertexBuffer(_renderer, attributeStagingBuffer);
+			}
+			else
+			{
+				Render::Buffer stagingBuffer(_renderer);
+				void* data = CreateMappedStagingBuffer(logicalDevice, stagingBuffer, vertexFormat.GetStride() * vertexCount);
+				vertexFormat.Encode(m_vertices, m_dequantization, data);
 
-				stagingBuffer.CopyBuffer(m_vertexBuffer->GetBuffer());
-				stagingBuffer.DestroyBuffer();
+				m_vertexBuffer = CreateVertexBuffer(_renderer, stagingBuffer);
 			}
 
 			if (UseIndices())
 			{
-				VkDeviceSize const indexBufferSize = sizeof(uint32) * GetIndexCount();
+				bool const shortIndices = m_indexType == VK_INDEX_TYPE_UINT16;
+				VkDeviceSize const indexBufferSize = (shortIndices ? sizeof(uint16) : sizeof(uint32)) * GetIndexCount();
 
 				VkBufferCreateInfo indexStagingBufferInfo{};
 				indexStagingBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -106,7 +398,14 @@ namespace Singularity
 
 				void* data;
 				vkMapMemory(logicalDevice, stagingBuffer.GetBufferMemory(), 0, indexBufferSize, 0, &data);
-				memcpy(data, m_indices.data(), (size_t)indexBufferSize);
+				if (shortIndices)
+				{
+					std::copy(m_indices.begin(), m_indices.end(), static_cast<uint16*>(data));
+				}
+				else
+				{
+					memcpy(data, m_indices.data(), (size_t)indexBufferSize);
+				}
 				vkUnmapMemory(logicalDevice, stagingBuffer.GetBufferMemory());
 
 				VkBufferCreateInfo bufferInfo{};
@@ -125,6 +424,105 @@ namespace Singularity
 			m_buffered = true;
 		}
 
+		//////////////////////////////////////////////////////////////////////////////////////
+		bool Mesh::Buffer(Renderer& _renderer, EncodedMesh const& _encoded, float* o_decodeSeconds)
+		{
+			if (m_buffered)
+			{
+				std::cout << "Error: Attempting to buffer already buffered data!" << std::endl;
+				return false;
+			}
+
+			// Only what drawing needs stays on the CPU, and with no vertices left the mesh is no longer valid to buffer
+			m_vertices.clear();
+			m_indices.clear();
+			m_vertexCount = _encoded.m_vertexCount;
+			m_indexCount = _encoded.m_indexCount;
+			m_indexType = _encoded.m_indexType;
+			m_submeshes = _encoded.m_submeshes;
+			m_boundingSphere = _encoded.m_boundingSphere;
+			m_boundsMinimum = _encoded.m_boundsMinimum;
+			m_boundsMaximum = _encoded.m_boundsMaximum;
+			m_dequantization = _encoded.m_dequantization;
+			m_valid = false;
+
+			// Compressed streams decode straight into the mapped memory, raw ones are copied as they are
+			auto const upload = [&](void const* _data, size_t _encodedSize, VkDeviceSize _size, uint32 _stride, VkBufferUsageFlags _usage)
+			{
+				return UploadBuffer(_renderer, _size, _usage, [&](void* o_data)
+				{
+					auto const start = std::chrono::high_resolution_clock::now();
+
+					bool decoded = true;
+					if (!_encoded.m_compressed)
+					{
+						memcpy(o_data, _data, (size_t)_size);
+					}
+					else if (_usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+					{
+						decoded = MeshCodec::DecodeIndices(static_cast<uint8 const*>(_data), _encodedSize, GetIndexCount(), _stride, o_data);
+					}
+					else
+					{
+						decoded = MeshCodec::DecodeVertices(static_cast<uint8 const*>(_data), _encodedSize, GetVertexCount(), _stride, o_data);
+					}
+
+					if (o_decodeSeconds)
+					{
+						*o_decodeSeconds += std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - start).count();
+					}
+					return decoded;
+				});
+			};
+
+			// The streams are trusted to match the renderer's format, whoever encoded them has to check that
+			VertexFormat const& vertexFormat = _renderer.GetVertexFormat();
+			VkDeviceSize const vertexCount = GetVertexCount();
+			if (vertexFormat.HasSplitPositions())
+			{
+				uint32 const attributeStride = vertexFormat.GetStride() - vertexFormat.GetPositionStride();
+				m_positionBuffer = upload(_encoded.m_positions, _encoded.m_positionsSize, vertexFormat.GetPositionStride() * vertexCount, vertexFormat.GetPositionStride(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+				m_vertexBuffer = m_positionBuffer ? upload(_encoded.m_vertices, _encoded.m_verticesSize, attributeStride * vertexCount, attributeStride, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) : nullptr;
+			}
+			else
+			{
+				m_vertexBuffer = upload(_encoded.m_vertices, _encoded.m_verticesSize, vertexFormat.GetStride() * vertexCount, vertexFormat.GetStride(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+			}
+
+			if (m_vertexBuffer && UseIndices())
+			{
+				uint32 const indexSize = m_indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16) : sizeof(uint32);
+				m_indexBuffer = upload(_encoded.m_indices, _encoded.m_indicesSize, static_cast<VkDeviceSize>(indexSize) * GetIndexCount(), indexSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+			}
+
+			// A stream that fails to decode leaves nothing behind, the mesh stays unbuffered
+			if (!m_vertexBuffer || (UseIndices() && !m_indexBuffer))
+			{
+				std::cout << "Error: Failed to decode compressed mesh data!" << std::endl;
+				Unbuffer();
+				return false;
+			}
+
+			m_buffered = true;
+			return true;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Mesh::BindVertexBuffers(VkCommandBuffer _commandBuffer, bool _positionsOnly) const
+		{
+			VkDeviceSize offsets[] = { 0, 0 };
+			if (!m_positionBuffer)
+			{
+				VkBuffer vertexBuffers[] = { m_vertexBuffer->GetBuffer() };
+				vkCmdBindVertexBuffers(_commandBuffer, 0, 1, vertexBuffers, offsets);
+				return;
+			}
+
+			// Split streams sit at bindings 0 and 1, matching the vertex format
+			VkBuffer vertexBuffers[] = { m_positionBuffer->GetBuffer(), m_vertexBuffer->GetBuffer() };
+			vkCmdBindVertexBuffers(_commandBuffer, 0, _positionsOnly ? 1 : 2, vertexBuffers, offsets);
+		}
+
 		//////////////////////////////////////////////////////////////////////////////////////
 		void Mesh::Unbuffer()
 		{
@@ -142,8 +540,62 @@ namespace Singularity
 				m_vertexBuffer = nullptr;
 			}
 
+			if (m_positionBuffer)
+			{
+				m_positionBuffer->DestroyBuffer();
+				delete m_positionBuffer;
+				m_positionBuffer = nullptr;
+			}
+
 			m_buffered = false;
 		}
 
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Mesh::CalculateBounds()
+		{
+			if (m_vertices.empty())
+			{
+				m_boundingSphere = glm::vec4(0.0f);
+				m_boundsMinimum = glm::vec3(0.0f);
+				m_boundsMaximum = glm::vec3(0.0f);
+				m_dequantization = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+				return;
+			}
+
+			// Sphere around the centre of the box, loose but cheap and stable
+			glm::vec3 minimum = m_vertices.front().m_position;
+			glm::vec3 maximum = minimum;
+			for (Vertex const& vertex : m_vertices)
+			{
+				minimum = glm::min(minimum, vertex.m_position);
+				maximum = glm::max(maximum, vertex.m_position);
+			}
+
+			glm::vec3 const centre = (minimum + maximum) * 0.5f;
+			float radiusSquared = 0.0f;
+			for (Vertex const& vertex : m_vertices)
+			{
+				glm::vec3 const offset = vertex.m_position - centre;
+				radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+			}
+
+			m_boundingSphere = glm::vec4(centre, std::sqrt(radiusSquared));
+			m_boundsMinimum = minimum;
+			m_boundsMaximum = maximum;
+
+			// One scale for every axis keeps dequantization a similarity transform, so spheres and normals survive it
+			glm::vec3 const halfExtent = (maximum - minimum) * 0.5f;
+			float const scale = std::max(halfExtent.x, std::max(halfExtent.y, halfExtent.z));
+			m_dequantization = glm::vec4(centre, scale > 0.0f ? scale : 1.0f);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		glm::mat4 Mesh::GetDequantizeTransform() const
+		{
+			glm::mat4 transform = glm::scale(glm::mat4(1.0f), glm::vec3(m_dequantization.w));
+			transform[3] = glm::vec4(glm::vec3(m_dequantization), 1.0f);
+			return transform;
+		}
+
 	}
 }
\ No newline at end of file
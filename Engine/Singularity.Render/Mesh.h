@@ -1,6 +1,6 @@
 #pragma once
-#include <array>
 
+#include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
@@ -25,43 +25,59 @@ namespace Singularity
 			glm::vec3 m_position;
 			glm::vec4 m_colour;
 			glm::vec2 m_uv;
-
-			static VkVertexInputBindingDescription GetBindingDescription() 
-			{
-				VkVertexInputBindingDescription bindingDescription;
-				bindingDescription.binding = 0;
-				bindingDescription.stride = sizeof(Vertex);
-				bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-				return bindingDescription;
-			}
-
-			static std::array<VkVertexInputAttributeDescription, 3> GetAttributeDescriptions() {
-				std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions;
-
-				// Position
-				attributeDescriptions[0].binding = 0;
-				attributeDescriptions[0].location = 0;
-				attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-				attributeDescriptions[0].offset = offsetof(Vertex, m_position);
-
-				// Colour
-				attributeDescriptions[1].binding = 0;
-				attributeDescriptions[1].location = 1;
-				attributeDescriptions[1].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-				attributeDescriptions[1].offset = offsetof(Vertex, m_colour);
-
-				// UV
-				attributeDescriptions[2].binding = 0;
-				attributeDescriptions[2].location = 2;
-				attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-				attributeDescriptions[2].offset = offsetof(Vertex, m_uv);
-
-				return attributeDescriptions;
-			}
 		};
 
 		class Renderer;
+		struct VertexCacheStats;
+
+		// One level of detail, a range of the mesh's index buffer (or vertex buffer for meshes without indices)
+		struct MeshLod
+		{
+			uint32 m_first = 0u;
+			uint32 m_count = 0u;
+			float m_error = 0.0f; // Object space distance the simplified surface may stray from the original
+		};
+
+		// A cluster of the full detail range, laid out to match the culling shader (std430)
+		struct Meshlet
+		{
+			glm::vec4 m_boundingSphere = glm::vec4(0.0f); // Local space centre (xyz) and radius (w)
+			glm::vec4 m_cone = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f); // Average face normal (xyz) and sine of the spread's complement (w), 1 never culls
+			uint32 m_firstIndex = 0u;
+			uint32 m_indexCount = 0u;
+			uint32 m_vertexCount = 0u;
+			uint32 m_padding = 0u;
+		};
+
+		// A run of the mesh drawn with one material. Every submesh shares the mesh's vertex and index buffers, and their
+		// full detail ranges sit back to back at the front of the index list with coarser levels appended after them all.
+		struct Submesh
+		{
+			uint32 m_material = 0u; // Index into the material table the mesh was loaded with, UINT32_MAX for none
+			std::vector<MeshLod> m_lods; // Finest first
+			std::vector<Meshlet> m_meshlets;
+		};
+
+		// A mesh already encoded for the renderer's vertex format, with indices at their GPU width. The streams are only read
+		// while buffering, so they can point straight into a mapped file.
+		struct EncodedMesh
+		{
+			void const* m_positions = nullptr; // Only for split vertex formats
+			void const* m_vertices = nullptr; // Every attribute but positions when those are split, otherwise all of them
+			void const* m_indices = nullptr;
+			size_t m_positionsSize = 0u; // Bytes behind each pointer, only read when compressed
+			size_t m_verticesSize = 0u;
+			size_t m_indicesSize = 0u;
+			bool m_compressed = false; // MeshCodec streams instead of the GPU's layout
+			uint32 m_vertexCount = 0u;
+			uint32 m_indexCount = 0u;
+			VkIndexType m_indexType = VK_INDEX_TYPE_UINT32;
+			std::vector<Submesh> m_submeshes;
+			glm::vec4 m_boundingSphere = glm::vec4(0.0f);
+			glm::vec3 m_boundsMinimum = glm::vec3(0.0f);
+			glm::vec3 m_boundsMaximum = glm::vec3(0.0f);
+			glm::vec4 m_dequantization = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		};
 
 		class Mesh
 		{
@@ -69,33 +85,68 @@ namespace Singularity
 			Mesh() {}
 			Mesh(std::vector<Vertex> const& _vertices) { SetData(_vertices); }
 			Mesh(std::vector<Vertex> const& _vertices, std::vector<uint32> _indices) { SetData(_vertices, _indices); }
+			Mesh(std::vector<Vertex> const& _vertices, std::vector<uint32> _indices, std::vector<Submesh> _submeshes) { SetData(_vertices, _indices, _submeshes); }
 
 			~Mesh();
 
 			void SetData(std::vector<Vertex> const& _vertices);
 			void SetData(std::vector<Vertex> const& _vertices, std::vector<uint32> _indices);
+			void SetData(std::vector<Vertex> const& _vertices, std::vector<uint32> _indices, std::vector<Submesh> _submeshes); // Submeshes give their material and full detail range, which must tile the indices in order
+			void GenerateLods(uint32 _lodCount); // Appends simplified index ranges after the original, call before buffering
+			void BuildMeshlets(); // Reorders the full detail range into clusters, call before buffering
+			void Optimize(VertexCacheStats* o_before = nullptr, VertexCacheStats* o_after = nullptr); // Call last before buffering, stats cover the full detail range
 
 			void Buffer(Renderer& _renderer);
+			bool Buffer(Renderer& _renderer, EncodedMesh const& _encoded, float* o_decodeSeconds = nullptr); // Keeps no CPU copy, so the mesh can't be processed, buffered again or occlude. Time spent decoding is added to o_decodeSeconds. False when a stream fails to decode, with nothing left buffered
 			void Unbuffer();
 
-			bool UseIndices() const { return !m_indices.empty(); }
-			std::vector<Vertex> const& GetVertices() const { return m_vertices; }
+			bool UseIndices() const { return m_indexCount > 0u; }
+			std::vector<Vertex> const& GetVertices() const { return m_vertices; } // Empty for meshes buffered from encoded data
 			std::vector<uint32> const& GetIndices() const { return m_indices; }
 
-			uint32 GetVertexCount() const { return static_cast<uint32>(m_vertices.size()); }
-			uint32 GetIndexCount() const { return static_cast<uint32>(m_indices.size()); }
-
-			Render::Buffer const* GetVertexBuffer() const { return m_vertexBuffer; }
+			uint32 GetVertexCount() const { return m_vertexCount; }
+			uint32 GetIndexCount() const { return m_indexCount; } // Every level of detail together
+			uint32 GetSubmeshCount() const { return static_cast<uint32>(m_submeshes.size()); }
+			Submesh const& GetSubmesh(uint32 _submesh) const { return m_submeshes[_submesh]; }
+			uint32 GetLodCount(uint32 _submesh = 0u) const { return static_cast<uint32>(m_submeshes[_submesh].m_lods.size()); }
+			MeshLod const& GetLod(uint32 _lod, uint32 _submesh = 0u) const { return m_submeshes[_submesh].m_lods[_lod]; }
+			std::vector<Meshlet> const& GetMeshlets(uint32 _submesh = 0u) const { return m_submeshes[_submesh].m_meshlets; }
+			uint32 GetFullDetailIndexCount() const; // Every submesh's finest level together, always the front of the index list
+
+			glm::vec4 const& GetBoundingSphere() const { return m_boundingSphere; } // Local space centre (xyz) and radius (w)
+			glm::vec3 const& GetBoundsMinimum() const { return m_boundsMinimum; } // Local space box
+			glm::vec3 const& GetBoundsMaximum() const { return m_boundsMaximum; }
+			glm::vec4 const& GetDequantization() const { return m_dequantization; } // Box centre (xyz) and largest half extent (w), GPU positions are stored relative to it
+			glm::mat4 GetDequantizeTransform() const; // Takes buffered positions back to local space, to be folded into the model matrix
+
+			Render::Buffer const* GetVertexBuffer() const { return m_vertexBuffer; } // Everything but positions when they are split off
+			Render::Buffer const* GetPositionBuffer() const { return m_positionBuffer; } // Only with a split vertex format
+			void BindVertexBuffers(VkCommandBuffer _commandBuffer, bool _positionsOnly = false) const; // Positions only is for depth only pipelines
 			Render::Buffer const* GetIndexBuffer() const { return m_indexBuffer; }
+			VkIndexType GetIndexType() const { return m_indexType; } // Indices are kept 32 bit on the CPU, only the GPU copy narrows
+
+			static uint32 constexpr c_maxLodCount = 4u;
+			static uint32 constexpr c_maxShortIndexVertexCount = 65536u; // Primitive restart is never enabled, so 0xFFFF is an ordinary index
 
 		private:
+			void CalculateBounds();
+
 			std::vector<Vertex> m_vertices;
 			std::vector<uint32> m_indices;
+			uint32 m_vertexCount = 0u; // Kept apart from the arrays, which are empty for meshes buffered from encoded data
+			uint32 m_indexCount = 0u;
+			std::vector<Submesh> m_submeshes; // A single one covering everything unless the mesh was set up with more
+			glm::vec4 m_boundingSphere = glm::vec4(0.0f);
+			glm::vec3 m_boundsMinimum = glm::vec3(0.0f);
+			glm::vec3 m_boundsMaximum = glm::vec3(0.0f);
+			glm::vec4 m_dequantization = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+			VkIndexType m_indexType = VK_INDEX_TYPE_UINT32;
 
 			bool m_valid = false;
 			bool m_buffered = false;
 
 			Render::Buffer* m_vertexBuffer = nullptr;
+			Render::Buffer* m_positionBuffer = nullptr;
 			Render::Buffer* m_indexBuffer = nullptr;
 
 		};
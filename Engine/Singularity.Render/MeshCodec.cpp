@@ -0,0 +1,443 @@
+#include "MeshCodec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <immintrin.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		namespace
+		{
+			uint32 constexpr c_payloadSizes[4] = { 0u, 4u, 8u, 16u }; // Bytes per group at 0, 2, 4 and 8 bits per value
+			uint8 constexpr c_newVertex = 0u; // Index codes, FIFO hits come after this
+			uint8 constexpr c_explicitIndex = 17u;
+
+			uint8 ZigZag(uint8 _delta)
+			{
+				return static_cast<uint8>((_delta << 1) ^ static_cast<uint8>(static_cast<int8_t>(_delta) >> 7));
+			}
+
+			// Header bits pick each group's width, followed by the groups' payloads. _values is read in whole groups, so
+			// it has to be zero padded up to a multiple of the group size.
+			void EncodeBytes(uint8 const* _values, uint32 _count, std::vector<uint8>& io_encoded)
+			{
+				uint32 const groupCount = (_count + MeshCodec::c_groupSize - 1u) / MeshCodec::c_groupSize;
+				size_t const header = io_encoded.size();
+				io_encoded.resize(header + (groupCount + 3u) / 4u, 0u);
+
+				for (uint32 group = 0; group < groupCount; ++group)
+				{
+					uint8 const* const values = _values + group * MeshCodec::c_groupSize;
+					uint8 const largest = *std::max_element(values, values + MeshCodec::c_groupSize);
+					uint32 const mode = largest == 0u ? 0u : largest < 4u ? 1u : largest < 16u ? 2u : 3u;
+					io_encoded[header + group / 4u] |= static_cast<uint8>(mode << ((group % 4u) * 2u));
+
+					// Value j shares its byte with j + 4, j + 8 and j + 12, or with j + 8, which unpacks with shifts alone
+					uint8 packed[16] = {};
+					for (uint32 j = 0; j < MeshCodec::c_groupSize; ++j)
+					{
+						if (mode == 1u)
+						{
+							packed[j % 4u] |= static_cast<uint8>(values[j] << ((j / 4u) * 2u));
+						}
+						else if (mode == 2u)
+						{
+							packed[j % 8u] |= static_cast<uint8>(values[j] << ((j / 8u) * 4u));
+						}
+						else
+						{
+							packed[j] = values[j];
+						}
+					}
+					io_encoded.insert(io_encoded.end(), packed, packed + c_payloadSizes[mode]);
+				}
+			}
+
+			// Writes whole groups, so o_values needs room for _count rounded up to the group size. Null when the data runs out.
+			uint8 const* DecodeBytes(uint8 const* _data, uint8 const* _end, uint32 _count, uint8* o_values)
+			{
+				uint32 const groupCount = (_count + MeshCodec::c_groupSize - 1u) / MeshCodec::c_groupSize;
+				uint32 const headerSize = (groupCount + 3u) / 4u;
+				if (static_cast<size_t>(_end - _data) < headerSize)
+				{
+					return nullptr;
+				}
+
+				uint8 const* const header = _data;
+				uint8 const* payload = _data + headerSize;
+				__m128i const twoBits = _mm_set1_epi8(0x03);
+				__m128i const fourBits = _mm_set1_epi8(0x0F);
+
+				for (uint32 group = 0; group < groupCount; ++group)
+				{
+					uint32 const mode = (header[group / 4u] >> ((group % 4u) * 2u)) & 3u;
+					if (static_cast<size_t>(_end - payload) < c_payloadSizes[mode])
+					{
+						return nullptr;
+					}
+
+					__m128i values = _mm_setzero_si128();
+					if (mode == 1u)
+					{
+						int packed;
+						memcpy(&packed, payload, sizeof(int));
+						__m128i const bytes = _mm_cvtsi32_si128(packed);
+						__m128i const first = _mm_and_si128(bytes, twoBits);
+						__m128i const second = _mm_and_si128(_mm_srli_epi16(bytes, 2), twoBits);
+						__m128i const third = _mm_and_si128(_mm_srli_epi16(bytes, 4), twoBits);
+						__m128i const fourth = _mm_and_si128(_mm_srli_epi16(bytes, 6), twoBits);
+						values = _mm_unpacklo_epi64(_mm_unpacklo_epi32(first, second), _mm_unpacklo_epi32(third, fourth));
+					}
+					else if (mode == 2u)
+					{
+						__m128i const bytes = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(payload));
+						values = _mm_unpacklo_epi64(_mm_and_si128(bytes, fourBits), _mm_and_si128(_mm_srli_epi16(bytes, 4), fourBits));
+					}
+					else if (mode == 3u)
+					{
+						values = _mm_loadu_si128(reinterpret_cast<__m128i const*>(payload));
+					}
+
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(o_values + group * MeshCodec::c_groupSize), values);
+					payload += c_payloadSizes[mode];
+				}
+				return payload;
+			}
+
+			// Turns a plane of zigzagged deltas back into bytes, 16 at a time with a log step prefix sum
+			uint8 AccumulatePlane(uint8* io_plane, uint32 _count, uint8 _previous)
+			{
+				__m128i const lowBit = _mm_set1_epi8(0x01);
+				__m128i const sevenBits = _mm_set1_epi8(0x7F);
+				__m128i carry = _mm_set1_epi8(static_cast<char>(_previous));
+
+				for (uint32 i = 0; i < _count; i += MeshCodec::c_groupSize)
+				{
+					__m128i* const group = reinterpret_cast<__m128i*>(io_plane + i);
+					__m128i const zigzag = _mm_loadu_si128(group);
+					__m128i value = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(zigzag, 1), sevenBits), _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(zigzag, lowBit)));
+
+					value = _mm_add_epi8(value, _mm_slli_si128(value, 1));
+					value = _mm_add_epi8(value, _mm_slli_si128(value, 2));
+					value = _mm_add_epi8(value, _mm_slli_si128(value, 4));
+					value = _mm_add_epi8(value, _mm_slli_si128(value, 8));
+					value = _mm_add_epi8(value, carry);
+					_mm_storeu_si128(group, value);
+
+					// Broadcast the last byte as the next group's starting point
+					__m128i const high = _mm_unpackhi_epi8(value, value);
+					carry = _mm_shuffle_epi32(_mm_unpackhi_epi16(high, high), 0xFF);
+				}
+				return io_plane[_count - 1u];
+			}
+
+			// Planes back to interleaved vertices, four planes of 16 vertices at a time become 16 four byte runs
+			void Interleave(uint8 const* _planes, uint32 _count, uint32 _stride, uint8* o_vertices)
+			{
+				uint32 plane = 0u;
+				for (; plane + 4u <= _stride; plane += 4u)
+				{
+					uint8 const* const source = _planes + plane * MeshCodec::c_blockSize;
+					for (uint32 i = 0; i < _count; i += MeshCodec::c_groupSize)
+					{
+						__m128i const p0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + i));
+						__m128i const p1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + MeshCodec::c_blockSize + i));
+						__m128i const p2 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + 2u * MeshCodec::c_blockSize + i));
+						__m128i const p3 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + 3u * MeshCodec::c_blockSize + i));
+
+						__m128i const low01 = _mm_unpacklo_epi8(p0, p1);
+						__m128i const high01 = _mm_unpackhi_epi8(p0, p1);
+						__m128i const low23 = _mm_unpacklo_epi8(p2, p3);
+						__m128i const high23 = _mm_unpackhi_epi8(p2, p3);
+						__m128i runs[4] = { _mm_unpacklo_epi16(low01, low23), _mm_unpackhi_epi16(low01, low23), _mm_unpacklo_epi16(high01, high23), _mm_unpackhi_epi16(high01, high23) };
+
+						uint8* const target = o_vertices + (size_t)i * _stride + plane;
+						uint32 const count = std::min(MeshCodec::c_groupSize, _count - i);
+						if (count == MeshCodec::c_groupSize)
+						{
+							for (uint32 r = 0; r < 4u; ++r)
+							{
+								uint8* const runTarget = target + (size_t)r * 4u * _stride;
+								int const run0 = _mm_cvtsi128_si32(runs[r]);
+								int const run1 = _mm_cvtsi128_si32(_mm_shuffle_epi32(runs[r], 0x55));
+								int const run2 = _mm_cvtsi128_si32(_mm_shuffle_epi32(runs[r], 0xAA));
+								int const run3 = _mm_cvtsi128_si32(_mm_shuffle_epi32(runs[r], 0xFF));
+								memcpy(runTarget, &run0, sizeof(int));
+								memcpy(runTarget + _stride, &run1, sizeof(int));
+								memcpy(runTarget + 2u * _stride, &run2, sizeof(int));
+								memcpy(runTarget + 3u * _stride, &run3, sizeof(int));
+							}
+							continue;
+						}
+
+						// The block's last, partial group
+						alignas(16) uint8 tail[64];
+						for (uint32 r = 0; r < 4u; ++r)
+						{
+							_mm_store_si128(reinterpret_cast<__m128i*>(tail + r * 16u), runs[r]);
+						}
+						for (uint32 j = 0; j < count; ++j)
+						{
+							memcpy(target + (size_t)j * _stride, tail + j * 4u, sizeof(int));
+						}
+					}
+				}
+
+				for (; plane < _stride; ++plane)
+				{
+					uint8 const* const source = _planes + plane * MeshCodec::c_blockSize;
+					for (uint32 i = 0; i < _count; ++i)
+					{
+						o_vertices[(size_t)i * _stride + plane] = source[i];
+					}
+				}
+			}
+
+			void WriteVarint(uint32 _value, std::vector<uint8>& io_encoded)
+			{
+				while (_value >= 0x80u)
+				{
+					io_encoded.push_back(static_cast<uint8>(_value | 0x80u));
+					_value >>= 7u;
+				}
+				io_encoded.push_back(static_cast<uint8>(_value));
+			}
+
+			uint8 const* ReadVarint(uint8 const* _data, uint8 const* _end, uint32& o_value)
+			{
+				o_value = 0u;
+				for (uint32 shift = 0u; shift < 35u && _data < _end; shift += 7u)
+				{
+					uint8 const byte = *_data++;
+					o_value |= static_cast<uint32>(byte & 0x7Fu) << shift;
+					if (byte < 0x80u)
+					{
+						return _data;
+					}
+				}
+				return nullptr;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void MeshCodec::EncodeVertices(void const* _vertices, uint32 _vertexCount, uint32 _stride, std::vector<uint8>& o_encoded)
+		{
+			o_encoded.clear();
+			if (_vertexCount == 0u || _stride == 0u || _stride > c_maxStride)
+			{
+				return;
+			}
+
+			uint8 const* const vertices = static_cast<uint8 const*>(_vertices);
+			uint8 previous[c_maxStride] = {};
+			uint8 deltas[c_blockSize];
+
+			for (uint32 first = 0; first < _vertexCount; first += c_blockSize)
+			{
+				uint32 const count = std::min(c_blockSize, _vertexCount - first);
+				for (uint32 plane = 0; plane < _stride; ++plane)
+				{
+					memset(deltas, 0, sizeof(deltas));
+					for (uint32 i = 0; i < count; ++i)
+					{
+						uint8 const value = vertices[(size_t)(first + i) * _stride + plane];
+						deltas[i] = ZigZag(static_cast<uint8>(value - previous[plane]));
+						previous[plane] = value;
+					}
+					EncodeBytes(deltas, count, o_encoded);
+				}
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		bool MeshCodec::DecodeVertices(uint8 const* _encoded, size_t _size, uint32 _vertexCount, uint32 _stride, void* o_vertices)
+		{
+			if (_stride == 0u || _stride > c_maxStride)
+			{
+				return false;
+			}
+
+			uint8 const* data = _encoded;
+			uint8 const* const end = _encoded + _size;
+			uint8* const vertices = static_cast<uint8*>(o_vertices);
+			uint8 previous[c_maxStride] = {};
+
+			// Blocks are interleaved in cached memory and copied out whole, mapped memory is often write combined and
+			// punishes the scattered writes interleaving makes
+			std::vector<uint8> planes(_stride * c_blockSize);
+			std::vector<uint8> block(_stride * c_blockSize);
+
+			for (uint32 first = 0; first < _vertexCount; first += c_blockSize)
+			{
+				uint32 const count = std::min(c_blockSize, _vertexCount - first);
+				for (uint32 plane = 0; plane < _stride; ++plane)
+				{
+					uint8* const values = planes.data() + plane * c_blockSize;
+					data = DecodeBytes(data, end, count, values);
+					if (!data)
+					{
+						return false;
+					}
+					previous[plane] = AccumulatePlane(values, count, previous[plane]);
+				}
+
+				Interleave(planes.data(), count, _stride, block.data());
+				memcpy(vertices + (size_t)first * _stride, block.data(), (size_t)count * _stride);
+			}
+			return data == end;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void MeshCodec::EncodeIndices(std::vector<uint32> const& _indices, std::vector<uint8>& o_encoded)
+		{
+			o_encoded.clear();
+			if (_indices.empty())
+			{
+				return;
+			}
+
+			// Indices the codes can't express go to a side stream, stored first so its size is known before the codes
+			std::vector<uint8> explicitIndices;
+			std::vector<uint8> codes;
+			codes.reserve(_indices.size() + c_blockSize);
+
+			uint32 fifo[c_fifoSize];
+			std::fill(fifo, fifo + c_fifoSize, ~0u);
+			uint32 head = 0u;
+			uint32 next = 0u;
+			uint32 last = 0u;
+
+			for (uint32 const index : _indices)
+			{
+				uint8 code = c_explicitIndex;
+				if (index == next)
+				{
+					code = c_newVertex;
+				}
+				else
+				{
+					for (uint32 age = 0; age < c_fifoSize; ++age)
+					{
+						if (fifo[(head - 1u - age) % c_fifoSize] == index)
+						{
+							code = static_cast<uint8>(1u + age);
+							break;
+						}
+					}
+				}
+
+				if (code == c_explicitIndex)
+				{
+					uint32 const delta = index - last;
+					WriteVarint((delta << 1) ^ static_cast<uint32>(static_cast<int32_t>(delta) >> 31), explicitIndices);
+				}
+
+				codes.push_back(code);
+				fifo[head++ % c_fifoSize] = index;
+				next = std::max(next, index + 1u);
+				last = index;
+			}
+
+			codes.resize(codes.size() + c_blockSize, 0u); // Padding for whole groups at the end
+
+			uint32 const explicitSize = static_cast<uint32>(explicitIndices.size());
+			o_encoded.resize(sizeof(uint32));
+			memcpy(o_encoded.data(), &explicitSize, sizeof(uint32));
+			o_encoded.insert(o_encoded.end(), explicitIndices.begin(), explicitIndices.end());
+
+			for (size_t first = 0; first < _indices.size(); first += c_blockSize)
+			{
+				EncodeBytes(codes.data() + first, static_cast<uint32>(std::min<size_t>(c_blockSize, _indices.size() - first)), o_encoded);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		bool MeshCodec::DecodeIndices(uint8 const* _encoded, size_t _size, uint32 _indexCount, uint32 _indexSize, void* o_indices)
+		{
+			if (_indexCount == 0u)
+			{
+				return _size == 0u;
+			}
+
+			uint32 explicitSize;
+			if (_size < sizeof(uint32) || (_indexSize != sizeof(uint16) && _indexSize != sizeof(uint32)))
+			{
+				return false;
+			}
+			memcpy(&explicitSize, _encoded, sizeof(uint32));
+			if (explicitSize > _size - sizeof(uint32))
+			{
+				return false;
+			}
+
+			uint8 const* explicitIndices = _encoded + sizeof(uint32);
+			uint8 const* const explicitEnd = explicitIndices + explicitSize;
+			uint8 const* data = explicitEnd;
+			uint8 const* const end = _encoded + _size;
+
+			uint16* const shortIndices = static_cast<uint16*>(o_indices);
+			uint32* const longIndices = static_cast<uint32*>(o_indices);
+
+			uint32 fifo[c_fifoSize];
+			std::fill(fifo, fifo + c_fifoSize, ~0u);
+			uint32 head = 0u;
+			uint32 next = 0u;
+			uint32 last = 0u;
+			uint8 codes[c_blockSize];
+
+			for (uint32 first = 0; first < _indexCount; first += c_blockSize)
+			{
+				uint32 const count = std::min(c_blockSize, _indexCount - first);
+				data = DecodeBytes(data, end, count, codes);
+				if (!data)
+				{
+					return false;
+				}
+
+				for (uint32 i = 0; i < count; ++i)
+				{
+					uint8 const code = codes[i];
+					uint32 index;
+					if (code == c_newVertex)
+					{
+						index = next;
+					}
+					else if (code < c_explicitIndex)
+					{
+						index = fifo[(head - code) % c_fifoSize];
+					}
+					else if (code == c_explicitIndex)
+					{
+						uint32 zigzag;
+						explicitIndices = ReadVarint(explicitIndices, explicitEnd, zigzag);
+						if (!explicitIndices)
+						{
+							return false;
+						}
+						index = last + ((zigzag >> 1) ^ (0u - (zigzag & 1u)));
+					}
+					else
+					{
+						return false;
+					}
+
+					if (_indexSize == sizeof(uint16))
+					{
+						shortIndices[first + i] = static_cast<uint16>(index);
+					}
+					else
+					{
+						longIndices[first + i] = index;
+					}
+
+					fifo[head++ % c_fifoSize] = index;
+					next = std::max(next, index + 1u);
+					last = index;
+				}
+			}
+			return data == end && explicitIndices == explicitEnd;
+		}
+	}
+}
\ No newline at end of file
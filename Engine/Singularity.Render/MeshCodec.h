@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		// Lossless compression for the vertex and index streams of cooked meshes, built to decode with SSE straight into
+		// mapped GPU memory.
+		//
+		// Vertices are split into blocks, and each byte of the stride into a plane holding that byte's delta from the
+		// previous vertex. Neighbouring vertices are similar after fetch optimization, so most deltas are tiny and each
+		// group of 16 is packed with the fewest of 0, 2, 4 or 8 bits that holds all of them.
+		//
+		// Indices are coded per corner as the next unseen vertex, a hit in a FIFO of recently used vertices (which catches
+		// the edges triangles share), or a delta from the previous index, and the codes are packed the same way.
+		class MeshCodec
+		{
+		public:
+			static void EncodeVertices(void const* _vertices, uint32 _vertexCount, uint32 _stride, std::vector<uint8>& o_encoded);
+			static bool DecodeVertices(uint8 const* _encoded, size_t _size, uint32 _vertexCount, uint32 _stride, void* o_vertices); // False when the stream is broken, o_vertices may be partly written then
+
+			static void EncodeIndices(std::vector<uint32> const& _indices, std::vector<uint8>& o_encoded);
+			static bool DecodeIndices(uint8 const* _encoded, size_t _size, uint32 _indexCount, uint32 _indexSize, void* o_indices); // Writes 2 or 4 byte indices
+
+			static uint32 constexpr c_blockSize = 256u; // Vertices or index codes packed together
+			static uint32 constexpr c_groupSize = 16u; // Values sharing one bit width
+			static uint32 constexpr c_maxStride = 256u;
+
+		private:
+			static uint32 constexpr c_fifoSize = 16u; // Recently used vertices indices can refer back to
+		};
+	}
+}
\ No newline at end of file
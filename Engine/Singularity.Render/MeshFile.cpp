@@ -0,0 +1,375 @@
+#include "MeshFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <glm/vec4.hpp>
+#include <iostream>
+#include <vector>
+
+#include <Singularity.IO/MappedFile.h>
+#include <Singularity.Render/Mesh.h>
+#include <Singularity.Render/MeshCodec.h>
+#include <Singularity.Render/Renderer.h>
+#include <Singularity.Render/VertexFormat.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		namespace
+		{
+			enum class MeshFileSection : uint32
+			{
+				Positions = 0, // Empty unless the format splits positions off
+				Vertices = 1,
+				Indices = 2,
+				Submeshes = 3,
+				Lods = 4,
+				Meshlets = 5,
+				Count = 6
+			};
+
+			uint32 constexpr c_sectionCount = static_cast<uint32>(MeshFileSection::Count);
+			uint32 constexpr c_streamCount = static_cast<uint32>(MeshFileSection::Submeshes); // The vertex and index sections, which are compressed
+
+			struct MeshFileRange
+			{
+				uint64 m_offset = 0u;
+				uint64 m_size = 0u;
+			};
+
+			// Where a submesh's levels and clusters sit in the LOD and meshlet tables
+			struct MeshFileSubmesh
+			{
+				uint32 m_material = 0u;
+				uint32 m_firstLod = 0u;
+				uint32 m_lodCount = 0u;
+				uint32 m_firstMeshlet = 0u;
+				uint32 m_meshletCount = 0u;
+			};
+
+			struct MeshFileHeader
+			{
+				uint32 m_magic = MeshFile::c_magic;
+				uint32 m_version = MeshFile::c_version;
+				uint32 m_formatSignature = 0u;
+				uint32 m_vertexCount = 0u;
+				uint32 m_indexCount = 0u;
+				uint32 m_indexSize = 0u; // Bytes per index, 0 for meshes drawn without
+				uint32 m_submeshCount = 0u;
+				uint32 m_lodCount = 0u; // Every submesh's together
+				uint32 m_meshletCount = 0u;
+				uint32 m_compressed = 0u; // Vertex and index sections are MeshCodec streams
+				glm::vec4 m_boundingSphere = glm::vec4(0.0f);
+				glm::vec4 m_boundsMinimum = glm::vec4(0.0f); // w unused
+				glm::vec4 m_boundsMaximum = glm::vec4(0.0f);
+				glm::vec4 m_dequantization = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+				MeshFileRange m_sections[c_sectionCount];
+				uint64 m_checksum = 0u; // Over everything after the header, which is checked against the file instead
+			};
+
+			uint64 Align(uint64 _offset)
+			{
+				return (_offset + MeshFile::c_sectionAlignment - 1u) & ~static_cast<uint64>(MeshFile::c_sectionAlignment - 1u);
+			}
+
+			// Sections are padded to the alignment, so the data is always a whole number of words
+			uint64 Checksum(uint8 const* _data, size_t _size)
+			{
+				uint64 checksum = 14695981039346656037ull;
+				for (size_t offset = 0; offset + sizeof(uint64) <= _size; offset += sizeof(uint64))
+				{
+					uint64 word;
+					memcpy(&word, _data + offset, sizeof(uint64));
+					checksum = (checksum ^ word) * 1099511628211ull;
+				}
+				return checksum;
+			}
+
+			// Sizes as uploaded, which compressed sections only match when empty
+			void GetSectionSizes(MeshFileHeader const& _header, VertexFormat const& _format, uint64 o_sizes[c_sectionCount])
+			{
+				uint64 const vertexCount = _header.m_vertexCount;
+				uint32 const positionStride = _format.HasSplitPositions() ? _format.GetPositionStride() : 0u;
+				o_sizes[static_cast<uint32>(MeshFileSection::Positions)] = positionStride * vertexCount;
+				o_sizes[static_cast<uint32>(MeshFileSection::Vertices)] = (_format.GetStride() - positionStride) * vertexCount;
+				o_sizes[static_cast<uint32>(MeshFileSection::Indices)] = static_cast<uint64>(_header.m_indexSize) * _header.m_indexCount;
+				o_sizes[static_cast<uint32>(MeshFileSection::Submeshes)] = sizeof(MeshFileSubmesh) * static_cast<uint64>(_header.m_submeshCount);
+				o_sizes[static_cast<uint32>(MeshFileSection::Lods)] = sizeof(MeshLod) * static_cast<uint64>(_header.m_lodCount);
+				o_sizes[static_cast<uint32>(MeshFileSection::Meshlets)] = sizeof(Meshlet) * static_cast<uint64>(_header.m_meshletCount);
+			}
+
+			bool Reject(std::string const& _filename, char const* _reason)
+			{
+				std::cout << "Error: " << _filename << " " << _reason << ", it needs cooking again!" << std::endl;
+				return false;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		bool MeshFile::Write(std::string const& _filename, Mesh const& _mesh, VertexFormat const& _format, bool _compress, MeshFileStats* o_stats)
+		{
+			std::vector<Vertex> const& vertices = _mesh.GetVertices();
+			if (vertices.empty() || vertices.size() != _mesh.GetVertexCount())
+			{
+				std::cout << "Error: Only meshes that still hold their vertices can be written to " << _filename << "!" << std::endl;
+				return false;
+			}
+
+			MeshFileHeader header;
+			header.m_formatSignature = _format.GetSignature();
+			header.m_vertexCount = _mesh.GetVertexCount();
+			header.m_indexCount = _mesh.GetIndexCount();
+			header.m_indexSize = !_mesh.UseIndices() ? 0u : _mesh.GetIndexType() == VK_INDEX_TYPE_UINT16 ? sizeof(uint16) : sizeof(uint32);
+			header.m_submeshCount = _mesh.GetSubmeshCount();
+			header.m_boundingSphere = _mesh.GetBoundingSphere();
+			header.m_boundsMinimum = glm::vec4(_mesh.GetBoundsMinimum(), 0.0f);
+			header.m_boundsMaximum = glm::vec4(_mesh.GetBoundsMaximum(), 0.0f);
+			header.m_dequantization = _mesh.GetDequantization();
+
+			// Submeshes own their levels and clusters in memory, on disk they are flattened into shared tables
+			std::vector<MeshFileSubmesh> submeshes;
+			std::vector<MeshLod> lods;
+			std::vector<Meshlet> meshlets;
+			for (uint32 i = 0; i < _mesh.GetSubmeshCount(); ++i)
+			{
+				Submesh const& source = _mesh.GetSubmesh(i);
+
+				MeshFileSubmesh& submesh = submeshes.emplace_back();
+				submesh.m_material = source.m_material;
+				submesh.m_firstLod = static_cast<uint32>(lods.size());
+				submesh.m_lodCount = static_cast<uint32>(source.m_lods.size());
+				submesh.m_firstMeshlet = static_cast<uint32>(meshlets.size());
+				submesh.m_meshletCount = static_cast<uint32>(source.m_meshlets.size());
+
+				lods.insert(lods.end(), source.m_lods.begin(), source.m_lods.end());
+				meshlets.insert(meshlets.end(), source.m_meshlets.begin(), source.m_meshlets.end());
+			}
+			header.m_lodCount = static_cast<uint32>(lods.size());
+			header.m_meshletCount = static_cast<uint32>(meshlets.size());
+
+			uint64 sizes[c_sectionCount];
+			GetSectionSizes(header, _format, sizes);
+
+			// Streams are encoded at their GPU layout first, compression works on those bytes
+			uint32 const positionStride = _format.HasSplitPositions() ? _format.GetPositionStride() : 0u;
+			std::vector<uint8> streams[c_streamCount] = {
+				std::vector<uint8>((size_t)sizes[static_cast<uint32>(MeshFileSection::Positions)]),
+				std::vector<uint8>((size_t)sizes[static_cast<uint32>(MeshFileSection::Vertices)]),
+				std::vector<uint8>((size_t)sizes[static_cast<uint32>(MeshFileSection::Indices)]) };
+			std::vector<uint8>& positionStream = streams[static_cast<uint32>(MeshFileSection::Positions)];
+			std::vector<uint8>& vertexStream = streams[static_cast<uint32>(MeshFileSection::Vertices)];
+			std::vector<uint8>& indexStream = streams[static_cast<uint32>(MeshFileSection::Indices)];
+
+			if (_format.HasSplitPositions())
+			{
+				_format.Encode(vertices, header.m_dequantization, positionStream.data(), vertexStream.data());
+			}
+			else
+			{
+				_format.Encode(vertices, header.m_dequantization, vertexStream.data());
+			}
+
+			std::vector<uint32> const& indices = _mesh.GetIndices();
+			if (header.m_indexSize == sizeof(uint16))
+			{
+				uint16* const shortIndices = reinterpret_cast<uint16*>(indexStream.data());
+				std::copy(indices.begin(), indices.end(), shortIndices);
+			}
+			else if (!indices.empty())
+			{
+				memcpy(indexStream.data(), indices.data(), indices.size() * sizeof(uint32));
+			}
+
+			if (_compress && _format.GetStride() <= MeshCodec::c_maxStride)
+			{
+				header.m_compressed = 1u;
+				std::vector<uint8> compressed;
+				MeshCodec::EncodeVertices(positionStream.data(), header.m_vertexCount, positionStride, compressed);
+				positionStream.swap(compressed);
+				MeshCodec::EncodeVertices(vertexStream.data(), header.m_vertexCount, _format.GetStride() - positionStride, compressed);
+				vertexStream.swap(compressed);
+				if (header.m_indexSize != 0u)
+				{
+					MeshCodec::EncodeIndices(indices, compressed);
+					indexStream.swap(compressed);
+				}
+			}
+
+			uint64 offset = Align(sizeof(MeshFileHeader));
+			for (uint32 section = 0; section < c_sectionCount; ++section)
+			{
+				uint64 const size = section < c_streamCount ? streams[section].size() : sizes[section];
+				header.m_sections[section].m_offset = offset;
+				header.m_sections[section].m_size = size;
+				offset = Align(offset + size);
+			}
+
+			// Built whole in memory so the sections can be filled in place, padding stays zeroed for the checksum
+			std::vector<uint8> file((size_t)offset, 0u);
+			auto const section = [&](MeshFileSection _section) { return file.data() + header.m_sections[static_cast<uint32>(_section)].m_offset; };
+
+			for (uint32 stream = 0; stream < c_streamCount; ++stream)
+			{
+				if (!streams[stream].empty())
+				{
+					memcpy(section(static_cast<MeshFileSection>(stream)), streams[stream].data(), streams[stream].size());
+				}
+			}
+
+			memcpy(section(MeshFileSection::Submeshes), submeshes.data(), submeshes.size() * sizeof(MeshFileSubmesh));
+			memcpy(section(MeshFileSection::Lods), lods.data(), lods.size() * sizeof(MeshLod));
+			memcpy(section(MeshFileSection::Meshlets), meshlets.data(), meshlets.size() * sizeof(Meshlet));
+
+			size_t const headerSize = (size_t)Align(sizeof(MeshFileHeader));
+			header.m_checksum = Checksum(file.data() + headerSize, file.size() - headerSize);
+			memcpy(file.data(), &header, sizeof(MeshFileHeader));
+
+			std::ofstream fileStream(_filename, std::ios::binary | std::ios::trunc);
+			fileStream.write(reinterpret_cast<char const*>(file.data()), file.size());
+			if (!fileStream)
+			{
+				std::cout << "Error: Failed to write mesh file " << _filename << "!" << std::endl;
+				return false;
+			}
+
+			if (o_stats)
+			{
+				*o_stats = MeshFileStats();
+				for (uint32 stream = 0; stream < c_streamCount; ++stream)
+				{
+					o_stats->m_rawSize += sizes[stream];
+					o_stats->m_storedSize += streams[stream].size();
+				}
+			}
+			return true;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		bool MeshFile::Load(std::string const& _filename, Renderer& _renderer, Mesh& o_mesh, MeshFileStats* o_stats)
+		{
+			IO::MappedFile file;
+			if (!file.Open(_filename))
+			{
+				return false; // Not cooked yet
+			}
+
+			size_t const headerSize = (size_t)Align(sizeof(MeshFileHeader));
+			if (file.GetSize() < headerSize)
+			{
+				return Reject(_filename, "is too small to be a mesh file");
+			}
+
+			MeshFileHeader header;
+			memcpy(&header, file.GetData(), sizeof(MeshFileHeader));
+			if (header.m_magic != c_magic || header.m_version != c_version)
+			{
+				return Reject(_filename, "is not a mesh file of this version");
+			}
+
+			VertexFormat const& vertexFormat = _renderer.GetVertexFormat();
+			if (header.m_formatSignature != vertexFormat.GetSignature())
+			{
+				return Reject(_filename, "was cooked for another vertex format");
+			}
+
+			if (header.m_vertexCount == 0u || header.m_submeshCount == 0u || header.m_compressed > 1u || (header.m_indexSize != 0u && header.m_indexSize != sizeof(uint16) && header.m_indexSize != sizeof(uint32)))
+			{
+				return Reject(_filename, "has a broken header");
+			}
+
+			// Every section has to sit inside the file and hold exactly what the header's counts say, compressed ones are
+			// only known to be empty or not until they decode
+			uint64 sizes[c_sectionCount];
+			GetSectionSizes(header, vertexFormat, sizes);
+			for (uint32 section = 0; section < c_sectionCount; ++section)
+			{
+				MeshFileRange const& range = header.m_sections[section];
+				bool const sizeMatches = header.m_compressed && section < c_streamCount ? (range.m_size == 0u) == (sizes[section] == 0u) : range.m_size == sizes[section];
+				if (!sizeMatches || range.m_offset < headerSize || range.m_offset % c_sectionAlignment != 0u || range.m_offset > file.GetSize() || range.m_size > file.GetSize() - range.m_offset)
+				{
+					return Reject(_filename, "has sections that don't match its header");
+				}
+			}
+
+			if (Checksum(file.GetData() + headerSize, file.GetSize() - headerSize) != header.m_checksum)
+			{
+				return Reject(_filename, "failed its checksum");
+			}
+
+			auto const section = [&](MeshFileSection _section) { return file.GetData() + header.m_sections[static_cast<uint32>(_section)].m_offset; };
+			MeshFileSubmesh const* const submeshes = reinterpret_cast<MeshFileSubmesh const*>(section(MeshFileSection::Submeshes));
+			MeshLod const* const lods = reinterpret_cast<MeshLod const*>(section(MeshFileSection::Lods));
+			Meshlet const* const meshlets = reinterpret_cast<Meshlet const*>(section(MeshFileSection::Meshlets));
+
+			// Draw ranges are checked too, the GPU would read past the buffers otherwise
+			uint32 const drawableCount = header.m_indexSize != 0u ? header.m_indexCount : header.m_vertexCount;
+
+			EncodedMesh encoded;
+			encoded.m_submeshes.resize(header.m_submeshCount);
+			for (uint32 i = 0; i < header.m_submeshCount; ++i)
+			{
+				MeshFileSubmesh const& source = submeshes[i];
+				if (source.m_lodCount == 0u || source.m_lodCount > header.m_lodCount || source.m_firstLod > header.m_lodCount - source.m_lodCount
+					|| source.m_meshletCount > header.m_meshletCount || source.m_firstMeshlet > header.m_meshletCount - source.m_meshletCount)
+				{
+					return Reject(_filename, "has submeshes outside its tables");
+				}
+
+				Submesh& submesh = encoded.m_submeshes[i];
+				submesh.m_material = source.m_material;
+				submesh.m_lods.assign(lods + source.m_firstLod, lods + source.m_firstLod + source.m_lodCount);
+				submesh.m_meshlets.assign(meshlets + source.m_firstMeshlet, meshlets + source.m_firstMeshlet + source.m_meshletCount);
+
+				for (MeshLod const& lod : submesh.m_lods)
+				{
+					if (lod.m_first > drawableCount || lod.m_count > drawableCount - lod.m_first)
+					{
+						return Reject(_filename, "has levels of detail outside its indices");
+					}
+				}
+				for (Meshlet const& meshlet : submesh.m_meshlets)
+				{
+					if (meshlet.m_firstIndex > drawableCount || meshlet.m_indexCount > drawableCount - meshlet.m_firstIndex)
+					{
+						return Reject(_filename, "has meshlets outside its indices");
+					}
+				}
+			}
+
+			encoded.m_positions = vertexFormat.HasSplitPositions() ? section(MeshFileSection::Positions) : nullptr;
+			encoded.m_vertices = section(MeshFileSection::Vertices);
+			encoded.m_indices = header.m_indexSize != 0u ? section(MeshFileSection::Indices) : nullptr;
+			encoded.m_positionsSize = (size_t)header.m_sections[static_cast<uint32>(MeshFileSection::Positions)].m_size;
+			encoded.m_verticesSize = (size_t)header.m_sections[static_cast<uint32>(MeshFileSection::Vertices)].m_size;
+			encoded.m_indicesSize = (size_t)header.m_sections[static_cast<uint32>(MeshFileSection::Indices)].m_size;
+			encoded.m_compressed = header.m_compressed != 0u;
+			encoded.m_vertexCount = header.m_vertexCount;
+			encoded.m_indexCount = header.m_indexSize != 0u ? header.m_indexCount : 0u;
+			encoded.m_indexType = header.m_indexSize == sizeof(uint16) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+			encoded.m_boundingSphere = header.m_boundingSphere;
+			encoded.m_boundsMinimum = glm::vec3(header.m_boundsMinimum);
+			encoded.m_boundsMaximum = glm::vec3(header.m_boundsMaximum);
+			encoded.m_dequantization = header.m_dequantization;
+
+			// Straight from the mapping into GPU visible memory, the file stays mapped until this returns
+			MeshFileStats stats;
+			for (uint32 stream = 0; stream < c_streamCount; ++stream)
+			{
+				stats.m_rawSize += sizes[stream];
+				stats.m_storedSize += header.m_sections[stream].m_size;
+			}
+
+			if (!o_mesh.Buffer(_renderer, encoded, &stats.m_decodeSeconds))
+			{
+				return false; // Corrupt streams, cooking again replaces the file
+			}
+
+			if (o_stats)
+			{
+				*o_stats = stats;
+			}
+			return true;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		class Mesh;
+		class Renderer;
+		class VertexFormat;
+
+		// The vertex and index streams, the part of a mesh file compression shrinks
+		struct MeshFileStats
+		{
+			uint64 m_rawSize = 0u; // As uploaded to the GPU
+			uint64 m_storedSize = 0u; // As stored in the file
+			float m_decodeSeconds = 0.0f; // Only measured by loading
+		};
+
+		// Engine native mesh container, cooked for one vertex format so loading goes from the mapped file into GPU memory
+		// with nothing parsed on the way. A header is followed by aligned sections for the vertex streams, the indices,
+		// and the submesh, LOD and meshlet tables, all covered by a checksum. The vertex and index sections are either
+		// MeshCodec compressed, and decoded straight into the upload memory, or stored at their GPU layout and copied.
+		// Everything is stored as laid out in memory, so files are as platform specific as any other cache.
+		class MeshFile
+		{
+		public:
+			static bool Write(std::string const& _filename, Mesh const& _mesh, VertexFormat const& _format, bool _compress = true, MeshFileStats* o_stats = nullptr); // The mesh has to still hold its vertices and indices
+			static bool Load(std::string const& _filename, Renderer& _renderer, Mesh& o_mesh, MeshFileStats* o_stats = nullptr); // False when missing, broken or cooked for another vertex format, so the source can be cooked again
+
+			static uint32 constexpr c_magic = 0x48534D53u; // "SMSH"
+			static uint32 constexpr c_version = 2u;
+			static uint32 constexpr c_sectionAlignment = 16u;
+			static char constexpr c_extension[] = ".smesh";
+		};
+	}
+}
\ No newline at end of file
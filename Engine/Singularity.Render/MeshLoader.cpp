@@ -1,61 +1,251 @@
 #include "MeshLoader.h"
 
 //External
-#define TINYOBJLOADER_IMPLEMENTATION 
-#include <tinyobj/tiny_obj_loader.h>
+#include <algorithm>
+#include <cstring>
+#include <glm/glm.hpp>
 #include <iostream>
+#include <unordered_map>
 
+#include <Singularity.Render/GltfParser.h>
 #include <Singularity.Render/Mesh.h>
+#include <Singularity.Render/ObjParser.h>
 
 
 namespace Singularity
 {
 	namespace Render
 	{
-		//////////////////////////////////////////////////////////////////////////////////////
-		Mesh MeshLoader::LoadObj(std::string _file)
+		namespace
 		{
-			tinyobj::ObjReaderConfig reader_config;
+			// Corners are only merged when every attribute matches bit for bit, so welding never changes what is drawn
+			struct VertexHash
+			{
+				size_t operator()(Vertex const& _vertex) const
+				{
+					uint32 words[9];
+					memcpy(words, &_vertex.m_position, sizeof(glm::vec3));
+					memcpy(words + 3, &_vertex.m_colour, sizeof(glm::vec4));
+					memcpy(words + 7, &_vertex.m_uv, sizeof(glm::vec2));
 
+					uint64 hash = 14695981039346656037ull;
+					for (uint32 word : words)
+					{
+						hash = (hash ^ word) * 1099511628211ull;
+					}
+					return static_cast<size_t>(hash);
+				}
+			};
 
-			tinyobj::ObjReader reader;
-			if (!reader.ParseFromFile(_file, reader_config)) {
-				if (!reader.Error().empty()) {
-					throw std::runtime_error("Failed to load obj file: " + _file + ", error: " + reader.Error());
+			struct VertexEqual
+			{
+				bool operator()(Vertex const& _a, Vertex const& _b) const
+				{
+					return memcmp(&_a.m_position, &_b.m_position, sizeof(glm::vec3)) == 0 && memcmp(&_a.m_colour, &_b.m_colour, sizeof(glm::vec4)) == 0 && memcmp(&_a.m_uv, &_b.m_uv, sizeof(glm::vec2)) == 0;
 				}
-				else
+			};
+
+			using VertexMap = std::unordered_map<Vertex, uint32, VertexHash, VertexEqual>;
+
+			void ParseObj(std::string const& _file, tinyobj::attrib_t& o_attrib, std::vector<tinyobj::shape_t>& o_shapes, std::vector<tinyobj::material_t>& o_materials)
+			{
+				// Materials are looked up next to the .obj
+				std::string warning;
+				std::string error;
+				if (!ObjParser::Parse(_file, o_attrib, o_shapes, o_materials, warning, error)) {
+					if (!error.empty()) {
+						throw std::runtime_error("Failed to load obj file: " + _file + ", error: " + error);
+					}
+					else
+					{
+						throw std::runtime_error("Failed to load obj file: " + _file);
+					}
+				}
+
+				if (!warning.empty()) {
+					std::cout << "ObjParser: " << warning;
+				}
+
+				if (o_shapes.empty())
 				{
-					throw std::runtime_error("Failed to load obj file: " + _file);
+					throw std::runtime_error("ObjParser: could not find shape in " + _file);
 				}
 			}
 
+			uint32 WeldVertex(tinyobj::attrib_t const& _attrib, tinyobj::index_t _index, std::vector<Vertex>& io_vertices, VertexMap& io_uniqueVertices)
+			{
+				glm::vec3 position = { _attrib.vertices[(uint64)3 * _index.vertex_index], _attrib.vertices[(uint64)3 * _index.vertex_index + 1], _attrib.vertices[(uint64)3 * _index.vertex_index + 2] };
+				glm::vec4 colour(0,0,0,0);
+				glm::vec2 uv(0, 0);
+				if (_index.texcoord_index >= 0)
+				{
+					uv = { _attrib.texcoords[(uint64)2 * _index.texcoord_index], 1.0f -  _attrib.texcoords[(uint64)2 * _index.texcoord_index + 1] }; // (1.0f - coordY) because obj is upside down
+				}
 
-			if (!reader.Warning().empty()) {
-				std::cout << "TinyObjReader: " << reader.Warning();
+				Vertex const vertex(position, colour, uv);
+				auto const inserted = io_uniqueVertices.emplace(vertex, static_cast<uint32>(io_vertices.size()));
+				if (inserted.second)
+				{
+					io_vertices.push_back(vertex);
+				}
+				return inserted.first->second;
 			}
 
-			auto& attrib = reader.GetAttrib();
-			auto& shapes = reader.GetShapes();
-			
+			std::string ResolveTexture(std::string const& _directory, std::string const& _texture)
+			{
+				return _texture.empty() ? _texture : _directory + _texture;
+			}
 
-			// TODO materials
+			// One component as a float, normalized integers map to [0, 1] or [-1, 1] as the glTF spec has it
+			float ReadGltfComponent(uint8 const* _data, uint32 _componentType, bool _normalized)
+			{
+				switch (_componentType)
+				{
+				case GltfParser::c_byte:
+				{
+					int8_t value;
+					memcpy(&value, _data, sizeof(value));
+					return _normalized ? std::max(value / 127.0f, -1.0f) : value;
+				}
+				case GltfParser::c_unsignedByte:
+					return _normalized ? *_data / 255.0f : *_data;
+				case GltfParser::c_short:
+				{
+					int16_t value;
+					memcpy(&value, _data, sizeof(value));
+					return _normalized ? std::max(value / 32767.0f, -1.0f) : value;
+				}
+				case GltfParser::c_unsignedShort:
+				{
+					uint16 value;
+					memcpy(&value, _data, sizeof(value));
+					return _normalized ? value / 65535.0f : value;
+				}
+				case GltfParser::c_unsignedInt:
+				{
+					uint32 value;
+					memcpy(&value, _data, sizeof(value));
+					return static_cast<float>(value);
+				}
+				default:
+				{
+					float value;
+					memcpy(&value, _data, sizeof(value));
+					return value;
+				}
+				}
+			}
 
-			if (shapes.size() > 1u)
+			// Reads up to four components of every element into a Vertex member. Float data is the common case and is copied
+			// as it is, anything else goes through the component conversion.
+			template<typename TValue>
+			void ReadGltfAccessor(GltfAccessor const& _accessor, TValue Vertex::* _member, Vertex* o_vertices)
 			{
-				std::cout << "TinyObjReader: currently only supports a single shape, " + _file + "contains many";
+				uint32 const componentCount = std::min<uint32>(_accessor.m_componentCount, sizeof(TValue) / sizeof(float));
+				if (_accessor.m_componentType == GltfParser::c_float)
+				{
+					for (uint32 i = 0; i < _accessor.m_count; ++i)
+					{
+						memcpy(&(o_vertices[i].*_member), _accessor.m_data + (size_t)i * _accessor.m_stride, componentCount * sizeof(float));
+					}
+					return;
+				}
+
+				uint32 const componentSize = _accessor.m_componentType == GltfParser::c_unsignedInt ? 4u : _accessor.m_componentType == GltfParser::c_short || _accessor.m_componentType == GltfParser::c_unsignedShort ? 2u : 1u;
+				for (uint32 i = 0; i < _accessor.m_count; ++i)
+				{
+					uint8 const* const element = _accessor.m_data + (size_t)i * _accessor.m_stride;
+					for (uint32 component = 0; component < componentCount; ++component)
+					{
+						(o_vertices[i].*_member)[component] = ReadGltfComponent(element + component * componentSize, _accessor.m_componentType, _accessor.m_normalized);
+					}
+				}
 			}
 
-			if (shapes.empty())
+			// Appends a primitive's triangles offset by _firstVertex, 32 bit indices are copied straight out of the file
+			bool ReadGltfIndices(GltfScene const& _scene, GltfPrimitive const& _primitive, uint32 _vertexCount, uint32 _firstVertex, bool _flipWinding, std::vector<uint32>& io_indices)
+			{
+				size_t const first = io_indices.size();
+				if (_primitive.m_indices == UINT32_MAX)
+				{
+					io_indices.resize(first + _vertexCount / 3u * 3u);
+					for (uint32 i = 0; i < _vertexCount / 3u * 3u; ++i)
+					{
+						io_indices[first + i] = i;
+					}
+				}
+				else
+				{
+					GltfAccessor const& accessor = _scene.m_accessors[_primitive.m_indices];
+					if (accessor.m_componentCount != 1u || (accessor.m_componentType != GltfParser::c_unsignedByte && accessor.m_componentType != GltfParser::c_unsignedShort && accessor.m_componentType != GltfParser::c_unsignedInt))
+					{
+						return false;
+					}
+
+					uint32 const count = accessor.m_count / 3u * 3u;
+					io_indices.resize(first + count);
+					uint32* const indices = io_indices.data() + first;
+					if (accessor.m_componentType == GltfParser::c_unsignedInt && accessor.m_stride == sizeof(uint32))
+					{
+						memcpy(indices, accessor.m_data, count * sizeof(uint32));
+					}
+					else
+					{
+						for (uint32 i = 0; i < count; ++i)
+						{
+							indices[i] = static_cast<uint32>(ReadGltfComponent(accessor.m_data + (size_t)i * accessor.m_stride, accessor.m_componentType, false));
+						}
+					}
+
+					uint32 outOfRange = 0u;
+					for (uint32 i = 0; i < count; ++i)
+					{
+						outOfRange |= indices[i] >= _vertexCount;
+					}
+					if (outOfRange)
+					{
+						return false;
+					}
+				}
+
+				for (size_t i = first; i < io_indices.size(); ++i)
+				{
+					io_indices[i] += _firstVertex;
+				}
+
+				// Mirroring transforms turn triangles inside out
+				if (_flipWinding)
+				{
+					for (size_t i = first; i < io_indices.size(); i += 3u)
+					{
+						std::swap(io_indices[i + 1u], io_indices[i + 2u]);
+					}
+				}
+				return true;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		Mesh MeshLoader::LoadObj(std::string _file)
+		{
+			tinyobj::attrib_t attrib;
+			std::vector<tinyobj::shape_t> shapes;
+			std::vector<tinyobj::material_t> materials;
+			ParseObj(_file, attrib, shapes, materials);
+
+			if (shapes.size() > 1u)
 			{
-				throw std::runtime_error("TinyObjReader: could not find shape in " + _file);
+				std::cout << "ObjParser: only the first shape is loaded, " + _file + " contains many, load it with its materials to get them all" << std::endl;
 			}
 
 			std::vector<uint32> indices;
 			std::vector<Vertex> vertices;
+			VertexMap uniqueVertices;
 			
 			auto const& shape = shapes.front();
 			indices.reserve(shape.mesh.indices.size());
-			vertices.reserve(shape.mesh.indices.size());
+			vertices.reserve(shape.mesh.indices.size() / 4u); // Closed meshes share each vertex between about six corners
+			uniqueVertices.reserve(shape.mesh.indices.size() / 4u);
 			// Loop over faces(polygon) // TODO sort this mess out lol
 			size_t index_offset = 0;
 			for (size_t f = 0; f < shape.mesh.num_face_vertices.size(); f++)
@@ -67,29 +257,216 @@ namespace Singularity
 				for (size_t v = 0; v < fv; v++) {
 					// access to vertex
 					uint32 const indexVal = (uint32)index_offset + v;
-					tinyobj::index_t idx = shape.mesh.indices[indexVal];
-					indices.push_back(indexVal);
+					indices.push_back(WeldVertex(attrib, shape.mesh.indices[indexVal], vertices, uniqueVertices));
+				}
+				index_offset += fv;
+			}
+
+
+			return Mesh(vertices, indices);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		Mesh MeshLoader::LoadObj(std::string _file, std::vector<ObjMaterial>& o_materials)
+		{
+			tinyobj::attrib_t attrib;
+			std::vector<tinyobj::shape_t> shapes;
+			std::vector<tinyobj::material_t> materials;
+			ParseObj(_file, attrib, shapes, materials);
+
+			// Faces are gathered per material across every shape, with one extra list for faces that name none
+			uint32 const materialCount = static_cast<uint32>(materials.size());
+			std::vector<std::vector<uint32>> materialIndices(materialCount + 1u);
+
+			size_t cornerCount = 0u;
+			for (auto const& shape : shapes)
+			{
+				cornerCount += shape.mesh.indices.size();
+			}
+
+			std::vector<Vertex> vertices;
+			VertexMap uniqueVertices;
+			vertices.reserve(cornerCount / 4u); // Closed meshes share each vertex between about six corners
+			uniqueVertices.reserve(cornerCount / 4u);
+
+			// Shapes weld against each other too, so corners on the seams between them are only stored once
+			for (auto const& shape : shapes)
+			{
+				size_t index_offset = 0;
+				for (size_t f = 0; f < shape.mesh.num_face_vertices.size(); f++)
+				{
+					int const material = shape.mesh.material_ids[f];
+					std::vector<uint32>& faceIndices = materialIndices[material >= 0 && static_cast<uint32>(material) < materialCount ? static_cast<uint32>(material) : materialCount];
+
+					size_t const fv = shape.mesh.num_face_vertices[f];
+					for (size_t v = 0; v < fv; v++)
+					{
+						faceIndices.push_back(WeldVertex(attrib, shape.mesh.indices[index_offset + v], vertices, uniqueVertices));
+					}
+					index_offset += fv;
+				}
+			}
+
+			// Each material's faces become one contiguous range of the shared index list, in material order
+			std::vector<uint32> indices;
+			std::vector<Submesh> submeshes;
+			indices.reserve(cornerCount);
+			for (uint32 material = 0; material <= materialCount; ++material)
+			{
+				if (materialIndices[material].empty())
+				{
+					continue;
+				}
+
+				Submesh& submesh = submeshes.emplace_back();
+				submesh.m_material = material < materialCount ? material : UINT32_MAX;
+				submesh.m_lods.push_back({ static_cast<uint32>(indices.size()), static_cast<uint32>(materialIndices[material].size()), 0.0f });
+				indices.insert(indices.end(), materialIndices[material].begin(), materialIndices[material].end());
+			}
+
+			// Texture paths in the .mtl are relative to it, and it was looked up next to the .obj
+			std::string const directory = _file.substr(0, _file.find_last_of("/\\") + 1u);
+
+			o_materials.clear();
+			o_materials.reserve(materialCount);
+			for (tinyobj::material_t const& source : materials)
+			{
+				ObjMaterial& material = o_materials.emplace_back();
+				material.m_name = source.name;
+				material.m_diffuse = glm::vec3(source.diffuse[0], source.diffuse[1], source.diffuse[2]);
+				material.m_specular = glm::vec3(source.specular[0], source.specular[1], source.specular[2]);
+				material.m_emission = glm::vec3(source.emission[0], source.emission[1], source.emission[2]);
+				material.m_shininess = source.shininess;
+				material.m_opacity = source.dissolve;
+				material.m_diffuseTexture = ResolveTexture(directory, source.diffuse_texname);
+				material.m_normalTexture = ResolveTexture(directory, source.normal_texname.empty() ? source.bump_texname : source.normal_texname);
+				material.m_alphaTexture = ResolveTexture(directory, source.alpha_texname);
+			}
+
+			return Mesh(vertices, indices, submeshes);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		Mesh MeshLoader::LoadGlb(std::string _file)
+		{
+			GltfScene scene;
+			std::string error;
+			if (!GltfParser::Parse(_file, scene, error))
+			{
+				throw std::runtime_error("Failed to load glb file: " + _file + ", error: " + error);
+			}
+
+			// Primitives are gathered per material across every instance, with one extra list for those that name none
+			uint32 const materialCount = scene.m_materialCount;
+			std::vector<std::vector<uint32>> materialIndices(materialCount + 1u);
+			std::vector<Vertex> vertices;
+
+			struct Instance
+			{
+				uint32 m_node;
+				glm::mat4 m_transform;
+			};
+
+			std::vector<Instance> stack;
+			for (auto it = scene.m_roots.rbegin(); it != scene.m_roots.rend(); ++it)
+			{
+				stack.push_back({ *it, glm::mat4(1.0f) });
+			}
+
+			uint32 skipped = 0u;
+			while (!stack.empty())
+			{
+				Instance const instance = stack.back();
+				stack.pop_back();
+
+				GltfNode const& node = scene.m_nodes[instance.m_node];
+				glm::mat4 const transform = instance.m_transform * node.m_transform;
+				for (auto it = node.m_children.rbegin(); it != node.m_children.rend(); ++it)
+				{
+					stack.push_back({ *it, transform });
+				}
+
+				if (node.m_mesh == UINT32_MAX)
+				{
+					continue;
+				}
 
-					glm::vec3 position = { attrib.vertices[(uint64)3 * idx.vertex_index], attrib.vertices[(uint64)3 * idx.vertex_index + 1], attrib.vertices[(uint64)3 * idx.vertex_index + 2] };
-					glm::vec4 colour(0,0,0,0);
-					glm::vec2 uv(0, 0);
-					if (idx.texcoord_index > 0u)
+				bool const identity = transform == glm::mat4(1.0f);
+				bool const flipWinding = glm::determinant(glm::mat3(transform)) < 0.0f;
+				for (GltfPrimitive const& primitive : scene.m_meshes[node.m_mesh].m_primitives)
+				{
+					// Only triangle lists are drawn, and every vertex needs a position
+					if (primitive.m_mode != 4u || primitive.m_positions == UINT32_MAX || scene.m_accessors[primitive.m_positions].m_componentCount != 3u)
 					{
-						uv = { attrib.texcoords[(uint64)2 * idx.texcoord_index], 1.0f -  attrib.texcoords[(uint64)2 * idx.texcoord_index + 1] }; // (1.0f - coordY) because obj is upside down
+						++skipped;
+						continue;
 					}
 
-					vertices.push_back(Vertex(position, colour, uv));
+					GltfAccessor const& positions = scene.m_accessors[primitive.m_positions];
+					uint32 const vertexCount = positions.m_count;
+					uint32 const firstVertex = static_cast<uint32>(vertices.size());
+					if (static_cast<uint64>(firstVertex) + vertexCount > UINT32_MAX)
+					{
+						throw std::runtime_error("Failed to load glb file: " + _file + ", error: too many vertices");
+					}
+
+					std::vector<uint32>& indices = materialIndices[primitive.m_material != UINT32_MAX ? primitive.m_material : materialCount];
+					if (!ReadGltfIndices(scene, primitive, vertexCount, firstVertex, flipWinding, indices))
+					{
+						throw std::runtime_error("Failed to load glb file: " + _file + ", error: a primitive has invalid indices");
+					}
 
-					
+					vertices.resize(firstVertex + vertexCount, Vertex(glm::vec3(0.0f), glm::vec4(1.0f), glm::vec2(0.0f)));
+					Vertex* const primitiveVertices = vertices.data() + firstVertex;
+					ReadGltfAccessor(positions, &Vertex::m_position, primitiveVertices);
+
+					// Attributes that don't cover every vertex are ignored rather than half applied
+					if (primitive.m_colours != UINT32_MAX && scene.m_accessors[primitive.m_colours].m_count == vertexCount)
+					{
+						ReadGltfAccessor(scene.m_accessors[primitive.m_colours], &Vertex::m_colour, primitiveVertices);
+					}
+					if (primitive.m_uvs != UINT32_MAX && scene.m_accessors[primitive.m_uvs].m_count == vertexCount)
+					{
+						ReadGltfAccessor(scene.m_accessors[primitive.m_uvs], &Vertex::m_uv, primitiveVertices);
+					}
+
+					if (!identity)
+					{
+						for (uint32 i = 0; i < vertexCount; ++i)
+						{
+							primitiveVertices[i].m_position = glm::vec3(transform * glm::vec4(primitiveVertices[i].m_position, 1.0f));
+						}
+					}
 				}
-				index_offset += fv;
+			}
 
-				// per-face material
-				//shapes[s].mesh.material_ids[f];
+			if (skipped > 0u)
+			{
+				std::cout << "GltfParser: skipped " << skipped << " primitive(s) in " << _file << " that aren't triangles with positions" << std::endl;
 			}
 
+			// Each material's triangles become one contiguous range of the shared index list, in material order
+			std::vector<uint32> indices;
+			std::vector<Submesh> submeshes;
+			for (uint32 material = 0; material <= materialCount; ++material)
+			{
+				if (materialIndices[material].empty())
+				{
+					continue;
+				}
 
-			return Mesh(vertices, indices);
+				Submesh& submesh = submeshes.emplace_back();
+				submesh.m_material = material < materialCount ? material : UINT32_MAX;
+				submesh.m_lods.push_back({ static_cast<uint32>(indices.size()), static_cast<uint32>(materialIndices[material].size()), 0.0f });
+				indices.insert(indices.end(), materialIndices[material].begin(), materialIndices[material].end());
+			}
+
+			if (indices.empty())
+			{
+				throw std::runtime_error("GltfParser: could not find triangles in " + _file);
+			}
+
+			return Mesh(vertices, indices, submeshes);
 		}
 
 		////////////////////////////////////////////////////////////////////////////////////////
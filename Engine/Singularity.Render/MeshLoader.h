@@ -1,7 +1,9 @@
 #pragma once
 
 // Externals
+#include <glm/vec3.hpp>
 #include <string>
+#include <vector>
 
 
 namespace Singularity
@@ -10,10 +12,26 @@ namespace Singularity
 	{
 		class Mesh;
 
+		// One material from the .mtl an .obj references, texture paths are resolved against the .obj's directory
+		struct ObjMaterial
+		{
+			std::string m_name;
+			glm::vec3 m_diffuse = glm::vec3(1.0f);
+			glm::vec3 m_specular = glm::vec3(0.0f);
+			glm::vec3 m_emission = glm::vec3(0.0f);
+			float m_shininess = 1.0f;
+			float m_opacity = 1.0f;
+			std::string m_diffuseTexture; // Empty when the material has none
+			std::string m_normalTexture; // Falls back to the bump map
+			std::string m_alphaTexture;
+		};
+
 		class MeshLoader
 		{
 		public:
-			static Mesh LoadObj(std::string _file);
+			static Mesh LoadObj(std::string _file); // First shape only, materials are ignored
+			static Mesh LoadObj(std::string _file, std::vector<ObjMaterial>& o_materials); // Every shape in one mesh, with a submesh per material indexing o_materials
+			static Mesh LoadGlb(std::string _file); // Every mesh instance of the default scene in one mesh with node transforms applied, and a submesh per material indexing the file's materials
 
 
 		private:
@@ -0,0 +1,347 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <glm/glm.hpp>
+#include <numeric>
+
+#include <Singularity.Render/Mesh.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		namespace
+		{
+			// Forsyth's scoring, recently used vertices are worth revisiting and vertices with few triangles left are worth
+			// finishing off before they drop out of the cache
+			float VertexScore(int _cachePosition, uint32 _remaining, uint32 _cacheSize)
+			{
+				if (_remaining == 0u)
+				{
+					return -1.0f;
+				}
+
+				float score = 0.0f;
+				if (_cachePosition >= 0)
+				{
+					// The last triangle's corners are scored flat so it doesn't matter which of them it was emitted with
+					score = _cachePosition < 3 ? 0.75f : std::pow(1.0f - float(_cachePosition - 3) / float(_cacheSize - 3u), 1.5f);
+				}
+				return score + 2.0f / std::sqrt(float(_remaining));
+			}
+
+			// Counts the corners that miss a FIFO cache, simulated with insertion timestamps
+			uint32 UpdateCache(uint32 const* _triangle, std::vector<uint32>& io_timestamps, uint32& io_time, uint32 _cacheSize)
+			{
+				uint32 misses = 0u;
+				for (uint32 corner = 0; corner < 3u; ++corner)
+				{
+					uint32& timestamp = io_timestamps[_triangle[corner]];
+					if (io_time - timestamp > _cacheSize)
+					{
+						timestamp = io_time++;
+						++misses;
+					}
+				}
+				return misses;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void MeshOptimizer::OptimizeVertexCache(std::vector<uint32>& io_indices, uint32 _firstIndex, uint32 _indexCount, uint32 _vertexCount)
+		{
+			uint32 const triangleCount = _indexCount / 3u;
+			if (triangleCount < 2u)
+			{
+				return;
+			}
+
+			uint32 const* triangles = io_indices.data() + _firstIndex;
+
+			// Triangles around each vertex, shrunk as they are emitted so the live ones stay at the front
+			std::vector<uint32> remaining(_vertexCount, 0u);
+			for (uint32 i = 0; i < triangleCount * 3u; ++i)
+			{
+				++remaining[triangles[i]];
+			}
+
+			std::vector<uint32> adjacencyOffsets(_vertexCount + 1u, 0u);
+			std::partial_sum(remaining.begin(), remaining.end(), adjacencyOffsets.begin() + 1);
+			std::vector<uint32> adjacency(triangleCount * 3u);
+			std::vector<uint32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (uint32 i = 0; i < triangleCount * 3u; ++i)
+			{
+				adjacency[fill[triangles[i]]++] = i / 3u;
+			}
+
+			std::vector<int> cachePositions(_vertexCount, -1);
+			std::vector<float> vertexScores(_vertexCount, 0.0f);
+			for (uint32 vertex = 0; vertex < _vertexCount; ++vertex)
+			{
+				vertexScores[vertex] = VertexScore(-1, remaining[vertex], c_cacheSize);
+			}
+
+			std::vector<float> triangleScores(triangleCount, 0.0f);
+			std::vector<bool> emitted(triangleCount, false);
+			uint32 best = 0u;
+			for (uint32 triangle = 0; triangle < triangleCount; ++triangle)
+			{
+				triangleScores[triangle] = vertexScores[triangles[triangle * 3u]] + vertexScores[triangles[triangle * 3u + 1u]] + vertexScores[triangles[triangle * 3u + 2u]];
+				if (triangleScores[triangle] > triangleScores[best])
+				{
+					best = triangle;
+				}
+			}
+
+			std::vector<uint32> output;
+			output.reserve(triangleCount * 3u);
+			std::vector<uint32> cache;
+			std::vector<uint32> nextCache;
+			cache.reserve(c_cacheSize + 3u);
+			nextCache.reserve(c_cacheSize + 3u);
+
+			for (uint32 emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+			{
+				if (best == UINT32_MAX)
+				{
+					// Nothing in the cache touches an open triangle, so start over from the best one anywhere
+					float bestScore = -FLT_MAX;
+					for (uint32 triangle = 0; triangle < triangleCount; ++triangle)
+					{
+						if (!emitted[triangle] && triangleScores[triangle] > bestScore)
+						{
+							best = triangle;
+							bestScore = triangleScores[triangle];
+						}
+					}
+				}
+
+				emitted[best] = true;
+				nextCache.clear();
+				for (uint32 corner = 0; corner < 3u; ++corner)
+				{
+					uint32 const vertex = triangles[best * 3u + corner];
+					output.push_back(vertex);
+
+					uint32* begin = adjacency.data() + adjacencyOffsets[vertex];
+					uint32* end = begin + remaining[vertex];
+					std::iter_swap(std::find(begin, end, best), end - 1);
+					--remaining[vertex];
+
+					if (std::find(nextCache.begin(), nextCache.end(), vertex) == nextCache.end())
+					{
+						nextCache.push_back(vertex);
+					}
+				}
+
+				for (uint32 vertex : cache)
+				{
+					if (std::find(nextCache.begin(), nextCache.end(), vertex) == nextCache.end())
+					{
+						nextCache.push_back(vertex);
+					}
+				}
+
+				// Vertices pushed past the end fall out of the cache, everything left behind gets rescored
+				for (uint32 i = 0; i < nextCache.size(); ++i)
+				{
+					uint32 const vertex = nextCache[i];
+					cachePositions[vertex] = i < c_cacheSize ? static_cast<int>(i) : -1;
+					vertexScores[vertex] = VertexScore(cachePositions[vertex], remaining[vertex], c_cacheSize);
+				}
+
+				best = UINT32_MAX;
+				float bestScore = 0.0f;
+				for (uint32 i = 0; i < nextCache.size(); ++i)
+				{
+					uint32 const vertex = nextCache[i];
+					for (uint32 j = adjacencyOffsets[vertex]; j < adjacencyOffsets[vertex] + remaining[vertex]; ++j)
+					{
+						uint32 const triangle = adjacency[j];
+						triangleScores[triangle] = vertexScores[triangles[triangle * 3u]] + vertexScores[triangles[triangle * 3u + 1u]] + vertexScores[triangles[triangle * 3u + 2u]];
+						if (triangleScores[triangle] > bestScore)
+						{
+							best = triangle;
+							bestScore = triangleScores[triangle];
+						}
+					}
+				}
+
+				nextCache.resize(std::min<size_t>(nextCache.size(), c_cacheSize));
+				std::swap(cache, nextCache);
+			}
+
+			std::copy(output.begin(), output.end(), io_indices.begin() + _firstIndex);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void MeshOptimizer::OptimizeOverdraw(std::vector<Vertex> const& _vertices, std::vector<uint32>& io_indices, uint32 _firstIndex, uint32 _indexCount, float _threshold)
+		{
+			uint32 const triangleCount = _indexCount / 3u;
+			if (triangleCount < 2u)
+			{
+				return;
+			}
+
+			uint32 const* triangles = io_indices.data() + _firstIndex;
+			uint32 const vertexCount = static_cast<uint32>(_vertices.size());
+
+			// Hard boundaries fall wherever the cache order restarts anyway, a triangle that misses on all three corners
+			std::vector<uint32> timestamps(vertexCount, 0u);
+			uint32 time = c_analyzeCacheSize + 1u;
+			uint32 totalMisses = 0u;
+			std::vector<uint32> hardClusters;
+			for (uint32 triangle = 0; triangle < triangleCount; ++triangle)
+			{
+				uint32 const misses = UpdateCache(triangles + triangle * 3u, timestamps, time, c_analyzeCacheSize);
+				if (triangle == 0u || misses == 3u)
+				{
+					hardClusters.push_back(triangle);
+				}
+				totalMisses += misses;
+			}
+			hardClusters.push_back(triangleCount);
+
+			// Soft boundaries split hard clusters further, wherever the run so far is already within the allowed ACMR.
+			// Each cluster starts with a cold cache, since it may end up anywhere in the new order.
+			float const targetAcmr = _threshold * float(totalMisses) / float(triangleCount);
+			std::vector<uint32> clusters;
+			for (uint32 i = 0; i + 1u < hardClusters.size(); ++i)
+			{
+				uint32 const end = hardClusters[i + 1u];
+				uint32 clusterStart = hardClusters[i];
+				uint32 clusterMisses = 0u;
+				time += c_analyzeCacheSize + 1u;
+				clusters.push_back(clusterStart);
+
+				for (uint32 triangle = clusterStart; triangle < end; ++triangle)
+				{
+					clusterMisses += UpdateCache(triangles + triangle * 3u, timestamps, time, c_analyzeCacheSize);
+					if (triangle + 1u < end && float(clusterMisses) <= targetAcmr * float(triangle + 1u - clusterStart))
+					{
+						clusterStart = triangle + 1u;
+						clusterMisses = 0u;
+						time += c_analyzeCacheSize + 1u;
+						clusters.push_back(clusterStart);
+					}
+				}
+			}
+			clusters.push_back(triangleCount);
+			uint32 const clusterCount = static_cast<uint32>(clusters.size()) - 1u;
+
+			// Clusters facing out from the middle of the mesh go first, they tend to hide the ones facing inwards
+			std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0.0f));
+			std::vector<glm::vec3> normals(clusterCount, glm::vec3(0.0f));
+			glm::vec3 meshCentroid(0.0f);
+			float meshArea = 0.0f;
+			for (uint32 cluster = 0; cluster < clusterCount; ++cluster)
+			{
+				float clusterArea = 0.0f;
+				for (uint32 triangle = clusters[cluster]; triangle < clusters[cluster + 1u]; ++triangle)
+				{
+					glm::vec3 const& a = _vertices[triangles[triangle * 3u]].m_position;
+					glm::vec3 const& b = _vertices[triangles[triangle * 3u + 1u]].m_position;
+					glm::vec3 const& c = _vertices[triangles[triangle * 3u + 2u]].m_position;
+					glm::vec3 const normal = glm::cross(b - a, c - a);
+					float const area = glm::length(normal);
+
+					centroids[cluster] += (a + b + c) * (area / 3.0f);
+					normals[cluster] += normal;
+					clusterArea += area;
+				}
+
+				meshCentroid += centroids[cluster];
+				meshArea += clusterArea;
+				centroids[cluster] = clusterArea > 0.0f ? centroids[cluster] / clusterArea : _vertices[triangles[clusters[cluster] * 3u]].m_position;
+			}
+			meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : glm::vec3(0.0f);
+
+			std::vector<float> sortKeys(clusterCount, 0.0f);
+			for (uint32 cluster = 0; cluster < clusterCount; ++cluster)
+			{
+				float const length = glm::length(normals[cluster]);
+				sortKeys[cluster] = length > 0.0f ? glm::dot(centroids[cluster] - meshCentroid, normals[cluster] / length) : 0.0f;
+			}
+
+			std::vector<uint32> order(clusterCount);
+			std::iota(order.begin(), order.end(), 0u);
+			std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32 _a, uint32 _b) { return sortKeys[_a] > sortKeys[_b]; });
+
+			std::vector<uint32> output;
+			output.reserve(triangleCount * 3u);
+			for (uint32 cluster : order)
+			{
+				output.insert(output.end(), triangles + clusters[cluster] * 3u, triangles + clusters[cluster + 1u] * 3u);
+			}
+
+			std::copy(output.begin(), output.end(), io_indices.begin() + _firstIndex);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& io_vertices, std::vector<uint32>& io_indices)
+		{
+			uint32 const vertexCount = static_cast<uint32>(io_vertices.size());
+			std::vector<uint32> remap(vertexCount, UINT32_MAX);
+			uint32 next = 0u;
+			for (uint32& index : io_indices)
+			{
+				if (remap[index] == UINT32_MAX)
+				{
+					remap[index] = next++;
+				}
+				index = remap[index];
+			}
+
+			for (uint32& newIndex : remap)
+			{
+				if (newIndex == UINT32_MAX)
+				{
+					newIndex = next++;
+				}
+			}
+
+			std::vector<Vertex> vertices(vertexCount);
+			for (uint32 vertex = 0; vertex < vertexCount; ++vertex)
+			{
+				vertices[remap[vertex]] = io_vertices[vertex];
+			}
+			io_vertices.swap(vertices);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		VertexCacheStats MeshOptimizer::AnalyzeVertexCache(std::vector<uint32> const& _indices, uint32 _firstIndex, uint32 _indexCount, uint32 _vertexCount, uint32 _cacheSize)
+		{
+			VertexCacheStats stats;
+			uint32 const triangleCount = _indexCount / 3u;
+			if (triangleCount == 0u)
+			{
+				return stats;
+			}
+
+			std::vector<uint32> timestamps(_vertexCount, 0u);
+			std::vector<bool> referenced(_vertexCount, false);
+			uint32 time = _cacheSize + 1u;
+			uint32 misses = 0u;
+			uint32 uniqueVertices = 0u;
+			for (uint32 triangle = 0; triangle < triangleCount; ++triangle)
+			{
+				uint32 const* corners = _indices.data() + _firstIndex + triangle * 3u;
+				misses += UpdateCache(corners, timestamps, time, _cacheSize);
+				for (uint32 corner = 0; corner < 3u; ++corner)
+				{
+					if (!referenced[corners[corner]])
+					{
+						referenced[corners[corner]] = true;
+						++uniqueVertices;
+					}
+				}
+			}
+
+			stats.m_acmr = float(misses) / float(triangleCount);
+			stats.m_atvr = float(misses) / float(uniqueVertices);
+			return stats;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		struct Vertex;
+
+		// Measured against a FIFO post-transform cache. ACMR is vertex shader invocations per triangle, 0.5 at best for
+		// a large regular grid and 3 at worst. ATVR is invocations per unique vertex, 1 at best.
+		struct VertexCacheStats
+		{
+			float m_acmr = 0.0f;
+			float m_atvr = 0.0f;
+		};
+
+		// Reorders triangles and vertices so the GPU does less work drawing the same surface. The passes are meant to run
+		// in order: vertex cache first, then overdraw, which only trades away cache efficiency within _threshold, then
+		// vertex fetch, which renumbers vertices into the order the indices first touch them.
+		class MeshOptimizer
+		{
+		public:
+			static void OptimizeVertexCache(std::vector<uint32>& io_indices, uint32 _firstIndex, uint32 _indexCount, uint32 _vertexCount);
+			static void OptimizeOverdraw(std::vector<Vertex> const& _vertices, std::vector<uint32>& io_indices, uint32 _firstIndex, uint32 _indexCount, float _threshold = 1.05f);
+			static void OptimizeVertexFetch(std::vector<Vertex>& io_vertices, std::vector<uint32>& io_indices); // Remaps every index, unused vertices move to the end
+
+			static VertexCacheStats AnalyzeVertexCache(std::vector<uint32> const& _indices, uint32 _firstIndex, uint32 _indexCount, uint32 _vertexCount, uint32 _cacheSize = c_analyzeCacheSize);
+
+			static uint32 constexpr c_analyzeCacheSize = 16u;
+
+		private:
+			static uint32 constexpr c_cacheSize = 32u; // Modelled LRU cache for ordering, larger than real caches so it degrades gracefully on them
+		};
+	}
+}
\ No newline at end of file
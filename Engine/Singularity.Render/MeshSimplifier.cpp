@@ -0,0 +1,408 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+#include <numeric>
+#include <tuple>
+
+#include <Singularity.Render/Mesh.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		namespace
+		{
+			// Sum of squared distances to a set of planes, each weighted by the area of the triangle it came from
+			struct Quadric
+			{
+				void AddPlane(glm::dvec3 const& _normal, double _distance, double _weight)
+				{
+					m_xx += _weight * _normal.x * _normal.x;
+					m_xy += _weight * _normal.x * _normal.y;
+					m_xz += _weight * _normal.x * _normal.z;
+					m_yy += _weight * _normal.y * _normal.y;
+					m_yz += _weight * _normal.y * _normal.z;
+					m_zz += _weight * _normal.z * _normal.z;
+					m_x += _weight * _normal.x * _distance;
+					m_y += _weight * _normal.y * _distance;
+					m_z += _weight * _normal.z * _distance;
+					m_c += _weight * _distance * _distance;
+					m_weight += _weight;
+				}
+
+				void Add(Quadric const& _other)
+				{
+					m_xx += _other.m_xx;
+					m_xy += _other.m_xy;
+					m_xz += _other.m_xz;
+					m_yy += _other.m_yy;
+					m_yz += _other.m_yz;
+					m_zz += _other.m_zz;
+					m_x += _other.m_x;
+					m_y += _other.m_y;
+					m_z += _other.m_z;
+					m_c += _other.m_c;
+					m_weight += _other.m_weight;
+				}
+
+				// Weighted sum of squared plane distances, dividing by the total weight turns it into a squared distance
+				double Evaluate(glm::vec3 const& _position) const
+				{
+					double const x = _position.x;
+					double const y = _position.y;
+					double const z = _position.z;
+					double const result = m_xx * x * x + m_yy * y * y + m_zz * z * z
+						+ 2.0 * (m_xy * x * y + m_xz * x * z + m_yz * y * z)
+						+ 2.0 * (m_x * x + m_y * y + m_z * z)
+						+ m_c;
+					return std::max(result, 0.0);
+				}
+
+				double m_xx = 0.0;
+				double m_xy = 0.0;
+				double m_xz = 0.0;
+				double m_yy = 0.0;
+				double m_yz = 0.0;
+				double m_zz = 0.0;
+				double m_x = 0.0;
+				double m_y = 0.0;
+				double m_z = 0.0;
+				double m_c = 0.0;
+				double m_weight = 0.0;
+			};
+
+			struct Collapse
+			{
+				uint32 m_from = 0u;
+				uint32 m_to = 0u;
+				double m_error = 0.0; // Squared distance from the original surface
+				double m_cost = 0.0; // Error plus the attribute penalty, decides the order
+			};
+
+			bool LessPosition(glm::vec3 const& _a, glm::vec3 const& _b)
+			{
+				return std::tie(_a.x, _a.y, _a.z) < std::tie(_b.x, _b.y, _b.z);
+			}
+
+			bool EqualAttributes(Vertex const& _a, Vertex const& _b)
+			{
+				return _a.m_colour == _b.m_colour && _a.m_uv == _b.m_uv;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		std::vector<uint32> MeshSimplifier::Simplify(std::vector<Vertex> const& _vertices, std::vector<uint32> const& _indices, uint32 _targetIndexCount, float _targetError, float* o_error)
+		{
+			if (o_error)
+			{
+				*o_error = 0.0f;
+			}
+
+			uint32 const vertexCount = static_cast<uint32>(_vertices.size());
+
+			// Weld corners, once by position for topology and once by everything to find which corners really differ
+			std::vector<uint32> order(vertexCount);
+			std::iota(order.begin(), order.end(), 0u);
+			std::sort(order.begin(), order.end(), [&_vertices](uint32 _a, uint32 _b)
+			{
+				Vertex const& a = _vertices[_a];
+				Vertex const& b = _vertices[_b];
+				if (a.m_position != b.m_position)
+				{
+					return LessPosition(a.m_position, b.m_position);
+				}
+				return std::tie(a.m_uv.x, a.m_uv.y, a.m_colour.x, a.m_colour.y, a.m_colour.z, a.m_colour.w) < std::tie(b.m_uv.x, b.m_uv.y, b.m_colour.x, b.m_colour.y, b.m_colour.z, b.m_colour.w);
+			});
+
+			std::vector<uint32> positionIds(vertexCount);
+			std::vector<uint32> canonical(vertexCount);
+			std::vector<glm::vec3> positions;
+			for (uint32 i = 0; i < vertexCount; ++i)
+			{
+				uint32 const vertex = order[i];
+				Vertex const& previous = _vertices[order[i > 0u ? i - 1u : 0u]];
+				bool const newPosition = i == 0u || previous.m_position != _vertices[vertex].m_position;
+				if (newPosition)
+				{
+					positions.push_back(_vertices[vertex].m_position);
+				}
+
+				positionIds[vertex] = static_cast<uint32>(positions.size() - 1u);
+				canonical[vertex] = newPosition || !EqualAttributes(previous, _vertices[vertex]) ? vertex : canonical[order[i - 1u]];
+			}
+
+			uint32 const positionCount = static_cast<uint32>(positions.size());
+
+			std::vector<uint32> indices;
+			indices.reserve(_indices.size());
+			for (size_t i = 0; i + 2u < _indices.size(); i += 3u)
+			{
+				uint32 const a = canonical[_indices[i]];
+				uint32 const b = canonical[_indices[i + 1u]];
+				uint32 const c = canonical[_indices[i + 2u]];
+				if (positionIds[a] != positionIds[b] && positionIds[b] != positionIds[c] && positionIds[c] != positionIds[a])
+				{
+					indices.push_back(a);
+					indices.push_back(b);
+					indices.push_back(c);
+				}
+			}
+
+			if (indices.size() <= _targetIndexCount)
+			{
+				return indices;
+			}
+
+			// Positions reached through more than one distinct vertex sit on an attribute seam
+			std::vector<bool> locked(positionCount, false);
+			std::vector<uint32> positionVertex(positionCount, UINT32_MAX);
+			for (uint32 vertex : indices)
+			{
+				uint32 const position = positionIds[vertex];
+				if (positionVertex[position] == UINT32_MAX)
+				{
+					positionVertex[position] = vertex;
+				}
+				else if (positionVertex[position] != vertex)
+				{
+					locked[position] = true;
+				}
+			}
+
+			// Edges not shared by exactly two triangles are borders or non-manifold
+			std::vector<std::pair<uint32, uint32>> edges;
+			edges.reserve(indices.size());
+			for (size_t i = 0; i < indices.size(); ++i)
+			{
+				uint32 const a = positionIds[indices[i]];
+				uint32 const b = positionIds[indices[i % 3u == 2u ? i - 2u : i + 1u]];
+				edges.emplace_back(std::min(a, b), std::max(a, b));
+			}
+			std::sort(edges.begin(), edges.end());
+			for (size_t i = 0; i < edges.size();)
+			{
+				size_t end = i + 1u;
+				while (end < edges.size() && edges[end] == edges[i])
+				{
+					++end;
+				}
+
+				if (end - i != 2u)
+				{
+					locked[edges[i].first] = true;
+					locked[edges[i].second] = true;
+				}
+				i = end;
+			}
+
+			std::vector<Quadric> quadrics(positionCount);
+			for (size_t i = 0; i < indices.size(); i += 3u)
+			{
+				glm::dvec3 const p0 = positions[positionIds[indices[i]]];
+				glm::dvec3 const p1 = positions[positionIds[indices[i + 1u]]];
+				glm::dvec3 const p2 = positions[positionIds[indices[i + 2u]]];
+				glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+				double const length = glm::length(normal);
+				if (length <= 0.0)
+				{
+					continue;
+				}
+
+				normal /= length;
+				for (uint32 corner = 0; corner < 3u; ++corner)
+				{
+					quadrics[positionIds[indices[i + corner]]].AddPlane(normal, -glm::dot(normal, p0), length * 0.5);
+				}
+			}
+
+			// Attribute error is measured against the mesh's size so it means the same thing on any model
+			glm::vec3 minimum(FLT_MAX);
+			glm::vec3 maximum(-FLT_MAX);
+			for (glm::vec3 const& position : positions)
+			{
+				minimum = glm::min(minimum, position);
+				maximum = glm::max(maximum, position);
+			}
+			glm::vec3 const extent = (maximum - minimum) * 0.5f;
+			double const attributeScale = c_attributeWeight * glm::dot(extent, extent);
+
+			double const targetErrorSquared = static_cast<double>(_targetError) * static_cast<double>(_targetError);
+			double maxError = 0.0;
+
+			std::vector<uint32> remap(vertexCount);
+			std::iota(remap.begin(), remap.end(), 0u);
+
+			std::vector<uint32> adjacencyOffsets(positionCount + 1u);
+			std::vector<uint32> adjacency;
+			std::vector<Collapse> collapses;
+			std::vector<bool> touched(positionCount);
+
+			while (indices.size() > _targetIndexCount)
+			{
+				uint32 const triangleCount = static_cast<uint32>(indices.size() / 3u);
+
+				// Triangles around each position
+				std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0u);
+				for (uint32 vertex : indices)
+				{
+					++adjacencyOffsets[positionIds[vertex] + 1u];
+				}
+				std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+				adjacency.resize(indices.size());
+				std::vector<uint32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (uint32 i = 0; i < indices.size(); ++i)
+				{
+					adjacency[fill[positionIds[indices[i]]]++] = i / 3u;
+				}
+
+				// A closed surface lists every edge once in each direction, so only the increasing one is taken
+				collapses.clear();
+				for (uint32 i = 0; i < indices.size(); ++i)
+				{
+					uint32 const a = indices[i];
+					uint32 const b = indices[i % 3u == 2u ? i - 2u : i + 1u];
+					uint32 const positionA = positionIds[a];
+					uint32 const positionB = positionIds[b];
+					if (positionA > positionB)
+					{
+						continue;
+					}
+
+					Quadric quadric = quadrics[positionA];
+					quadric.Add(quadrics[positionB]);
+
+					glm::vec2 const uvOffset = _vertices[a].m_uv - _vertices[b].m_uv;
+					glm::vec4 const colourOffset = _vertices[a].m_colour - _vertices[b].m_colour;
+					double const attributeError = attributeScale * (glm::dot(uvOffset, uvOffset) + glm::dot(colourOffset, colourOffset));
+					double const weight = std::max(quadric.m_weight, 1e-12);
+
+					if (!locked[positionA])
+					{
+						double const error = quadric.Evaluate(positions[positionB]) / weight;
+						collapses.push_back({ a, b, error, error + attributeError });
+					}
+					if (!locked[positionB])
+					{
+						double const error = quadric.Evaluate(positions[positionA]) / weight;
+						collapses.push_back({ b, a, error, error + attributeError });
+					}
+				}
+
+				std::sort(collapses.begin(), collapses.end(), [](Collapse const& _a, Collapse const& _b) { return _a.m_cost < _b.m_cost; });
+
+				// Each collapse removes about two triangles, stop short of the target rather than overshooting it
+				uint32 const targetTriangles = _targetIndexCount / 3u;
+				uint32 const collapseBudget = std::max(1u, (triangleCount - targetTriangles) / 2u);
+
+				std::fill(touched.begin(), touched.end(), false);
+				uint32 collapsed = 0u;
+				for (Collapse const& collapse : collapses)
+				{
+					if (collapsed >= collapseBudget)
+					{
+						break;
+					}
+
+					if (collapse.m_error > targetErrorSquared)
+					{
+						continue;
+					}
+
+					uint32 const from = positionIds[collapse.m_from];
+					uint32 const to = positionIds[collapse.m_to];
+					if (touched[from] || touched[to])
+					{
+						continue;
+					}
+
+					// Triangles that keep their area must not flip, ones spanning the edge must agree on the vertex they end up with
+					bool valid = true;
+					for (uint32 j = adjacencyOffsets[from]; j < adjacencyOffsets[from + 1u] && valid; ++j)
+					{
+						uint32 const triangle = adjacency[j];
+						uint32 corners[3];
+						glm::vec3 before[3];
+						bool spansEdge = false;
+						for (uint32 k = 0; k < 3u; ++k)
+						{
+							corners[k] = remap[indices[triangle * 3u + k]];
+							before[k] = positions[positionIds[corners[k]]];
+							if (positionIds[corners[k]] == to)
+							{
+								spansEdge = true;
+								valid = corners[k] == collapse.m_to;
+							}
+						}
+
+						if (spansEdge)
+						{
+							continue;
+						}
+
+						glm::vec3 after[3] = { before[0], before[1], before[2] };
+						for (uint32 k = 0; k < 3u; ++k)
+						{
+							if (positionIds[corners[k]] == from)
+							{
+								after[k] = positions[to];
+							}
+						}
+
+						// Already flattened by an earlier collapse in this pass, dropped once the pass is applied
+						glm::vec3 const normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+						if (glm::dot(normalBefore, normalBefore) == 0.0f)
+						{
+							continue;
+						}
+
+						glm::vec3 const normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+						valid = glm::dot(normalBefore, normalAfter) > 0.0f;
+					}
+
+					if (!valid)
+					{
+						continue;
+					}
+
+					remap[collapse.m_from] = collapse.m_to;
+					quadrics[to].Add(quadrics[from]);
+					touched[from] = true;
+					touched[to] = true;
+
+					maxError = std::max(maxError, collapse.m_error);
+					++collapsed;
+				}
+
+				if (collapsed == 0u)
+				{
+					break;
+				}
+
+				// Collapsed triangles have two corners on the same position and are dropped
+				uint32 write = 0u;
+				for (size_t i = 0; i < indices.size(); i += 3u)
+				{
+					uint32 const a = remap[indices[i]];
+					uint32 const b = remap[indices[i + 1u]];
+					uint32 const c = remap[indices[i + 2u]];
+					if (positionIds[a] != positionIds[b] && positionIds[b] != positionIds[c] && positionIds[c] != positionIds[a])
+					{
+						indices[write++] = a;
+						indices[write++] = b;
+						indices[write++] = c;
+					}
+				}
+				indices.resize(write);
+			}
+
+			if (o_error)
+			{
+				*o_error = static_cast<float>(std::sqrt(maxError));
+			}
+
+			return indices;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cfloat>
+#include <vector>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		struct Vertex;
+
+		// Quadric error metric simplification by half edge collapse. Every collapse moves one vertex onto a neighbour, so
+		// the result only references vertices that already exist and can share the source's vertex buffer.
+		//
+		// Corners are welded by position first so meshes with one vertex per corner still simplify. Vertices on open
+		// borders, non-manifold edges and attribute seams are locked, which keeps silhouettes and texture layouts intact.
+		// Collapses also pay for how far they drag uvs and colours, scaled to the mesh's size.
+		class MeshSimplifier
+		{
+		public:
+			// Returns as few indices as it can down to _targetIndexCount without exceeding _targetError, an object space
+			// distance. o_error receives the largest geometric deviation of any collapse made, attribute penalties only
+			// decide which collapses go first.
+			static std::vector<uint32> Simplify(std::vector<Vertex> const& _vertices, std::vector<uint32> const& _indices, uint32 _targetIndexCount, float _targetError = FLT_MAX, float* o_error = nullptr);
+
+		private:
+			static float constexpr c_attributeWeight = 0.05f; // Relative to the squared radius of the mesh
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,278 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <glm/glm.hpp>
+#include <numeric>
+#include <tuple>
+
+#include <Singularity.Render/Frustum.h>
+#include <Singularity.Render/Mesh.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		//////////////////////////////////////////////////////////////////////////////////////
+		void MeshletBuilder::Build(std::vector<Vertex> const& _vertices, std::vector<uint32>& io_indices, uint32 _firstIndex, uint32 _indexCount, std::vector<Meshlet>& o_meshlets)
+		{
+			o_meshlets.clear();
+
+			uint32 const triangleCount = _indexCount / 3u;
+			if (triangleCount == 0u)
+			{
+				return;
+			}
+
+			std::vector<uint32> const triangles(io_indices.begin() + _firstIndex, io_indices.begin() + _firstIndex + triangleCount * 3u);
+
+			// Neighbours are found by position, meshes with a vertex per corner share no indices at all
+			std::vector<uint32> order(triangles);
+			std::sort(order.begin(), order.end());
+			order.erase(std::unique(order.begin(), order.end()), order.end());
+			std::sort(order.begin(), order.end(), [&_vertices](uint32 _a, uint32 _b)
+			{
+				glm::vec3 const& a = _vertices[_a].m_position;
+				glm::vec3 const& b = _vertices[_b].m_position;
+				return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+			});
+
+			std::vector<uint32> positionIds(_vertices.size(), UINT32_MAX);
+			uint32 positionCount = 0u;
+			for (uint32 i = 0; i < order.size(); ++i)
+			{
+				if (i > 0u && _vertices[order[i]].m_position != _vertices[order[i - 1u]].m_position)
+				{
+					++positionCount;
+				}
+				positionIds[order[i]] = positionCount;
+			}
+			++positionCount;
+
+			std::vector<uint32> adjacencyOffsets(positionCount + 1u, 0u);
+			for (uint32 vertex : triangles)
+			{
+				++adjacencyOffsets[positionIds[vertex] + 1u];
+			}
+			std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+
+			std::vector<uint32> adjacency(triangles.size());
+			std::vector<uint32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (uint32 i = 0; i < triangles.size(); ++i)
+			{
+				adjacency[fill[positionIds[triangles[i]]]++] = i / 3u;
+			}
+
+			std::vector<bool> used(triangleCount, false);
+			std::vector<uint32> vertexMeshlet(_vertices.size(), UINT32_MAX); // Which cluster last took each vertex
+			std::vector<uint32> candidateMeshlet(triangleCount, UINT32_MAX);
+			std::vector<uint32> candidates;
+			std::vector<uint32> output;
+			output.reserve(triangles.size());
+
+			uint32 meshletIndex = 0u;
+			uint32 meshletStart = 0u;
+			uint32 vertexCount = 0u;
+			uint32 nextSeed = UINT32_MAX;
+			uint32 scanSeed = 0u;
+
+			auto countNewVertices = [&](uint32 _triangle)
+			{
+				uint32 count = 0u;
+				for (uint32 corner = 0; corner < 3u; ++corner)
+				{
+					uint32 const vertex = triangles[_triangle * 3u + corner];
+					bool const repeated = (corner > 0u && vertex == triangles[_triangle * 3u]) || (corner > 1u && vertex == triangles[_triangle * 3u + 1u]);
+					if (vertexMeshlet[vertex] != meshletIndex && !repeated)
+					{
+						++count;
+					}
+				}
+				return count;
+			};
+
+			auto flush = [&]()
+			{
+				Meshlet& meshlet = o_meshlets.emplace_back();
+				meshlet.m_firstIndex = _firstIndex + meshletStart;
+				meshlet.m_indexCount = static_cast<uint32>(output.size()) - meshletStart;
+				meshlet.m_vertexCount = vertexCount;
+				CalculateBounds(_vertices, output.data() + meshletStart, meshlet);
+
+				// The next cluster starts next to this one rather than wherever the scan has got to
+				nextSeed = UINT32_MAX;
+				for (uint32 candidate : candidates)
+				{
+					if (!used[candidate])
+					{
+						nextSeed = candidate;
+						break;
+					}
+				}
+
+				++meshletIndex;
+				meshletStart = static_cast<uint32>(output.size());
+				vertexCount = 0u;
+				candidates.clear();
+			};
+
+			for (uint32 remaining = triangleCount; remaining > 0u; --remaining)
+			{
+				uint32 best = UINT32_MAX;
+				uint32 bestNewVertices = UINT32_MAX;
+				uint32 write = 0u;
+				for (uint32 candidate : candidates)
+				{
+					if (used[candidate])
+					{
+						continue;
+					}
+					candidates[write++] = candidate;
+
+					uint32 const newVertices = countNewVertices(candidate);
+					if (vertexCount + newVertices <= c_maxVertices && newVertices < bestNewVertices)
+					{
+						best = candidate;
+						bestNewVertices = newVertices;
+					}
+				}
+				candidates.resize(write);
+
+				if (best == UINT32_MAX)
+				{
+					if (meshletStart != output.size())
+					{
+						flush();
+					}
+
+					if (nextSeed == UINT32_MAX || used[nextSeed])
+					{
+						while (used[scanSeed])
+						{
+							++scanSeed;
+						}
+						nextSeed = scanSeed;
+					}
+					best = nextSeed;
+				}
+
+				used[best] = true;
+				for (uint32 corner = 0; corner < 3u; ++corner)
+				{
+					uint32 const vertex = triangles[best * 3u + corner];
+					output.push_back(vertex);
+					if (vertexMeshlet[vertex] != meshletIndex)
+					{
+						vertexMeshlet[vertex] = meshletIndex;
+						++vertexCount;
+					}
+
+					uint32 const position = positionIds[vertex];
+					for (uint32 i = adjacencyOffsets[position]; i < adjacencyOffsets[position + 1u]; ++i)
+					{
+						uint32 const neighbour = adjacency[i];
+						if (!used[neighbour] && candidateMeshlet[neighbour] != meshletIndex)
+						{
+							candidateMeshlet[neighbour] = meshletIndex;
+							candidates.push_back(neighbour);
+						}
+					}
+				}
+
+				if (output.size() - meshletStart == c_maxTriangles * 3u)
+				{
+					flush();
+				}
+			}
+
+			if (meshletStart != output.size())
+			{
+				flush();
+			}
+
+			std::copy(output.begin(), output.end(), io_indices.begin() + _firstIndex);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		bool MeshletBuilder::IsVisible(Meshlet const& _meshlet, glm::mat4 const& _model, Frustum const& _frustum, glm::vec3 const& _cameraPosition)
+		{
+			glm::vec3 const axisScale(glm::length(glm::vec3(_model[0])), glm::length(glm::vec3(_model[1])), glm::length(glm::vec3(_model[2])));
+			float const scale = std::max(std::max(axisScale.x, axisScale.y), axisScale.z);
+			glm::vec3 const centre = glm::vec3(_model * glm::vec4(glm::vec3(_meshlet.m_boundingSphere), 1.0f));
+			float const radius = _meshlet.m_boundingSphere.w * scale;
+			if (!_frustum.IntersectsSphere(centre, radius))
+			{
+				return false;
+			}
+
+			// Non-uniform scale bends the normals away from the cone, so those clusters only get the frustum test
+			bool const uniformScale = scale - std::min(std::min(axisScale.x, axisScale.y), axisScale.z) <= scale * 1e-3f;
+			if (!uniformScale || _meshlet.m_cone.w >= 1.0f)
+			{
+				return true;
+			}
+
+			glm::vec3 const axis = glm::normalize(glm::mat3(_model) * glm::vec3(_meshlet.m_cone));
+			glm::vec3 const toCentre = centre - _cameraPosition;
+			return glm::dot(toCentre, axis) < _meshlet.m_cone.w * glm::length(toCentre) + radius;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void MeshletBuilder::CalculateBounds(std::vector<Vertex> const& _vertices, uint32 const* _indices, Meshlet& io_meshlet)
+		{
+			glm::vec3 minimum(FLT_MAX);
+			glm::vec3 maximum(-FLT_MAX);
+			for (uint32 i = 0; i < io_meshlet.m_indexCount; ++i)
+			{
+				minimum = glm::min(minimum, _vertices[_indices[i]].m_position);
+				maximum = glm::max(maximum, _vertices[_indices[i]].m_position);
+			}
+
+			glm::vec3 const centre = (minimum + maximum) * 0.5f;
+			float radiusSquared = 0.0f;
+			for (uint32 i = 0; i < io_meshlet.m_indexCount; ++i)
+			{
+				glm::vec3 const offset = _vertices[_indices[i]].m_position - centre;
+				radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+			}
+			io_meshlet.m_boundingSphere = glm::vec4(centre, std::sqrt(radiusSquared));
+
+			// Every face normal lies inside the cone, so a view from within its reverse sees only back faces
+			std::vector<glm::vec3> normals;
+			normals.reserve(io_meshlet.m_indexCount / 3u);
+			glm::vec3 normalSum(0.0f);
+			for (uint32 i = 0; i < io_meshlet.m_indexCount; i += 3u)
+			{
+				glm::vec3 const& a = _vertices[_indices[i]].m_position;
+				glm::vec3 const& b = _vertices[_indices[i + 1u]].m_position;
+				glm::vec3 const& c = _vertices[_indices[i + 2u]].m_position;
+				glm::vec3 const normal = glm::cross(b - a, c - a);
+				float const length = glm::length(normal);
+				if (length > 0.0f)
+				{
+					normals.push_back(normal / length);
+					normalSum += normals.back();
+				}
+			}
+
+			float const sumLength = glm::length(normalSum);
+			if (sumLength <= 0.0f)
+			{
+				io_meshlet.m_cone = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+				return;
+			}
+
+			glm::vec3 const axis = normalSum / sumLength;
+			float minimumDot = 1.0f;
+			for (glm::vec3 const& normal : normals)
+			{
+				minimumDot = std::min(minimumDot, glm::dot(axis, normal));
+			}
+
+			// Past roughly 85 degrees of spread there is hardly any view the whole cluster faces away from
+			float const cutoff = minimumDot <= 0.1f ? 1.0f : std::sqrt(1.0f - minimumDot * minimumDot);
+			io_meshlet.m_cone = glm::vec4(axis, cutoff);
+		}
+	}
+}
\ No newline at end of file
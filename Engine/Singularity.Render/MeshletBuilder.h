@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		struct Frustum;
+		struct Meshlet;
+		struct Vertex;
+
+		// Splits a range of an index buffer into clusters small enough to cull individually. Triangles are reordered in
+		// place so every cluster is one contiguous run of indices that a plain indexed draw can cover. Clusters grow
+		// across shared edges, taking whichever neighbour adds the fewest new vertices, so they stay compact.
+		class MeshletBuilder
+		{
+		public:
+			static void Build(std::vector<Vertex> const& _vertices, std::vector<uint32>& io_indices, uint32 _firstIndex, uint32 _indexCount, std::vector<Meshlet>& o_meshlets);
+			static bool IsVisible(Meshlet const& _meshlet, glm::mat4 const& _model, Frustum const& _frustum, glm::vec3 const& _cameraPosition); // cluster_cull.comp's sphere and cone test on the CPU
+
+			static uint32 constexpr c_maxVertices = 64u;
+			static uint32 constexpr c_maxTriangles = 124u;
+
+		private:
+			static void CalculateBounds(std::vector<Vertex> const& _vertices, uint32 const* _indices, Meshlet& io_meshlet);
+		};
+	}
+}
\ No newline at end of file
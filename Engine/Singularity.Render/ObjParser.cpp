@@ -0,0 +1,1057 @@
+#include "ObjParser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+
+// tinyobj still reads the .mtl files
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tinyobj/tiny_obj_loader.h>
+
+#include <Singularity.Core/Parallel.h>
+#include <Singularity.IO/MappedFile.h>
+
+
+namespace Singularity
+{
+	namespace Render
+	{
+		namespace
+		{
+			// State changes between faces, replayed in file order once every chunk is parsed
+			struct ObjCommand
+			{
+				enum class Type
+				{
+					UseMaterial,
+					MaterialLibrary,
+					Group,
+					Object,
+					Smoothing
+				};
+
+				Type m_type;
+				uint32 m_value = 0u; // Smoothing group, or the line of a group without a name
+				std::string m_text;
+
+				// Primitives of the chunk that come before the command
+				uint32 m_face = 0u;
+				uint32 m_line = 0u;
+				uint32 m_point = 0u;
+			};
+
+			struct ObjChunk
+			{
+				char const* m_begin = nullptr;
+				char const* m_end = nullptr;
+
+				// Counted first so every chunk knows where its attributes go and how many come before it
+				uint32 m_lineCount = 0u;
+				uint32 m_positionCount = 0u;
+				uint32 m_normalCount = 0u;
+				uint32 m_texcoordCount = 0u;
+				uint32 m_firstLine = 0u;
+				uint32 m_firstPosition = 0u;
+				uint32 m_firstNormal = 0u;
+				uint32 m_firstTexcoord = 0u;
+
+				std::vector<tinyobj::index_t> m_corners; // Polygons as written
+				std::vector<uint32> m_faces = { 0u }; // First corner of each polygon, plus one past the last
+				std::vector<tinyobj::index_t> m_triangles;
+				std::vector<uint32> m_faceTriangles; // First triangle corner of each polygon, plus one past the last
+				std::vector<tinyobj::index_t> m_lineCorners;
+				std::vector<uint32> m_lines = { 0u }; // First corner of each polyline, plus one past the last
+				std::vector<tinyobj::index_t> m_pointCorners;
+				std::vector<uint32> m_points = { 0u }; // First corner of each "p" record, plus one past the last
+				std::vector<ObjCommand> m_commands;
+
+				int m_greatestPosition = -1;
+				int m_greatestNormal = -1;
+				int m_greatestTexcoord = -1;
+				std::string m_error;
+			};
+
+			// Faces, lines or points waiting to be flushed into a shape, the counterpart of tinyobj's primitive groups
+			struct ObjSpan
+			{
+				ObjChunk const* m_chunk;
+				uint32 m_begin;
+				uint32 m_end;
+				uint32 m_smoothing;
+			};
+
+			bool IsSpace(char _c)
+			{
+				return _c == ' ' || _c == '\t';
+			}
+
+			bool IsDigit(char _c)
+			{
+				return static_cast<uint32>(_c - '0') < 10u;
+			}
+
+			char const* SkipSpace(char const* _token, char const* _end)
+			{
+				while (_token < _end && IsSpace(*_token))
+				{
+					++_token;
+				}
+				return _token;
+			}
+
+			char const* FindSpace(char const* _token, char const* _end)
+			{
+				while (_token < _end && !IsSpace(*_token))
+				{
+					++_token;
+				}
+				return _token;
+			}
+
+			char const* FindSeparator(char const* _token, char const* _end)
+			{
+				while (_token < _end && *_token != '/' && !IsSpace(*_token))
+				{
+					++_token;
+				}
+				return _token;
+			}
+
+			// Lines end at "\n", "\r\n" or a lone "\r", the same as tinyobj's safeGetline. Each line is scanned once for
+			// whichever break comes first, only the file's bytes are touched and nothing is copied.
+			template<typename Function>
+			void ForEachLine(char const* _begin, char const* _end, Function const& _function)
+			{
+				char const* line = _begin;
+				while (line < _end)
+				{
+					char const* lineEnd = line;
+					while (lineEnd < _end && *lineEnd != '\n' && *lineEnd != '\r')
+					{
+						++lineEnd;
+					}
+
+					char const* next = lineEnd;
+					if (next < _end)
+					{
+						next += *next == '\r' && next + 1 < _end && next[1] == '\n' ? 2 : 1;
+					}
+
+					_function(line, lineEnd);
+					line = next;
+				}
+			}
+
+			// tinyobj's tryParseDouble, doing the same arithmetic in the same order so every value is identical to the bit
+			bool ParseDouble(char const* _begin, char const* _end, double& o_value)
+			{
+				static double constexpr c_decimals[] = { 1.0, 0.1, 0.01, 0.001, 0.0001, 0.00001, 0.000001, 0.0000001 };
+				static int constexpr c_decimalCount = sizeof(c_decimals) / sizeof(c_decimals[0]);
+
+				if (_begin >= _end)
+				{
+					return false;
+				}
+
+				double mantissa = 0.0;
+				int exponent = 0;
+				bool negative = false;
+				char const* current = _begin;
+
+				if (*current == '+' || *current == '-')
+				{
+					negative = *current == '-';
+					++current;
+				}
+				else if (!IsDigit(*current) && *current != '.')
+				{
+					return false;
+				}
+
+				// Integer digits are required unless the number starts with its decimal point
+				if (current == _end || *current != '.')
+				{
+					char const* const digits = current;
+					while (current < _end && IsDigit(*current))
+					{
+						mantissa *= 10;
+						mantissa += static_cast<int>(*current - '0');
+						++current;
+					}
+
+					if (current == digits)
+					{
+						return false;
+					}
+				}
+
+				if (current < _end && *current == '.')
+				{
+					++current;
+					for (int read = 1; current < _end && IsDigit(*current); ++read, ++current)
+					{
+						mantissa += static_cast<int>(*current - '0') * (read < c_decimalCount ? c_decimals[read] : std::pow(10.0, -read));
+					}
+				}
+
+				if (current < _end && (*current == 'e' || *current == 'E'))
+				{
+					++current;
+					bool negativeExponent = false;
+					if (current < _end && (*current == '+' || *current == '-'))
+					{
+						negativeExponent = *current == '-';
+						++current;
+					}
+					else if (current == _end || !IsDigit(*current))
+					{
+						return false;
+					}
+
+					char const* const digits = current;
+					while (current < _end && IsDigit(*current))
+					{
+						exponent *= 10;
+						exponent += static_cast<int>(*current - '0');
+						++current;
+					}
+					exponent *= negativeExponent ? -1 : 1;
+
+					if (current == digits)
+					{
+						return false;
+					}
+				}
+
+				o_value = (negative ? -1 : 1) * (exponent ? std::ldexp(mantissa * std::pow(5.0, exponent), exponent) : mantissa);
+				return true;
+			}
+
+			float ParseReal(char const*& io_token, char const* _end, double _default = 0.0)
+			{
+				io_token = SkipSpace(io_token, _end);
+				char const* const end = FindSpace(io_token, _end);
+				double value = _default;
+				ParseDouble(io_token, end, value);
+				io_token = end;
+				return static_cast<float>(value);
+			}
+
+			bool ParseReal(char const*& io_token, char const* _end, float& o_value)
+			{
+				io_token = SkipSpace(io_token, _end);
+				char const* const end = FindSpace(io_token, _end);
+				double value;
+				bool const parsed = ParseDouble(io_token, end, value);
+				if (parsed)
+				{
+					o_value = static_cast<float>(value);
+				}
+				io_token = end;
+				return parsed;
+			}
+
+			// atoi over a line that isn't null terminated
+			int ParseInt(char const* _token, char const* _end)
+			{
+				while (_token < _end && (IsSpace(*_token) || *_token == '\v' || *_token == '\f'))
+				{
+					++_token;
+				}
+
+				bool negative = false;
+				if (_token < _end && (*_token == '+' || *_token == '-'))
+				{
+					negative = *_token == '-';
+					++_token;
+				}
+
+				int64_t value = 0;
+				for (; _token < _end && IsDigit(*_token); ++_token)
+				{
+					value = value * 10 + (*_token - '0');
+				}
+				return static_cast<int>(negative ? -value : value);
+			}
+
+			std::string ParseString(char const*& io_token, char const* _end)
+			{
+				io_token = SkipSpace(io_token, _end);
+				char const* const begin = io_token;
+				io_token = FindSpace(io_token, _end);
+				return std::string(begin, io_token);
+			}
+
+			// Zero based, negative indices count back from the attributes parsed so far and zero is invalid
+			bool FixIndex(int _index, int _count, int& o_index)
+			{
+				if (_index == 0)
+				{
+					return false;
+				}
+
+				o_index = _index > 0 ? _index - 1 : _count + _index;
+				return true;
+			}
+
+			// One corner of a face, "v", "v/vt", "v//vn" or "v/vt/vn"
+			bool ParseCorner(char const*& io_token, char const* _end, int _positions, int _normals, int _texcoords, tinyobj::index_t& o_corner)
+			{
+				o_corner = { -1, -1, -1 };
+
+				if (!FixIndex(ParseInt(io_token, _end), _positions, o_corner.vertex_index))
+				{
+					return false;
+				}
+
+				io_token = FindSeparator(io_token, _end);
+				if (io_token == _end || *io_token != '/')
+				{
+					return true;
+				}
+				++io_token;
+
+				if (io_token < _end && *io_token == '/')
+				{
+					++io_token;
+					if (!FixIndex(ParseInt(io_token, _end), _normals, o_corner.normal_index))
+					{
+						return false;
+					}
+					io_token = FindSeparator(io_token, _end);
+					return true;
+				}
+
+				if (!FixIndex(ParseInt(io_token, _end), _texcoords, o_corner.texcoord_index))
+				{
+					return false;
+				}
+
+				io_token = FindSeparator(io_token, _end);
+				if (io_token == _end || *io_token != '/')
+				{
+					return true;
+				}
+				++io_token;
+
+				if (!FixIndex(ParseInt(io_token, _end), _normals, o_corner.normal_index))
+				{
+					return false;
+				}
+				io_token = FindSeparator(io_token, _end);
+				return true;
+			}
+
+			//////////////////////////////////////////////////////////////////////////////////////
+			void CountChunk(ObjChunk& io_chunk)
+			{
+				ForEachLine(io_chunk.m_begin, io_chunk.m_end, [&](char const* _line, char const* _end)
+				{
+					++io_chunk.m_lineCount;
+
+					_line = SkipSpace(_line, _end);
+					if (_end - _line < 2 || _line[0] != 'v')
+					{
+						return;
+					}
+
+					if (IsSpace(_line[1]))
+					{
+						++io_chunk.m_positionCount;
+					}
+					else if (_end - _line >= 3 && IsSpace(_line[2]))
+					{
+						io_chunk.m_normalCount += _line[1] == 'n' ? 1u : 0u;
+						io_chunk.m_texcoordCount += _line[1] == 't' ? 1u : 0u;
+					}
+				});
+			}
+
+			//////////////////////////////////////////////////////////////////////////////////////
+			void ParseChunk(ObjChunk& io_chunk, tinyobj::attrib_t& io_attrib)
+			{
+				uint32 line = io_chunk.m_firstLine;
+				uint32 positions = io_chunk.m_firstPosition;
+				uint32 normals = io_chunk.m_firstNormal;
+				uint32 texcoords = io_chunk.m_firstTexcoord;
+
+				ForEachLine(io_chunk.m_begin, io_chunk.m_end, [&](char const* _token, char const* _end)
+				{
+					++line;
+					if (!io_chunk.m_error.empty())
+					{
+						return;
+					}
+
+					_token = SkipSpace(_token, _end);
+					if (_token == _end || _token[0] == '#')
+					{
+						return;
+					}
+
+					auto const matches = [&](char const* _keyword, size_t _length)
+					{
+						return static_cast<size_t>(_end - _token) > _length && memcmp(_token, _keyword, _length) == 0 && IsSpace(_token[_length]);
+					};
+
+					auto const addCommand = [&](ObjCommand::Type _type, uint32 _value, std::string _text)
+					{
+						io_chunk.m_commands.push_back({ _type, _value, std::move(_text), static_cast<uint32>(io_chunk.m_faces.size() - 1u), static_cast<uint32>(io_chunk.m_lines.size() - 1u), static_cast<uint32>(io_chunk.m_points.size() - 1u) });
+					};
+
+					// Lines and points take the same corners as faces, but don't count towards the out of bounds warnings
+					auto const parseCorners = [&](char const* _record, std::vector<tinyobj::index_t>& io_corners, std::vector<uint32>& io_records)
+					{
+						_token = SkipSpace(_token + 2, _end);
+						while (_token < _end)
+						{
+							tinyobj::index_t corner;
+							if (!ParseCorner(_token, _end, static_cast<int>(positions), static_cast<int>(normals), static_cast<int>(texcoords), corner))
+							{
+								io_chunk.m_error = std::string("Failed parse `") + _record + "' line(e.g. zero value for vertex index. line " + std::to_string(line) + ".)\n";
+								return;
+							}
+
+							io_corners.push_back(corner);
+							_token = SkipSpace(_token, _end);
+						}
+						io_records.push_back(static_cast<uint32>(io_corners.size()));
+					};
+
+					if (matches("v", 1u))
+					{
+						_token += 2;
+						float* const position = io_attrib.vertices.data() + 3u * (uint64)positions;
+						float* const colour = io_attrib.colors.data() + 3u * (uint64)positions;
+						position[0] = ParseReal(_token, _end);
+						position[1] = ParseReal(_token, _end);
+						position[2] = ParseReal(_token, _end);
+						if (!(ParseReal(_token, _end, colour[0]) && ParseReal(_token, _end, colour[1]) && ParseReal(_token, _end, colour[2])))
+						{
+							colour[0] = colour[1] = colour[2] = 1.0f;
+						}
+						++positions;
+					}
+					else if (matches("vn", 2u))
+					{
+						_token += 3;
+						float* const normal = io_attrib.normals.data() + 3u * (uint64)normals;
+						normal[0] = ParseReal(_token, _end);
+						normal[1] = ParseReal(_token, _end);
+						normal[2] = ParseReal(_token, _end);
+						++normals;
+					}
+					else if (matches("vt", 2u))
+					{
+						_token += 3;
+						float* const texcoord = io_attrib.texcoords.data() + 2u * (uint64)texcoords;
+						texcoord[0] = ParseReal(_token, _end);
+						texcoord[1] = ParseReal(_token, _end);
+						++texcoords;
+					}
+					else if (matches("f", 1u))
+					{
+						_token = SkipSpace(_token + 2, _end);
+						while (_token < _end)
+						{
+							tinyobj::index_t corner;
+							if (!ParseCorner(_token, _end, static_cast<int>(positions), static_cast<int>(normals), static_cast<int>(texcoords), corner))
+							{
+								io_chunk.m_error = "Failed parse `f' line(e.g. zero value for face index. line " + std::to_string(line) + ".)\n";
+								return;
+							}
+
+							io_chunk.m_greatestPosition = std::max(io_chunk.m_greatestPosition, corner.vertex_index);
+							io_chunk.m_greatestNormal = std::max(io_chunk.m_greatestNormal, corner.normal_index);
+							io_chunk.m_greatestTexcoord = std::max(io_chunk.m_greatestTexcoord, corner.texcoord_index);
+							io_chunk.m_corners.push_back(corner);
+							_token = SkipSpace(_token, _end);
+						}
+						io_chunk.m_faces.push_back(static_cast<uint32>(io_chunk.m_corners.size()));
+					}
+					else if (matches("l", 1u))
+					{
+						parseCorners("l", io_chunk.m_lineCorners, io_chunk.m_lines);
+					}
+					else if (matches("p", 1u))
+					{
+						parseCorners("p", io_chunk.m_pointCorners, io_chunk.m_points);
+					}
+					else if (_end - _token >= 6 && memcmp(_token, "usemtl", 6u) == 0)
+					{
+						_token += 6;
+						addCommand(ObjCommand::Type::UseMaterial, 0u, ParseString(_token, _end));
+					}
+					else if (matches("mtllib", 6u))
+					{
+						addCommand(ObjCommand::Type::MaterialLibrary, 0u, std::string(_token + 7, _end));
+					}
+					else if (matches("g", 1u))
+					{
+						// Every name after the first is appended with a space, tinyobj has no multiple groups either
+						std::string name;
+						uint32 nameCount = 0u;
+						_token = SkipSpace(_token + 1, _end);
+						while (_token < _end)
+						{
+							std::string const part = ParseString(_token, _end);
+							name += (nameCount++ > 0u ? " " : "") + part;
+							_token = SkipSpace(_token, _end);
+						}
+						addCommand(ObjCommand::Type::Group, nameCount > 0u ? 0u : line, name);
+					}
+					else if (matches("o", 1u))
+					{
+						addCommand(ObjCommand::Type::Object, 0u, std::string(_token + 2, _end));
+					}
+					else if (matches("s", 1u))
+					{
+						_token = SkipSpace(_token + 2, _end);
+						if (_token == _end)
+						{
+							return;
+						}
+
+						int group = 0;
+						if (_end - _token < 3 || memcmp(_token, "off", 3u) != 0)
+						{
+							group = std::max(0, ParseInt(_token, _end));
+						}
+						addCommand(ObjCommand::Type::Smoothing, static_cast<uint32>(group), std::string());
+					}
+				});
+			}
+
+			//////////////////////////////////////////////////////////////////////////////////////
+			// tinyobj's ear clipping, kept step for step so polygons split into the same triangles in the same order
+			void Triangulate(tinyobj::index_t const* _polygon, size_t _count, std::vector<float> const& _positions, std::vector<tinyobj::index_t>& io_remaining, std::vector<tinyobj::index_t>& io_triangles)
+			{
+				if (_count < 3u)
+				{
+					return;
+				}
+
+				if (_count == 3u)
+				{
+					io_triangles.insert(io_triangles.end(), _polygon, _polygon + 3);
+					return;
+				}
+
+				auto const inside = [](float const* _x, float const* _y, float _testX, float _testY)
+				{
+					bool result = false;
+					for (int i = 0, j = 2; i < 3; j = i++)
+					{
+						if (((_y[i] > _testY) != (_y[j] > _testY)) && (_testX < (_x[j] - _x[i]) * (_testY - _y[i]) / (_y[j] - _y[i]) + _x[i]))
+						{
+							result = !result;
+						}
+					}
+					return result;
+				};
+
+				// Project onto the two axes the polygon's first corner spans the most
+				size_t axes[2] = { 1u, 2u };
+				for (size_t k = 0; k < _count; ++k)
+				{
+					size_t const vi0 = size_t(_polygon[(k + 0) % _count].vertex_index);
+					size_t const vi1 = size_t(_polygon[(k + 1) % _count].vertex_index);
+					size_t const vi2 = size_t(_polygon[(k + 2) % _count].vertex_index);
+					if (((3 * vi0 + 2) >= _positions.size()) || ((3 * vi1 + 2) >= _positions.size()) || ((3 * vi2 + 2) >= _positions.size()))
+					{
+						continue;
+					}
+
+					float const e0x = _positions[vi1 * 3 + 0] - _positions[vi0 * 3 + 0];
+					float const e0y = _positions[vi1 * 3 + 1] - _positions[vi0 * 3 + 1];
+					float const e0z = _positions[vi1 * 3 + 2] - _positions[vi0 * 3 + 2];
+					float const e1x = _positions[vi2 * 3 + 0] - _positions[vi1 * 3 + 0];
+					float const e1y = _positions[vi2 * 3 + 1] - _positions[vi1 * 3 + 1];
+					float const e1z = _positions[vi2 * 3 + 2] - _positions[vi1 * 3 + 2];
+					float const cx = std::fabs(e0y * e1z - e0z * e1y);
+					float const cy = std::fabs(e0z * e1x - e0x * e1z);
+					float const cz = std::fabs(e0x * e1y - e0y * e1x);
+					float const epsilon = std::numeric_limits<float>::epsilon();
+					if (cx > epsilon || cy > epsilon || cz > epsilon)
+					{
+						if (!(cx > cy && cx > cz))
+						{
+							axes[0] = 0;
+							if (cz > cx && cz > cy)
+							{
+								axes[1] = 1;
+							}
+						}
+						break;
+					}
+				}
+
+				// The sign of the area gives the winding that ears have to match
+				float area = 0;
+				for (size_t k = 0; k < _count; ++k)
+				{
+					size_t const vi0 = size_t(_polygon[(k + 0) % _count].vertex_index);
+					size_t const vi1 = size_t(_polygon[(k + 1) % _count].vertex_index);
+					if (((vi0 * 3 + axes[0]) >= _positions.size()) || ((vi0 * 3 + axes[1]) >= _positions.size()) || ((vi1 * 3 + axes[0]) >= _positions.size()) || ((vi1 * 3 + axes[1]) >= _positions.size()))
+					{
+						continue;
+					}
+
+					float const v0x = _positions[vi0 * 3 + axes[0]];
+					float const v0y = _positions[vi0 * 3 + axes[1]];
+					float const v1x = _positions[vi1 * 3 + axes[0]];
+					float const v1y = _positions[vi1 * 3 + axes[1]];
+					area += (v0x * v1y - v0y * v1x) * static_cast<float>(0.5);
+				}
+
+				io_remaining.assign(_polygon, _polygon + _count);
+				size_t guess = 0;
+				size_t remainingIterations = _count;
+				size_t previousRemaining = _count;
+				tinyobj::index_t ear[3];
+				float vx[3];
+				float vy[3];
+
+				while (io_remaining.size() > 3u && remainingIterations > 0u)
+				{
+					size_t const count = io_remaining.size();
+					if (guess >= count)
+					{
+						guess -= count;
+					}
+
+					// Give up once a whole loop around the polygon finds no ear
+					if (previousRemaining != count)
+					{
+						previousRemaining = count;
+						remainingIterations = count;
+					}
+					else
+					{
+						remainingIterations--;
+					}
+
+					for (size_t k = 0; k < 3u; k++)
+					{
+						ear[k] = io_remaining[(guess + k) % count];
+						size_t const vi = size_t(ear[k].vertex_index);
+						if (((vi * 3 + axes[0]) >= _positions.size()) || ((vi * 3 + axes[1]) >= _positions.size()))
+						{
+							vx[k] = 0.0f;
+							vy[k] = 0.0f;
+						}
+						else
+						{
+							vx[k] = _positions[vi * 3 + axes[0]];
+							vy[k] = _positions[vi * 3 + axes[1]];
+						}
+					}
+
+					float const e0x = vx[1] - vx[0];
+					float const e0y = vy[1] - vy[0];
+					float const e1x = vx[2] - vx[1];
+					float const e1y = vy[2] - vy[1];
+					float const cross = e0x * e1y - e0y * e1x;
+					if (cross * area < 0.0f)
+					{
+						guess += 1;
+						continue;
+					}
+
+					bool overlap = false;
+					for (size_t other = 3; other < count; ++other)
+					{
+						size_t const ovi = size_t(io_remaining[(guess + other) % count].vertex_index);
+						if (((ovi * 3 + axes[0]) >= _positions.size()) || ((ovi * 3 + axes[1]) >= _positions.size()))
+						{
+							continue;
+						}
+
+						if (inside(vx, vy, _positions[ovi * 3 + axes[0]], _positions[ovi * 3 + axes[1]]))
+						{
+							overlap = true;
+							break;
+						}
+					}
+
+					if (overlap)
+					{
+						guess += 1;
+						continue;
+					}
+
+					io_triangles.insert(io_triangles.end(), ear, ear + 3);
+					io_remaining.erase(io_remaining.begin() + (guess + 1) % count);
+				}
+
+				if (io_remaining.size() == 3u)
+				{
+					io_triangles.insert(io_triangles.end(), io_remaining.begin(), io_remaining.end());
+				}
+			}
+
+			//////////////////////////////////////////////////////////////////////////////////////
+			void TriangulateChunk(ObjChunk& io_chunk, std::vector<float> const& _positions)
+			{
+				size_t const faceCount = io_chunk.m_faces.size() - 1u;
+				io_chunk.m_triangles.reserve(io_chunk.m_corners.size() + io_chunk.m_corners.size() / 2u); // Quads become six corners
+				io_chunk.m_faceTriangles.reserve(faceCount + 1u);
+				io_chunk.m_faceTriangles.push_back(0u);
+
+				std::vector<tinyobj::index_t> remaining;
+				for (size_t face = 0; face < faceCount; ++face)
+				{
+					uint32 const first = io_chunk.m_faces[face];
+					Triangulate(io_chunk.m_corners.data() + first, io_chunk.m_faces[face + 1u] - first, _positions, remaining, io_chunk.m_triangles);
+					io_chunk.m_faceTriangles.push_back(static_cast<uint32>(io_chunk.m_triangles.size()));
+				}
+
+				// Nothing reads the polygons again
+				io_chunk.m_corners = std::vector<tinyobj::index_t>();
+			}
+
+			//////////////////////////////////////////////////////////////////////////////////////
+			// tinyobj's exportGroupsToShape, false when there was nothing to flush
+			bool ExportSpans(std::vector<ObjSpan> const& _faces, std::vector<ObjSpan> const& _lines, std::vector<ObjSpan> const& _points, int _material, std::string const& _name, tinyobj::shape_t& io_shape)
+			{
+				if (_faces.empty() && _lines.empty() && _points.empty())
+				{
+					return false;
+				}
+
+				io_shape.name = _name;
+				tinyobj::mesh_t& mesh = io_shape.mesh;
+				for (ObjSpan const& span : _faces)
+				{
+					auto const begin = span.m_chunk->m_triangles.begin() + span.m_chunk->m_faceTriangles[span.m_begin];
+					auto const end = span.m_chunk->m_triangles.begin() + span.m_chunk->m_faceTriangles[span.m_end];
+					size_t const triangleCount = (end - begin) / 3u;
+
+					mesh.indices.insert(mesh.indices.end(), begin, end);
+					mesh.num_face_vertices.insert(mesh.num_face_vertices.end(), triangleCount, static_cast<unsigned char>(3u));
+					mesh.material_ids.insert(mesh.material_ids.end(), triangleCount, _material);
+					mesh.smoothing_group_ids.insert(mesh.smoothing_group_ids.end(), triangleCount, span.m_smoothing);
+				}
+
+				for (ObjSpan const& span : _lines)
+				{
+					std::vector<uint32> const& lines = span.m_chunk->m_lines;
+					auto const corners = span.m_chunk->m_lineCorners.begin();
+					io_shape.lines.indices.insert(io_shape.lines.indices.end(), corners + lines[span.m_begin], corners + lines[span.m_end]);
+					for (uint32 i = span.m_begin; i < span.m_end; ++i)
+					{
+						io_shape.lines.num_line_vertices.push_back(static_cast<int>(lines[i + 1u] - lines[i]));
+					}
+				}
+
+				for (ObjSpan const& span : _points)
+				{
+					std::vector<uint32> const& points = span.m_chunk->m_points;
+					auto const corners = span.m_chunk->m_pointCorners.begin();
+					io_shape.points.indices.insert(io_shape.points.indices.end(), corners + points[span.m_begin], corners + points[span.m_end]);
+				}
+				return true;
+			}
+
+			std::vector<std::string> SplitFilenames(std::string const& _text)
+			{
+				// Spaces separate names unless escaped with a backslash
+				std::vector<std::string> filenames;
+				std::string filename;
+				bool escaping = false;
+				for (char const c : _text)
+				{
+					if (escaping)
+					{
+						escaping = false;
+					}
+					else if (c == '\\')
+					{
+						escaping = true;
+						continue;
+					}
+					else if (c == ' ')
+					{
+						if (!filename.empty())
+						{
+							filenames.push_back(filename);
+						}
+						filename.clear();
+						continue;
+					}
+					filename += c;
+				}
+				filenames.push_back(filename);
+				return filenames;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		bool ObjParser::Parse(std::string const& _file, tinyobj::attrib_t& o_attrib, std::vector<tinyobj::shape_t>& o_shapes, std::vector<tinyobj::material_t>& o_materials, std::string& o_warning, std::string& o_error)
+		{
+			o_attrib = tinyobj::attrib_t();
+			o_shapes.clear();
+			o_materials.clear();
+
+			IO::MappedFile file;
+			if (!file.Open(_file))
+			{
+				o_error = "Cannot open file [" + _file + "]\n";
+				return false;
+			}
+
+			// Chunks are cut after a line break of any kind, so no line is split between two of them
+			char const* const data = reinterpret_cast<char const*>(file.GetData());
+			char const* const dataEnd = data + file.GetSize();
+			size_t const chunkCount = std::max<size_t>(1u, std::min<size_t>(Core::GetWorkerCount(), file.GetSize() / c_minChunkSize));
+
+			std::vector<ObjChunk> chunks(chunkCount);
+			char const* chunkBegin = data;
+			for (size_t i = 0; i < chunkCount; ++i)
+			{
+				char const* chunkEnd = dataEnd;
+				if (i + 1u < chunkCount)
+				{
+					char const* const target = std::max(chunkBegin, data + file.GetSize() / chunkCount * (i + 1u));
+					chunkEnd = target;
+					while (chunkEnd < dataEnd && *chunkEnd != '\n' && *chunkEnd != '\r')
+					{
+						++chunkEnd;
+					}
+
+					// A "\r\n" pair stays together, splitting it would add an empty line to the next chunk
+					if (chunkEnd < dataEnd)
+					{
+						chunkEnd += *chunkEnd == '\r' && chunkEnd + 1 < dataEnd && chunkEnd[1] == '\n' ? 2 : 1;
+					}
+				}
+
+				chunks[i].m_begin = chunkBegin;
+				chunks[i].m_end = chunkEnd;
+				chunkBegin = chunkEnd;
+			}
+
+			Core::ParallelFor(static_cast<uint32>(chunkCount), 1u, [&](uint32 _begin, uint32 _end, uint32)
+			{
+				for (uint32 i = _begin; i < _end; ++i)
+				{
+					CountChunk(chunks[i]);
+				}
+			});
+
+			// Counts give every chunk the offset of its first attribute, which also resolves relative indices
+			uint32 lineCount = 0u;
+			uint32 positionCount = 0u;
+			uint32 normalCount = 0u;
+			uint32 texcoordCount = 0u;
+			for (ObjChunk& chunk : chunks)
+			{
+				chunk.m_firstLine = lineCount;
+				chunk.m_firstPosition = positionCount;
+				chunk.m_firstNormal = normalCount;
+				chunk.m_firstTexcoord = texcoordCount;
+				lineCount += chunk.m_lineCount;
+				positionCount += chunk.m_positionCount;
+				normalCount += chunk.m_normalCount;
+				texcoordCount += chunk.m_texcoordCount;
+			}
+
+			o_attrib.vertices.resize(3u * (uint64)positionCount);
+			o_attrib.colors.resize(3u * (uint64)positionCount);
+			o_attrib.normals.resize(3u * (uint64)normalCount);
+			o_attrib.texcoords.resize(2u * (uint64)texcoordCount);
+
+			Core::ParallelFor(static_cast<uint32>(chunkCount), 1u, [&](uint32 _begin, uint32 _end, uint32)
+			{
+				for (uint32 i = _begin; i < _end; ++i)
+				{
+					ParseChunk(chunks[i], o_attrib);
+				}
+			});
+
+			for (ObjChunk const& chunk : chunks)
+			{
+				if (!chunk.m_error.empty())
+				{
+					o_attrib = tinyobj::attrib_t();
+					o_error = chunk.m_error;
+					return false;
+				}
+			}
+
+			// Ears are clipped against every position, which are only all known now
+			Core::ParallelFor(static_cast<uint32>(chunkCount), 1u, [&](uint32 _begin, uint32 _end, uint32)
+			{
+				for (uint32 i = _begin; i < _end; ++i)
+				{
+					TriangulateChunk(chunks[i], o_attrib.vertices);
+				}
+			});
+
+			// Replay the commands in file order to cut the faces into shapes, exactly where tinyobj would
+			std::string baseDirectory;
+			size_t const separator = _file.find_last_of("/\\");
+			if (separator != std::string::npos)
+			{
+				baseDirectory = _file.substr(0, separator);
+#ifdef _WIN32
+				char const directorySeparator = '\\';
+#else
+				char const directorySeparator = '/';
+#endif
+				if (!baseDirectory.empty() && baseDirectory.back() != directorySeparator)
+				{
+					baseDirectory += directorySeparator;
+				}
+			}
+			tinyobj::MaterialFileReader materialReader(baseDirectory);
+			std::map<std::string, int> materialMap;
+
+			// Like tinyobj, a material change only flushes the faces, lines and points stay until the next group or object
+			tinyobj::shape_t shape;
+			std::vector<ObjSpan> faces;
+			std::vector<ObjSpan> lines;
+			std::vector<ObjSpan> points;
+			std::string name;
+			int material = -1;
+			uint32 smoothing = 0u;
+
+			for (ObjChunk const& chunk : chunks)
+			{
+				uint32 face = 0u;
+				uint32 line = 0u;
+				uint32 point = 0u;
+				auto const flush = [&](uint32 _face, uint32 _line, uint32 _point)
+				{
+					if (face < _face)
+					{
+						faces.push_back({ &chunk, face, _face, smoothing });
+						face = _face;
+					}
+					if (line < _line)
+					{
+						lines.push_back({ &chunk, line, _line, 0u });
+						line = _line;
+					}
+					if (point < _point)
+					{
+						points.push_back({ &chunk, point, _point, 0u });
+						point = _point;
+					}
+				};
+
+				for (ObjCommand const& command : chunk.m_commands)
+				{
+					flush(command.m_face, command.m_line, command.m_point);
+
+					switch (command.m_type)
+					{
+					case ObjCommand::Type::UseMaterial:
+					{
+						int newMaterial = -1;
+						auto const found = materialMap.find(command.m_text);
+						if (found != materialMap.end())
+						{
+							newMaterial = found->second;
+						}
+						else
+						{
+							o_warning += "material [ '" + command.m_text + "' ] not found in .mtl\n";
+						}
+
+						if (newMaterial != material)
+						{
+							ExportSpans(faces, lines, points, material, name, shape);
+							faces.clear();
+							material = newMaterial;
+						}
+						break;
+					}
+					case ObjCommand::Type::MaterialLibrary:
+					{
+						bool loaded = false;
+						for (std::string const& filename : SplitFilenames(command.m_text))
+						{
+							std::string warning;
+							std::string error;
+							loaded = materialReader(filename, &o_materials, &materialMap, &warning, &error);
+							o_warning += warning;
+							o_error += error;
+							if (loaded)
+							{
+								break;
+							}
+						}
+
+						if (!loaded)
+						{
+							o_warning += "Failed to load material file(s). Use default material.\n";
+						}
+						break;
+					}
+					case ObjCommand::Type::Group:
+					case ObjCommand::Type::Object:
+					{
+						// Groups keep only shapes with faces, objects also those with just lines or points
+						ExportSpans(faces, lines, points, material, name, shape);
+						bool const primitives = command.m_type == ObjCommand::Type::Object && (!shape.lines.indices.empty() || !shape.points.indices.empty());
+						if (!shape.mesh.indices.empty() || primitives)
+						{
+							o_shapes.push_back(std::move(shape));
+						}
+						shape = tinyobj::shape_t();
+						faces.clear();
+						lines.clear();
+						points.clear();
+
+						name = command.m_text;
+						if (command.m_type == ObjCommand::Type::Group && command.m_value > 0u)
+						{
+							o_warning += "Empty group name. line: " + std::to_string(command.m_value) + "\n";
+						}
+						break;
+					}
+					case ObjCommand::Type::Smoothing:
+						smoothing = command.m_value;
+						break;
+					}
+				}
+
+				flush(static_cast<uint32>(chunk.m_faces.size() - 1u), static_cast<uint32>(chunk.m_lines.size() - 1u), static_cast<uint32>(chunk.m_points.size() - 1u));
+			}
+
+			int greatestPosition = -1;
+			int greatestNormal = -1;
+			int greatestTexcoord = -1;
+			for (ObjChunk const& chunk : chunks)
+			{
+				greatestPosition = std::max(greatestPosition, chunk.m_greatestPosition);
+				greatestNormal = std::max(greatestNormal, chunk.m_greatestNormal);
+				greatestTexcoord = std::max(greatestTexcoord, chunk.m_greatestTexcoord);
+			}
+
+			std::string const lineText = std::to_string(lineCount);
+			if (greatestPosition >= static_cast<int>(positionCount))
+			{
+				o_warning += "Vertex indices out of bounds (line " + lineText + ".)\n\n";
+			}
+			if (greatestNormal >= static_cast<int>(normalCount))
+			{
+				o_warning += "Vertex normal indices out of bounds (line " + lineText + ".)\n\n";
+			}
+			if (greatestTexcoord >= static_cast<int>(texcoordCount))
+			{
+				o_warning += "Vertex texcoord indices out of bounds (line " + lineText + ".)\n\n";
+			}
+
+			if (ExportSpans(faces, lines, points, material, name, shape) || !shape.mesh.indices.empty())
+			{
+				o_shapes.push_back(std::move(shape));
+			}
+
+			return true;
+		}
+	}
+}
\ No newline at end of file
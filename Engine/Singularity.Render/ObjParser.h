@@ -0,0 +1,26 @@
+#pragma once
+
+// Externals
+#include <string>
+#include <tinyobj/tiny_obj_loader.h>
+#include <vector>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		// Parallel replacement for tinyobj's .obj parsing that fills the same structures with the same values, so nothing
+		// downstream can tell which one ran. The file is mapped and cut into chunks at line breaks, every chunk is counted,
+		// parsed and triangulated on its own worker, and the chunks are stitched back together in file order. Polygons
+		// are always triangulated, .mtl files are still read by tinyobj, and tags are skipped.
+		class ObjParser
+		{
+		public:
+			static bool Parse(std::string const& _file, tinyobj::attrib_t& o_attrib, std::vector<tinyobj::shape_t>& o_shapes, std::vector<tinyobj::material_t>& o_materials, std::string& o_warning, std::string& o_error);
+
+			static uint32 constexpr c_minChunkSize = 1u << 20u; // Bytes, smaller files are parsed on the calling thread
+		};
+	}
+}
\ No newline at end of file
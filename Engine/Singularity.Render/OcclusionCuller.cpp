@@ -0,0 +1,304 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <immintrin.h>
+#include <iostream>
+
+#include <Singularity.Core/Parallel.h>
+#include <Singularity.Render/FrustumCuller.h>
+#include <Singularity.Render/Mesh.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		namespace
+		{
+			// Projects a clip space position into depth buffer pixels and normalised device depth
+			glm::vec3 ToScreen(glm::vec4 const& _clip)
+			{
+				glm::vec3 const ndc = glm::vec3(_clip) / _clip.w;
+				return glm::vec3((ndc.x * 0.5f + 0.5f) * OcclusionCuller::c_width, (ndc.y * 0.5f + 0.5f) * OcclusionCuller::c_height, ndc.z);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void OcclusionCuller::Begin(glm::mat4 const& _viewProjection)
+		{
+			m_viewProjection = _viewProjection;
+
+			m_depth.assign(c_width * c_height, 1.0f);
+			m_triangles.clear();
+			m_tileBins.resize(c_tilesX * c_tilesY);
+			for (std::vector<uint32>& bin : m_tileBins)
+			{
+				bin.clear();
+			}
+
+			m_stats = OcclusionStats();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void OcclusionCuller::AddOccluder(Mesh const& _mesh, glm::mat4 const& _model)
+		{
+			std::vector<Vertex> const& vertices = _mesh.GetVertices();
+			if (vertices.size() != _mesh.GetVertexCount())
+			{
+				std::cout << "Error: Occluder meshes need their vertices on the CPU, meshes buffered from encoded data have none!" << std::endl;
+				return;
+			}
+
+			glm::mat4 const modelViewProjection = m_viewProjection * _model;
+			m_clipVertices.resize(vertices.size());
+			for (size_t i = 0; i < vertices.size(); ++i)
+			{
+				m_clipVertices[i] = modelViewProjection * glm::vec4(vertices[i].m_position, 1.0f);
+			}
+
+			// Only the full detail ranges of every submesh, coarser levels follow them in the same index list
+			if (_mesh.UseIndices())
+			{
+				std::vector<uint32> const& indices = _mesh.GetIndices();
+				uint32 const indexCount = _mesh.GetFullDetailIndexCount();
+				for (size_t i = 0; i + 2u < indexCount; i += 3u)
+				{
+					SetupTriangle(m_clipVertices[indices[i]], m_clipVertices[indices[i + 1u]], m_clipVertices[indices[i + 2u]]);
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i + 2u < m_clipVertices.size(); i += 3u)
+				{
+					SetupTriangle(m_clipVertices[i], m_clipVertices[i + 1u], m_clipVertices[i + 2u]);
+				}
+			}
+
+			++m_stats.m_occluders;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void OcclusionCuller::Rasterize()
+		{
+			// Tiles never share pixels, so each worker writes its own part of the buffer
+			Core::ParallelFor(c_tilesX * c_tilesY, 1u, [&](uint32 _begin, uint32 _end, uint32)
+			{
+				for (uint32 tile = _begin; tile < _end; ++tile)
+				{
+					RasterizeTile(tile);
+				}
+			});
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void OcclusionCuller::Cull(CullBounds const& _bounds, std::vector<uint32> const& _candidates)
+		{
+			uint32 const count = static_cast<uint32>(_candidates.size());
+
+			m_workerVisible.resize(Core::GetWorkerCount());
+			for (std::vector<uint32>& visible : m_workerVisible)
+			{
+				visible.clear();
+			}
+
+			Core::ParallelFor(count, c_minPerWorker, [&](uint32 _begin, uint32 _end, uint32 _worker)
+			{
+				for (uint32 i = _begin; i < _end; ++i)
+				{
+					uint32 const object = _candidates[i];
+					glm::vec3 const minimum(_bounds.m_minimumX[object], _bounds.m_minimumY[object], _bounds.m_minimumZ[object]);
+					glm::vec3 const maximum(_bounds.m_maximumX[object], _bounds.m_maximumY[object], _bounds.m_maximumZ[object]);
+					if (IsVisible(minimum, maximum))
+					{
+						m_workerVisible[_worker].push_back(object);
+					}
+				}
+			});
+
+			// Workers own consecutive ranges, so joining in worker order keeps the candidates' order
+			m_visible.clear();
+			for (std::vector<uint32> const& visible : m_workerVisible)
+			{
+				m_visible.insert(m_visible.end(), visible.begin(), visible.end());
+			}
+
+			m_stats.m_tested = count;
+			m_stats.m_occluded = count - static_cast<uint32>(m_visible.size());
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		bool OcclusionCuller::IsVisible(glm::vec3 const& _minimum, glm::vec3 const& _maximum) const
+		{
+			glm::vec2 screenMinimum(FLT_MAX);
+			glm::vec2 screenMaximum(-FLT_MAX);
+			float nearestDepth = FLT_MAX;
+			for (uint32 corner = 0; corner < 8u; ++corner)
+			{
+				glm::vec3 const position((corner & 1u) ? _maximum.x : _minimum.x, (corner & 2u) ? _maximum.y : _minimum.y, (corner & 4u) ? _maximum.z : _minimum.z);
+				glm::vec4 const clip = m_viewProjection * glm::vec4(position, 1.0f);
+				if (clip.w < c_minimumW)
+				{
+					// Reaches around the camera, the projected rectangle would be meaningless
+					return true;
+				}
+
+				glm::vec3 const screen = ToScreen(clip);
+				screenMinimum = glm::min(screenMinimum, glm::vec2(screen));
+				screenMaximum = glm::max(screenMaximum, glm::vec2(screen));
+				nearestDepth = std::min(nearestDepth, screen.z);
+			}
+
+			// Every pixel the box touches, even partially
+			int const x0 = std::max(0, static_cast<int>(std::floor(screenMinimum.x)));
+			int const y0 = std::max(0, static_cast<int>(std::floor(screenMinimum.y)));
+			int const x1 = std::min(static_cast<int>(c_width), static_cast<int>(std::ceil(screenMaximum.x)));
+			int const y1 = std::min(static_cast<int>(c_height), static_cast<int>(std::ceil(screenMaximum.y)));
+			if (x0 >= x1 || y0 >= y1)
+			{
+				return true;
+			}
+
+			__m128 const nearest = _mm_set1_ps(nearestDepth);
+			for (int y = y0; y < y1; ++y)
+			{
+				float const* row = &m_depth[y * c_width];
+
+				int x = x0;
+				for (; x + 4 <= x1; x += 4)
+				{
+					if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), nearest)) != 0)
+					{
+						return true;
+					}
+				}
+
+				for (; x < x1; ++x)
+				{
+					if (row[x] >= nearestDepth)
+					{
+						return true;
+					}
+				}
+			}
+
+			return false;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void OcclusionCuller::SetupTriangle(glm::vec4 const& _a, glm::vec4 const& _b, glm::vec4 const& _c)
+		{
+			if (_a.w < c_minimumW || _b.w < c_minimumW || _c.w < c_minimumW)
+			{
+				return;
+			}
+
+			glm::vec3 a = ToScreen(_a);
+			glm::vec3 b = ToScreen(_b);
+			glm::vec3 c = ToScreen(_c);
+
+			float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+			if (std::abs(area) < 1e-6f)
+			{
+				return;
+			}
+
+			// Both windings are drawn, the nearest surface wins either way
+			if (area < 0.0f)
+			{
+				std::swap(b, c);
+				area = -area;
+			}
+
+			Triangle triangle;
+			triangle.m_minimum = glm::max(glm::vec2(0.0f), glm::min(glm::vec2(a), glm::min(glm::vec2(b), glm::vec2(c))));
+			triangle.m_maximum = glm::min(glm::vec2(c_width, c_height), glm::max(glm::vec2(a), glm::max(glm::vec2(b), glm::vec2(c))));
+			if (triangle.m_minimum.x >= triangle.m_maximum.x || triangle.m_minimum.y >= triangle.m_maximum.y)
+			{
+				return;
+			}
+
+			glm::vec3 const* vertices[3] = { &a, &b, &c };
+			for (uint32 i = 0; i < 3u; ++i)
+			{
+				glm::vec3 const& from = *vertices[i];
+				glm::vec3 const& to = *vertices[(i + 1u) % 3u];
+				triangle.m_edges[i] = glm::vec3(from.y - to.y, to.x - from.x, from.x * to.y - from.y * to.x);
+			}
+
+			float const depthX = ((b.z - a.z) * (c.y - a.y) - (c.z - a.z) * (b.y - a.y)) / area;
+			float const depthY = ((c.z - a.z) * (b.x - a.x) - (b.z - a.z) * (c.x - a.x)) / area;
+			triangle.m_depthPlane = glm::vec3(depthX, depthY, a.z - depthX * a.x - depthY * a.y);
+
+			uint32 const index = static_cast<uint32>(m_triangles.size());
+			m_triangles.push_back(triangle);
+			++m_stats.m_triangles;
+
+			uint32 const tileX0 = static_cast<uint32>(triangle.m_minimum.x) / c_tileWidth;
+			uint32 const tileY0 = static_cast<uint32>(triangle.m_minimum.y) / c_tileHeight;
+			uint32 const tileX1 = std::min(c_tilesX - 1u, static_cast<uint32>(triangle.m_maximum.x) / c_tileWidth);
+			uint32 const tileY1 = std::min(c_tilesY - 1u, static_cast<uint32>(triangle.m_maximum.y) / c_tileHeight);
+			for (uint32 tileY = tileY0; tileY <= tileY1; ++tileY)
+			{
+				for (uint32 tileX = tileX0; tileX <= tileX1; ++tileX)
+				{
+					m_tileBins[tileY * c_tilesX + tileX].push_back(index);
+				}
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void OcclusionCuller::RasterizeTile(uint32 _tile)
+		{
+			uint32 const tileLeft = (_tile % c_tilesX) * c_tileWidth;
+			uint32 const tileTop = (_tile / c_tilesX) * c_tileHeight;
+
+			__m128 const laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+			for (uint32 index : m_tileBins[_tile])
+			{
+				Triangle const& triangle = m_triangles[index];
+
+				// Tile widths are a multiple of four, so starting on a multiple of four never runs past the tile
+				uint32 const left = std::max(tileLeft, static_cast<uint32>(triangle.m_minimum.x) & ~3u);
+				uint32 const right = std::min(tileLeft + c_tileWidth, static_cast<uint32>(std::ceil(triangle.m_maximum.x)));
+				uint32 const top = std::max(tileTop, static_cast<uint32>(triangle.m_minimum.y));
+				uint32 const bottom = std::min(tileTop + c_tileHeight, static_cast<uint32>(std::ceil(triangle.m_maximum.y)));
+
+				__m128 const edgeX0 = _mm_set1_ps(triangle.m_edges[0].x);
+				__m128 const edgeX1 = _mm_set1_ps(triangle.m_edges[1].x);
+				__m128 const edgeX2 = _mm_set1_ps(triangle.m_edges[2].x);
+				__m128 const depthX = _mm_set1_ps(triangle.m_depthPlane.x);
+
+				for (uint32 y = top; y < bottom; ++y)
+				{
+					// Everything that only depends on the row is folded into one constant per function
+					float const centreY = y + 0.5f;
+					__m128 const row0 = _mm_set1_ps(triangle.m_edges[0].y * centreY + triangle.m_edges[0].z);
+					__m128 const row1 = _mm_set1_ps(triangle.m_edges[1].y * centreY + triangle.m_edges[1].z);
+					__m128 const row2 = _mm_set1_ps(triangle.m_edges[2].y * centreY + triangle.m_edges[2].z);
+					__m128 const rowDepth = _mm_set1_ps(triangle.m_depthPlane.y * centreY + triangle.m_depthPlane.z);
+
+					float* const depthRow = &m_depth[y * c_width];
+					for (uint32 x = left; x < right; x += 4u)
+					{
+						__m128 const centreX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+
+						__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeX0, centreX), row0), _mm_setzero_ps());
+						inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeX1, centreX), row1), _mm_setzero_ps()));
+						inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeX2, centreX), row2), _mm_setzero_ps()));
+						if (_mm_movemask_ps(inside) == 0)
+						{
+							continue;
+						}
+
+						__m128 const depth = _mm_add_ps(_mm_mul_ps(depthX, centreX), rowDepth);
+						__m128 const previous = _mm_loadu_ps(depthRow + x);
+						__m128 const nearest = _mm_min_ps(previous, depth);
+						_mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+					}
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		struct CullBounds;
+		class Mesh;
+
+		struct OcclusionStats
+		{
+			uint32 m_occluders = 0u;
+			uint32 m_triangles = 0u;
+			uint32 m_tested = 0u;
+			uint32 m_occluded = 0u;
+		};
+
+		// Software occlusion culling. Occluder triangles are rasterized on the CPU into a small depth buffer, split into
+		// tiles that are filled by separate workers four pixels at a time. Candidate boxes are then projected and only kept
+		// if some pixel under them is further away than their nearest point. Nothing here touches the GPU, so it costs no
+		// readback latency and runs the same without a device.
+		//
+		// Depth is the renderer's OpenGL style -1 (near) to 1 (far) NDC depth, cleared to the far plane. Triangles crossing
+		// the near plane are dropped rather than clipped, which can only let more through.
+		class OcclusionCuller
+		{
+		public:
+			void Begin(glm::mat4 const& _viewProjection);
+			void AddOccluder(Mesh const& _mesh, glm::mat4 const& _model);
+			void Rasterize();
+			void Cull(CullBounds const& _bounds, std::vector<uint32> const& _candidates);
+
+			bool IsVisible(glm::vec3 const& _minimum, glm::vec3 const& _maximum) const;
+
+			std::vector<uint32> const& GetVisible() const { return m_visible; }
+			std::vector<float> const& GetDepth() const { return m_depth; }
+			OcclusionStats const& GetStats() const { return m_stats; }
+
+			static uint32 constexpr c_width = 256u;
+			static uint32 constexpr c_height = 128u;
+
+		private:
+			struct Triangle
+			{
+				glm::vec2 m_minimum; // Screen space bounds
+				glm::vec2 m_maximum;
+				glm::vec3 m_edges[3]; // Edge functions a * x + b * y + c, positive inside
+				glm::vec3 m_depthPlane; // Depth as dzdx * x + dzdy * y + z0
+			};
+
+			void SetupTriangle(glm::vec4 const& _a, glm::vec4 const& _b, glm::vec4 const& _c);
+			void RasterizeTile(uint32 _tile);
+
+			static uint32 constexpr c_tileWidth = 64u;
+			static uint32 constexpr c_tileHeight = 32u;
+			static uint32 constexpr c_tilesX = c_width / c_tileWidth;
+			static uint32 constexpr c_tilesY = c_height / c_tileHeight;
+			static uint32 constexpr c_minPerWorker = 256u; // Candidates tested per worker
+			static float constexpr c_minimumW = 1e-3f; // Anything closer to the eye plane is treated as crossing it
+
+			glm::mat4 m_viewProjection = glm::mat4(1.0f);
+
+			std::vector<float> m_depth;
+			std::vector<Triangle> m_triangles;
+			std::vector<std::vector<uint32>> m_tileBins; // Triangles touching each tile
+			std::vector<glm::vec4> m_clipVertices;
+
+			std::vector<uint32> m_visible;
+			std::vector<std::vector<uint32>> m_workerVisible;
+			OcclusionStats m_stats;
+		};
+	}
+}
\ No newline at end of file
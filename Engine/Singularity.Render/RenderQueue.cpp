@@ -0,0 +1,245 @@
+#include "RenderQueue.h"
+
+#include <iostream>
+
+#include <Singularity.Core/RadixSort.h>
+#include <Singularity.Render/Material.h>
+#include <Singularity.Render/Mesh.h>
+#include <Singularity.Render/Scene.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		namespace
+		{
+			uint32 constexpr c_pipelineBits = 8u;
+			uint32 constexpr c_materialBits = 14u;
+			uint32 constexpr c_meshBits = 14u;
+			uint32 constexpr c_depthBits = 26u;
+
+			uint64 constexpr Mask(uint32 _bits) { return (1ull << _bits) - 1ull; }
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void RenderQueue::Begin(glm::mat4 const& _view, float _farPlane)
+		{
+			m_view = _view;
+			m_farPlane = _farPlane;
+
+			m_packets.clear();
+			m_keys.clear();
+			m_order.clear();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void RenderQueue::Submit(DrawPacket const& _packet, float _viewDepth)
+		{
+			Pass const pass = _packet.m_material->IsBlended() ? Pass::Blended : Pass::Opaque;
+			uint32 const pipelineId = GetId(m_pipelineIds, _packet.m_pipeline, c_pipelineBits);
+			uint32 const materialId = GetId(m_materialIds, _packet.m_material, c_materialBits);
+			uint32 const meshId = GetId(m_meshIds, _packet.m_mesh, c_meshBits);
+
+			m_keys.push_back(MakeKey(pass, pipelineId, materialId, meshId, _viewDepth / m_farPlane));
+			m_order.push_back(static_cast<uint32>(m_packets.size()));
+			m_packets.push_back(_packet);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void RenderQueue::Sort()
+		{
+			m_unsortedStats = CountBinds(m_packets, m_order);
+
+			Core::RadixSort(m_keys, m_order, m_keyScratch, m_orderScratch);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void RenderQueue::Execute(VkCommandBuffer _commandBuffer, uint32 _imageIndex)
+		{
+			m_stats = RenderQueueStats();
+
+			VkPipeline boundPipeline = VK_NULL_HANDLE;
+			Material const* boundMaterial = nullptr;
+			Mesh const* boundMesh = nullptr;
+			bool boundIndices = false;
+
+			for (uint32 index : m_order)
+			{
+				DrawPacket const& packet = m_packets[index];
+
+				if (packet.m_pipeline != boundPipeline)
+				{
+					boundPipeline = packet.m_pipeline;
+					vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, boundPipeline);
+					++m_stats.m_pipelineBinds;
+				}
+
+				if (packet.m_material != boundMaterial)
+				{
+					boundMaterial = packet.m_material;
+					boundMaterial->Bind(_commandBuffer);
+					++m_stats.m_materialBinds;
+				}
+
+				if (packet.m_mesh != boundMesh)
+				{
+					boundMesh = packet.m_mesh;
+
+					boundMesh->BindVertexBuffers(_commandBuffer);
+					++m_stats.m_vertexBufferBinds;
+
+					boundIndices = boundMesh->UseIndices();
+					if (boundIndices)
+					{
+						vkCmdBindIndexBuffer(_commandBuffer, boundMesh->GetIndexBuffer()->GetBuffer(), 0, boundMesh->GetIndexType());
+						++m_stats.m_indexBufferBinds;
+					}
+				}
+
+				if (packet.m_scene)
+				{
+					packet.m_scene->BindObjectData(_commandBuffer, _imageIndex, packet.m_proxy);
+				}
+
+				MeshLod const& lod = boundMesh->GetLod(packet.m_lod, packet.m_submesh);
+				if (boundIndices)
+				{
+					vkCmdDrawIndexed(_commandBuffer, lod.m_count, packet.m_instanceCount, lod.m_first, 0, packet.m_firstInstance);
+				}
+				else
+				{
+					vkCmdDraw(_commandBuffer, lod.m_count, packet.m_instanceCount, lod.m_first, packet.m_firstInstance);
+				}
+				++m_stats.m_draws;
+				m_stats.m_triangles += lod.m_count / 3u * packet.m_instanceCount;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void RenderQueue::ExecuteDepth(VkCommandBuffer _commandBuffer, uint32 _imageIndex, VkPipeline _depthPipeline) const
+		{
+			vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _depthPipeline);
+
+			// Materials don't matter to depth, so only mesh changes break the run
+			Mesh const* boundMesh = nullptr;
+			for (uint32 index : m_order)
+			{
+				DrawPacket const& packet = m_packets[index];
+				if (packet.m_material->IsBlended())
+				{
+					break; // Blended packets sort after every opaque one
+				}
+
+				if (packet.m_mesh != boundMesh)
+				{
+					boundMesh = packet.m_mesh;
+					boundMesh->BindVertexBuffers(_commandBuffer, true);
+					if (boundMesh->UseIndices())
+					{
+						vkCmdBindIndexBuffer(_commandBuffer, boundMesh->GetIndexBuffer()->GetBuffer(), 0, boundMesh->GetIndexType());
+					}
+				}
+
+				if (packet.m_scene)
+				{
+					packet.m_scene->BindObjectData(_commandBuffer, _imageIndex, packet.m_proxy);
+				}
+
+				MeshLod const& lod = boundMesh->GetLod(packet.m_lod, packet.m_submesh);
+				if (boundMesh->UseIndices())
+				{
+					vkCmdDrawIndexed(_commandBuffer, lod.m_count, packet.m_instanceCount, lod.m_first, 0, packet.m_firstInstance);
+				}
+				else
+				{
+					vkCmdDraw(_commandBuffer, lod.m_count, packet.m_instanceCount, lod.m_first, packet.m_firstInstance);
+				}
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		float RenderQueue::GetViewDepth(glm::vec3 const& _worldPosition) const
+		{
+			// View space looks down -z
+			return -(m_view * glm::vec4(_worldPosition, 1.0f)).z;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		uint64 RenderQueue::MakeKey(Pass _pass, uint32 _pipelineId, uint32 _materialId, uint32 _meshId, float _normalisedDepth)
+		{
+			uint64 const depth = static_cast<uint64>(glm::clamp(_normalisedDepth, 0.0f, 1.0f) * static_cast<float>(Mask(c_depthBits)));
+			uint64 const state = (static_cast<uint64>(_pipelineId) << (c_materialBits + c_meshBits))
+				| (static_cast<uint64>(_materialId) << c_meshBits)
+				| static_cast<uint64>(_meshId);
+			uint32 const stateBits = c_pipelineBits + c_materialBits + c_meshBits;
+
+			uint64 key = static_cast<uint64>(_pass) << (stateBits + c_depthBits);
+			if (_pass == Pass::Blended)
+			{
+				// Furthest first, so the depth goes above the state and is inverted
+				key |= (Mask(c_depthBits) - depth) << stateBits;
+				key |= state;
+			}
+			else
+			{
+				key |= state << c_depthBits;
+				key |= depth;
+			}
+
+			return key;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		RenderQueueStats RenderQueue::CountBinds(std::vector<DrawPacket> const& _packets, std::vector<uint32> const& _order)
+		{
+			RenderQueueStats stats;
+
+			DrawPacket const* previous = nullptr;
+			for (uint32 index : _order)
+			{
+				DrawPacket const& packet = _packets[index];
+				stats.m_pipelineBinds += (!previous || previous->m_pipeline != packet.m_pipeline) ? 1u : 0u;
+				stats.m_materialBinds += (!previous || previous->m_material != packet.m_material) ? 1u : 0u;
+				if (!previous || previous->m_mesh != packet.m_mesh)
+				{
+					++stats.m_vertexBufferBinds;
+					stats.m_indexBufferBinds += packet.m_mesh->UseIndices() ? 1u : 0u;
+				}
+				++stats.m_draws;
+
+				previous = &packet;
+			}
+
+			return stats;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void RenderQueue::ResetIds()
+		{
+			m_pipelineIds.clear();
+			m_materialIds.clear();
+			m_meshIds.clear();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		uint32 RenderQueue::GetId(std::unordered_map<void const*, uint32>& io_ids, void const* _resource, uint32 _bits)
+		{
+			auto const it = io_ids.find(_resource);
+			if (it != io_ids.end())
+			{
+				return it->second;
+			}
+
+			uint32 id = static_cast<uint32>(io_ids.size());
+			if (id > Mask(_bits))
+			{
+				// Still draws correctly, it just shares a key slot and may cost an extra bind
+				std::cout << "Error: Render queue ran out of sort key IDs!" << std::endl;
+				id = static_cast<uint32>(Mask(_bits));
+			}
+
+			io_ids.emplace(_resource, id);
+			return id;
+		}
+	}
+}
\ No newline at end of file
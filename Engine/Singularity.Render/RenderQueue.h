@@ -0,0 +1,93 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		class Material;
+		class Mesh;
+		class Scene;
+
+		// A single draw, either one object or a run of instances, ordered by its sort key
+		struct DrawPacket
+		{
+			VkPipeline m_pipeline = VK_NULL_HANDLE;
+			Material const* m_material = nullptr;
+			Mesh const* m_mesh = nullptr;
+			Scene const* m_scene = nullptr; // Binds the proxy's data when set, instanced draws read theirs from the instance buffer
+			uint32 m_proxy = 0u;
+			uint32 m_submesh = 0u;
+			uint32 m_lod = 0u; // Which of the submesh's ranges is drawn, they share buffers so neither changes the key
+			uint32 m_firstInstance = 0u;
+			uint32 m_instanceCount = 1u;
+		};
+
+		struct RenderQueueStats
+		{
+			uint32 m_draws = 0u;
+			uint32 m_pipelineBinds = 0u;
+			uint32 m_materialBinds = 0u;
+			uint32 m_vertexBufferBinds = 0u;
+			uint32 m_indexBufferBinds = 0u;
+			uint32 m_triangles = 0u;
+		};
+
+		// Collects draw packets for a frame, sorts them by a 64-bit key and records them so that pipeline, descriptor
+		// and buffer binds only happen when the state actually changes.
+		//
+		// Opaque:  | pass:2 | pipeline:8 | material:14 | mesh:14 | depth:26 | - state first, then front to back
+		// Blended: | pass:2 | inverted depth:26 | pipeline:8 | material:14 | mesh:14 | - back to front, state only breaks ties
+		class RenderQueue
+		{
+		public:
+			enum class Pass : uint8
+			{
+				Opaque = 0,
+				Blended = 1
+			};
+
+			void Begin(glm::mat4 const& _view, float _farPlane);
+			void Submit(DrawPacket const& _packet, float _viewDepth);
+			void Sort();
+			void Execute(VkCommandBuffer _commandBuffer, uint32 _imageIndex);
+			void ExecuteDepth(VkCommandBuffer _commandBuffer, uint32 _imageIndex, VkPipeline _depthPipeline) const; // Opaque packets with positions alone, for a depth prepass ahead of Execute
+
+			float GetViewDepth(glm::vec3 const& _worldPosition) const;
+			void ResetIds(); // Once pipelines are recreated, their old addresses may come back as different resources
+
+			uint32 GetPacketCount() const { return static_cast<uint32>(m_packets.size()); }
+			RenderQueueStats const& GetStats() const { return m_stats; }
+			RenderQueueStats const& GetUnsortedStats() const { return m_unsortedStats; } // What the same packets would have cost in submission order
+
+			static uint64 MakeKey(Pass _pass, uint32 _pipelineId, uint32 _materialId, uint32 _meshId, float _normalisedDepth);
+
+		private:
+			static RenderQueueStats CountBinds(std::vector<DrawPacket> const& _packets, std::vector<uint32> const& _order);
+			uint32 GetId(std::unordered_map<void const*, uint32>& io_ids, void const* _resource, uint32 _bits);
+
+			glm::mat4 m_view = glm::mat4(1.0f);
+			float m_farPlane = 1.0f;
+
+			std::vector<DrawPacket> m_packets;
+			std::vector<uint64> m_keys;
+			std::vector<uint32> m_order;
+			std::vector<uint64> m_keyScratch;
+			std::vector<uint32> m_orderScratch;
+
+			// Small stable IDs so resources fit in the key, handed out the first time each is seen
+			std::unordered_map<void const*, uint32> m_pipelineIds;
+			std::unordered_map<void const*, uint32> m_materialIds;
+			std::unordered_map<void const*, uint32> m_meshIds;
+
+			RenderQueueStats m_stats;
+			RenderQueueStats m_unsortedStats;
+		};
+	}
+}
\ No newline at end of file
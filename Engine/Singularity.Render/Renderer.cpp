@@ -3,6 +3,7 @@
 // External Includes
 #define GLM_FORCE_RADIANS
 #include <chrono>
+#include <filesystem>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
@@ -14,7 +15,10 @@
 // Engine Includes
 #include <Singularity.IO/IO.h>
 #include <Singularity.Render/Mesh.h>
+#include <Singularity.Render/MeshFile.h>
 #include <Singularity.Render/MeshLoader.h>
+#include <Singularity.Render/MeshOptimizer.h>
+#include <Singularity.Render/ShaderReflection.h>
 #include <Singularity.Window/Window.h>
 
 namespace Singularity
@@ -23,18 +27,25 @@ namespace Singularity
 	{
 
 		//////////////////////////////////////////////////////////////////////////////////////
-		Renderer::Renderer(Window::Window& _window)
+		Renderer::Renderer(Window::Window& _window, RendererSettings const& _settings)
 			: 
+			m_frameDescriptorLayout(*this),
+			m_materialDescriptorLayout(*this),
+			m_objectDescriptorLayout(*this),
+			m_descriptorAllocator(*this),
+			m_descriptorSetCache(*this, m_descriptorAllocator),
+			m_bindlessTextures(*this),
+			m_scene(*this),
+			m_instanceBatcher(*this),
+			m_gpuCulling(*this),
+			m_depthImage(*this),
+			m_settings(_settings),
 			m_device(*this),
 			m_validation(*this),
 			m_swapChain(*this),
-			m_uniformBufferAllocator(*this),
 			m_window(_window),
-			m_depthImage(*this),
 			m_texture(*this),
-			m_testMesh(MeshLoader::LoadObj(std::string(DATA_DIRECTORY) + "Models/anky.obj")),
-			m_testMesh2(MeshLoader::LoadObj(std::string(DATA_DIRECTORY) + "Models/testSphere.obj")),
-			m_testObject(*this)
+			m_testMaterial(*this)
 		{
 			Initialize();
 		}
@@ -50,6 +61,7 @@ namespace Singularity
 		{
 			VkDevice const device = m_device.GetLogicalDevice();
 			vkWaitForFences(device, 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
+			m_bindlessTextures.BeginFrame(static_cast<uint32>(m_currentFrame));
 	
 			uint32 imageIndex;
 			VkResult result = vkAcquireNextImageKHR(device, m_swapChain.GetSwapChain(), UINT64_MAX, m_imageAvailableSemaphores[m_currentFrame], VK_NULL_HANDLE, &imageIndex);
@@ -69,8 +81,58 @@ namespace Singularity
 			else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
 				throw std::runtime_error("failed to acquire swap chain image!");
 			}
+
+			// The wait above retired this image's last frame, so every set it allocated can go back
+			m_transientDescriptorAllocators[imageIndex].Reset();
 			
-			m_testObject.UpdateUniformBuffer(imageIndex);
+			static auto startTime = std::chrono::high_resolution_clock::now();
+			auto currentTime = std::chrono::high_resolution_clock::now();
+			float const time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+
+			UpdateFrameUniformBuffer(imageIndex, time, _timeStep);
+			m_scene.GetHierarchy().SetLocal(m_testNode, glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+			// Only proxies touched since the last frame are uploaded
+			m_scene.Update(imageIndex);
+
+			if (m_useGpuCulling)
+			{
+				// Objects are already resident, only the ones that changed get copied
+				m_gpuCulling.Update(imageIndex);
+			}
+			else
+			{
+				// Only what survives the frustum is handed to draw submission
+				if (m_settings.m_useBvhCulling)
+				{
+					m_frustumCuller.Cull(m_frustum, m_scene.GetBounds(), m_scene.GetBvh());
+				}
+				else
+				{
+					m_frustumCuller.Cull(m_frustum, m_scene.GetBounds());
+				}
+
+				// Then whatever is hidden behind the large occluders that survived
+				if (m_settings.m_useOcclusionCulling)
+				{
+					m_occlusionCuller.Begin(m_viewProjection);
+					m_scene.SubmitOccluders(m_occlusionCuller, m_frustumCuller.GetVisible());
+					m_occlusionCuller.Rasterize();
+					m_occlusionCuller.Cull(m_scene.GetBounds(), m_frustumCuller.GetVisible());
+				}
+
+				m_scene.SelectLods(m_cameraPosition, m_lodPixelsPerUnit, c_lodPixelError, GetVisibleProxies());
+			}
+
+			if (!m_useGpuCulling && m_settings.m_useInstancing)
+			{
+				m_instanceBatcher.Begin();
+				m_scene.SubmitInstances(m_instanceBatcher, m_graphicsPipeline, GetVisibleProxies());
+				m_instanceBatcher.Build(imageIndex);
+			}
+
+			// After the passes above, which may have swapped out the buffers it points at
+			CreateFrameDescriptorSet(imageIndex);
+			RecordCommandBuffer(imageIndex);
 
 			VkSubmitInfo submitInfo{};
 			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -131,6 +193,28 @@ namespace Singularity
 			m_swapChain.Initialize();
 			CreatePipeline();
 
+			// Everything kept per image has to follow when the new swap chain has a different number of them
+			uint32 const imageViewCount = static_cast<uint32>(m_swapChain.GetImageViews().size());
+			if (imageViewCount != m_frameUniformBuffers.size())
+			{
+				vkDeviceWaitIdle(m_device.GetLogicalDevice());
+
+				DestroyFrameUniformBuffers();
+				m_frameUniformBuffers.clear();
+				CreateFrameUniformBuffers();
+
+				m_scene.CreateFrames();
+				m_instanceBatcher.Destroy();
+				m_instanceBatcher.Create();
+				if (m_useGpuCulling)
+				{
+					m_gpuCulling.CreateFrames();
+				}
+
+				DestroyTransientDescriptorAllocators();
+				CreateTransientDescriptorAllocators();
+				m_imagesInFlight.assign(imageViewCount, VK_NULL_HANDLE);
+			}
 		}
 
 		//////////////////////////////////////////////////////////////////////////////////////
@@ -146,13 +230,32 @@ namespace Singularity
 			m_device.Initialize();
 			m_swapChain.Initialize();
 
-			CreateDescriptorSetLayout();
-
-			m_uniformBufferAllocator.CreateUniformBuffers();
+			// Per-draw data goes through push constants when the device has room for it, otherwise through the object's uniform slot
+			m_usePushConstants = m_device.GetProperties().limits.maxPushConstantsSize >= sizeof(GenericPushConstantObject);
+			// With descriptor indexing every texture sits in one table, otherwise each material binds its own set
+			m_useBindlessTextures = m_device.SupportsBindlessTextures();
+			// Culling and draw emission move to the GPU when indirect draws can address objects through firstInstance
+			m_useGpuCulling = m_settings.m_useGpuCulling && m_device.SupportsMultiDrawIndirect();
+			// Meshes buffer their vertices in this format, so it has to be settled before any of them load. Positions get a
+			// stream of their own when a depth prepass will read them without the rest.
+			m_vertexFormat = m_settings.m_useCompactVertices ? VertexFormat::Of<CompactVertexLayout>(m_settings.m_useDepthPrepass) : VertexFormat::Of<FullVertexLayout>(m_settings.m_useDepthPrepass);
+
+			CreateDescriptorLayouts();
+			CreateTransientDescriptorAllocators();
+
+			CreateFrameUniformBuffers();
+			m_instanceBatcher.Create();
+			if (m_useGpuCulling)
+			{
+				m_gpuCulling.Create();
+			}
 
 			CreatePipeline();
-		
+
+			// Cooked meshes only know their bounds once loaded, and the scene reads those as proxies are created
 			CreateVertexBuffer();
+			CreateSceneResources();
+
 			CreateCommandBuffers();
 
 			CreateSyncObjects();
@@ -173,11 +276,22 @@ namespace Singularity
 			m_testMesh2.Unbuffer();
 			m_testMesh.Unbuffer();
 
-			m_uniformBufferAllocator.DestroyBuffers();
+			m_scene.Destroy();
+			DestroyFrameUniformBuffers();
+			m_instanceBatcher.Destroy();
+			if (m_useGpuCulling)
+			{
+				m_gpuCulling.Destroy();
+			}
+
+			m_testMaterial.Destroy();
+			m_texture.DestroyTexture();
 
 			DestroyPipeline();
+
+			DestroyDescriptorAllocators();
 			
-			vkDestroyDescriptorSetLayout(device, m_descriptorSetLayout, nullptr);
+			DestroyDescriptorLayouts();
 
 			m_swapChain.Shutdown();
 
@@ -191,31 +305,42 @@ namespace Singularity
 		}
 
 		//////////////////////////////////////////////////////////////////////////////////////
-		void Renderer::CreateDescriptorSetLayout()
+		void Renderer::CreateDescriptorLayouts()
 		{
-			VkDescriptorSetLayoutBinding uboLayoutBinding{};
-			uboLayoutBinding.binding = 0;
-			uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			uboLayoutBinding.descriptorCount = 1;
-			uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-			uboLayoutBinding.pImmutableSamplers = nullptr; // Optional
-
-			VkDescriptorSetLayoutBinding samplerLayoutBinding{};
-			samplerLayoutBinding.binding = 1;
-			samplerLayoutBinding.descriptorCount = 1;
-			samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			samplerLayoutBinding.pImmutableSamplers = nullptr;
-			samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+			// Set 0: per-frame camera, time and instances, set 1: per-material texture, set 2: per-object transform
+			m_frameDescriptorLayout.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+			m_frameDescriptorLayout.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
+			m_frameDescriptorLayout.Create();
+
+			m_materialDescriptorLayout.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
+			m_materialDescriptorLayout.Create();
+
+			if (m_useBindlessTextures)
+			{
+				// Replaces the material layout at set 1
+				m_bindlessTextures.Create(static_cast<uint32>(MAX_FRAMES_IN_FLIGHT));
+			}
 
-			std::array<VkDescriptorSetLayoutBinding, 2> bindings = { uboLayoutBinding, samplerLayoutBinding };
-			VkDescriptorSetLayoutCreateInfo layoutInfo{};
-			layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-			layoutInfo.bindingCount = static_cast<uint32>(bindings.size());;
-			layoutInfo.pBindings = bindings.data();
+			m_objectDescriptorLayout.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT);
+			m_objectDescriptorLayout.Create();
+		}
 
-			if (vkCreateDescriptorSetLayout(m_device.GetLogicalDevice(), &layoutInfo, nullptr, &m_descriptorSetLayout) != VK_SUCCESS) {
-				throw std::runtime_error("failed to create descriptor set layout!");
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Renderer::DestroyDescriptorLayouts()
+		{
+			m_objectDescriptorLayout.Destroy();
+			if (m_useBindlessTextures)
+			{
+				m_bindlessTextures.Destroy();
 			}
+			m_materialDescriptorLayout.Destroy();
+			m_frameDescriptorLayout.Destroy();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		std::vector<uint32> const& Renderer::GetVisibleProxies() const
+		{
+			return m_settings.m_useOcclusionCulling ? m_occlusionCuller.GetVisible() : m_frustumCuller.GetVisible();
 		}
 
 		//////////////////////////////////////////////////////////////////////////////////////
@@ -227,18 +352,25 @@ namespace Singularity
 			CreateCommandPool(); // TODO ordering and cleanup and not rebuilding stuff i shouldn't
 								 // Can not just make this command pool once? Would have to free commands manually tho
 
-			CreateDescriptorPool(); // TODO ordering and cleanup and not rebuilding stuff i shouldn't
-
 			CreateDepthResources();
 			CreateFramebuffers();
+		}
 
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Renderer::CreateSceneResources()
+		{
+			// Nothing in here depends on the swap chain, so it survives resizes along with its descriptor sets
 			CreateTextureImage();
 
-			m_testObject.SetupUniform();
-			m_testObject.SetMesh(&m_testMesh);
-			m_testObject.SetTexture(&m_texture);
-			m_testObject.CreateDescriptorSets();
-			
+			m_testMaterial.SetTexture(&m_texture);
+			m_testMaterial.CreateDescriptorSet();
+
+			m_scene.Create();
+			uint32 const testMeshId = m_scene.AddMesh(&m_testMesh);
+			uint32 const testMaterialId = m_scene.AddMaterial(&m_testMaterial);
+			m_testProxy = m_scene.CreateProxy(testMeshId, testMaterialId, glm::mat4(1.0f));
+			m_testNode = m_scene.GetHierarchy().CreateNode(glm::mat4(1.0f));
+			m_scene.AttachProxy(m_testProxy, m_testNode);
 		}
 
 		//////////////////////////////////////////////////////////////////////////////////////
@@ -246,19 +378,23 @@ namespace Singularity
 		{
 			VkDevice const logicalDevice = m_device.GetLogicalDevice();
 
-			m_depthImage.DestroyImage();
+			// Sort key IDs would otherwise fill up over rebuilds and could match a new pipeline at a reused address
+			m_renderQueue.ResetIds();
 
-			m_texture.DestroyTexture();
+			m_depthImage.DestroyImage();
 
 			vkDestroyCommandPool(logicalDevice, m_commandPool, nullptr);
 
-			vkDestroyDescriptorPool(logicalDevice, m_descriptorPool, nullptr);
-
 			for (auto framebuffer : m_swapChainFramebuffers) {
 				vkDestroyFramebuffer(logicalDevice, framebuffer, nullptr);
 			}
 
 			vkDestroyPipeline(logicalDevice, m_graphicsPipeline, nullptr);
+			if (m_depthPipeline != VK_NULL_HANDLE)
+			{
+				vkDestroyPipeline(logicalDevice, m_depthPipeline, nullptr);
+				m_depthPipeline = VK_NULL_HANDLE;
+			}
 			vkDestroyPipelineLayout(logicalDevice, m_pipelineLayout, nullptr);
 			vkDestroyRenderPass(logicalDevice, m_renderPass, nullptr);
 		}
@@ -279,8 +415,26 @@ namespace Singularity
 		//////////////////////////////////////////////////////////////////////////////////////
 		void Renderer::CreateGraphicsPipeline()
 		{
-			VkShaderModule vertexShaderModule = CreateShaderModule(std::string(DATA_DIRECTORY) + "Shaders/Vertex/textured_vert.spv"); // TODO eewwwww
-			VkShaderModule fragmentShaderModule = CreateShaderModule(std::string(DATA_DIRECTORY) + "Shaders/Fragment/textured_frag.spv");
+			// The depth shaders come in the same variants, fetching per-object data the same way
+			std::string variant = m_usePushConstants ? "_push" : "";
+			if (m_useGpuCulling)
+			{
+				variant = "_gpu";
+			}
+			else if (m_settings.m_useInstancing)
+			{
+				variant = "_instanced";
+			}
+			std::string vertexShader = "textured" + variant;
+			if (!m_vertexFormat.HasLocation(VertexLocation::Colour))
+			{
+				vertexShader += "_compact";
+			}
+			std::vector<char> const vertexShaderCode = IO::ReadFile(std::string(DATA_DIRECTORY) + "Shaders/Vertex/" + vertexShader + "_vert.spv"); // TODO eewwwww
+			m_vertexFormat.Validate(ShaderReflection::GetInputs(vertexShaderCode));
+			VkShaderModule vertexShaderModule = CreateShaderModule(vertexShaderCode);
+			std::string const fragmentShader = m_useBindlessTextures ? "Shaders/Fragment/textured_bindless_frag.spv" : "Shaders/Fragment/textured_frag.spv";
+			VkShaderModule fragmentShaderModule = CreateShaderModule(std::string(DATA_DIRECTORY) + fragmentShader);
 
 			VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
 			vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -298,12 +452,12 @@ namespace Singularity
 
 			VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 			vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-			auto bindingDescription = Vertex::GetBindingDescription();
-			auto attributeDescriptions = Vertex::GetAttributeDescriptions();
+			auto const& bindingDescriptions = m_vertexFormat.GetBindingDescriptions();
+			auto const& attributeDescriptions = m_vertexFormat.GetAttributeDescriptions();
 
-			vertexInputInfo.vertexBindingDescriptionCount = 1;
+			vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
 			vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-			vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+			vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
 			vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
 			VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
@@ -377,8 +531,8 @@ namespace Singularity
 			VkPipelineDepthStencilStateCreateInfo depthStencil{};
 			depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
 			depthStencil.depthTestEnable = VK_TRUE;
-			depthStencil.depthWriteEnable = VK_TRUE;
-			depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+			depthStencil.depthWriteEnable = m_settings.m_useDepthPrepass ? VK_FALSE : VK_TRUE; // The prepass already laid down the final depth
+			depthStencil.depthCompareOp = m_settings.m_useDepthPrepass ? VK_COMPARE_OP_LESS_OR_EQUAL : VK_COMPARE_OP_LESS;
 			depthStencil.depthBoundsTestEnable = VK_FALSE;
 			depthStencil.minDepthBounds = 0.0f; // Optional
 			depthStencil.maxDepthBounds = 1.0f; // Optional
@@ -388,10 +542,28 @@ namespace Singularity
 
 			VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 			pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-			pipelineLayoutInfo.setLayoutCount = 1;
-			pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout;
-			pipelineLayoutInfo.pushConstantRangeCount = 0;
-			pipelineLayoutInfo.pPushConstantRanges = nullptr;
+			// The object set is only part of the layout when per-object data is neither in a storage buffer nor pushed
+			VkDescriptorSetLayout const materialLayout = m_useBindlessTextures ? m_bindlessTextures.GetLayout().GetLayout() : m_materialDescriptorLayout.GetLayout();
+			std::array<VkDescriptorSetLayout, 3> const setLayouts = { m_frameDescriptorLayout.GetLayout(), materialLayout, m_objectDescriptorLayout.GetLayout() };
+			bool const objectsInStorageBuffer = m_useGpuCulling || m_settings.m_useInstancing;
+			pipelineLayoutInfo.setLayoutCount = (objectsInStorageBuffer || m_usePushConstants) ? c_objectDescriptorSet : static_cast<uint32>(setLayouts.size());
+			pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+
+			VkPushConstantRange pushConstantRange{};
+			pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+			pushConstantRange.offset = 0;
+			pushConstantRange.size = sizeof(GenericPushConstantObject);
+
+			if (m_usePushConstants && !objectsInStorageBuffer)
+			{
+				pipelineLayoutInfo.pushConstantRangeCount = 1;
+				pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+			}
+			else
+			{
+				pipelineLayoutInfo.pushConstantRangeCount = 0;
+				pipelineLayoutInfo.pPushConstantRanges = nullptr;
+			}
 
 			if (vkCreatePipelineLayout(m_device.GetLogicalDevice(), &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS) {
 				throw std::runtime_error("failed to create pipeline layout!");
@@ -411,7 +583,7 @@ namespace Singularity
 			pipelineInfo.pDynamicState = nullptr;
 			pipelineInfo.layout = m_pipelineLayout;
 			pipelineInfo.renderPass = m_renderPass;
-			pipelineInfo.subpass = 0;
+			pipelineInfo.subpass = m_settings.m_useDepthPrepass ? 1 : 0;
 			pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 			pipelineInfo.basePipelineIndex = -1;
 
@@ -419,6 +591,37 @@ namespace Singularity
 				throw std::runtime_error("failed to create graphics pipeline!");
 			}
 
+			if (m_settings.m_useDepthPrepass)
+			{
+				// Same state and layout, but only the position stream goes in and only depth comes out
+				VertexFormat const positionFormat = m_vertexFormat.GetPositionFormat();
+				std::vector<char> const depthShaderCode = IO::ReadFile(std::string(DATA_DIRECTORY) + "Shaders/Vertex/depth" + variant + "_vert.spv");
+				positionFormat.Validate(ShaderReflection::GetInputs(depthShaderCode));
+
+				VkPipelineShaderStageCreateInfo depthShaderStageInfo = vertShaderStageInfo;
+				depthShaderStageInfo.module = CreateShaderModule(depthShaderCode);
+
+				vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(positionFormat.GetBindingDescriptions().size());
+				vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(positionFormat.GetAttributeDescriptions().size());
+				vertexInputInfo.pVertexBindingDescriptions = positionFormat.GetBindingDescriptions().data();
+				vertexInputInfo.pVertexAttributeDescriptions = positionFormat.GetAttributeDescriptions().data();
+
+				depthStencil.depthWriteEnable = VK_TRUE;
+				depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+				colorBlending.attachmentCount = 0;
+				colorBlending.pAttachments = nullptr;
+
+				pipelineInfo.stageCount = 1;
+				pipelineInfo.pStages = &depthShaderStageInfo;
+				pipelineInfo.subpass = 0;
+
+				if (vkCreateGraphicsPipelines(m_device.GetLogicalDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_depthPipeline) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create depth pipeline!");
+				}
+
+				vkDestroyShaderModule(m_device.GetLogicalDevice(), depthShaderStageInfo.module, nullptr);
+			}
+
 			vkDestroyShaderModule(m_device.GetLogicalDevice(), fragmentShaderModule, nullptr);
 			vkDestroyShaderModule(m_device.GetLogicalDevice(), vertexShaderModule, nullptr);
 		}
@@ -426,12 +629,16 @@ namespace Singularity
 		//////////////////////////////////////////////////////////////////////////////////////
 		VkShaderModule Renderer::CreateShaderModule(std::string _filePath)
 		{
-			auto shaderCode = IO::ReadFile(_filePath);
+			return CreateShaderModule(IO::ReadFile(_filePath));
+		}
 
+		//////////////////////////////////////////////////////////////////////////////////////
+		VkShaderModule Renderer::CreateShaderModule(std::vector<char> const& _shaderCode)
+		{
 			VkShaderModuleCreateInfo createInfo{};
 			createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-			createInfo.codeSize = shaderCode.size();
-			createInfo.pCode = reinterpret_cast<const uint32_t*>(shaderCode.data());
+			createInfo.codeSize = _shaderCode.size();
+			createInfo.pCode = reinterpret_cast<const uint32_t*>(_shaderCode.data());
 
 			VkShaderModule shaderModule;
 			if (vkCreateShaderModule(m_device.GetLogicalDevice(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
@@ -472,13 +679,24 @@ namespace Singularity
 			depthAttachmentRef.attachment = 1;
 			depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
-			VkSubpassDescription subpass{};
+			// With a depth prepass, depth is written in a subpass of its own before the main one shades against it
+			std::vector<VkSubpassDescription> subpasses;
+			if (m_settings.m_useDepthPrepass)
+			{
+				VkSubpassDescription& depthSubpass = subpasses.emplace_back();
+				depthSubpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+				depthSubpass.colorAttachmentCount = 0;
+				depthSubpass.pDepthStencilAttachment = &depthAttachmentRef;
+			}
+
+			VkSubpassDescription& subpass = subpasses.emplace_back();
 			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 			subpass.colorAttachmentCount = 1;
 			subpass.pColorAttachments = &colorAttachmentRef;
 			subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
-			VkSubpassDependency dependency{};
+			std::vector<VkSubpassDependency> dependencies;
+			VkSubpassDependency& dependency = dependencies.emplace_back();
 			dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
 			dependency.dstSubpass = 0;
 			dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
@@ -486,15 +704,35 @@ namespace Singularity
 			dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
 			dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
+			if (m_settings.m_useDepthPrepass)
+			{
+				VkSubpassDependency& colourDependency = dependencies.emplace_back();
+				colourDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+				colourDependency.dstSubpass = 1;
+				colourDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				colourDependency.srcAccessMask = 0;
+				colourDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				colourDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+				VkSubpassDependency& depthDependency = dependencies.emplace_back();
+				depthDependency.srcSubpass = 0;
+				depthDependency.dstSubpass = 1;
+				depthDependency.srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+				depthDependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+				depthDependency.dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+				depthDependency.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+				depthDependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+			}
+
 			std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
 			VkRenderPassCreateInfo renderPassInfo{};
 			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 			renderPassInfo.attachmentCount = static_cast<uint32>(attachments.size());
 			renderPassInfo.pAttachments = attachments.data();
-			renderPassInfo.subpassCount = 1;
-			renderPassInfo.pSubpasses = &subpass;
-			renderPassInfo.dependencyCount = 1;
-			renderPassInfo.pDependencies = &dependency;
+			renderPassInfo.subpassCount = static_cast<uint32>(subpasses.size());
+			renderPassInfo.pSubpasses = subpasses.data();
+			renderPassInfo.dependencyCount = static_cast<uint32>(dependencies.size());
+			renderPassInfo.pDependencies = dependencies.data();
 
 
 			if (vkCreateRenderPass(m_device.GetLogicalDevice(), &renderPassInfo, nullptr, &m_renderPass) != VK_SUCCESS) {
@@ -561,32 +799,142 @@ namespace Singularity
 			//Mesh diamond(vertices);
 			// diamond not in use - using obj
 
-			m_testMesh.Buffer(*this);
-			m_testMesh2.Buffer(*this);
+			LoadMesh(m_testMesh, "anky");
+			LoadMesh(m_testMesh2, "testSphere");
 		}
 
 		//////////////////////////////////////////////////////////////////////////////////////
-		void Renderer::CreateDescriptorPool()
+		void Renderer::LoadMesh(Mesh& o_mesh, std::string const& _name)
 		{
-			uint32 const imageViewCount = static_cast<uint32>(m_swapChain.GetImageViews().size());
+			// Binary glTF from the DCC tools wins over an .obj of the same name
+			std::error_code error;
+			std::string const glbPath = std::string(DATA_DIRECTORY) + "Models/" + _name + ".glb";
+			bool const isGlb = std::filesystem::exists(glbPath, error);
+			std::string const sourcePath = isGlb ? glbPath : std::string(DATA_DIRECTORY) + "Models/" + _name + ".obj";
+			std::string const cookedPath = std::string(DATA_DIRECTORY) + "Models/" + _name + MeshFile::c_extension;
+
+			// Missing files read as the oldest possible time, so a cooked file shipped without its source still loads
+			bool const stale = std::filesystem::last_write_time(sourcePath, error) > std::filesystem::last_write_time(cookedPath, error);
+			MeshFileStats stats;
+			if (!stale && MeshFile::Load(cookedPath, *this, o_mesh, &stats))
+			{
+				double const ratio = stats.m_storedSize != 0u ? static_cast<double>(stats.m_rawSize) / stats.m_storedSize : 1.0;
+				double const throughput = stats.m_decodeSeconds > 0.0f ? stats.m_rawSize / (stats.m_decodeSeconds * 1e9) : 0.0;
+				std::cout << _name << ": " << stats.m_storedSize << " of " << stats.m_rawSize << " bytes stored (" << ratio << ":1), decoded at " << throughput << " GB/s" << std::endl;
+				return;
+			}
 
-			std::array<VkDescriptorPoolSize, 2> poolSizes{};
-			poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			poolSizes[0].descriptorCount = imageViewCount;
-			poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			poolSizes[1].descriptorCount = imageViewCount;
+			o_mesh = isGlb ? MeshLoader::LoadGlb(sourcePath) : MeshLoader::LoadObj(sourcePath);
+			o_mesh.BuildMeshlets();
+			o_mesh.GenerateLods(Mesh::c_maxLodCount);
+			VertexCacheStats before;
+			VertexCacheStats after;
+			o_mesh.Optimize(&before, &after);
+			std::cout << _name << ": ACMR " << before.m_acmr << " -> " << after.m_acmr << ", ATVR " << before.m_atvr << " -> " << after.m_atvr << std::endl;
+			MeshFile::Write(cookedPath, o_mesh, m_vertexFormat); // A failed write only costs the next launch another cook
+			o_mesh.Buffer(*this);
+		}
 
-			VkDescriptorPoolCreateInfo poolInfo{};
-			poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-			poolInfo.poolSizeCount = static_cast<uint32>(poolSizes.size());;
-			poolInfo.pPoolSizes = poolSizes.data();
-			
-			poolInfo.maxSets = imageViewCount;
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Renderer::CreateTransientDescriptorAllocators()
+		{
+			size_t const imageViewCount = m_swapChain.GetImageViews().size();
+			m_transientDescriptorAllocators.reserve(imageViewCount);
+			for (size_t i = 0; i < imageViewCount; ++i)
+			{
+				m_transientDescriptorAllocators.emplace_back(*this);
+			}
+			m_frameDescriptorSets.assign(imageViewCount, VK_NULL_HANDLE);
+		}
 
-			VkDevice const logicalDevice = m_device.GetLogicalDevice();
-			if (vkCreateDescriptorPool(logicalDevice, &poolInfo, nullptr, &m_descriptorPool) != VK_SUCCESS) {
-				throw std::runtime_error("failed to create descriptor pool!");
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Renderer::DestroyTransientDescriptorAllocators()
+		{
+			for (DescriptorAllocator& allocator : m_transientDescriptorAllocators)
+			{
+				allocator.Shutdown();
 			}
+			m_transientDescriptorAllocators.clear();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Renderer::DestroyDescriptorAllocators()
+		{
+			DestroyTransientDescriptorAllocators();
+			m_descriptorSetCache.Clear();
+			m_descriptorAllocator.Shutdown();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Renderer::CreateFrameUniformBuffers()
+		{
+			size_t const imageViewCount = m_swapChain.GetImageViews().size();
+			m_frameUniformBuffers.reserve(imageViewCount);
+
+			VkBufferCreateInfo bufferInfo{};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size = sizeof(FrameUniformBufferObject);
+			bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			for (size_t i = 0; i < imageViewCount; i++) {
+				Buffer& newBuffer = m_frameUniformBuffers.emplace_back(*this);
+				newBuffer.CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Renderer::DestroyFrameUniformBuffers()
+		{
+			for (Buffer& buffer : m_frameUniformBuffers) {
+				buffer.DestroyBuffer();
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Renderer::CreateFrameDescriptorSet(uint32 _imageIndex)
+		{
+			m_frameDescriptorSets[_imageIndex] = m_transientDescriptorAllocators[_imageIndex].Allocate(m_frameDescriptorLayout.GetLayout());
+			std::vector<uint8> const packed = m_frameDescriptorLayout.Pack(GetFrameDescriptorBindings(_imageIndex));
+			m_frameDescriptorLayout.Write(m_frameDescriptorSets[_imageIndex], packed.data());
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		std::vector<DescriptorBinding> Renderer::GetFrameDescriptorBindings(uint32 _imageIndex) const
+		{
+			return {
+				DescriptorBinding::Buffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, m_frameUniformBuffers[_imageIndex].GetBuffer(), 0, sizeof(FrameUniformBufferObject)),
+				DescriptorBinding::Buffer(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_useGpuCulling ? m_gpuCulling.GetObjectBuffer(_imageIndex) : m_instanceBatcher.GetInstanceBuffer(_imageIndex), 0, VK_WHOLE_SIZE)
+			};
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Renderer::UpdateFrameUniformBuffer(uint32 _imageIndex, float _time, float _timeStep)
+		{
+			// Camera matrices are computed once per frame rather than once per object
+			FrameUniformBufferObject ubo{};
+			m_cameraPosition = glm::vec3(0.0f, 3.0f, 10.0f);
+			ubo.m_view = glm::lookAt(m_cameraPosition, glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+			m_view = ubo.m_view;
+
+			VkExtent2D const swapChainExtent = m_swapChain.GetExtent();
+			float const fieldOfView = glm::radians(45.0f);
+			ubo.m_projection = glm::perspective(fieldOfView, swapChainExtent.width / (float)swapChainExtent.height, c_nearPlane, c_farPlane);
+			ubo.m_projection[1][1] *= -1;
+
+			// How many pixels tall one unit is at unit distance, LOD error shrinks from there with distance
+			m_lodPixelsPerUnit = swapChainExtent.height / (2.0f * std::tan(fieldOfView * 0.5f));
+
+			ubo.m_time = glm::vec4(_time, _timeStep, 0.0f, 0.0f);
+
+			m_viewProjection = ubo.m_projection * ubo.m_view;
+			m_frustum = Frustum::FromViewProjection(m_viewProjection);
+
+			VkDevice const logicalDevice = m_device.GetLogicalDevice();
+			void* data;
+			vkMapMemory(logicalDevice, m_frameUniformBuffers[_imageIndex].GetBufferMemory(), 0, sizeof(ubo), 0, &data);
+			memcpy(data, &ubo, sizeof(ubo));
+			vkUnmapMemory(logicalDevice, m_frameUniformBuffers[_imageIndex].GetBufferMemory());
 		}
 
 		//////////////////////////////////////////////////////////////////////////////////////
@@ -595,7 +943,7 @@ namespace Singularity
 			VkCommandPoolCreateInfo poolInfo{};
 			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 			poolInfo.queueFamilyIndex = m_device.GetQueueFamilies().m_graphicsFamily.value();
-			poolInfo.flags = 0;
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; // Command buffers are re-recorded every frame
 
 			if (vkCreateCommandPool(m_device.GetLogicalDevice(), &poolInfo, nullptr, &m_commandPool) != VK_SUCCESS) {
 				throw std::runtime_error("failed to create command pool!");
@@ -616,42 +964,91 @@ namespace Singularity
 			if (vkAllocateCommandBuffers(m_device.GetLogicalDevice(), &allocInfo, m_commandBuffers.data()) != VK_SUCCESS) {
 				throw std::runtime_error("failed to allocate command buffers!");
 			}
+		}
 
-			for (size_t i = 0; i < m_commandBuffers.size(); i++) {
-				VkCommandBufferBeginInfo beginInfo{};
-				beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-				beginInfo.flags = 0; // Optional
-				beginInfo.pInheritanceInfo = nullptr; // Optional
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Renderer::RecordCommandBuffer(uint32 _imageIndex)
+		{
+			VkCommandBuffer const commandBuffer = m_commandBuffers[_imageIndex];
 
-				if (vkBeginCommandBuffer(m_commandBuffers[i], &beginInfo) != VK_SUCCESS) {
-					throw std::runtime_error("failed to begin recording command buffer!");
-				}
+			VkCommandBufferBeginInfo beginInfo{};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			beginInfo.pInheritanceInfo = nullptr; // Optional
+
+			if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+				throw std::runtime_error("failed to begin recording command buffer!");
+			}
+
+			if (m_useGpuCulling)
+			{
+				// Compute can't run inside the render pass, the draws below read what this writes
+				m_gpuCulling.Cull(commandBuffer, _imageIndex, m_frustum, m_cameraPosition, m_lodPixelsPerUnit / c_lodPixelError);
+			}
+
+			VkRenderPassBeginInfo renderPassInfo{};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = m_renderPass;
+			renderPassInfo.framebuffer = m_swapChainFramebuffers[_imageIndex];
+			renderPassInfo.renderArea.offset = { 0, 0 };
+			renderPassInfo.renderArea.extent = m_swapChain.GetExtent();
 
-				VkRenderPassBeginInfo renderPassInfo{};
-				renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-				renderPassInfo.renderPass = m_renderPass;
-				renderPassInfo.framebuffer = m_swapChainFramebuffers[i];
-				renderPassInfo.renderArea.offset = { 0, 0 };
-				renderPassInfo.renderArea.extent = m_swapChain.GetExtent();
+			std::array<VkClearValue, 2> clearValues{}; // TODO programmable clear colours
+			clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
+			clearValues[1].depthStencil = { 1.0f, 0 };
 
-				std::array<VkClearValue, 2> clearValues{}; // TODO programmable clear colours
-				clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
-				clearValues[1].depthStencil = { 1.0f, 0 };
+			renderPassInfo.clearValueCount = static_cast<uint32>(clearValues.size());
+			renderPassInfo.pClearValues = clearValues.data();
 
-				renderPassInfo.clearValueCount = static_cast<uint32>(clearValues.size());
-				renderPassInfo.pClearValues = clearValues.data();
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-				vkCmdBeginRenderPass(m_commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, c_frameDescriptorSet, 1, &m_frameDescriptorSets[_imageIndex], 0, nullptr);
 
-				vkCmdBindPipeline(m_commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline);
+			if (m_useBindlessTextures)
+			{
+				// Every material indexes into the same table, so set 1 never changes within the pass
+				m_bindlessTextures.Bind(commandBuffer, m_pipelineLayout, c_materialDescriptorSet);
+			}
 
-				m_testObject.WriteDrawToCommandBuffer(m_commandBuffers[i], i);
+			if (m_useGpuCulling)
+			{
+				if (m_settings.m_useDepthPrepass)
+				{
+					vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_depthPipeline);
+					m_gpuCulling.Draw(commandBuffer, _imageIndex, true);
+					vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+				}
 
-				vkCmdEndRenderPass(m_commandBuffers[i]);
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline);
+				m_gpuCulling.Draw(commandBuffer, _imageIndex);
+			}
+			else
+			{
+				// Sorted so state only changes between packets that need it
+				m_renderQueue.Begin(m_view, c_farPlane);
+				if (m_settings.m_useInstancing)
+				{
+					// One packet per unique pipeline, material and mesh
+					m_instanceBatcher.Submit(m_renderQueue);
+				}
+				else
+				{
+					m_scene.Submit(m_renderQueue, m_graphicsPipeline, GetVisibleProxies());
+				}
 
-				if (vkEndCommandBuffer(m_commandBuffers[i]) != VK_SUCCESS) {
-					throw std::runtime_error("failed to record command buffer!");
+				m_renderQueue.Sort();
+				if (m_settings.m_useDepthPrepass)
+				{
+					m_renderQueue.ExecuteDepth(commandBuffer, _imageIndex, m_depthPipeline);
+					vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
 				}
+				m_renderQueue.Execute(commandBuffer, _imageIndex);
+			}
+
+			vkCmdEndRenderPass(commandBuffer);
+
+			if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("failed to record command buffer!");
 			}
 		}
 
@@ -778,7 +1175,7 @@ namespace Singularity
 			appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 			appInfo.pEngineName = "Singularity";
 			appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-			appInfo.apiVersion = VK_API_VERSION_1_0;
+			appInfo.apiVersion = VK_API_VERSION_1_2;
 
 
 			std::vector<const char*> const extensions = GetRequiredExtensions();
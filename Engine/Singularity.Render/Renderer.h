@@ -3,15 +3,29 @@
 #include <vulkan/vulkan.hpp>
 
 #include <Singularity.Core/CoreDeclare.h>
+#include <Singularity.Render/BindlessTextureTable.h>
+#include <Singularity.Render/Buffer.h>
+#include <Singularity.Render/DescriptorAllocator.h>
+#include <Singularity.Render/DescriptorLayout.h>
+#include <Singularity.Render/DescriptorSetCache.h>
 #include <Singularity.Render/Device.h>
+#include <Singularity.Render/FrameUniformBufferObject.h>
+#include <Singularity.Render/Frustum.h>
+#include <Singularity.Render/FrustumCuller.h>
 #include <Singularity.Render/Image.h>
+#include <Singularity.Render/GenericPushConstantObject.h>
 #include <Singularity.Render/GenericUniformBufferObject.h>
+#include <Singularity.Render/GpuCullingPass.h>
+#include <Singularity.Render/InstanceBatcher.h>
+#include <Singularity.Render/Material.h>
 #include <Singularity.Render/Mesh.h>
-#include <Singularity.Render/RenderObject.h>
+#include <Singularity.Render/OcclusionCuller.h>
+#include <Singularity.Render/RenderQueue.h>
+#include <Singularity.Render/Scene.h>
 #include <Singularity.Render/SwapChain.h>
 #include <Singularity.Render/Texture.h>
-#include <Singularity.Render/UniformBufferAllocator.h>
 #include <Singularity.Render/Validation.h>
+#include <Singularity.Render/VertexFormat.h>
 
 namespace Singularity
 {
@@ -22,13 +36,27 @@ namespace Singularity
 
 	namespace Render
 	{
+		// Which paths the renderer takes, fixed once it is created. GPU culling is only taken when the device supports
+		// multi-draw indirect. Without it the CPU culls with FrustumCuller, then the BVH and OcclusionCuller when enabled,
+		// and only the proxies that survive are instanced or submitted one draw each.
+		struct RendererSettings
+		{
+			bool m_useGpuCulling = true; // A compute pass culls, picks LODs and writes the draws, superseding the CPU paths below
+			bool m_useClusterCulling = false; // GPU culling only. Only pays off for high poly meshes, small ones cost more in commands than they save
+			bool m_useInstancing = true; // CPU culling only. Per-object draws are kept as a fallback for debugging
+			bool m_useBvhCulling = false; // CPU culling only. Pays off for large mostly static scenes, flat culling wins when most things move
+			bool m_useOcclusionCulling = false; // CPU culling only. Pays off in dense interiors, open scenes rarely hide enough to cover the raster
+			bool m_useCompactVertices = true; // Full float vertices are kept as a fallback for debugging
+			bool m_useDepthPrepass = false; // Pays off when shading is expensive and overdraw high, otherwise the extra geometry pass costs more than it saves
+		};
+
 
 		class Buffer;
 
 		class Renderer
 		{
 		public:
-			Renderer(Window::Window& _window);
+			Renderer(Window::Window& _window, RendererSettings const& _settings = RendererSettings());
 			~Renderer();
 
 			void Update(float _timeStep);
@@ -39,7 +67,6 @@ namespace Singularity
 			Device const& GetDevice() const { return m_device; }
 			Validation const& GetValidation() const { return m_validation; }
 			SwapChain const& GetSwapChain() const { return m_swapChain; }
-			UniformBufferAllocator& GetUniformBufferAllocator() { return m_uniformBufferAllocator; }
 
 			Window::Window const& GetWindow() const { return m_window; }
 
@@ -48,15 +75,41 @@ namespace Singularity
 			VkCommandBuffer BeginSingleTimeCommands(); // TODO extract out command buffer stuff
 			void EndSingleTimeCommands(VkCommandBuffer _commandBuffer);
 
-			VkDescriptorPool GetDescriptorPool() const { return m_descriptorPool; }
-			VkDescriptorSetLayout GetDescriptorSetLayout() const { return m_descriptorSetLayout; }
+			// Descriptor sets are split by update frequency and bound only when they change
+			static uint32 constexpr c_frameDescriptorSet = 0u;
+			static uint32 constexpr c_materialDescriptorSet = 1u;
+			static uint32 constexpr c_objectDescriptorSet = 2u;
+
+			DescriptorAllocator& GetDescriptorAllocator() { return m_descriptorAllocator; } // Sets that live until shutdown
+			DescriptorAllocator& GetTransientDescriptorAllocator(uint32 _imageIndex) { return m_transientDescriptorAllocators[_imageIndex]; } // Sets for one frame of the image, handed back once its fence has signalled
+			DescriptorSetCache& GetDescriptorSetCache() { return m_descriptorSetCache; }
+			DescriptorLayout const& GetFrameDescriptorLayout() const { return m_frameDescriptorLayout; }
+			DescriptorLayout const& GetMaterialDescriptorLayout() const { return m_materialDescriptorLayout; }
+			DescriptorLayout const& GetObjectDescriptorLayout() const { return m_objectDescriptorLayout; }
 			VkPipelineLayout GetPipelineLayout() const { return  m_pipelineLayout; }
+			bool UsePushConstants() const { return m_usePushConstants; }
+			bool UseBindlessTextures() const { return m_useBindlessTextures; }
+			bool UseInstancing() const { return m_settings.m_useInstancing; }
+			bool UseGpuCulling() const { return m_useGpuCulling; }
+			bool UseClusterCulling() const { return m_settings.m_useClusterCulling; }
+			VertexFormat const& GetVertexFormat() const { return m_vertexFormat; }
+			GpuCullingPass& GetGpuCullingPass() { return m_gpuCulling; }
+			Scene& GetScene() { return m_scene; }
+			RenderQueueStats const& GetRenderQueueStats() const { return m_renderQueue.GetStats(); }
+			CullStats const& GetCullStats() const { return m_frustumCuller.GetStats(); }
+			OcclusionStats const& GetOcclusionStats() const { return m_occlusionCuller.GetStats(); }
+
+			VkShaderModule CreateShaderModule(std::string _filePath); // TODO - SHADER.h
+			VkShaderModule CreateShaderModule(std::vector<char> const& _shaderCode);
+			BindlessTextureTable& GetBindlessTextureTable() { return m_bindlessTextures; }
 
 		private:
 			void Initialize();
 			void Shutdown();
 
-			void CreateDescriptorSetLayout();
+			void CreateDescriptorLayouts();
+			void DestroyDescriptorLayouts();
+			std::vector<uint32> const& GetVisibleProxies() const;
 			void CreatePipeline();// Can't think of better name (Framebuffers + Pipeline)
 			void DestroyPipeline();
 
@@ -67,18 +120,29 @@ namespace Singularity
 			void CreateSurface();
 
 			void CreateGraphicsPipeline(); // TODO - PIPELINE.h
-			VkShaderModule CreateShaderModule(std::string _filePath); // TODO - SHADER.h
 
 			void CreateRenderPass();
 
 			void CreateFramebuffers();
 
 			void CreateVertexBuffer();
+			void LoadMesh(Mesh& o_mesh, std::string const& _name); // From its cooked file, cooking it from the .obj first when that is missing or stale
+
+			void CreateTransientDescriptorAllocators();
+			void DestroyTransientDescriptorAllocators();
+			void DestroyDescriptorAllocators();
+
+			void CreateSceneResources();
 
-			void CreateDescriptorPool();
+			void CreateFrameUniformBuffers();
+			void DestroyFrameUniformBuffers();
+			void CreateFrameDescriptorSet(uint32 _imageIndex);
+			std::vector<DescriptorBinding> GetFrameDescriptorBindings(uint32 _imageIndex) const;
+			void UpdateFrameUniformBuffer(uint32 _imageIndex, float _time, float _timeStep);
 
 			void CreateCommandPool();
 			void CreateCommandBuffers();
+			void RecordCommandBuffer(uint32 _imageIndex);
 
 			void CreateSyncObjects();
 
@@ -94,13 +158,40 @@ namespace Singularity
 
 			std::vector<VkFramebuffer> m_swapChainFramebuffers;
 
-			VkDescriptorSetLayout m_descriptorSetLayout; // TO OWN THING
-			VkDescriptorPool m_descriptorPool;
+			DescriptorLayout m_frameDescriptorLayout;
+			DescriptorLayout m_materialDescriptorLayout;
+			DescriptorLayout m_objectDescriptorLayout;
+
+			DescriptorAllocator m_descriptorAllocator;
+			std::vector<DescriptorAllocator> m_transientDescriptorAllocators; // One per swap chain image, reset once that image's last frame has retired
+			DescriptorSetCache m_descriptorSetCache;
+			BindlessTextureTable m_bindlessTextures;
+
+			std::vector<Buffer> m_frameUniformBuffers;
+			std::vector<VkDescriptorSet> m_frameDescriptorSets;
+
+			Scene m_scene;
+			InstanceBatcher m_instanceBatcher;
+			GpuCullingPass m_gpuCulling;
+			RenderQueue m_renderQueue;
+			Frustum m_frustum;
+			FrustumCuller m_frustumCuller;
+			OcclusionCuller m_occlusionCuller;
+			glm::mat4 m_view = glm::mat4(1.0f);
+			glm::mat4 m_viewProjection = glm::mat4(1.0f);
+			glm::vec3 m_cameraPosition = glm::vec3(0.0f);
+			float m_lodPixelsPerUnit = 1.0f;
 
 			VkRenderPass m_renderPass;
 			VkPipeline m_graphicsPipeline;
+			VkPipeline m_depthPipeline = VK_NULL_HANDLE;
 			VkPipelineLayout m_pipelineLayout;
 			Image m_depthImage;
+			bool m_usePushConstants = false;
+			bool m_useBindlessTextures = false;
+			RendererSettings m_settings;
+			bool m_useGpuCulling = false; // Asked for by the settings and supported by the device
+			VertexFormat m_vertexFormat;
 
 			VkCommandPool m_commandPool;
 			std::vector<VkCommandBuffer> m_commandBuffers;
@@ -113,18 +204,22 @@ namespace Singularity
 			Device m_device;
 			Validation m_validation;
 			SwapChain m_swapChain;
-			UniformBufferAllocator m_uniformBufferAllocator;
 
 			Window::Window& m_window;
 
 			static uint64 constexpr MAX_FRAMES_IN_FLIGHT = 2u;
+			static float constexpr c_nearPlane = 0.1f;
+			static float constexpr c_farPlane = 1000.0f;
+			static float constexpr c_lodPixelError = 1.0f; // Largest on screen deviation a coarser LOD may introduce
 			uint64 m_currentFrame = 0u;
 
 			Texture m_texture;
+			Material m_testMaterial;
 			Mesh m_testMesh;
 			Mesh m_testMesh2;
 
-			RenderObject m_testObject;
+			RenderProxyHandle m_testProxy;
+			TransformHandle m_testNode;
 		};
 
 	}
@@ -0,0 +1,652 @@
+#include "Scene.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include <Singularity.Render/GenericPushConstantObject.h>
+#include <Singularity.Render/GenericUniformBufferObject.h>
+#include <Singularity.Render/InstanceBatcher.h>
+#include <Singularity.Render/InstanceData.h>
+#include <Singularity.Render/Material.h>
+#include <Singularity.Render/Mesh.h>
+#include <Singularity.Render/OcclusionCuller.h>
+#include <Singularity.Render/Renderer.h>
+#include <Singularity.Render/RenderQueue.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::Create()
+		{
+			// Every other path carries per-object data with the draw or in a shared storage buffer
+			m_useUniforms = !m_renderer.UseGpuCulling() && !m_renderer.UseInstancing() && !m_renderer.UsePushConstants();
+			if (!m_useUniforms)
+			{
+				return;
+			}
+
+			// Each proxy is bound at its own dynamic offset, which must respect the device alignment
+			VkDeviceSize const alignment = m_renderer.GetDevice().GetProperties().limits.minUniformBufferOffsetAlignment;
+			m_uniformStride = sizeof(GenericUniformBufferObject);
+			if (alignment > 0u)
+			{
+				m_uniformStride = (m_uniformStride + alignment - 1u) & ~(alignment - 1u);
+			}
+
+			CreateFrames();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::CreateFrames()
+		{
+			for (Frame& frame : m_frames)
+			{
+				DestroyFrameBuffer(frame);
+			}
+			m_frames.clear();
+
+			uint32 const imageViewCount = static_cast<uint32>(m_renderer.GetSwapChain().GetImageViews().size());
+			m_frames.reserve(imageViewCount);
+			for (uint32 i = 0; i < imageViewCount; ++i)
+			{
+				Frame& frame = m_frames.emplace_back(m_renderer);
+				frame.m_isDirty.resize(GetProxyCount(), false);
+				CreateFrameBuffer(frame, c_initialUniformCapacity);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::Destroy()
+		{
+			for (Frame& frame : m_frames)
+			{
+				DestroyFrameBuffer(frame);
+			}
+			m_frames.clear();
+
+			m_transforms.clear();
+			m_tints.clear();
+			m_bounds.Clear();
+			m_meshIds.clear();
+			m_materialIds.clear();
+			m_occluderMeshIds.clear();
+			m_lods.clear();
+			m_transformNodes.clear();
+			m_proxySlots.clear();
+
+			m_slotProxies.clear();
+			m_slotGenerations.clear();
+			m_freeSlots.clear();
+
+			m_changedProxies.clear();
+			m_isChanged.clear();
+
+			m_hierarchy.Clear();
+
+			m_bvh.Clear();
+			m_rebuildBvh = false;
+			m_refitBvh = false;
+
+			m_meshes.clear();
+			m_meshSubmeshes.clear();
+			m_materials.clear();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		uint32 Scene::AddMesh(Mesh const* _mesh, uint32 _submesh)
+		{
+			if (_submesh >= _mesh->GetSubmeshCount())
+			{
+				throw std::runtime_error("failed to add mesh, submesh is out of range!");
+			}
+
+			m_meshes.push_back(_mesh);
+			m_meshSubmeshes.push_back(_submesh);
+			return static_cast<uint32>(m_meshes.size() - 1u);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		uint32 Scene::AddMaterial(Material const* _material)
+		{
+			m_materials.push_back(_material);
+			return static_cast<uint32>(m_materials.size() - 1u);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		RenderProxyHandle Scene::CreateProxy(uint32 _meshId, uint32 _materialId, glm::mat4 const& _transform, glm::vec4 const& _tint)
+		{
+			uint32 const proxy = GetProxyCount();
+
+			RenderProxyHandle handle;
+			if (m_freeSlots.empty())
+			{
+				handle.m_slot = static_cast<uint32>(m_slotProxies.size());
+				m_slotProxies.push_back(proxy);
+				m_slotGenerations.push_back(0u);
+			}
+			else
+			{
+				handle.m_slot = m_freeSlots.back();
+				m_freeSlots.pop_back();
+				m_slotProxies[handle.m_slot] = proxy;
+			}
+			handle.m_generation = m_slotGenerations[handle.m_slot];
+
+			m_transforms.push_back(_transform);
+			m_tints.push_back(_tint);
+			m_bounds.PushBack();
+			m_meshIds.push_back(_meshId);
+			m_materialIds.push_back(_materialId);
+			m_occluderMeshIds.push_back(UINT32_MAX);
+			m_lods.push_back(0u);
+			m_transformNodes.push_back(TransformHandle());
+			m_proxySlots.push_back(handle.m_slot);
+			m_isChanged.push_back(false);
+
+			for (Frame& frame : m_frames)
+			{
+				frame.m_isDirty.push_back(false);
+			}
+
+			if (m_renderer.UseGpuCulling())
+			{
+				// Kept in lockstep with the proxy arrays, so the object index is the proxy index
+				m_renderer.GetGpuCullingPass().AddObject(m_meshes[_meshId], m_meshSubmeshes[_meshId], m_materials[_materialId], _transform, _tint);
+			}
+
+			MarkChanged(proxy);
+			m_rebuildBvh = true;
+			return handle;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::DestroyProxy(RenderProxyHandle _handle)
+		{
+			uint32 const proxy = GetProxy(_handle);
+			if (proxy == UINT32_MAX)
+			{
+				std::cout << "Error: tried to destroy a render proxy that no longer exists!" << std::endl;
+				return;
+			}
+
+			if (m_renderer.UseGpuCulling())
+			{
+				m_renderer.GetGpuCullingPass().RemoveObject(proxy);
+			}
+
+			if (m_transformNodes[proxy].IsValid())
+			{
+				m_hierarchy.SetOwner(m_transformNodes[proxy], UINT32_MAX);
+			}
+
+			// Last proxy fills the hole, then its handle is pointed at the new index
+			uint32 const last = GetProxyCount() - 1u;
+			m_transforms[proxy] = m_transforms[last];
+			m_tints[proxy] = m_tints[last];
+			m_bounds.Move(last, proxy);
+			m_meshIds[proxy] = m_meshIds[last];
+			m_materialIds[proxy] = m_materialIds[last];
+			m_occluderMeshIds[proxy] = m_occluderMeshIds[last];
+			m_lods[proxy] = m_lods[last];
+			m_transformNodes[proxy] = m_transformNodes[last];
+			m_proxySlots[proxy] = m_proxySlots[last];
+			m_slotProxies[m_proxySlots[proxy]] = proxy;
+
+			m_transforms.pop_back();
+			m_tints.pop_back();
+			m_bounds.PopBack();
+			m_meshIds.pop_back();
+			m_materialIds.pop_back();
+			m_occluderMeshIds.pop_back();
+			m_lods.pop_back();
+			m_transformNodes.pop_back();
+			m_proxySlots.pop_back();
+
+			// Pending work for the old last index goes away, the moved proxy is rewritten at its new one below
+			m_changedProxies.erase(std::remove(m_changedProxies.begin(), m_changedProxies.end(), last), m_changedProxies.end());
+			m_isChanged.pop_back();
+			for (Frame& frame : m_frames)
+			{
+				frame.m_dirtyProxies.erase(std::remove(frame.m_dirtyProxies.begin(), frame.m_dirtyProxies.end(), last), frame.m_dirtyProxies.end());
+				frame.m_isDirty.pop_back();
+			}
+
+			if (proxy != last)
+			{
+				MarkChanged(proxy);
+			}
+
+			m_slotProxies[_handle.m_slot] = UINT32_MAX;
+			++m_slotGenerations[_handle.m_slot];
+			m_freeSlots.push_back(_handle.m_slot);
+
+			m_rebuildBvh = true;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		bool Scene::IsAlive(RenderProxyHandle _handle) const
+		{
+			return GetProxy(_handle) != UINT32_MAX;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::SetTransform(RenderProxyHandle _handle, glm::mat4 const& _transform)
+		{
+			uint32 const proxy = GetProxy(_handle);
+			if (proxy == UINT32_MAX)
+			{
+				std::cout << "Error: tried to move a render proxy that no longer exists!" << std::endl;
+				return;
+			}
+
+			m_transforms[proxy] = _transform;
+			MarkChanged(proxy);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::SetTint(RenderProxyHandle _handle, glm::vec4 const& _tint)
+		{
+			uint32 const proxy = GetProxy(_handle);
+			if (proxy == UINT32_MAX)
+			{
+				std::cout << "Error: tried to tint a render proxy that no longer exists!" << std::endl;
+				return;
+			}
+
+			m_tints[proxy] = _tint;
+			MarkChanged(proxy);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::SetOccluder(RenderProxyHandle _handle, uint32 _occluderMeshId)
+		{
+			uint32 const proxy = GetProxy(_handle);
+			if (proxy == UINT32_MAX)
+			{
+				std::cout << "Error: tried to make an occluder of a render proxy that no longer exists!" << std::endl;
+				return;
+			}
+
+			m_occluderMeshIds[proxy] = _occluderMeshId;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::ClearOccluder(RenderProxyHandle _handle)
+		{
+			uint32 const proxy = GetProxy(_handle);
+			if (proxy != UINT32_MAX)
+			{
+				m_occluderMeshIds[proxy] = UINT32_MAX;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::AttachProxy(RenderProxyHandle _handle, TransformHandle _node)
+		{
+			uint32 const proxy = GetProxy(_handle);
+			if (proxy == UINT32_MAX)
+			{
+				std::cout << "Error: tried to attach a render proxy that no longer exists!" << std::endl;
+				return;
+			}
+			if (!m_hierarchy.IsAlive(_node))
+			{
+				std::cout << "Error: tried to attach a render proxy to a transform node that no longer exists!" << std::endl;
+				return;
+			}
+
+			DetachProxy(_handle);
+			m_transformNodes[proxy] = _node;
+			m_hierarchy.SetOwner(_node, _handle.m_slot);
+
+			// A node still waiting on its update gets picked up by the next one, until then its last world transform is right
+			m_transforms[proxy] = m_hierarchy.GetWorld(_node);
+			MarkChanged(proxy);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::DetachProxy(RenderProxyHandle _handle)
+		{
+			uint32 const proxy = GetProxy(_handle);
+			if (proxy == UINT32_MAX || !m_transformNodes[proxy].IsValid())
+			{
+				return;
+			}
+
+			m_hierarchy.SetOwner(m_transformNodes[proxy], UINT32_MAX);
+			m_transformNodes[proxy] = TransformHandle();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::Update(uint32 _imageIndex)
+		{
+			// Only subtrees that moved are recomputed, and only their nodes are checked for proxies
+			m_hierarchy.Update();
+			std::vector<glm::mat4> const& worlds = m_hierarchy.GetWorlds();
+			std::vector<uint32> const& owners = m_hierarchy.GetOwners();
+			for (TransformRange const& range : m_hierarchy.GetUpdatedRanges())
+			{
+				for (uint32 node = range.m_first; node < range.m_first + range.m_count; ++node)
+				{
+					if (owners[node] != UINT32_MAX)
+					{
+						uint32 const proxy = m_slotProxies[owners[node]];
+						m_transforms[proxy] = worlds[node];
+						MarkChanged(proxy);
+					}
+				}
+			}
+
+			bool const boundsChanged = !m_changedProxies.empty();
+			for (uint32 proxy : m_changedProxies)
+			{
+				UpdateBounds(proxy);
+
+				if (m_renderer.UseGpuCulling())
+				{
+					// The culling pass fans this out to each image's copy itself
+					m_renderer.GetGpuCullingPass().SetObject(proxy, m_transforms[proxy], m_tints[proxy]);
+				}
+
+				for (Frame& frame : m_frames)
+				{
+					if (!frame.m_isDirty[proxy])
+					{
+						frame.m_isDirty[proxy] = true;
+						frame.m_dirtyProxies.push_back(proxy);
+					}
+				}
+
+				m_isChanged[proxy] = false;
+			}
+			m_changedProxies.clear();
+
+			m_refitBvh = m_refitBvh || boundsChanged;
+
+			if (!m_useUniforms)
+			{
+				return;
+			}
+
+			Frame& frame = m_frames[_imageIndex];
+			uint32 const proxyCount = GetProxyCount();
+			if (proxyCount > frame.m_capacity)
+			{
+				// This image's previous frame has retired, so its buffer can be swapped out
+				uint32 capacity = frame.m_capacity;
+				while (capacity < proxyCount)
+				{
+					capacity *= 2u;
+				}
+
+				DestroyFrameBuffer(frame);
+				CreateFrameBuffer(frame, capacity);
+				frame.m_fullUpload = true;
+			}
+
+			// One dynamic descriptor covers every proxy, the offset picks which one a draw sees. The set only lasts this frame,
+			// the image's transient sets are handed back once its fence has signalled.
+			DescriptorLayout const& layout = m_renderer.GetObjectDescriptorLayout();
+			std::vector<uint8> const packed = layout.Pack({
+				DescriptorBinding::Buffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, frame.m_uniforms.GetBuffer(), 0, sizeof(GenericUniformBufferObject))
+			});
+			frame.m_descriptorSet = m_renderer.GetTransientDescriptorAllocator(_imageIndex).Allocate(layout.GetLayout());
+			layout.Write(frame.m_descriptorSet, packed.data());
+
+			if (frame.m_fullUpload)
+			{
+				for (uint32 proxy = 0; proxy < proxyCount; ++proxy)
+				{
+					WriteUniform(frame, proxy);
+				}
+				frame.m_fullUpload = false;
+			}
+			else
+			{
+				for (uint32 proxy : frame.m_dirtyProxies)
+				{
+					WriteUniform(frame, proxy);
+				}
+			}
+
+			for (uint32 proxy : frame.m_dirtyProxies)
+			{
+				frame.m_isDirty[proxy] = false;
+			}
+			frame.m_dirtyProxies.clear();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::SelectLods(glm::vec3 const& _cameraPosition, float _pixelsPerUnit, float _maxPixelError, std::vector<uint32> const& _visibleProxies)
+		{
+			for (uint32 proxy : _visibleProxies)
+			{
+				Mesh const* mesh = m_meshes[m_meshIds[proxy]];
+				uint32 const submesh = m_meshSubmeshes[m_meshIds[proxy]];
+				uint32 const lodCount = mesh->GetLodCount(submesh);
+
+				// Error is measured where the bounds come closest, which only overestimates it for the rest of the mesh
+				float const distance = glm::length(m_bounds.GetCentre(proxy) - _cameraPosition) - m_bounds.m_radius[proxy];
+				if (lodCount <= 1u || distance <= 0.0f)
+				{
+					m_lods[proxy] = 0u;
+					continue;
+				}
+
+				glm::mat4 const& transform = m_transforms[proxy];
+				float const scale = std::max(std::max(glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1]))), glm::length(glm::vec3(transform[2])));
+				float const pixelsPerError = scale * _pixelsPerUnit / distance;
+
+				// Refine as soon as the current level is too coarse, coarsen only with margin so boundaries don't flicker
+				uint32 lod = std::min(m_lods[proxy], lodCount - 1u);
+				while (lod > 0u && mesh->GetLod(lod, submesh).m_error * pixelsPerError > _maxPixelError)
+				{
+					--lod;
+				}
+				while (lod + 1u < lodCount && mesh->GetLod(lod + 1u, submesh).m_error * pixelsPerError <= _maxPixelError * c_lodHysteresis)
+				{
+					++lod;
+				}
+
+				m_lods[proxy] = lod;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		Bvh const& Scene::GetBvh() const
+		{
+			if (m_rebuildBvh)
+			{
+				m_bvh.Build(m_bounds);
+			}
+			else if (m_refitBvh)
+			{
+				m_bvh.Refit(m_bounds);
+			}
+			m_rebuildBvh = false;
+			m_refitBvh = false;
+			return m_bvh;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		RenderProxyHandle Scene::Raycast(glm::vec3 const& _origin, glm::vec3 const& _direction, float _maxDistance, float* o_distance) const
+		{
+			RayHit hit;
+			if (!GetBvh().Raycast(_origin, _direction, _maxDistance, m_bounds, hit))
+			{
+				return RenderProxyHandle();
+			}
+
+			if (o_distance)
+			{
+				*o_distance = hit.m_distance;
+			}
+			return GetHandle(hit.m_object);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::QuerySphere(glm::vec3 const& _centre, float _radius, std::vector<RenderProxyHandle>& o_proxies) const
+		{
+			std::vector<uint32> proxies;
+			GetBvh().QuerySphere(_centre, _radius, m_bounds, proxies);
+
+			o_proxies.reserve(o_proxies.size() + proxies.size());
+			for (uint32 proxy : proxies)
+			{
+				o_proxies.push_back(GetHandle(proxy));
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::SubmitInstances(InstanceBatcher& io_batcher, VkPipeline _pipeline, std::vector<uint32> const& _visibleProxies) const
+		{
+			InstanceData instance;
+			for (uint32 proxy : _visibleProxies)
+			{
+				Material const* material = m_materials[m_materialIds[proxy]];
+
+				instance.m_model = m_transforms[proxy] * m_meshes[m_meshIds[proxy]]->GetDequantizeTransform();
+				instance.m_tint = m_tints[proxy];
+				instance.m_textureIndex = material->GetTextureIndex();
+				io_batcher.Add(_pipeline, m_meshes[m_meshIds[proxy]], m_meshSubmeshes[m_meshIds[proxy]], m_lods[proxy], material, instance);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::Submit(RenderQueue& io_queue, VkPipeline _pipeline, std::vector<uint32> const& _visibleProxies) const
+		{
+			DrawPacket packet;
+			packet.m_pipeline = _pipeline;
+			packet.m_scene = this;
+
+			for (uint32 proxy : _visibleProxies)
+			{
+				packet.m_material = m_materials[m_materialIds[proxy]];
+				packet.m_mesh = m_meshes[m_meshIds[proxy]];
+				packet.m_submesh = m_meshSubmeshes[m_meshIds[proxy]];
+				packet.m_lod = m_lods[proxy];
+				packet.m_proxy = proxy;
+
+				io_queue.Submit(packet, io_queue.GetViewDepth(m_bounds.GetCentre(proxy)));
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::SubmitOccluders(OcclusionCuller& io_culler, std::vector<uint32> const& _visibleProxies) const
+		{
+			// Occluders outside the frustum cannot hide anything inside it
+			for (uint32 proxy : _visibleProxies)
+			{
+				if (m_occluderMeshIds[proxy] != UINT32_MAX)
+				{
+					io_culler.AddOccluder(*m_meshes[m_occluderMeshIds[proxy]], m_transforms[proxy]);
+				}
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::BindObjectData(VkCommandBuffer _commandBuffer, uint32 _imageIndex, uint32 _proxy) const
+		{
+			if (m_renderer.UsePushConstants())
+			{
+				GenericPushConstantObject pushConstants;
+				pushConstants.m_model = m_transforms[_proxy] * m_meshes[m_meshIds[_proxy]]->GetDequantizeTransform();
+				pushConstants.m_textureIndex = m_materials[m_materialIds[_proxy]]->GetTextureIndex();
+				vkCmdPushConstants(_commandBuffer, m_renderer.GetPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(GenericPushConstantObject), &pushConstants);
+			}
+			else
+			{
+				uint32 const offset = static_cast<uint32>(m_uniformStride * _proxy);
+				vkCmdBindDescriptorSets(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_renderer.GetPipelineLayout(), Renderer::c_objectDescriptorSet, 1, &m_frames[_imageIndex].m_descriptorSet, 1, &offset);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		uint32 Scene::GetProxy(RenderProxyHandle _handle) const
+		{
+			if (_handle.m_slot >= m_slotProxies.size() || m_slotGenerations[_handle.m_slot] != _handle.m_generation)
+			{
+				return UINT32_MAX;
+			}
+
+			return m_slotProxies[_handle.m_slot];
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		RenderProxyHandle Scene::GetHandle(uint32 _proxy) const
+		{
+			RenderProxyHandle handle;
+			handle.m_slot = m_proxySlots[_proxy];
+			handle.m_generation = m_slotGenerations[handle.m_slot];
+			return handle;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::MarkChanged(uint32 _proxy)
+		{
+			if (!m_isChanged[_proxy])
+			{
+				m_isChanged[_proxy] = true;
+				m_changedProxies.push_back(_proxy);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::UpdateBounds(uint32 _proxy)
+		{
+			glm::mat4 const& transform = m_transforms[_proxy];
+			Mesh const* mesh = m_meshes[m_meshIds[_proxy]];
+			glm::vec4 const localSphere = mesh->GetBoundingSphere();
+
+			// Largest axis scale keeps the sphere conservative under non-uniform scaling
+			float const scale = std::max(glm::length(glm::vec3(transform[0])), std::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+			glm::vec3 const sphereCentre = glm::vec3(transform * glm::vec4(glm::vec3(localSphere), 1.0f));
+
+			// Box that encloses the rotated local box, its extent along each world axis is the sum of the rotated half extents
+			glm::vec3 const boxCentre = glm::vec3(transform * glm::vec4((mesh->GetBoundsMinimum() + mesh->GetBoundsMaximum()) * 0.5f, 1.0f));
+			glm::vec3 const halfExtent = (mesh->GetBoundsMaximum() - mesh->GetBoundsMinimum()) * 0.5f;
+			glm::vec3 const worldHalfExtent = glm::abs(glm::vec3(transform[0])) * halfExtent.x + glm::abs(glm::vec3(transform[1])) * halfExtent.y + glm::abs(glm::vec3(transform[2])) * halfExtent.z;
+
+			m_bounds.Set(_proxy, glm::vec4(sphereCentre, localSphere.w * scale), boxCentre - worldHalfExtent, boxCentre + worldHalfExtent);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::WriteUniform(Frame const& _frame, uint32 _proxy) const
+		{
+			GenericUniformBufferObject uniform;
+			uniform.m_model = m_transforms[_proxy] * m_meshes[m_meshIds[_proxy]]->GetDequantizeTransform(); // Buffered positions are relative to the mesh's bounds
+			uniform.m_textureIndex = m_materials[m_materialIds[_proxy]]->GetTextureIndex();
+
+			memcpy(static_cast<uint8*>(_frame.m_mappedUniforms) + m_uniformStride * _proxy, &uniform, sizeof(uniform));
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::CreateFrameBuffer(Frame& io_frame, uint32 _capacity)
+		{
+			VkBufferCreateInfo bufferInfo{};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size = m_uniformStride * _capacity;
+			bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			// Written from the CPU as proxies change, so kept mapped
+			io_frame.m_uniforms.CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			if (vkMapMemory(m_renderer.GetDevice().GetLogicalDevice(), io_frame.m_uniforms.GetBufferMemory(), 0, bufferInfo.size, 0, &io_frame.m_mappedUniforms) != VK_SUCCESS) {
+				throw std::runtime_error("failed to map object uniform buffer!");
+			}
+			io_frame.m_capacity = _capacity;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void Scene::DestroyFrameBuffer(Frame& io_frame)
+		{
+			vkUnmapMemory(m_renderer.GetDevice().GetLogicalDevice(), io_frame.m_uniforms.GetBufferMemory());
+			io_frame.m_uniforms.DestroyBuffer();
+
+			io_frame.m_mappedUniforms = nullptr;
+			io_frame.m_capacity = 0u;
+		}
+	}
+}
\ No newline at end of file
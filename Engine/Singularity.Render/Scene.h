@@ -0,0 +1,145 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include <Singularity.Core/CoreDeclare.h>
+#include <Singularity.Render/Buffer.h>
+#include <Singularity.Render/Bvh.h>
+#include <Singularity.Render/FrustumCuller.h>
+#include <Singularity.Render/TransformHierarchy.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		class InstanceBatcher;
+		class Material;
+		class Mesh;
+		class OcclusionCuller;
+		class Renderer;
+		class RenderQueue;
+
+		// Refers to a proxy without pinning where it lives, the generation goes stale once the proxy is destroyed
+		struct RenderProxyHandle
+		{
+			uint32 m_slot = UINT32_MAX;
+			uint32 m_generation = 0u;
+
+			bool IsValid() const { return m_slot != UINT32_MAX; }
+		};
+
+		// Owns everything that gets drawn, proxies live in packed parallel arrays and are reached through handles
+		class Scene
+		{
+		public:
+			Scene(Renderer& _renderer) : m_renderer(_renderer) {}
+
+			void Create();
+			void Destroy();
+			void CreateFrames(); // One per swap chain image, again whenever a rebuilt swap chain has a different number of them
+
+			uint32 AddMesh(Mesh const* _mesh, uint32 _submesh = 0u); // Every submesh drawn needs an ID of its own, they can share the one mesh
+			uint32 AddMaterial(Material const* _material);
+
+			RenderProxyHandle CreateProxy(uint32 _meshId, uint32 _materialId, glm::mat4 const& _transform, glm::vec4 const& _tint = glm::vec4(1.0f));
+			void DestroyProxy(RenderProxyHandle _handle);
+			bool IsAlive(RenderProxyHandle _handle) const;
+
+			void SetTransform(RenderProxyHandle _handle, glm::mat4 const& _transform);
+			void SetTint(RenderProxyHandle _handle, glm::vec4 const& _tint);
+			void SetOccluder(RenderProxyHandle _handle, uint32 _occluderMeshId); // Usually a simplified stand in for the proxy's mesh
+			void ClearOccluder(RenderProxyHandle _handle);
+			void AttachProxy(RenderProxyHandle _handle, TransformHandle _node); // One proxy per node, SetTransform only holds until the node moves
+			void DetachProxy(RenderProxyHandle _handle);
+			glm::mat4 const& GetTransform(RenderProxyHandle _handle) const { return m_transforms[GetProxy(_handle)]; }
+
+			void Update(uint32 _imageIndex);
+			void SelectLods(glm::vec3 const& _cameraPosition, float _pixelsPerUnit, float _maxPixelError, std::vector<uint32> const& _visibleProxies);
+
+			RenderProxyHandle Raycast(glm::vec3 const& _origin, glm::vec3 const& _direction, float _maxDistance = FLT_MAX, float* o_distance = nullptr) const;
+			void QuerySphere(glm::vec3 const& _centre, float _radius, std::vector<RenderProxyHandle>& o_proxies) const;
+			void SubmitInstances(InstanceBatcher& io_batcher, VkPipeline _pipeline, std::vector<uint32> const& _visibleProxies) const;
+			void Submit(RenderQueue& io_queue, VkPipeline _pipeline, std::vector<uint32> const& _visibleProxies) const;
+			void SubmitOccluders(OcclusionCuller& io_culler, std::vector<uint32> const& _visibleProxies) const;
+			void BindObjectData(VkCommandBuffer _commandBuffer, uint32 _imageIndex, uint32 _proxy) const;
+
+			uint32 GetProxyCount() const { return static_cast<uint32>(m_transforms.size()); }
+			std::vector<glm::mat4> const& GetTransforms() const { return m_transforms; }
+			CullBounds const& GetBounds() const { return m_bounds; } // World space, refreshed by Update for proxies that changed
+			Bvh const& GetBvh() const; // Brought up to date with the bounds on first use, so scenes that never query it never build it
+			std::vector<uint32> const& GetMeshIds() const { return m_meshIds; }
+			std::vector<uint32> const& GetMaterialIds() const { return m_materialIds; }
+			std::vector<uint32> const& GetLods() const { return m_lods; }
+			Mesh const* GetMesh(uint32 _meshId) const { return m_meshes[_meshId]; }
+			uint32 GetSubmesh(uint32 _meshId) const { return m_meshSubmeshes[_meshId]; }
+			Material const* GetMaterial(uint32 _materialId) const { return m_materials[_materialId]; }
+			TransformHierarchy& GetHierarchy() { return m_hierarchy; }
+
+			static float constexpr c_lodHysteresis = 0.75f; // A coarser level has to beat the error limit by this much before it is taken, GPU culling uses it too
+
+		private:
+			// Only used when objects are drawn one at a time without push constants, each image keeps its own uniforms
+			struct Frame
+			{
+				Frame(Renderer& _renderer) : m_uniforms(_renderer) {}
+
+				Buffer m_uniforms;
+				void* m_mappedUniforms = nullptr;
+				uint32 m_capacity = 0u;
+				VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+
+				std::vector<uint32> m_dirtyProxies;
+				std::vector<bool> m_isDirty;
+				bool m_fullUpload = true;
+			};
+
+			uint32 GetProxy(RenderProxyHandle _handle) const;
+			RenderProxyHandle GetHandle(uint32 _proxy) const;
+			void MarkChanged(uint32 _proxy);
+			void UpdateBounds(uint32 _proxy);
+			void WriteUniform(Frame const& _frame, uint32 _proxy) const;
+			void CreateFrameBuffer(Frame& io_frame, uint32 _capacity);
+			void DestroyFrameBuffer(Frame& io_frame);
+
+			static uint32 constexpr c_initialUniformCapacity = 256u;
+
+			Renderer& m_renderer;
+			bool m_useUniforms = false;
+			VkDeviceSize m_uniformStride = 0u;
+
+			std::vector<Mesh const*> m_meshes;
+			std::vector<uint32> m_meshSubmeshes; // Which of the mesh's submeshes each ID draws, occluders always use the whole mesh
+			std::vector<Material const*> m_materials;
+
+			// Proxy data, one entry per live proxy
+			std::vector<glm::mat4> m_transforms;
+			std::vector<glm::vec4> m_tints;
+			CullBounds m_bounds;
+			std::vector<uint32> m_meshIds;
+			std::vector<uint32> m_materialIds;
+			std::vector<uint32> m_occluderMeshIds; // UINT32_MAX for proxies that hide nothing
+			std::vector<uint32> m_lods; // Level drawn last, selection moves away from it only once it is clearly wrong
+			std::vector<TransformHandle> m_transformNodes; // Invalid for proxies placed directly
+			std::vector<uint32> m_proxySlots; // Back reference so the moved proxy's handle can be patched on destroy
+
+			// Handle slots, reused through the free list with a bumped generation
+			std::vector<uint32> m_slotProxies;
+			std::vector<uint32> m_slotGenerations;
+			std::vector<uint32> m_freeSlots;
+
+			std::vector<uint32> m_changedProxies;
+			std::vector<bool> m_isChanged;
+
+			TransformHierarchy m_hierarchy; // Node owners are proxy slots, which survive proxies moving around
+
+			// Only kept current on demand, a cache behind the const queries
+			mutable Bvh m_bvh;
+			mutable bool m_rebuildBvh = false; // Set when proxies come or go
+			mutable bool m_refitBvh = false; // Set when proxies move, which only needs a refit
+
+			std::vector<Frame> m_frames; // One per swap chain image
+		};
+	}
+}
\ No newline at end of file
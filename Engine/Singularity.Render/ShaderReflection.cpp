@@ -0,0 +1,134 @@
+#include "ShaderReflection.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		namespace
+		{
+			uint32 constexpr c_magicNumber = 0x07230203u;
+			uint32 constexpr c_headerWordCount = 5u;
+
+			uint32 constexpr c_opTypeInt = 21u;
+			uint32 constexpr c_opTypeFloat = 22u;
+			uint32 constexpr c_opTypeVector = 23u;
+			uint32 constexpr c_opTypePointer = 32u;
+			uint32 constexpr c_opVariable = 59u;
+			uint32 constexpr c_opDecorate = 71u;
+
+			uint32 constexpr c_decorationBuiltIn = 11u;
+			uint32 constexpr c_decorationLocation = 30u;
+			uint32 constexpr c_storageClassInput = 1u;
+
+			struct NumericType
+			{
+				uint32 m_componentCount = 0u;
+				bool m_isInteger = false;
+			};
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		std::vector<ShaderInput> ShaderReflection::GetInputs(std::vector<char> const& _code)
+		{
+			if (_code.size() % sizeof(uint32) != 0u || _code.size() < c_headerWordCount * sizeof(uint32))
+			{
+				throw std::runtime_error("failed to reflect shader, code is not SPIR-V!");
+			}
+
+			std::vector<uint32> words(_code.size() / sizeof(uint32));
+			memcpy(words.data(), _code.data(), _code.size());
+			if (words[0] != c_magicNumber)
+			{
+				throw std::runtime_error("failed to reflect shader, code is not SPIR-V!");
+			}
+
+			// Declarations can come in any order relative to each other, so collect them all before resolving
+			std::unordered_map<uint32, NumericType> numericTypes;
+			std::unordered_map<uint32, uint32> vectorComponents; // Vector type to its component type
+			std::unordered_map<uint32, uint32> inputPointers; // Pointer type to the type it points at
+			std::unordered_map<uint32, uint32> locations;
+			std::unordered_set<uint32> builtIns;
+			std::vector<std::pair<uint32, uint32>> variables; // Result id and pointer type
+
+			for (size_t word = c_headerWordCount; word < words.size();)
+			{
+				uint32 const opcode = words[word] & 0xFFFFu;
+				uint32 const wordCount = words[word] >> 16u;
+				if (wordCount == 0u || word + wordCount > words.size())
+				{
+					throw std::runtime_error("failed to reflect shader, instruction runs past the end!");
+				}
+
+				uint32 const* operands = &words[word + 1u];
+				if (opcode == c_opTypeInt)
+				{
+					numericTypes[operands[0]] = { 1u, true };
+				}
+				else if (opcode == c_opTypeFloat)
+				{
+					numericTypes[operands[0]] = { 1u, false };
+				}
+				else if (opcode == c_opTypeVector)
+				{
+					vectorComponents[operands[0]] = operands[1];
+					numericTypes[operands[0]] = { operands[2], false };
+				}
+				else if (opcode == c_opTypePointer && operands[1] == c_storageClassInput)
+				{
+					inputPointers[operands[0]] = operands[2];
+				}
+				else if (opcode == c_opVariable && operands[2] == c_storageClassInput)
+				{
+					variables.emplace_back(operands[1], operands[0]);
+				}
+				else if (opcode == c_opDecorate && operands[1] == c_decorationLocation)
+				{
+					locations[operands[0]] = operands[2];
+				}
+				else if (opcode == c_opDecorate && operands[1] == c_decorationBuiltIn)
+				{
+					builtIns.insert(operands[0]);
+				}
+
+				word += wordCount;
+			}
+
+			std::vector<ShaderInput> inputs;
+			for (auto const& [variable, pointer] : variables)
+			{
+				auto const location = locations.find(variable);
+				auto const pointee = inputPointers.find(pointer);
+				if (builtIns.count(variable) || location == locations.end() || pointee == inputPointers.end())
+				{
+					continue;
+				}
+
+				// Matrices, arrays and structs span several locations and are never vertex inputs here
+				auto type = numericTypes.find(pointee->second);
+				if (type == numericTypes.end())
+				{
+					continue;
+				}
+
+				ShaderInput& input = inputs.emplace_back();
+				input.m_location = location->second;
+				input.m_componentCount = type->second.m_componentCount;
+				input.m_isInteger = type->second.m_isInteger;
+
+				auto const component = vectorComponents.find(pointee->second);
+				if (component != vectorComponents.end())
+				{
+					auto const componentType = numericTypes.find(component->second);
+					input.m_isInteger = componentType != numericTypes.end() && componentType->second.m_isInteger;
+				}
+			}
+
+			return inputs;
+		}
+	}
+}
\ No newline at end of file
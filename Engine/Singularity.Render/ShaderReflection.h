@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		struct ShaderInput
+		{
+			uint32 m_location = 0u;
+			uint32 m_componentCount = 0u;
+			bool m_isInteger = false;
+		};
+
+		// Just enough of SPIR-V to see what a shader reads, so pipelines can be checked against what feeds them
+		class ShaderReflection
+		{
+		public:
+			static std::vector<ShaderInput> GetInputs(std::vector<char> const& _code); // User defined scalar and vector inputs, built-ins are skipped
+		};
+	}
+}
\ No newline at end of file
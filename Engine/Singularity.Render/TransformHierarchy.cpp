@@ -0,0 +1,392 @@
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <immintrin.h>
+#include <iostream>
+
+#include <Singularity.Core/Parallel.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		namespace
+		{
+			// Column major like glm, each result column is the parent's columns weighted by one column of the child
+			void Multiply(glm::mat4 const& _parent, glm::mat4 const& _local, glm::mat4& o_world)
+			{
+				__m128 const column0 = _mm_loadu_ps(&_parent[0][0]);
+				__m128 const column1 = _mm_loadu_ps(&_parent[1][0]);
+				__m128 const column2 = _mm_loadu_ps(&_parent[2][0]);
+				__m128 const column3 = _mm_loadu_ps(&_parent[3][0]);
+
+				for (int i = 0; i < 4; ++i)
+				{
+					__m128 const weights = _mm_loadu_ps(&_local[i][0]);
+					__m128 result = _mm_mul_ps(column0, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(0, 0, 0, 0)));
+					result = _mm_add_ps(result, _mm_mul_ps(column1, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(1, 1, 1, 1))));
+					result = _mm_add_ps(result, _mm_mul_ps(column2, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(2, 2, 2, 2))));
+					result = _mm_add_ps(result, _mm_mul_ps(column3, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(3, 3, 3, 3))));
+					_mm_storeu_ps(&o_world[i][0], result);
+				}
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		TransformHandle TransformHierarchy::CreateNode(glm::mat4 const& _local, TransformHandle _parent)
+		{
+			uint32 parent = UINT32_MAX;
+			if (_parent.IsValid())
+			{
+				parent = GetNode(_parent);
+				if (parent == UINT32_MAX)
+				{
+					std::cout << "Error: tried to attach a transform node to a parent that no longer exists!" << std::endl;
+					return TransformHandle();
+				}
+			}
+
+			// Children go at the end of their parent's run, roots at the very end where nothing has to shift
+			uint32 const node = parent == UINT32_MAX ? GetNodeCount() : parent + m_subtreeSizes[parent];
+			bool const shifted = node != GetNodeCount();
+			InsertNodes(node, 1u, parent);
+
+			TransformHandle handle;
+			if (m_freeSlots.empty())
+			{
+				handle.m_slot = static_cast<uint32>(m_slotNodes.size());
+				m_slotNodes.push_back(node);
+				m_slotGenerations.push_back(0u);
+			}
+			else
+			{
+				handle.m_slot = m_freeSlots.back();
+				m_freeSlots.pop_back();
+				m_slotNodes[handle.m_slot] = node;
+			}
+			handle.m_generation = m_slotGenerations[handle.m_slot];
+
+			m_locals[node] = _local;
+			m_nodeSlots[node] = handle.m_slot;
+
+			if (shifted)
+			{
+				RebuildDirtyList();
+			}
+			MarkDirty(node);
+			return handle;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void TransformHierarchy::DestroyNode(TransformHandle _handle)
+		{
+			uint32 const node = GetNode(_handle);
+			if (node == UINT32_MAX)
+			{
+				std::cout << "Error: tried to destroy a transform node that no longer exists!" << std::endl;
+				return;
+			}
+
+			uint32 const count = m_subtreeSizes[node];
+			for (uint32 i = node; i < node + count; ++i)
+			{
+				uint32 const slot = m_nodeSlots[i];
+				m_slotNodes[slot] = UINT32_MAX;
+				++m_slotGenerations[slot];
+				m_freeSlots.push_back(slot);
+			}
+
+			EraseNodes(node, count);
+			RebuildDirtyList();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		bool TransformHierarchy::IsAlive(TransformHandle _handle) const
+		{
+			return GetNode(_handle) != UINT32_MAX;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void TransformHierarchy::Clear()
+		{
+			m_parents.clear();
+			m_subtreeSizes.clear();
+			m_locals.clear();
+			m_worlds.clear();
+			m_owners.clear();
+			m_nodeSlots.clear();
+
+			m_slotNodes.clear();
+			m_slotGenerations.clear();
+			m_freeSlots.clear();
+
+			m_dirtyNodes.clear();
+			m_isDirty.clear();
+
+			m_updatedRanges.clear();
+			m_jobs.clear();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void TransformHierarchy::SetParent(TransformHandle _handle, TransformHandle _parent)
+		{
+			uint32 const node = GetNode(_handle);
+			if (node == UINT32_MAX)
+			{
+				std::cout << "Error: tried to reparent a transform node that no longer exists!" << std::endl;
+				return;
+			}
+
+			uint32 const count = m_subtreeSizes[node];
+			uint32 parent = UINT32_MAX;
+			if (_parent.IsValid())
+			{
+				parent = GetNode(_parent);
+				if (parent == UINT32_MAX)
+				{
+					std::cout << "Error: tried to attach a transform node to a parent that no longer exists!" << std::endl;
+					return;
+				}
+				if (parent >= node && parent < node + count)
+				{
+					std::cout << "Error: tried to attach a transform node below itself!" << std::endl;
+					return;
+				}
+			}
+
+			if (m_parents[node] == parent)
+			{
+				return;
+			}
+
+			// Lift the subtree out with parents relative to its root, then drop it in at the end of the new parent's run
+			std::vector<uint32> parents(m_parents.begin() + node, m_parents.begin() + node + count);
+			std::vector<uint32> const subtreeSizes(m_subtreeSizes.begin() + node, m_subtreeSizes.begin() + node + count);
+			std::vector<glm::mat4> const locals(m_locals.begin() + node, m_locals.begin() + node + count);
+			std::vector<uint32> const owners(m_owners.begin() + node, m_owners.begin() + node + count);
+			std::vector<uint32> const slots(m_nodeSlots.begin() + node, m_nodeSlots.begin() + node + count);
+			for (uint32 i = 1; i < count; ++i)
+			{
+				parents[i] -= node;
+			}
+
+			EraseNodes(node, count);
+
+			parent = _parent.IsValid() ? GetNode(_parent) : UINT32_MAX;
+			uint32 const position = parent == UINT32_MAX ? GetNodeCount() : parent + m_subtreeSizes[parent];
+			InsertNodes(position, count, parent);
+
+			for (uint32 i = 0; i < count; ++i)
+			{
+				m_parents[position + i] = i == 0u ? parent : parents[i] + position;
+				m_subtreeSizes[position + i] = subtreeSizes[i];
+				m_locals[position + i] = locals[i];
+				m_owners[position + i] = owners[i];
+				m_nodeSlots[position + i] = slots[i];
+				m_slotNodes[slots[i]] = position + i;
+			}
+
+			RebuildDirtyList();
+			MarkDirty(position);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void TransformHierarchy::SetLocal(TransformHandle _handle, glm::mat4 const& _local)
+		{
+			uint32 const node = GetNode(_handle);
+			if (node == UINT32_MAX)
+			{
+				std::cout << "Error: tried to move a transform node that no longer exists!" << std::endl;
+				return;
+			}
+
+			m_locals[node] = _local;
+			MarkDirty(node);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void TransformHierarchy::SetOwner(TransformHandle _handle, uint32 _owner)
+		{
+			uint32 const node = GetNode(_handle);
+			if (node != UINT32_MAX)
+			{
+				m_owners[node] = _owner;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void TransformHierarchy::Update()
+		{
+			m_updatedRanges.clear();
+			if (m_dirtyNodes.empty())
+			{
+				return;
+			}
+
+			// Sorted, a flagged node either starts a new subtree or sits inside the last one taken
+			std::sort(m_dirtyNodes.begin(), m_dirtyNodes.end());
+			uint32 end = 0u;
+			uint32 total = 0u;
+			for (uint32 node : m_dirtyNodes)
+			{
+				m_isDirty[node] = false;
+				if (node < end)
+				{
+					continue;
+				}
+
+				m_updatedRanges.push_back({ node, m_subtreeSizes[node] });
+				end = node + m_subtreeSizes[node];
+				total += m_subtreeSizes[node];
+			}
+			m_dirtyNodes.clear();
+
+			uint32 const workerCount = Core::GetWorkerCount();
+			if (total < c_minPerWorker || workerCount == 1u)
+			{
+				for (TransformRange const& range : m_updatedRanges)
+				{
+					UpdateRange(range);
+				}
+				return;
+			}
+
+			// Subtrees bigger than a job are split at their children once their own root is in place. Several jobs per
+			// worker even out subtrees of uneven size.
+			uint32 const jobSize = std::max(1u, total / (workerCount * 4u));
+			std::vector<TransformRange> pending(m_updatedRanges);
+			m_jobs.clear();
+			while (!pending.empty())
+			{
+				TransformRange const range = pending.back();
+				pending.pop_back();
+				if (range.m_count <= jobSize)
+				{
+					m_jobs.push_back(range);
+					continue;
+				}
+
+				UpdateRange({ range.m_first, 1u });
+				for (uint32 child = range.m_first + 1u; child < range.m_first + range.m_count; child += m_subtreeSizes[child])
+				{
+					pending.push_back({ child, m_subtreeSizes[child] });
+				}
+			}
+
+			Core::ParallelFor(static_cast<uint32>(m_jobs.size()), 1u, [&](uint32 _begin, uint32 _end, uint32)
+			{
+				for (uint32 i = _begin; i < _end; ++i)
+				{
+					UpdateRange(m_jobs[i]);
+				}
+			});
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		uint32 TransformHierarchy::GetNode(TransformHandle _handle) const
+		{
+			if (_handle.m_slot >= m_slotNodes.size() || m_slotGenerations[_handle.m_slot] != _handle.m_generation)
+			{
+				return UINT32_MAX;
+			}
+
+			return m_slotNodes[_handle.m_slot];
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void TransformHierarchy::MarkDirty(uint32 _node)
+		{
+			if (!m_isDirty[_node])
+			{
+				m_isDirty[_node] = true;
+				m_dirtyNodes.push_back(_node);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void TransformHierarchy::RebuildDirtyList()
+		{
+			// Flags move with their nodes, only the list of indices goes stale when nodes shift
+			m_dirtyNodes.clear();
+			for (uint32 i = 0; i < GetNodeCount(); ++i)
+			{
+				if (m_isDirty[i])
+				{
+					m_dirtyNodes.push_back(i);
+				}
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void TransformHierarchy::InsertNodes(uint32 _position, uint32 _count, uint32 _parent)
+		{
+			m_parents.insert(m_parents.begin() + _position, _count, _parent);
+			m_subtreeSizes.insert(m_subtreeSizes.begin() + _position, _count, 1u);
+			m_locals.insert(m_locals.begin() + _position, _count, glm::mat4(1.0f));
+			m_worlds.insert(m_worlds.begin() + _position, _count, glm::mat4(1.0f));
+			m_owners.insert(m_owners.begin() + _position, _count, UINT32_MAX);
+			m_nodeSlots.insert(m_nodeSlots.begin() + _position, _count, UINT32_MAX);
+			m_isDirty.insert(m_isDirty.begin() + _position, _count, false);
+
+			// Parents always come first, so only nodes after the gap can point past it
+			for (uint32 i = _position + _count; i < GetNodeCount(); ++i)
+			{
+				if (m_parents[i] != UINT32_MAX && m_parents[i] >= _position)
+				{
+					m_parents[i] += _count;
+				}
+				m_slotNodes[m_nodeSlots[i]] = i;
+			}
+
+			for (uint32 ancestor = _parent; ancestor != UINT32_MAX; ancestor = m_parents[ancestor])
+			{
+				m_subtreeSizes[ancestor] += _count;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void TransformHierarchy::EraseNodes(uint32 _first, uint32 _count)
+		{
+			for (uint32 ancestor = m_parents[_first]; ancestor != UINT32_MAX; ancestor = m_parents[ancestor])
+			{
+				m_subtreeSizes[ancestor] -= _count;
+			}
+
+			m_parents.erase(m_parents.begin() + _first, m_parents.begin() + _first + _count);
+			m_subtreeSizes.erase(m_subtreeSizes.begin() + _first, m_subtreeSizes.begin() + _first + _count);
+			m_locals.erase(m_locals.begin() + _first, m_locals.begin() + _first + _count);
+			m_worlds.erase(m_worlds.begin() + _first, m_worlds.begin() + _first + _count);
+			m_owners.erase(m_owners.begin() + _first, m_owners.begin() + _first + _count);
+			m_nodeSlots.erase(m_nodeSlots.begin() + _first, m_nodeSlots.begin() + _first + _count);
+			m_isDirty.erase(m_isDirty.begin() + _first, m_isDirty.begin() + _first + _count);
+
+			// A whole subtree went, so nothing left can have had its parent inside the range
+			for (uint32 i = _first; i < GetNodeCount(); ++i)
+			{
+				if (m_parents[i] != UINT32_MAX && m_parents[i] >= _first)
+				{
+					m_parents[i] -= _count;
+				}
+				m_slotNodes[m_nodeSlots[i]] = i;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void TransformHierarchy::UpdateRange(TransformRange const& _range)
+		{
+			// The range's own root has a parent that is already up to date, everything after it has its parent in front
+			for (uint32 i = _range.m_first; i < _range.m_first + _range.m_count; ++i)
+			{
+				uint32 const parent = m_parents[i];
+				if (parent == UINT32_MAX)
+				{
+					m_worlds[i] = m_locals[i];
+				}
+				else
+				{
+					Multiply(m_worlds[parent], m_locals[i], m_worlds[i]);
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
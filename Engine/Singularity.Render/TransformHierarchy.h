@@ -0,0 +1,86 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		// Refers to a node without pinning where it lives, the generation goes stale once the node is destroyed
+		struct TransformHandle
+		{
+			uint32 m_slot = UINT32_MAX;
+			uint32 m_generation = 0u;
+
+			bool IsValid() const { return m_slot != UINT32_MAX; }
+		};
+
+		struct TransformRange
+		{
+			uint32 m_first = 0u;
+			uint32 m_count = 0u;
+		};
+
+		// Parent/child transforms kept in depth first order, so every subtree is one contiguous run of nodes and parents
+		// always come before their children. Node data sits in parallel arrays, the handle's slot tracks where each node
+		// ended up as nodes come and go. Roots are appended in constant time, anything else that changes the structure
+		// shifts the nodes behind it and is linear in the size of the hierarchy.
+		//
+		// Changing a node flags it, and the flag stands for its whole subtree. Update only recomputes the world matrices of
+		// flagged subtrees, with SSE matrix multiplies, so nodes that never move cost nothing per frame. Wide subtrees are
+		// split at their children and spread across workers.
+		class TransformHierarchy
+		{
+		public:
+			TransformHandle CreateNode(glm::mat4 const& _local, TransformHandle _parent = TransformHandle());
+			void DestroyNode(TransformHandle _handle); // Takes the node's descendants with it
+			bool IsAlive(TransformHandle _handle) const;
+			void Clear();
+
+			void SetParent(TransformHandle _handle, TransformHandle _parent); // An invalid parent makes the node a root, its local transform is kept
+			void SetLocal(TransformHandle _handle, glm::mat4 const& _local);
+			void SetOwner(TransformHandle _handle, uint32 _owner); // Whatever the node drives, UINT32_MAX for nothing
+			glm::mat4 const& GetLocal(TransformHandle _handle) const { return m_locals[GetNode(_handle)]; }
+			glm::mat4 const& GetWorld(TransformHandle _handle) const { return m_worlds[GetNode(_handle)]; } // As of the last Update
+
+			void Update();
+
+			uint32 GetNodeCount() const { return static_cast<uint32>(m_parents.size()); }
+			std::vector<glm::mat4> const& GetWorlds() const { return m_worlds; }
+			std::vector<uint32> const& GetOwners() const { return m_owners; }
+			std::vector<TransformRange> const& GetUpdatedRanges() const { return m_updatedRanges; } // Nodes the last Update recomputed
+
+		private:
+			uint32 GetNode(TransformHandle _handle) const;
+			void MarkDirty(uint32 _node);
+			void RebuildDirtyList();
+			void InsertNodes(uint32 _position, uint32 _count, uint32 _parent);
+			void EraseNodes(uint32 _first, uint32 _count);
+			void UpdateRange(TransformRange const& _range);
+
+			static uint32 constexpr c_minPerWorker = 16384u; // Dirty nodes needed before the update is spread across workers
+
+			// Node data, in depth first order
+			std::vector<uint32> m_parents; // UINT32_MAX for roots
+			std::vector<uint32> m_subtreeSizes; // Including the node itself
+			std::vector<glm::mat4> m_locals;
+			std::vector<glm::mat4> m_worlds;
+			std::vector<uint32> m_owners;
+			std::vector<uint32> m_nodeSlots; // Back reference so handles can be patched when nodes shift
+
+			// Handle slots, reused through the free list with a bumped generation
+			std::vector<uint32> m_slotNodes;
+			std::vector<uint32> m_slotGenerations;
+			std::vector<uint32> m_freeSlots;
+
+			std::vector<uint32> m_dirtyNodes;
+			std::vector<bool> m_isDirty;
+
+			std::vector<TransformRange> m_updatedRanges;
+			std::vector<TransformRange> m_jobs;
+		};
+	}
+}
\ No newline at end of file
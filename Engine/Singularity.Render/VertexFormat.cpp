@@ -0,0 +1,109 @@
+#include "VertexFormat.h"
+
+#include <stdexcept>
+#include <string>
+
+#include <Singularity.Render/ShaderReflection.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		//////////////////////////////////////////////////////////////////////////////////////
+		VertexFormat::VertexFormat()
+			: VertexFormat(Of<FullVertexLayout>())
+		{
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		VertexFormat::VertexFormat(uint32 _stride, uint32 _positionStride, bool _splitPositions)
+			: m_stride(_stride)
+			, m_positionStride(_positionStride)
+			, m_splitPositions(_splitPositions)
+		{
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		VertexFormat VertexFormat::GetPositionFormat() const
+		{
+			if (!m_splitPositions)
+			{
+				throw std::runtime_error("failed to get position format, positions are interleaved with the other attributes!");
+			}
+
+			// Nothing is encoded through this, meshes buffer their positions through the full format
+			VertexFormat format(m_positionStride, m_positionStride, false);
+			format.m_bindingDescriptions.push_back(m_bindingDescriptions[0]);
+			for (VkVertexInputAttributeDescription const& attributeDescription : m_attributeDescriptions)
+			{
+				if (attributeDescription.binding == 0u)
+				{
+					format.m_attributeDescriptions.push_back(attributeDescription);
+				}
+			}
+			return format;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		bool VertexFormat::HasLocation(VertexLocation _location) const
+		{
+			for (VkVertexInputAttributeDescription const& attributeDescription : m_attributeDescriptions)
+			{
+				if (attributeDescription.location == static_cast<uint32>(_location))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		uint32 VertexFormat::GetSignature() const
+		{
+			std::vector<uint32> words = { m_stride, m_positionStride, m_splitPositions ? 1u : 0u };
+			for (VkVertexInputBindingDescription const& bindingDescription : m_bindingDescriptions)
+			{
+				words.insert(words.end(), { bindingDescription.binding, bindingDescription.stride });
+			}
+			for (VkVertexInputAttributeDescription const& attributeDescription : m_attributeDescriptions)
+			{
+				words.insert(words.end(), { attributeDescription.location, attributeDescription.binding, static_cast<uint32>(attributeDescription.format), attributeDescription.offset });
+			}
+
+			uint32 signature = 2166136261u;
+			for (uint32 word : words)
+			{
+				signature = (signature ^ word) * 16777619u;
+			}
+			return signature;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		void VertexFormat::Validate(std::vector<ShaderInput> const& _inputs) const
+		{
+			// Extra attributes are fine, and component counts may differ since missing components read as 0, 0, 0, 1
+			for (ShaderInput const& input : _inputs)
+			{
+				VkVertexInputAttributeDescription const* match = nullptr;
+				for (VkVertexInputAttributeDescription const& attributeDescription : m_attributeDescriptions)
+				{
+					if (attributeDescription.location == input.m_location)
+					{
+						match = &attributeDescription;
+						break;
+					}
+				}
+
+				if (!match)
+				{
+					throw std::runtime_error("vertex shader reads location " + std::to_string(input.m_location) + " which the vertex format does not provide!");
+				}
+
+				if (GetVertexAttributeFormat(match->format).m_isInteger != input.m_isInteger)
+				{
+					throw std::runtime_error("vertex shader reads location " + std::to_string(input.m_location) + " as a different numeric type than the vertex format stores!");
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
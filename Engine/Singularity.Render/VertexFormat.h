@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glm/vec4.hpp>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include <Singularity.Core/CoreDeclare.h>
+#include <Singularity.Render/Mesh.h>
+#include <Singularity.Render/VertexLayout.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		struct ShaderInput;
+
+		// A VertexLayout picked at runtime, so the renderer can settle on one at startup and meshes can buffer through it
+		// without knowing which. Everything here is generated from the layout, the encoders included. Positions are always
+		// stored relative to the mesh's bounds, and the mesh's dequantization transform is folded into the model matrix
+		// the vertex shader already applies.
+		//
+		// Split formats keep positions in a stream of their own at binding 0 with everything else at binding 1, so depth
+		// only passes can bind just the positions and fetch a fraction of the data.
+		class VertexFormat
+		{
+		public:
+			VertexFormat(); // The full float layout
+
+			template<typename TLayout>
+			static VertexFormat Of(bool _splitPositions = false)
+			{
+				VertexFormat format(TLayout::c_stride, TLayout::c_positionStride, _splitPositions);
+				if (_splitPositions)
+				{
+					format.m_bindingDescriptions.assign(TLayout::c_splitBindings.begin(), TLayout::c_splitBindings.end());
+					format.m_attributeDescriptions.assign(TLayout::c_splitAttributes.begin(), TLayout::c_splitAttributes.end());
+					format.m_encodeSplit = &TLayout::template EncodeSplit<Vertex>;
+				}
+				else
+				{
+					format.m_bindingDescriptions.assign(1u, TLayout::c_binding);
+					format.m_attributeDescriptions.assign(TLayout::c_attributes.begin(), TLayout::c_attributes.end());
+					format.m_encode = &TLayout::template Encode<Vertex>;
+				}
+				return format;
+			}
+
+			uint32 GetStride() const { return m_stride; } // Every stream together
+			uint32 GetPositionStride() const { return m_positionStride; }
+			bool HasSplitPositions() const { return m_splitPositions; }
+			std::vector<VkVertexInputBindingDescription> const& GetBindingDescriptions() const { return m_bindingDescriptions; }
+			std::vector<VkVertexInputAttributeDescription> const& GetAttributeDescriptions() const { return m_attributeDescriptions; }
+			VertexFormat GetPositionFormat() const; // Only the position stream of a split format, for depth only pipelines
+			bool HasLocation(VertexLocation _location) const;
+			uint32 GetSignature() const; // Differs between formats that lay data out differently, so stored encodings can be matched to one
+
+			void Encode(std::vector<Vertex> const& _vertices, glm::vec4 const& _dequantization, void* o_data) const { m_encode(_vertices, _dequantization, o_data); } // Interleaved, o_data must hold GetStride() bytes per vertex
+			void Encode(std::vector<Vertex> const& _vertices, glm::vec4 const& _dequantization, void* o_positions, void* o_attributes) const { m_encodeSplit(_vertices, _dequantization, o_positions, o_attributes); } // Split
+			void Validate(std::vector<ShaderInput> const& _inputs) const; // Throws if the shader reads anything the format can't feed it
+
+		private:
+			using EncodeFunction = void (*)(std::vector<Vertex> const&, glm::vec4 const&, void*);
+			using EncodeSplitFunction = void (*)(std::vector<Vertex> const&, glm::vec4 const&, void*, void*);
+
+			VertexFormat(uint32 _stride, uint32 _positionStride, bool _splitPositions);
+
+			uint32 m_stride = 0u;
+			uint32 m_positionStride = 0u;
+			bool m_splitPositions = false;
+			std::vector<VkVertexInputBindingDescription> m_bindingDescriptions;
+			std::vector<VkVertexInputAttributeDescription> m_attributeDescriptions;
+			EncodeFunction m_encode = nullptr;
+			EncodeSplitFunction m_encodeSplit = nullptr;
+		};
+	}
+}
\ No newline at end of file
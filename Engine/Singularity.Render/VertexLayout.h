@@ -0,0 +1,229 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include <Singularity.Core/CoreDeclare.h>
+
+namespace Singularity
+{
+	namespace Render
+	{
+		// Fixed per attribute so every shader and layout agree on them
+		enum class VertexLocation : uint32
+		{
+			Position = 0,
+			Colour = 1,
+			Uv = 2
+		};
+
+		struct VertexAttributeFormat
+		{
+			uint32 m_size = 0u; // Zero for formats vertex attributes may not use
+			uint32 m_componentCount = 0u;
+			bool m_isInteger = false; // Read as ints rather than floats in the shader
+		};
+
+		constexpr VertexAttributeFormat GetVertexAttributeFormat(VkFormat _format)
+		{
+			if (_format == VK_FORMAT_R32G32B32A32_SFLOAT) return { 16u, 4u, false };
+			if (_format == VK_FORMAT_R32G32B32_SFLOAT) return { 12u, 3u, false };
+			if (_format == VK_FORMAT_R32G32_SFLOAT) return { 8u, 2u, false };
+			if (_format == VK_FORMAT_R16G16B16A16_SNORM) return { 8u, 4u, false };
+			if (_format == VK_FORMAT_R16G16B16A16_SFLOAT) return { 8u, 4u, false };
+			if (_format == VK_FORMAT_R16G16_UNORM) return { 4u, 2u, false };
+			if (_format == VK_FORMAT_R16G16_SFLOAT) return { 4u, 2u, false };
+			if (_format == VK_FORMAT_R8G8B8A8_UNORM) return { 4u, 4u, false };
+			return {};
+		}
+
+		// Packs the first components of _value the way the fixed function fetch expects to find them
+		template<VkFormat Format>
+		void WriteVertexAttribute(glm::vec4 const& _value, uint8* o_data)
+		{
+			static_assert(GetVertexAttributeFormat(Format).m_size > 0u, "unsupported vertex attribute format!");
+
+			if constexpr (Format == VK_FORMAT_R32G32B32A32_SFLOAT || Format == VK_FORMAT_R32G32B32_SFLOAT || Format == VK_FORMAT_R32G32_SFLOAT)
+			{
+				memcpy(o_data, &_value, GetVertexAttributeFormat(Format).m_size);
+			}
+			else if constexpr (Format == VK_FORMAT_R16G16B16A16_SNORM || Format == VK_FORMAT_R16G16B16A16_SFLOAT)
+			{
+				uint16 packed[4];
+				for (int i = 0; i < 4; ++i)
+				{
+					packed[i] = Format == VK_FORMAT_R16G16B16A16_SNORM ? glm::packSnorm1x16(_value[i]) : glm::packHalf1x16(_value[i]);
+				}
+				memcpy(o_data, packed, sizeof(packed));
+			}
+			else if constexpr (Format == VK_FORMAT_R16G16_UNORM || Format == VK_FORMAT_R16G16_SFLOAT)
+			{
+				uint16 packed[2];
+				for (int i = 0; i < 2; ++i)
+				{
+					packed[i] = Format == VK_FORMAT_R16G16_UNORM ? glm::packUnorm1x16(_value[i]) : glm::packHalf1x16(_value[i]);
+				}
+				memcpy(o_data, packed, sizeof(packed));
+			}
+			else
+			{
+				uint32 const packed = glm::packUnorm4x8(_value);
+				memcpy(o_data, &packed, sizeof(packed));
+			}
+		}
+
+		// What each attribute reads from a vertex. Positions are written relative to the
+		// mesh's bounds, see Mesh::GetDequantization.
+		template<VkFormat Format>
+		struct PositionAttribute
+		{
+			static uint32 constexpr c_location = static_cast<uint32>(VertexLocation::Position);
+			static VkFormat constexpr c_format = Format;
+
+			template<typename TVertex>
+			static glm::vec4 Read(TVertex const& _vertex, glm::vec4 const& _dequantization) { return glm::vec4((_vertex.m_position - glm::vec3(_dequantization)) / _dequantization.w, 0.0f); }
+		};
+
+		template<VkFormat Format>
+		struct ColourAttribute
+		{
+			static uint32 constexpr c_location = static_cast<uint32>(VertexLocation::Colour);
+			static VkFormat constexpr c_format = Format;
+
+			template<typename TVertex>
+			static glm::vec4 Read(TVertex const& _vertex, glm::vec4 const&) { return _vertex.m_colour; }
+		};
+
+		template<VkFormat Format>
+		struct UvAttribute
+		{
+			static uint32 constexpr c_location = static_cast<uint32>(VertexLocation::Uv);
+			static VkFormat constexpr c_format = Format; // Unorm formats clamp uvs to [0, 1]
+
+			template<typename TVertex>
+			static glm::vec4 Read(TVertex const& _vertex, glm::vec4 const&) { return glm::vec4(_vertex.m_uv, 0.0f, 0.0f); }
+		};
+
+		// Split layouts move every attribute after the position into a second binding
+		template<bool Split, typename... TAttributes>
+		constexpr std::array<VkVertexInputAttributeDescription, sizeof...(TAttributes)> MakeVertexAttributeDescriptions()
+		{
+			std::array<VkVertexInputAttributeDescription, sizeof...(TAttributes)> attributeDescriptions = {};
+			uint32 const locations[] = { TAttributes::c_location... };
+			VkFormat const formats[] = { TAttributes::c_format... };
+
+			uint32 offset = 0u;
+			for (uint32 i = 0; i < sizeof...(TAttributes); ++i)
+			{
+				if (Split && i == 1u)
+				{
+					offset = 0u;
+				}
+
+				attributeDescriptions[i].location = locations[i];
+				attributeDescriptions[i].binding = Split && i > 0u ? 1u : 0u;
+				attributeDescriptions[i].format = formats[i];
+				attributeDescriptions[i].offset = offset;
+				offset += GetVertexAttributeFormat(formats[i]).m_size;
+			}
+			return attributeDescriptions;
+		}
+
+		template<typename... TAttributes>
+		constexpr bool HasUniqueVertexLocations()
+		{
+			uint32 const locations[] = { TAttributes::c_location... };
+			for (uint32 i = 0; i < sizeof...(TAttributes); ++i)
+			{
+				for (uint32 j = i + 1u; j < sizeof...(TAttributes); ++j)
+				{
+					if (locations[i] == locations[j])
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		// A vertex buffer layout declared as a list of attributes, packed in order into one interleaved binding, or split
+		// into a position stream and an interleaved stream of everything else. Strides, offsets and the Vulkan
+		// descriptions are worked out at compile time, and the encoders are generated per layout so writing vertices
+		// never branches on the format.
+		template<typename TPosition, typename... TAttributes>
+		struct VertexLayout
+		{
+			static_assert(TPosition::c_location == static_cast<uint32>(VertexLocation::Position), "a vertex layout starts with its position!");
+			static_assert(((GetVertexAttributeFormat(TAttributes::c_format).m_size > 0u) && ... && (GetVertexAttributeFormat(TPosition::c_format).m_size > 0u)), "unsupported vertex attribute format!");
+			static_assert(HasUniqueVertexLocations<TPosition, TAttributes...>(), "vertex layout attributes must have unique locations!");
+
+			static uint32 constexpr c_attributeCount = static_cast<uint32>(1u + sizeof...(TAttributes));
+			static uint32 constexpr c_positionStride = GetVertexAttributeFormat(TPosition::c_format).m_size;
+			static uint32 constexpr c_stride = (c_positionStride + ... + GetVertexAttributeFormat(TAttributes::c_format).m_size);
+
+			static VkVertexInputBindingDescription constexpr c_binding = { 0u, c_stride, VK_VERTEX_INPUT_RATE_VERTEX };
+			static std::array<VkVertexInputAttributeDescription, 1u + sizeof...(TAttributes)> constexpr c_attributes = MakeVertexAttributeDescriptions<false, TPosition, TAttributes...>();
+
+			static std::array<VkVertexInputBindingDescription, 2u> constexpr c_splitBindings = { {
+				{ 0u, c_positionStride, VK_VERTEX_INPUT_RATE_VERTEX },
+				{ 1u, c_stride - c_positionStride, VK_VERTEX_INPUT_RATE_VERTEX }
+			} };
+			static std::array<VkVertexInputAttributeDescription, 1u + sizeof...(TAttributes)> constexpr c_splitAttributes = MakeVertexAttributeDescriptions<true, TPosition, TAttributes...>();
+
+			static constexpr bool HasLocation(uint32 _location) { return TPosition::c_location == _location || ((TAttributes::c_location == _location) || ...); }
+
+			template<typename TVertex>
+			static void Encode(std::vector<TVertex> const& _vertices, glm::vec4 const& _dequantization, void* o_data) // o_data must hold c_stride bytes per vertex
+			{
+				EncodeStreams<false>(_vertices, _dequantization, o_data, o_data);
+			}
+
+			template<typename TVertex>
+			static void EncodeSplit(std::vector<TVertex> const& _vertices, glm::vec4 const& _dequantization, void* o_positions, void* o_attributes)
+			{
+				EncodeStreams<true>(_vertices, _dequantization, o_positions, o_attributes);
+			}
+
+		private:
+			template<bool Split, typename TVertex>
+			static void EncodeStreams(std::vector<TVertex> const& _vertices, glm::vec4 const& _dequantization, void* o_positions, void* o_attributes)
+			{
+				uint32 constexpr positionStride = Split ? c_positionStride : c_stride;
+				uint32 constexpr attributeStride = Split ? c_stride - c_positionStride : c_stride;
+
+				uint8* positionData = static_cast<uint8*>(o_positions);
+				uint8* attributeData = static_cast<uint8*>(o_attributes);
+				for (TVertex const& vertex : _vertices)
+				{
+					EncodeVertex<Split>(vertex, _dequantization, positionData, attributeData, std::index_sequence_for<TAttributes...>());
+					positionData += positionStride;
+					attributeData += attributeStride;
+				}
+			}
+
+			template<bool Split, typename TVertex, size_t... Indices>
+			static void EncodeVertex(TVertex const& _vertex, glm::vec4 const& _dequantization, uint8* o_position, uint8* o_attributes, std::index_sequence<Indices...>)
+			{
+				auto const& attributeDescriptions = Split ? c_splitAttributes : c_attributes;
+				WriteVertexAttribute<TPosition::c_format>(TPosition::Read(_vertex, _dequantization), o_position);
+				(WriteVertexAttribute<TAttributes::c_format>(TAttributes::Read(_vertex, _dequantization), o_attributes + attributeDescriptions[Indices + 1u].offset), ...);
+			}
+		};
+
+		// Every Vertex member at full precision, kept for debugging against the compact layout
+		using FullVertexLayout = VertexLayout<
+			PositionAttribute<VK_FORMAT_R32G32B32_SFLOAT>,
+			ColourAttribute<VK_FORMAT_R32G32B32A32_SFLOAT>,
+			UvAttribute<VK_FORMAT_R32G32_SFLOAT>>;
+
+		// 12 bytes, positions to 1/32767 of the mesh's largest half extent and no colour stream
+		using CompactVertexLayout = VertexLayout<
+			PositionAttribute<VK_FORMAT_R16G16B16A16_SNORM>,
+			UvAttribute<VK_FORMAT_R16G16_SFLOAT>>;
+	}
+}
\ No newline at end of file
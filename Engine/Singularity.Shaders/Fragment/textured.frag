@@ -3,10 +3,11 @@
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragUV;
+layout(location = 3) flat in vec4 fragTint;
 
 layout(location = 0) out vec4 outColor;
 
-layout(binding = 1) uniform sampler2D texSampler;
+layout(set = 1, binding = 0) uniform sampler2D texSampler;
 
 void main() {
     //outColor = vec4(fragUV, 0.0, 1.0);
@@ -14,7 +15,7 @@ void main() {
     vec4 textureColour = texture(texSampler, fragUV);
     if(textureColour.a != 0.0)
     {
-        outColor = textureColour;
+        outColor = textureColour * fragTint;
     }
     else
     {
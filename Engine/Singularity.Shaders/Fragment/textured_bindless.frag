@@ -0,0 +1,25 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : enable
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragUV;
+layout(location = 2) flat in uint fragTextureIndex;
+layout(location = 3) flat in vec4 fragTint;
+
+layout(location = 0) out vec4 outColor;
+
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+void main() {
+    vec4 textureColour = texture(textures[nonuniformEXT(fragTextureIndex)], fragUV);
+    if(textureColour.a != 0.0)
+    {
+        outColor = textureColour * fragTint;
+    }
+    else
+    {
+        // Discard fully transparent fragments
+        discard;
+    }
+}
\ No newline at end of file
@@ -1,11 +1,16 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(binding = 0) uniform GenericUniformBufferObject {
-    mat4 model;
+layout(set = 0, binding = 0) uniform FrameUniformBufferObject {
     mat4 view;
     mat4 proj;
-} ubo;
+    vec4 time;
+} frame;
+
+layout(set = 2, binding = 0) uniform GenericUniformBufferObject {
+    mat4 model;
+    uint textureIndex;
+} object;
 
 
 layout(location = 0) in vec3 inPosition;
@@ -15,6 +20,6 @@ layout(location = 2) in vec2 inUV;
 layout(location = 0) out vec4 fragColor;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    gl_Position = frame.proj * frame.view * object.model * vec4(inPosition, 1.0);
     fragColor = inColor;
 }
\ No newline at end of file
@@ -0,0 +1,35 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(set = 0, binding = 0) uniform FrameUniformBufferObject {
+    mat4 view;
+    mat4 proj;
+    vec4 time;
+} frame;
+
+struct GpuObjectData {
+    mat4 model;
+    vec4 tint;
+    vec4 boundingSphere;
+    uint textureIndex;
+    uint bucket;
+    uint commandSlot;
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer ObjectBuffer {
+    GpuObjectData objects[];
+};
+
+
+// Depth only, the position stream is the only one bound
+layout(location = 0) in vec3 inPosition;
+
+// Must match the main pass exactly for its depth test to pass
+invariant gl_Position;
+
+void main() {
+    // The culling pass writes the object index as the command's firstInstance
+    GpuObjectData object = objects[gl_InstanceIndex];
+
+    gl_Position = frame.proj * frame.view * object.model * vec4(inPosition, 1.0);
+}
\ No newline at end of file
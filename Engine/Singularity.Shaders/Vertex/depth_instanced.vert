@@ -0,0 +1,32 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(set = 0, binding = 0) uniform FrameUniformBufferObject {
+    mat4 view;
+    mat4 proj;
+    vec4 time;
+} frame;
+
+struct InstanceData {
+    mat4 model;
+    vec4 tint;
+    uint textureIndex;
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer InstanceBuffer {
+    InstanceData instances[];
+};
+
+
+// Depth only, the position stream is the only one bound
+layout(location = 0) in vec3 inPosition;
+
+// Must match the main pass exactly for its depth test to pass
+invariant gl_Position;
+
+void main() {
+    // gl_InstanceIndex includes the draw's firstInstance, so it lands in this group's slice of the buffer
+    InstanceData instance = instances[gl_InstanceIndex];
+
+    gl_Position = frame.proj * frame.view * instance.model * vec4(inPosition, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(set = 0, binding = 0) uniform FrameUniformBufferObject {
+    mat4 view;
+    mat4 proj;
+    vec4 time;
+} frame;
+
+layout(push_constant) uniform GenericPushConstantObject {
+    mat4 model;
+    uint textureIndex;
+} pushConstants;
+
+
+// Depth only, the position stream is the only one bound
+layout(location = 0) in vec3 inPosition;
+
+// Must match the main pass exactly for its depth test to pass
+invariant gl_Position;
+
+void main() {
+    gl_Position = frame.proj * frame.view * pushConstants.model * vec4(inPosition, 1.0);
+}
@@ -1,11 +1,16 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(binding = 0) uniform GenericUniformBufferObject {
-    mat4 model;
+layout(set = 0, binding = 0) uniform FrameUniformBufferObject {
     mat4 view;
     mat4 proj;
-} ubo;
+    vec4 time;
+} frame;
+
+layout(set = 2, binding = 0) uniform GenericUniformBufferObject {
+    mat4 model;
+    uint textureIndex;
+} object;
 
 
 layout(location = 0) in vec3 inPosition;
@@ -14,9 +19,16 @@ layout(location = 2) in vec2 inUV;
 
 layout(location = 0) out vec4 fragColor;
 layout(location = 1) out vec2 fragUV;
+layout(location = 2) flat out uint fragTextureIndex;
+layout(location = 3) flat out vec4 fragTint;
+
+// Must match the depth prepass exactly for its depth test to pass
+invariant gl_Position;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    gl_Position = frame.proj * frame.view * object.model * vec4(inPosition, 1.0);
     fragColor = inColor;
     fragUV = inUV;
-}
\ No newline at end of file
+    fragTextureIndex = object.textureIndex;
+    fragTint = vec4(1.0);
+}
@@ -0,0 +1,46 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(set = 0, binding = 0) uniform FrameUniformBufferObject {
+    mat4 view;
+    mat4 proj;
+    vec4 time;
+} frame;
+
+struct GpuObjectData {
+    mat4 model;
+    vec4 tint;
+    vec4 boundingSphere;
+    uint textureIndex;
+    uint bucket;
+    uint commandSlot;
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer ObjectBuffer {
+    GpuObjectData objects[];
+};
+
+
+// Positions arrive in [-1, 1] of the mesh's bounds, the model matrix carries the mesh's dequantization.
+// There is no colour stream, location 1 is left unused.
+layout(location = 0) in vec3 inPosition;
+layout(location = 2) in vec2 inUV;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragUV;
+layout(location = 2) flat out uint fragTextureIndex;
+layout(location = 3) flat out vec4 fragTint;
+
+// Must match the depth prepass exactly for its depth test to pass
+invariant gl_Position;
+
+void main() {
+    // The culling pass writes the object index as the command's firstInstance
+    GpuObjectData object = objects[gl_InstanceIndex];
+
+    gl_Position = frame.proj * frame.view * object.model * vec4(inPosition, 1.0);
+    fragColor = vec4(1.0);
+    fragUV = inUV;
+    fragTextureIndex = object.textureIndex;
+    fragTint = object.tint;
+}
\ No newline at end of file
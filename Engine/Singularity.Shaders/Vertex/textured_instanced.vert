@@ -0,0 +1,42 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(set = 0, binding = 0) uniform FrameUniformBufferObject {
+    mat4 view;
+    mat4 proj;
+    vec4 time;
+} frame;
+
+struct InstanceData {
+    mat4 model;
+    vec4 tint;
+    uint textureIndex;
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer InstanceBuffer {
+    InstanceData instances[];
+};
+
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) in vec2 inUV;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragUV;
+layout(location = 2) flat out uint fragTextureIndex;
+layout(location = 3) flat out vec4 fragTint;
+
+// Must match the depth prepass exactly for its depth test to pass
+invariant gl_Position;
+
+void main() {
+    // gl_InstanceIndex includes the draw's firstInstance, so it lands in this group's slice of the buffer
+    InstanceData instance = instances[gl_InstanceIndex];
+
+    gl_Position = frame.proj * frame.view * instance.model * vec4(inPosition, 1.0);
+    fragColor = inColor;
+    fragUV = inUV;
+    fragTextureIndex = instance.textureIndex;
+    fragTint = instance.tint;
+}
\ No newline at end of file
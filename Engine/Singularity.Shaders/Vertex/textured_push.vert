@@ -0,0 +1,34 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(set = 0, binding = 0) uniform FrameUniformBufferObject {
+    mat4 view;
+    mat4 proj;
+    vec4 time;
+} frame;
+
+layout(push_constant) uniform GenericPushConstantObject {
+    mat4 model;
+    uint textureIndex;
+} pushConstants;
+
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) in vec2 inUV;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragUV;
+layout(location = 2) flat out uint fragTextureIndex;
+layout(location = 3) flat out vec4 fragTint;
+
+// Must match the depth prepass exactly for its depth test to pass
+invariant gl_Position;
+
+void main() {
+    gl_Position = frame.proj * frame.view * pushConstants.model * vec4(inPosition, 1.0);
+    fragColor = inColor;
+    fragUV = inUV;
+    fragTextureIndex = pushConstants.textureIndex;
+    fragTint = vec4(1.0);
+}
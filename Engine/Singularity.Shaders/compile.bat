@@ -8,12 +8,15 @@ echo %compiler%
 :: Clean up old shaders
 if exist %outputDir%\Vertex\ rmdir %outputDir%\Vertex\ /q /s
 if exist %outputDir%\Fragment\ rmdir %outputDir%\Fragment\ /q /s
+if exist %outputDir%\Compute\ rmdir %outputDir%\Compute\ /q /s
 
 :: Remake directories
 mkdir %outputDir%
 mkdir %outputDir%\Vertex\
 mkdir %outputDir%\Fragment\
+mkdir %outputDir%\Compute\
 
 :: Run the compiler for each file in the directories
 for /f "delims=|" %%f in ('dir /b Vertex') do %compiler% Vertex\%%f -o %outputDir%\Vertex\%%~nf_vert.spv
-for /f "delims=|" %%f in ('dir /b Fragment') do %compiler% Fragment\%%f -o %outputDir%\Fragment\%%~nf_frag.spv
\ No newline at end of file
+for /f "delims=|" %%f in ('dir /b Fragment') do %compiler% Fragment\%%f -o %outputDir%\Fragment\%%~nf_frag.spv
+for /f "delims=|" %%f in ('dir /b Compute') do %compiler% Compute\%%f -o %outputDir%\Compute\%%~nf_comp.spv
\ No newline at end of file